@@ -24,7 +24,7 @@
 namespace Antmicro.Renode.Peripherals.CPU
 {
     [GPIO(NumberOfInputs = 0x1000 + 1)]
-    public partial class CortexM : Arm, IPeripheralWithTransactionState
+    public partial class CortexM : Arm, IPeripheralWithTransactionState, INVICNativeState
     {
         public CortexM(string cpuType, IMachine machine, NVIC nvic, [NameAlias("id")] uint cpuId = 0, Endianess endianness = Endianess.LittleEndian,
             uint? fpuInterruptNumber = null, uint? numberOfMPURegions = null, bool enableTrustZone = false, uint? numberOfSAURegions = null, uint? numberOfIDAURegions = null, bool isCpuWaitSignalSet = false)
@@ -171,6 +171,77 @@ public uint GetPrimask(bool secure)
             return tlibGetPrimask(secure ? 1u : 0u);
         }
 
+        // The NVIC publishes its state here after each arbitration, see INVICNativeState
+        public void BeginNvicStateUpdate()
+        {
+            renodeNvicBeginStateUpdate();
+        }
+
+        public void SetNvicCandidateExceptions(int word, ulong bits)
+        {
+            renodeNvicSetCandidateExceptions(word, bits);
+        }
+
+        public void SetNvicActiveExceptions(int word, ulong bits)
+        {
+            renodeNvicSetActiveExceptions(word, bits);
+        }
+
+        public void SetNvicRunningExceptions(int word, ulong bits)
+        {
+            renodeNvicSetRunningExceptions(word, bits);
+        }
+
+        public void SetNvicPendingActiveExceptions(int word, ulong bits)
+        {
+            renodeNvicSetPendingActiveExceptions(word, bits);
+        }
+
+        public void SetNvicActiveStackEntry(int index, int slot)
+        {
+            renodeNvicSetActiveStackEntry(index, slot);
+        }
+
+        public void SetNvicExceptionNumber(int slot, int number)
+        {
+            renodeNvicSetExceptionNumber(slot, number);
+        }
+
+        public void SetNvicPriority(int slot, int priority, int groupPriority)
+        {
+            renodeNvicSetPriority(slot, priority, groupPriority);
+        }
+
+        public void SetNvicPriorityBoostState(byte nonSecureBasepri, byte secureBasepri, int nonSecureBinaryPoint, int secureBinaryPoint)
+        {
+            renodeNvicSetPriorityBoostState(nonSecureBasepri, secureBasepri, (uint)nonSecureBinaryPoint, (uint)secureBinaryPoint);
+        }
+
+        public void SetNvicExecutionState(NVICNativeFlags flags, int activeDepth, byte priorityMask)
+        {
+            renodeNvicSetExecutionState((uint)flags, (uint)activeDepth, priorityMask);
+        }
+
+        public void EndNvicStateUpdate(bool irqLine, bool maskedInterruptPresent)
+        {
+            renodeNvicEndStateUpdate(irqLine ? 1u : 0u, maskedInterruptPresent ? 1u : 0u);
+        }
+
+        public void InvalidateNvicState()
+        {
+            renodeNvicInvalidateState();
+        }
+
+        public ulong TakeNvicOperation()
+        {
+            return renodeNvicTakeOperation();
+        }
+
+        public uint GetNvicOutputs()
+        {
+            return renodeNvicGetOutputs();
+        }
+
         public void SetIDAURegion(uint regionIndex, uint baseAddress, uint limitAddress, bool enabled, bool nonSecureCallable)
         {
             SetIDAURegion(regionIndex, new IDAURegion(baseAddress, limitAddress, enabled, nonSecureCallable));
@@ -1385,6 +1456,48 @@ private void SetTrustZoneRelatedRegister(string registerName, Action<uint> sette
         [Import]
         private readonly Func<uint, uint> tlibGetFaultmask;
 
+        [Import]
+        private readonly Action renodeNvicBeginStateUpdate;
+
+        [Import]
+        private readonly Action<int, ulong> renodeNvicSetCandidateExceptions;
+
+        [Import]
+        private readonly Action<int, ulong> renodeNvicSetActiveExceptions;
+
+        [Import]
+        private readonly Action<int, ulong> renodeNvicSetRunningExceptions;
+
+        [Import]
+        private readonly Action<int, ulong> renodeNvicSetPendingActiveExceptions;
+
+        [Import]
+        private readonly Action<int, int> renodeNvicSetActiveStackEntry;
+
+        [Import]
+        private readonly Action<int, int> renodeNvicSetExceptionNumber;
+
+        [Import]
+        private readonly Action<int, int, int> renodeNvicSetPriority;
+
+        [Import]
+        private readonly Action<uint, uint, uint, uint> renodeNvicSetPriorityBoostState;
+
+        [Import]
+        private readonly Action<uint, uint, uint> renodeNvicSetExecutionState;
+
+        [Import]
+        private readonly Action<uint, uint> renodeNvicEndStateUpdate;
+
+        [Import]
+        private readonly Action renodeNvicInvalidateState;
+
+        [Import]
+        private readonly Func<ulong> renodeNvicTakeOperation;
+
+        [Import]
+        private readonly Func<uint> renodeNvicGetOutputs;
+
         [Import]
         private readonly Func<uint, uint, uint> tlibGetPmsav8Rlar;
 
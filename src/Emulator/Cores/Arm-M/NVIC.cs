@@ -11,6 +11,7 @@
 using System.Collections.Generic;
 using System.Linq;
 
+using Antmicro.Migrant;
 using Antmicro.Renode.Core;
 using Antmicro.Renode.Core.Structure.Registers;
 using Antmicro.Renode.Debugging;
@@ -82,6 +83,7 @@ public InterruptTargetSecurityState GetTargetInterruptSecurityState(int interrup
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var preemptNeeded = activeIRQs.Count != 0;
                 int? result = null;
 
@@ -116,6 +118,7 @@ public InterruptTargetSecurityState GetTargetInterruptSecurityState(int interrup
                 {
                     IRQ.Set(false);
                     maskedInterruptPresent = false;
+                    PublishNativeState(irqLine: false, maskedInterruptPresent: false);
                     return null;
                 }
 
@@ -127,8 +130,10 @@ public InterruptTargetSecurityState GetTargetInterruptSecurityState(int interrup
                 IRQ.Set(canBecomeActive);
 
                 // This field has side-effects, and can cause Cortex-M CPU running in another thread to exit WFI immediately.
-                // Make absolutely sure to execute last, after updating `IRQ`.
+                // Make absolutely sure to execute after updating `IRQ`.
                 maskedInterruptPresent = canWakeFromWfi;
+                // The CPU thread can act on the published state right away, so it has to match the outputs
+                PublishNativeState(canBecomeActive, canWakeFromWfi);
 
                 return result;
             }
@@ -149,6 +154,7 @@ public void OnGPIO(int number, bool value)
             int? pendingInterrupt = null;
             lock(irqs)
             {
+                SynchronizeNativeState();
                 if(value)
                 {
                     irqs[number] |= IRQState.Running;
@@ -180,6 +186,7 @@ public void SetPendingIRQ(int number)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 this.NoisyLog("Internal IRQ {0}.", ExceptionToString(number));
                 SetPending(number);
                 FindPendingInterrupt();
@@ -190,6 +197,7 @@ public SynchronousFaultResult SetPendingSynchronousFault(int number)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 this.NoisyLog("Synchronous fault {0}.", ExceptionToString(number));
 
                 if(!ShouldEscalateToHardFault(number, synchronous: true))
@@ -221,6 +229,7 @@ public SynchronousFaultResult SetPendingStackingFault(int number, int originalEx
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 // ExceptionEntry() performs PushStack() before ExceptionTaken().
                 // We acknowledged the original exception before stacking,
                 // so ignore the top active entry while reproducing the
@@ -273,6 +282,7 @@ public SynchronousFaultResult SetPendingVectorFault(bool secure, int originalExc
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 // Armv8-M ARM rule RCTKP and pseudocode operation DerivedLateArrival:
                 // a terminal vector-table BusFault becomes HardFault with
                 // HFSR.VECTTBL set. We choose to have FORCED remain clear which is
@@ -307,6 +317,7 @@ public uint GetFpccrReadyBits(int originalException, bool secure)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 bool IsReady(int exception)
                 {
                     return originalException != 0
@@ -353,6 +364,7 @@ public LazyFpFaultResult SetPendingLazyFpFault(int number, uint fpccr)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var architecturalNumber = number & ~BankedExcpSecureBit;
                 bool escalate;
                 switch((SystemException)architecturalNumber)
@@ -404,6 +416,7 @@ public void EnterResetLockup(bool secure)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 // Armv8-M ARM rule RBHVG and pseudocode operation TakeReset:
                 // a reset-vector BusFault makes the relevant HardFault active,
                 // clears its pending state, and enters Lockup with IPSR == 0.
@@ -421,6 +434,7 @@ public void SetLockupState(bool value)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 isLockedUp = value;
                 Lockup.Set(value);
                 if(value)
@@ -435,6 +449,7 @@ public bool CompleteIRQ(int number)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var currentIRQ = irqs[number];
                 var isActive = (currentIRQ & IRQState.Active) != 0;
                 var isTopActive = activeIRQs.Count > 0 && activeIRQs.Peek() == number;
@@ -477,14 +492,11 @@ public bool CompleteIRQ(int number)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var pendingIrq = FindPendingInterrupt();
                 if(pendingIrq is int result)
                 {
-                    irqs[result] |= IRQState.Active;
-                    irqs[result] &= ~IRQState.Pending;
-                    pendingIRQs.Remove(result);
-                    this.NoisyLog("Acknowledged IRQ {0}.", ExceptionToString(result));
-                    activeIRQs.Push(result);
+                    ActivateIRQ(result);
                 }
                 // at this point we can surely deactivate interrupt, because the best was chosen
                 IRQ.Set(false);
@@ -502,6 +514,9 @@ public void SetSleepOnExceptionExitOnAllCPUs(bool value)
 
         public void WriteDoubleWord(long offset, uint value, bool isSecure)
         {
+            // Not every register write ends with a new arbitration, e.g. the SHCSR active bits,
+            // the native state stays invalid until the next one
+            SynchronizeNativeState();
             if(offset >= SetEnableStart && offset < SetEnableEnd)
             {
                 EnableOrDisableInterrupt((int)offset - SetEnableStart, value, true, isSecure);
@@ -581,6 +596,7 @@ public void WriteDoubleWord(long offset, uint value, bool isSecure)
             case Registers.SystemHandlerPriority1:
                 lock(irqs)
                 {
+                    SynchronizeNativeState();
                     SetSystemHandlerPriority(SystemException.MemManageFault, (byte)value, isSecure);
                     SetSystemHandlerPriority(SystemException.BusFault, (byte)(value >> 8), isSecure);
                     SetSystemHandlerPriority(SystemException.UsageFault, (byte)(value >> 16), isSecure);
@@ -593,6 +609,7 @@ public void WriteDoubleWord(long offset, uint value, bool isSecure)
             case Registers.SystemHandlerPriority2:
                 lock(irqs)
                 {
+                    SynchronizeNativeState();
                     SetSystemHandlerPriority(SystemException.SuperVisorCall, (byte)(value >> 24), isSecure);
                     FindPendingInterrupt();
                 }
@@ -601,6 +618,7 @@ public void WriteDoubleWord(long offset, uint value, bool isSecure)
             case Registers.SystemHandlerPriority3:
                 lock(irqs)
                 {
+                    SynchronizeNativeState();
                     SetSystemHandlerPriority(SystemException.PendSV, (byte)(value >> 16), isSecure);
                     SetSystemHandlerPriority(SystemException.SysTick, (byte)(value >> 24), isSecure);
                     FindPendingInterrupt();
@@ -712,6 +730,7 @@ public void WriteDoubleWordNonSecureAlias(long offset, uint value)
 
         public uint ReadDoubleWord(long offset, bool isSecure)
         {
+            SynchronizeNativeState();
             if(offset >= PriorityStart && offset < PriorityEnd)
             {
                 return HandlePriorityRead(offset - PriorityStart, true, isSecure);
@@ -825,12 +844,14 @@ public uint ReadDoubleWord(long offset)
 
         public void Reset()
         {
+            SynchronizeNativeState();
             RegisterCollection.Reset();
             InitInterrupts();
             for(var i = 0; i < priorities.Length; i++)
             {
                 priorities[i] = 0x00;
             }
+            nativeState?.MarkPrioritiesChanged();
             activeIRQs.Clear();
             systick.NonSecureVal.Reset();
             systick.SecureVal?.Reset();
@@ -912,12 +933,20 @@ public bool IsBFHFNMINSEnabled
         [HideInMonitor]
         public byte BASEPRI_S
         {
-            get { return basepri.SecureVal; }
+            get
+            {
+                lock(irqs)
+                {
+                    SynchronizeNativeState();
+                    return basepri.SecureVal;
+                }
+            }
 
             set
             {
                 lock(irqs)
                 {
+                    SynchronizeNativeState();
                     var normalizedValue = (byte)(value & priorityMask);
                     if(normalizedValue == basepri.SecureVal)
                     {
@@ -932,12 +961,20 @@ public byte BASEPRI_S
         [HideInMonitor]
         public byte BASEPRI_NS
         {
-            get { return basepri.NonSecureVal; }
+            get
+            {
+                lock(irqs)
+                {
+                    SynchronizeNativeState();
+                    return basepri.NonSecureVal;
+                }
+            }
 
             set
             {
                 lock(irqs)
                 {
+                    SynchronizeNativeState();
                     var normalizedValue = (byte)(value & priorityMask);
                     if(normalizedValue == basepri.NonSecureVal)
                     {
@@ -949,7 +986,17 @@ public byte BASEPRI_NS
             }
         }
 
-        public bool MaskedInterruptPresent { get { return maskedInterruptPresent; } }
+        public bool MaskedInterruptPresent
+        {
+            get
+            {
+                lock(irqs)
+                {
+                    SynchronizeNativeState();
+                    return maskedInterruptPresent;
+                }
+            }
+        }
 
         public bool PauseInsteadOfReset { get; set; }
 
@@ -1248,6 +1295,7 @@ private void DefineRegisters()
                     {
                         targetInterruptSecurityState[(int)excp] = sec;
                     }
+                    nativeState?.MarkPrioritiesChanged();
                     FindPendingInterrupt();
                 },
                 valueProviderCallback: _ => IsBFHFNMINSEnabled,
@@ -1779,6 +1827,7 @@ private void InitInterrupts()
         {
             irqs.Clear();
             Array.Clear(targetInterruptSecurityState, 0, targetInterruptSecurityState.Length);
+            nativeState?.MarkPrioritiesChanged();
             for(var i = 0; i < 16; i++)
             {
                 irqs[i] = IRQState.Enabled;
@@ -1797,6 +1846,7 @@ private void InitInterrupts()
             maskedInterruptPresent = false;
             prioritizeSecureInterrupts = false;
             pendingIRQs.Clear();
+            InvalidateNativeState();
         }
 
         private void SetSystemHandlerPriority(SystemException exception, byte value, bool isSecure)
@@ -1819,6 +1869,8 @@ private void SetSystemHandlerPriority(SystemException exception, byte value, boo
                     ExceptionToString(number), value, priorityMask);
             }
             priorities[number] = normalizedValue;
+            nativeState?.MarkPrioritiesChanged();
+            InvalidateNativeState();
             this.DebugLog("Priority 0x{0:X} set for interrupt {1}.", normalizedValue, ExceptionToString(number));
         }
 
@@ -1826,6 +1878,7 @@ private void HandlePriorityWrite(long offset, bool externalInterrupt, uint value
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var startingInterrupt = GetStartingInterrupt(offset, externalInterrupt);
                 for(var i = startingInterrupt; i < startingInterrupt + 4; i++)
                 {
@@ -1842,6 +1895,7 @@ private void HandlePriorityWrite(long offset, bool externalInterrupt, uint value
                     }
 
                     priorities[i] = (byte)(value & priorityMask);
+                    nativeState?.MarkPrioritiesChanged();
 
                     this.DebugLog("Priority 0x{0:X} set for interrupt {1}.", priorities[i], i);
                     value >>= 8;
@@ -1854,6 +1908,7 @@ private uint HandlePriorityRead(long offset, bool externalInterrupt, bool isSecu
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var returnValue = 0u;
                 var startingInterrupt = GetStartingInterrupt(offset, externalInterrupt);
                 for(var i = startingInterrupt + 3; i >= startingInterrupt; i--)
@@ -2164,6 +2219,7 @@ private void EnableOrDisableInterrupt(int offset, uint value, bool enable, bool
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var firstIRQNo = 8 * offset + 16;  // 16 is added because this is HW interrupt
                 {
                     var lastIRQNo = firstIRQNo + 31;
@@ -2201,6 +2257,7 @@ private uint HandleEnableRead(int offset, bool isSecure)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var firstIRQNo = 8 * offset + 16;
                 var lastIRQNo = firstIRQNo + 31;
                 var result = 0u;
@@ -2238,6 +2295,7 @@ private void SetPendingWithoutEscalation(int i)
             var before = irqs[i];
             irqs[i] |= IRQState.Pending;
             pendingIRQs.Add(i);
+            InvalidateNativeState();
 
             // when SEVONPEND is set all interrupts (even those masked)
             // generate an event when entering the pending state
@@ -2377,6 +2435,16 @@ private void RestoreAcknowledgedExceptionAsPending(int originalException)
             }
         }
 
+        private void ActivateIRQ(int number)
+        {
+            irqs[number] |= IRQState.Active;
+            irqs[number] &= ~IRQState.Pending;
+            pendingIRQs.Remove(number);
+            this.NoisyLog("Acknowledged IRQ {0}.", ExceptionToString(number));
+            activeIRQs.Push(number);
+            InvalidateNativeState();
+        }
+
         private void DeactivateIRQ(int number)
         {
             DebugHelper.Assert(activeIRQs.Count > 0 && activeIRQs.Peek() == number);
@@ -2385,6 +2453,7 @@ private void DeactivateIRQ(int number)
 
             irqs[number] &= ~IRQState.Active;
             activeIRQs.Pop();
+            InvalidateNativeState();
             if((currentIRQ & IRQState.Running) > 0)
             {
                 this.NoisyLog("Completed IRQ {0} active -> pending.", ExceptionToString(number));
@@ -2401,15 +2470,106 @@ private void DeactivateIRQ(int number)
             }
         }
 
+        private void InvalidateNativeState()
+        {
+            nativeState?.Invalidate();
+        }
+
+        // Mirrors the state used for arbitration to the native library, together with the outputs it resulted in
+        private void PublishNativeState(bool irqLine, bool maskedInterruptPresent)
+        {
+            if(cpu == null)
+            {
+                return;
+            }
+            if(nativeState == null)
+            {
+                nativeState = new NVICNativeStatePublisher(cpu, exceptionNumbersBySlot, AdjustPriority, GetGroupPriority);
+            }
+
+            nativeState.Clear();
+            foreach(var i in pendingIRQs)
+            {
+                if(IsCandidate(irqs[i]))
+                {
+                    nativeState.AddCandidate(ExceptionSimpleArray<IRQState>.GetSlot(i));
+                }
+            }
+            foreach(var i in activeIRQs)
+            {
+                var state = irqs[i];
+                var enabled = (state & IRQState.Enabled) != 0;
+                nativeState.AddActive(ExceptionSimpleArray<IRQState>.GetSlot(i), enabled && (state & IRQState.Pending) != 0, enabled && (state & IRQState.Running) != 0);
+            }
+
+            var flags = isLockedUp ? NVICNativeFlags.LockedUp : NVICNativeFlags.None;
+            if(cpu.TrustZoneEnabled)
+            {
+                flags |= NVICNativeFlags.TrustZone;
+                flags |= prioritizeSecureInterrupts ? NVICNativeFlags.PrioritizeSecure : NVICNativeFlags.None;
+                flags |= IsBFHFNMINSEnabled ? NVICNativeFlags.BFHFNMINS : NVICNativeFlags.None;
+            }
+            var secureBasepri = cpu.TrustZoneEnabled ? basepri.SecureVal : (byte)0;
+            var secureBinaryPoint = cpu.TrustZoneEnabled ? binaryPointPosition.SecureVal : 0;
+            nativeState.Publish(binaryPointPosition.NonSecureVal, secureBinaryPoint, basepri.NonSecureVal, secureBasepri, priorityMask,
+                flags, irqLine, maskedInterruptPresent);
+        }
+
+        // Applies what the native library did on the published state since it was published, has to be done before the NVIC uses its own one
+        private void SynchronizeNativeState()
+        {
+            lock(irqs)
+            {
+                if(nativeState == null || !nativeState.TryTakeOperation(out var operation))
+                {
+                    return;
+                }
+                do
+                {
+                    switch(operation.Type)
+                    {
+                    case NVICNativeOperationType.Acknowledge:
+                        ActivateIRQ(operation.Argument);
+                        break;
+                    case NVICNativeOperationType.Complete:
+                        DeactivateIRQ(operation.Argument);
+                        break;
+                    case NVICNativeOperationType.WriteNonSecureBasepri:
+                        basepri.NonSecureVal = (byte)operation.Argument;
+                        break;
+                    case NVICNativeOperationType.WriteSecureBasepri:
+                        basepri.SecureVal = (byte)operation.Argument;
+                        break;
+                    default:
+                        throw new InvalidOperationException($"Invalid native NVIC operation: {operation.Type}");
+                    }
+                }
+                while(nativeState.TryTakeOperation(out operation));
+
+                // The native library only lowers the IRQ line, this brings the GPIO up to date
+                nativeState.GetOutputs(out var irqLine, out var canWakeFromWfi);
+                IRQ.Set(irqLine);
+                maskedInterruptPresent = canWakeFromWfi;
+            }
+        }
+
+        [PreSerialization]
+        private void SynchronizeNativeStateBeforeSerialization()
+        {
+            SynchronizeNativeState();
+        }
+
         private void ClearPending(int i)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 if((irqs[i] & IRQState.Running) == 0)
                 {
                     this.DebugLog("Cleared pending IRQ {0}.", ExceptionToString(i));
                     irqs[i] &= ~IRQState.Pending;
                     pendingIRQs.Remove(i);
+                    InvalidateNativeState();
                 }
                 else
                 {
@@ -2422,6 +2582,7 @@ private void SetOrClearPendingInterrupt(int offset, uint value, bool set, bool i
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var firstIRQNo = 8 * offset + 16;  // 16 is added because this is HW interrupt
                 {
                     var lastIRQNo = firstIRQNo + 31;
@@ -2456,6 +2617,7 @@ private void ModifySecurityTarget(int offset, uint value)
         {
             lock(irqs)
             {
+                SynchronizeNativeState();
                 var mask = 1u;
                 // Only HW interrupts are modified by this
                 for(var i = 0; i < 32; i++)
@@ -2465,6 +2627,7 @@ private void ModifySecurityTarget(int offset, uint value)
                     targetInterruptSecurityState[pos] = (value & mask) > 0 ? InterruptTargetSecurityState.NonSecure : InterruptTargetSecurityState.Secure;
                     mask <<= 1;
                 }
+                nativeState?.MarkPrioritiesChanged();
                 FindPendingInterrupt();
             }
         }
@@ -2747,6 +2910,10 @@ private bool IsCurrentCPUInSecureState(out ICPU currentCpu)
 
         private readonly ExceptionSimpleArray<IRQState> irqs;
 
+        // Created when the state is first published, it's recreated after deserialization as the native state is lost
+        [Transient]
+        private NVICNativeStatePublisher nativeState;
+
         // This is configurable through NVIC_ITNSx only for Hardware Interrupts (exception numbered 16 and above)
         // for configuring selected exceptions, look at AIRCR.BFHFNMINS
         // for other exceptions, this will be completely ignored
@@ -2999,6 +3166,12 @@ public void Clear()
 
             public int Length => container.Length;
 
+            // The index used for the exception, the Secure banked ones are placed after all the others
+            public static int GetSlot(int exception)
+            {
+                return MapSystemExceptionToInteger(exception);
+            }
+
             private static int MapSystemExceptionToInteger(int exception)
             {
                 if(exception < BankedExcpSecureBit)
@@ -3247,5 +3420,17 @@ private enum SystemException
             SystemException.UsageFault,
             SystemException.UsageFault_S,
         };
+
+        // Exception numbers in the order of ExceptionSimpleArray, which identifies them in the native state
+        private static readonly int[] exceptionNumbersBySlot = Enumerable.Range(0, IRQCount).Concat(new int []
+        {
+            (int)SystemException.MemManageFault_S,
+            (int)SystemException.UsageFault_S,
+            (int)SystemException.SuperVisorCall_S,
+            (int)SystemException.PendSV_S,
+            (int)SystemException.SysTick_S,
+            (int)SystemException.HardFault_S,
+            (int)SystemException.DebugMonitor_S,
+        }).ToArray();
     }
 }
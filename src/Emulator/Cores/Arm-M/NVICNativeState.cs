@@ -0,0 +1,290 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+
+namespace Antmicro.Renode.Peripherals.IRQControllers
+{
+    // Implemented by CortexM, whose native library arbitrates tlib's pending interrupt queries on the published state.
+    // It also acknowledges and completes exceptions and writes BASEPRI on it, recording these operations for the NVIC to apply.
+    // Exceptions are identified by slots, which are their numbers except for the Secure banked ones placed after all the others.
+    public interface INVICNativeState
+    {
+        void BeginNvicStateUpdate();
+
+        void SetNvicCandidateExceptions(int word, ulong bits);
+
+        void SetNvicActiveExceptions(int word, ulong bits);
+
+        void SetNvicRunningExceptions(int word, ulong bits);
+
+        void SetNvicPendingActiveExceptions(int word, ulong bits);
+
+        void SetNvicActiveStackEntry(int index, int slot);
+
+        void SetNvicExceptionNumber(int slot, int number);
+
+        void SetNvicPriority(int slot, int priority, int groupPriority);
+
+        void SetNvicPriorityBoostState(byte nonSecureBasepri, byte secureBasepri, int nonSecureBinaryPoint, int secureBinaryPoint);
+
+        void SetNvicExecutionState(NVICNativeFlags flags, int activeDepth, byte priorityMask);
+
+        void EndNvicStateUpdate(bool irqLine, bool maskedInterruptPresent);
+
+        void InvalidateNvicState();
+
+        // Also invalidates the native state
+        ulong TakeNvicOperation();
+
+        uint GetNvicOutputs();
+    }
+
+    // Publishes the state the NVIC arbitrates on, keeping what was sent last, so that only the bitmap words, active stack
+    // entries and priorities that changed are sent. The native state starts zeroed and isn't serialized.
+    public class NVICNativeStatePublisher
+    {
+        public NVICNativeStatePublisher(INVICNativeState target, IReadOnlyList<int> exceptionNumbers, Func<int, int> getPriority, Func<int, int> getGroupPriority)
+        {
+            this.target = target;
+            this.exceptionNumbers = exceptionNumbers;
+            this.getPriority = getPriority;
+            this.getGroupPriority = getGroupPriority;
+            var words = (exceptionNumbers.Count + 63) / 64;
+            candidates = new ulong[words];
+            active = new ulong[words];
+            running = new ulong[words];
+            pendingActive = new ulong[words];
+            publishedCandidates = new ulong[words];
+            publishedActive = new ulong[words];
+            publishedRunning = new ulong[words];
+            publishedPendingActive = new ulong[words];
+            activeStack = new int[exceptionNumbers.Count];
+            publishedActiveStack = new int[exceptionNumbers.Count];
+            publishedPriorities = new int[exceptionNumbers.Count];
+            publishedGroupPriorities = new int[exceptionNumbers.Count];
+            prioritiesChanged = true;
+        }
+
+        public void Invalidate()
+        {
+            target.InvalidateNvicState();
+        }
+
+        public void MarkPrioritiesChanged()
+        {
+            prioritiesChanged = true;
+        }
+
+        // Operations are only done on a published state, the NVIC has to apply them before using its own one.
+        // Taking the first of them invalidates the native state until the next publication.
+        public bool TryTakeOperation(out NVICNativeOperation operation)
+        {
+            operation = default(NVICNativeOperation);
+            if(!mayHaveOperations)
+            {
+                return false;
+            }
+            operation = new NVICNativeOperation(target.TakeNvicOperation());
+            if(operation.Type == NVICNativeOperationType.None)
+            {
+                mayHaveOperations = false;
+                return false;
+            }
+            // The native state was changed by the operation, what was sent last is no longer known
+            publishedStateLost = true;
+            return true;
+        }
+
+        public void GetOutputs(out bool irqLine, out bool maskedInterruptPresent)
+        {
+            var outputs = target.GetNvicOutputs();
+            irqLine = (outputs & 1) != 0;
+            maskedInterruptPresent = (outputs & 2) != 0;
+        }
+
+        // Starts collecting the state for the next Publish
+        public void Clear()
+        {
+            Array.Clear(candidates, 0, candidates.Length);
+            Array.Clear(active, 0, active.Length);
+            Array.Clear(running, 0, running.Length);
+            Array.Clear(pendingActive, 0, pendingActive.Length);
+            activeDepth = 0;
+        }
+
+        public void AddCandidate(int slot)
+        {
+            SetBit(candidates, slot);
+        }
+
+        // Has to be called for the active exceptions in the order of the active stack, starting from its top
+        public void AddActive(int slot, bool pending, bool running)
+        {
+            SetBit(active, slot);
+            if(pending)
+            {
+                SetBit(pendingActive, slot);
+            }
+            if(running)
+            {
+                SetBit(this.running, slot);
+            }
+            activeStack[activeDepth++] = slot;
+        }
+
+        public void Publish(int nonSecureBinaryPoint, int secureBinaryPoint, byte nonSecureBasepri, byte secureBasepri, byte priorityMask,
+            NVICNativeFlags flags, bool irqLine, bool maskedInterruptPresent)
+        {
+            // Priorities depend on the grouping and the Security configuration
+            if(nonSecureBinaryPoint != publishedNonSecureBinaryPoint || secureBinaryPoint != publishedSecureBinaryPoint
+                || (flags & ~NVICNativeFlags.LockedUp) != (publishedFlags & ~NVICNativeFlags.LockedUp))
+            {
+                prioritiesChanged = true;
+            }
+
+            target.BeginNvicStateUpdate();
+            if(!exceptionNumbersPublished)
+            {
+                for(var slot = 0; slot < exceptionNumbers.Count; slot++)
+                {
+                    if(exceptionNumbers[slot] != slot)
+                    {
+                        target.SetNvicExceptionNumber(slot, exceptionNumbers[slot]);
+                    }
+                }
+                exceptionNumbersPublished = true;
+            }
+            for(var word = 0; word < candidates.Length; word++)
+            {
+                if(publishedStateLost || candidates[word] != publishedCandidates[word])
+                {
+                    publishedCandidates[word] = candidates[word];
+                    target.SetNvicCandidateExceptions(word, candidates[word]);
+                }
+                if(publishedStateLost || active[word] != publishedActive[word])
+                {
+                    publishedActive[word] = active[word];
+                    target.SetNvicActiveExceptions(word, active[word]);
+                }
+                if(publishedStateLost || running[word] != publishedRunning[word])
+                {
+                    publishedRunning[word] = running[word];
+                    target.SetNvicRunningExceptions(word, running[word]);
+                }
+                if(publishedStateLost || pendingActive[word] != publishedPendingActive[word])
+                {
+                    publishedPendingActive[word] = pendingActive[word];
+                    target.SetNvicPendingActiveExceptions(word, pendingActive[word]);
+                }
+            }
+            // The native stack starts from the bottom
+            for(var i = 0; i < activeDepth; i++)
+            {
+                var slot = activeStack[activeDepth - 1 - i];
+                if(publishedStateLost || slot != publishedActiveStack[i])
+                {
+                    publishedActiveStack[i] = slot;
+                    target.SetNvicActiveStackEntry(i, slot);
+                }
+            }
+            if(prioritiesChanged)
+            {
+                for(var slot = 0; slot < publishedPriorities.Length; slot++)
+                {
+                    var priority = getPriority(exceptionNumbers[slot]);
+                    var groupPriority = getGroupPriority(exceptionNumbers[slot]);
+                    if(priority != publishedPriorities[slot] || groupPriority != publishedGroupPriorities[slot])
+                    {
+                        publishedPriorities[slot] = priority;
+                        publishedGroupPriorities[slot] = groupPriority;
+                        target.SetNvicPriority(slot, priority, groupPriority);
+                    }
+                }
+                prioritiesChanged = false;
+            }
+            target.SetNvicPriorityBoostState(nonSecureBasepri, secureBasepri, nonSecureBinaryPoint, secureBinaryPoint);
+            target.SetNvicExecutionState(flags, activeDepth, priorityMask);
+            target.EndNvicStateUpdate(irqLine, maskedInterruptPresent);
+
+            publishedNonSecureBinaryPoint = nonSecureBinaryPoint;
+            publishedSecureBinaryPoint = secureBinaryPoint;
+            publishedFlags = flags;
+            publishedStateLost = false;
+            mayHaveOperations = true;
+        }
+
+        private void SetBit(ulong[] bitmap, int slot)
+        {
+            if(slot < publishedPriorities.Length)
+            {
+                bitmap[slot / 64] |= 1UL << (slot % 64);
+            }
+        }
+
+        private bool prioritiesChanged;
+        private bool exceptionNumbersPublished;
+        private bool publishedStateLost;
+        private bool mayHaveOperations;
+        private int activeDepth;
+        private int publishedNonSecureBinaryPoint;
+        private int publishedSecureBinaryPoint;
+        private NVICNativeFlags publishedFlags;
+
+        private readonly INVICNativeState target;
+        private readonly IReadOnlyList<int> exceptionNumbers;
+        private readonly Func<int, int> getPriority;
+        private readonly Func<int, int> getGroupPriority;
+        private readonly ulong[] candidates;
+        private readonly ulong[] active;
+        private readonly ulong[] running;
+        private readonly ulong[] pendingActive;
+        private readonly ulong[] publishedCandidates;
+        private readonly ulong[] publishedActive;
+        private readonly ulong[] publishedRunning;
+        private readonly ulong[] publishedPendingActive;
+        private readonly int[] activeStack;
+        private readonly int[] publishedActiveStack;
+        private readonly int[] publishedPriorities;
+        private readonly int[] publishedGroupPriorities;
+    }
+
+    public struct NVICNativeOperation
+    {
+        public NVICNativeOperation(ulong encoded)
+        {
+            Type = (NVICNativeOperationType)(encoded >> 32);
+            Argument = unchecked((int)encoded);
+        }
+
+        public NVICNativeOperationType Type { get; }
+
+        // The exception number, or the normalized BASEPRI value
+        public int Argument { get; }
+    }
+
+    // Has to match nvic_operation_type_t in renode_arm_callbacks.c
+    public enum NVICNativeOperationType
+    {
+        None,
+        Acknowledge,
+        Complete,
+        WriteNonSecureBasepri,
+        WriteSecureBasepri,
+    }
+
+    // Has to match NVIC_FLAG_* in renode_arm_callbacks.c
+    [Flags]
+    public enum NVICNativeFlags : uint
+    {
+        None = 0,
+        LockedUp = 1 << 0,
+        TrustZone = 1 << 1,
+        PrioritizeSecure = 1 << 2,
+        BFHFNMINS = 1 << 3,
+    }
+}
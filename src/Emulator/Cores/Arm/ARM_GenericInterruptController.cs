@@ -69,7 +69,7 @@ public ARM_GenericInterruptController(IMachine machine, bool supportsTwoSecurity
 
             foreach(var irq in sharedInterrupts.Values)
             {
-                irq.State.OnPendingChange += UpdatePendingInterruptsListHandler(irq);
+                SubscribeToInterruptChanges(irq);
             }
 
             var groupTypes = new[]
@@ -305,17 +305,31 @@ public uint ReadDoubleWordFromCPUInterface(long offset)
 
         public void WriteSystemRegisterCPUInterface(uint offset, ulong value)
         {
-            LockExecuteAndUpdate(() =>
-                LogWriteAccess(cpuInterfaceSystemRegisters.TryWrite(offset, value), value, "CPU Interface", offset, (CPUInterfaceSystemRegisters)offset)
-            );
+            Action write = () =>
+                LogWriteAccess(cpuInterfaceSystemRegisters.TryWrite(offset, value), value, "CPU Interface", offset, (CPUInterfaceSystemRegisters)offset);
+            if(IsSystemRegisterChangingInterruptStatesOnly(offset))
+            {
+                LockExecuteAndUpdateChangedCPUs(GetAskingCPUEntry(), write);
+            }
+            else
+            {
+                LockExecuteAndUpdate(write);
+            }
         }
 
         public ulong ReadSystemRegisterCPUInterface(uint offset)
         {
             ulong value = 0;
-            LockExecuteAndUpdate(() =>
-                LogReadAccess(cpuInterfaceSystemRegisters.TryRead(offset, out value), value, "CPU Interface", offset, (CPUInterfaceSystemRegisters)offset)
-            );
+            Action read = () =>
+                LogReadAccess(cpuInterfaceSystemRegisters.TryRead(offset, out value), value, "CPU Interface", offset, (CPUInterfaceSystemRegisters)offset);
+            if(IsSystemRegisterChangingInterruptStatesOnly(offset))
+            {
+                LockExecuteAndUpdateChangedCPUs(GetAskingCPUEntry(), read);
+            }
+            else
+            {
+                LockExecuteAndUpdate(read);
+            }
             return value;
         }
 
@@ -362,11 +376,12 @@ public void LockExecuteAndUpdate(Action action)
             lock(locker)
             {
                 action();
-                UpdateBestPendingInterrupts();
                 foreach(var cpu in cpuEntries.Values)
                 {
+                    UpdateBestPendingInterrupts(cpu);
                     cpu.UpdateSignals();
                 }
+                ClearInterruptChanges();
             }
         }
 
@@ -685,6 +700,26 @@ public bool AffinityRoutingEnabledNonSecure
 
         public event Action<IARMSingleSecurityStateCPU> CPUAttached;
 
+        // Accesses to these registers change nothing but states of interrupts and the CPU interface of the asking CPU,
+        // these are the ones frequent during SGI storms and interrupt handling
+        private static bool IsSystemRegisterChangingInterruptStatesOnly(uint offset)
+        {
+            switch((CPUInterfaceSystemRegisters)offset)
+            {
+            case CPUInterfaceSystemRegisters.InterruptAcknowledgeGroup0:
+            case CPUInterfaceSystemRegisters.InterruptAcknowledgeGroup1:
+            case CPUInterfaceSystemRegisters.InterruptEndGroup0:
+            case CPUInterfaceSystemRegisters.InterruptEndGroup1:
+            case CPUInterfaceSystemRegisters.InterruptDeactivate:
+            case CPUInterfaceSystemRegisters.SoftwareGeneratedInterruptGroup0Generate:
+            case CPUInterfaceSystemRegisters.SoftwareGeneratedInterruptGroup1Generate:
+            case CPUInterfaceSystemRegisters.SoftwareGeneratedInterruptGroup1GenerateAlias:
+                return true;
+            default:
+                return false;
+            }
+        }
+
         private uint GetProcessorNumber(ICPU cpu)
         {
             if(ArchitectureVersion == ARM_GenericInterruptControllerVersion.GICv1)
@@ -706,7 +741,7 @@ private void OnPrivateInterrupt(CPUEntry cpu, int id, bool value)
                 return;
             }
             this.Log(LogLevel.Debug, "Setting Private Peripheral Interrupt #{0} signal to {1} for {2}", irqId, value, cpu.Name);
-            LockExecuteAndUpdate(() =>
+            LockExecuteAndUpdateChangedCPUs(null, () =>
                 cpu.PrivatePeripheralInterrupts[irqId].State.AssertAsPending(value)
             );
         }
@@ -898,70 +933,161 @@ private void OnExecutionModeChanged(CPUEntry cpu)
             }
         }
 
-        // Returns the best pending interrupt for given candidates.
-        // If null is returned, that means there's no pending interrupt.
-        private T FindBestPendingInterrupt<T>(IEnumerable<T> pendingCandidates) where T : Interrupt
+        // Used for the accesses which can only change states of interrupts and the CPU interface of `askingCPU`, i.e. signaling PPIs,
+        // requesting SGIs, acknowledging, ending and deactivating interrupts. Only `askingCPU` and the owners of the changed SGIs and PPIs
+        // are updated then, so the cost of these accesses doesn't grow with the number of CPUs unless an SPI changes.
+        // The accesses still take the lock shared with all the other ones, delivering SGIs and PPIs without it would require
+        // all the state the best pending interrupts depend on to be safe to read concurrently.
+        private void LockExecuteAndUpdateChangedCPUs(CPUEntry askingCPU, Action action)
         {
-            var bestPending = pendingCandidates.FirstOrDefault();
-            foreach(var irq in pendingCandidates.Skip(1))
+            lock(locker)
             {
-                if(irq.Config.Priority < bestPending.Config.Priority)
+                action();
+                if(sharedInterruptsChanged)
                 {
-                    bestPending = irq;
-                    if(bestPending.Config.Priority == InterruptPriority.Highest)
+                    foreach(var cpu in cpuEntries.Values)
                     {
-                        break;
+                        UpdateBestPendingInterrupts(cpu);
+                        cpu.UpdateSignals();
+                    }
+                }
+                else
+                {
+                    if(askingCPU != null && !askingCPU.InterruptsChanged)
+                    {
+                        UpdateBestPendingInterrupts(askingCPU);
+                        askingCPU.UpdateSignals();
+                    }
+                    foreach(var cpu in cpusWithChangedInterrupts)
+                    {
+                        UpdateBestPendingInterrupts(cpu);
+                        cpu.UpdateSignals();
                     }
                 }
+                ClearInterruptChanges();
             }
-            return bestPending;
         }
 
-        private void UpdateBestPendingInterrupts()
+        private void UpdateBestPendingInterrupts(CPUEntry cpu)
         {
-            foreach(var cpu in cpuEntries.Values)
+            if(cpu.VirtualCPUInterfaceEnabled)
+            {
+                cpu.BestPendingVirtual = FindBestPendingVirtualInterrupt(cpu);
+            }
+            else
             {
-                if(cpu.VirtualCPUInterfaceEnabled)
+                cpu.BestPendingVirtual = null;
+            }
+            cpu.BestPending = FindBestPendingInterrupt(cpu);
+        }
+
+        // Returns the best pending interrupt which can be signaled to the given CPU.
+        // If null is returned, that means there's no such interrupt.
+        // The priorities with pending interrupts are visited from the highest one, so usually only the first of them is checked.
+        // Of the interrupts with equal priorities the CPU's own SGIs and PPIs go first, then the one which became pending first wins.
+        private Interrupt FindBestPendingInterrupt(CPUEntry cpu)
+        {
+            var priorityMask = cpu.PhysicalPriorityMask;
+            var runningPriority = cpu.RunningInterrupts.PhysicalPriority;
+            var priorityLimit = (int)(priorityMask < runningPriority ? priorityMask : runningPriority);
+            var privateInterrupts = cpu.PendingPrivateInterrupts;
+            var privatePriority = privateInterrupts.FindNextPriority(0);
+            var sharedPriority = pendingSharedInterrupts.FindNextPriority(0);
+            bool? affinityRoutingEnabled = null;
+
+            while(true)
+            {
+                var priority = Math.Min(privatePriority, sharedPriority);
+                if(priority >= priorityLimit)
                 {
-                    cpu.BestPendingVirtual = FindBestPendingInterrupt(GetAllPendingCandidateVirtualInterrupts(cpu));
+                    return null;
                 }
-                else
+                if(privatePriority == priority)
+                {
+                    foreach(var irq in privateInterrupts.GetInterrupts(priority))
+                    {
+                        if(IsPendingCandidate(irq, cpu))
+                        {
+                            return irq;
+                        }
+                    }
+                    privatePriority = privateInterrupts.FindNextPriority(priority + 1);
+                }
+                if(sharedPriority == priority)
                 {
-                    cpu.BestPendingVirtual = null;
+                    foreach(SharedInterrupt irq in pendingSharedInterrupts.GetInterrupts(priority))
+                    {
+                        if(IsPendingCandidate(irq, cpu))
+                        {
+                            affinityRoutingEnabled = affinityRoutingEnabled ?? IsAffinityRoutingEnabled(cpu);
+                            if(IsSharedInterruptTargetingCPU(irq, cpu, affinityRoutingEnabled.Value))
+                            {
+                                return irq;
+                            }
+                        }
+                    }
+                    sharedPriority = pendingSharedInterrupts.FindNextPriority(priority + 1);
+                }
+            }
+        }
+
+        private VirtualInterrupt FindBestPendingVirtualInterrupt(CPUEntry cpu)
+        {
+            var priorityMask = cpu.VirtualPriorityMask;
+            var runningPriority = cpu.RunningInterrupts.VirtualPriority;
+            var bestPriority = priorityMask < runningPriority ? priorityMask : runningPriority;
+            VirtualInterrupt bestPending = null;
+
+            foreach(var irq in cpu.VirtualInterrupts)
+            {
+                if(irq.State.Pending && !irq.State.Active && irq.Config.Priority < bestPriority
+                    && cpu.Groups.Virtual.TryGetValue(irq.Config.GroupType, out var group) && group.Enabled)
+                {
+                    bestPending = irq;
+                    bestPriority = irq.Config.Priority;
+                    if(bestPriority == InterruptPriority.Highest)
+                    {
+                        break;
+                    }
                 }
-                cpu.BestPending = FindBestPendingInterrupt(GetAllPendingCandidateInterrupts(cpu));
             }
+            return bestPending;
         }
 
-        private IEnumerable<Interrupt> GetSharedInterruptsTargetingCPU(CPUEntry cpu) =>
-            FilterSharedInterruptsTargetingCPU(sharedInterrupts.Values, cpu);
+        private bool IsPendingCandidate(Interrupt irq, CPUEntry cpu)
+        {
+            // The cheapest checks go first, most of the candidates are rejected by them
+            return !irq.State.Active && irq.Config.Enabled && IsGroupEnabled(irq.Config.GroupType, cpu);
+        }
 
-        private IEnumerable<Interrupt> GetPendingSharedInterruptsTargetingCPU(CPUEntry cpu) =>
-            FilterSharedInterruptsTargetingCPU(pendingInterrupts.OfType<SharedInterrupt>(), cpu);
+        private bool IsGroupEnabled(GroupType type, CPUEntry cpu)
+        {
+            return groups.TryGetValue(type, out var group) && group.Enabled && cpu.Groups.Physical[type].Enabled;
+        }
+
+        private IEnumerable<Interrupt> GetSharedInterruptsTargetingCPU(CPUEntry cpu)
+        {
+            var affinityRoutingEnabled = IsAffinityRoutingEnabled(cpu);
+            return sharedInterrupts.Values.Where(irq => IsSharedInterruptTargetingCPU(irq, cpu, affinityRoutingEnabled));
+        }
 
         private Func<Interrupt, bool> GetInterruptEnabledFilter(CPUEntry cpu)
         {
-            var enabledGroups = groups.Keys.Where(type => groups[type].Enabled && cpu.Groups.Physical[type].Enabled).ToArray();
-            return irq => irq.Config.Enabled && enabledGroups.Contains(irq.Config.GroupType);
+            return irq => irq.Config.Enabled && IsGroupEnabled(irq.Config.GroupType, cpu);
         }
 
-        private IEnumerable<Interrupt> FilterSharedInterruptsTargetingCPU(IEnumerable<SharedInterrupt> interrupts, CPUEntry cpu)
+        private bool IsSharedInterruptTargetingCPU(SharedInterrupt irq, CPUEntry cpu, bool affinityRoutingEnabled)
         {
             if(cpuEntries.Count == 1)
             {
                 // If there is only one CPU all interrupts target it.
-                return interrupts;
+                return true;
             }
-            if(!IsAffinityRoutingEnabled(cpu))
+            if(!affinityRoutingEnabled)
             {
-                return interrupts.Where(irq =>
-                    irq.IsLegacyRoutingTargetingCPU(cpu) && (!ForceLowestIdCpuAsInterruptTarget || irq.IsLowestLegacyRoutingTargettedCPU(cpu))
-                );
+                return irq.IsLegacyRoutingTargetingCPU(cpu) && (!ForceLowestIdCpuAsInterruptTarget || irq.IsLowestLegacyRoutingTargettedCPU(cpu));
             }
-
-            return interrupts.Where(irq =>
-                irq.IsAffinityRoutingTargetingCPU(cpu) && (!ForceLowestIdCpuAsInterruptTarget || irq.IsLowestAffinityRoutingTargettedCPU(cpu, this))
-            );
+            return irq.IsAffinityRoutingTargetingCPU(cpu) && (!ForceLowestIdCpuAsInterruptTarget || irq.IsLowestAffinityRoutingTargettedCPU(cpu, this));
         }
 
         private IEnumerable<Interrupt> GetAllEnabledInterrupts(CPUEntry cpu)
@@ -976,31 +1102,6 @@ private IEnumerable<Interrupt> GetAllInterrupts(CPUEntry cpu)
             return cpu.AllPrivateAndSoftwareGeneratedInterrupts.Concat(sharedInterrupts.Values);
         }
 
-        private Func<Interrupt, bool> InterruptPriorityFilter(InterruptPriority priorityMask, InterruptPriority runningPriority)
-        {
-            return irq => irq.State.Pending && !irq.State.Active && irq.Config.Priority < priorityMask && irq.Config.Priority < runningPriority;
-        }
-
-        private IEnumerable<Interrupt> GetAllPendingCandidateInterrupts(CPUEntry cpu)
-        {
-            var filter = InterruptPriorityFilter(cpu.PhysicalPriorityMask, cpu.RunningInterrupts.PhysicalPriority);
-
-            return pendingInterrupts
-                .Where(irq => !irq.IsShared && irq.Owner == cpu)
-                .Concat(GetPendingSharedInterruptsTargetingCPU(cpu))
-                .Where(GetInterruptEnabledFilter(cpu))
-                .Where(filter);
-        }
-
-        private IEnumerable<VirtualInterrupt> GetAllPendingCandidateVirtualInterrupts(CPUEntry cpu)
-        {
-            var enabledGroups = groups.Keys.Where(type => cpu.Groups.Virtual[type].Enabled).ToArray();
-            var filter = InterruptPriorityFilter(cpu.VirtualPriorityMask, cpu.RunningInterrupts.VirtualPriority);
-            return cpu
-                .VirtualInterrupts
-                .Where(irq => enabledGroups.Contains(irq.Config.GroupType) && filter(irq));
-        }
-
         private Dictionary<long, DoubleWordRegister> BuildDistributorDoubleWordRegistersMap()
         {
             var registersMap = new Dictionary<long, DoubleWordRegister>
@@ -2091,21 +2192,65 @@ private void AddAutomaticGPIOConnections(IARMSingleSecurityStateCPU cpu)
             }
         }
 
+        private void SubscribeToInterruptChanges(Interrupt irq)
+        {
+            irq.State.OnPendingChange += UpdatePendingInterruptsListHandler(irq);
+            irq.State.OnActiveChange += () => MarkInterruptChanged(irq);
+            irq.Config.OnPriorityChange += UpdatePendingInterruptPriorityHandler(irq);
+        }
+
         private Action UpdatePendingInterruptsListHandler(Interrupt irq)
         {
             return () =>
             {
+                var queue = GetPendingInterruptsQueue(irq);
                 if(irq.State.Pending)
                 {
-                    pendingInterrupts.Add(irq);
+                    queue.Add(irq, (byte)irq.Config.Priority);
                 }
                 else
                 {
-                    pendingInterrupts.Remove(irq);
+                    queue.Remove(irq);
                 }
+                MarkInterruptChanged(irq);
             };
         }
 
+        // Any CPU may be a target of an SPI, an SGI or a PPI is only ever signaled to its owner
+        private void MarkInterruptChanged(Interrupt irq)
+        {
+            if(irq.IsShared)
+            {
+                sharedInterruptsChanged = true;
+            }
+            else if(!irq.Owner.InterruptsChanged)
+            {
+                irq.Owner.InterruptsChanged = true;
+                cpusWithChangedInterrupts.Add(irq.Owner);
+            }
+        }
+
+        private void ClearInterruptChanges()
+        {
+            foreach(var cpu in cpusWithChangedInterrupts)
+            {
+                cpu.InterruptsChanged = false;
+            }
+            cpusWithChangedInterrupts.Clear();
+            sharedInterruptsChanged = false;
+        }
+
+        private Action UpdatePendingInterruptPriorityHandler(Interrupt irq)
+        {
+            return () => GetPendingInterruptsQueue(irq).UpdatePriority(irq, (byte)irq.Config.Priority);
+        }
+
+        // SGIs and PPIs are only ever signaled to their owners, so they are kept separately for each CPU
+        private PendingInterruptsQueue<Interrupt> GetPendingInterruptsQueue(Interrupt irq)
+        {
+            return irq.IsShared ? pendingSharedInterrupts : irq.Owner.PendingPrivateInterrupts;
+        }
+
         private CPUEntry ForcedTargettingCpuForAffinityRouting
         {
             get
@@ -2123,6 +2268,7 @@ private CPUEntry ForcedTargettingCpuForAffinityRouting
         private bool disabledSecurity;
         private bool affinityRoutingEnabledSecure;
         private bool affinityRoutingEnabledNonSecure;
+        private bool sharedInterruptsChanged;
         private uint legacyCpusAttachedMask;
         private CPUEntry forcedTargettedCpuForAffinityRouting;
 
@@ -2131,7 +2277,9 @@ private CPUEntry ForcedTargettingCpuForAffinityRouting
         private readonly Dictionary<uint, IARMSingleSecurityStateCPU> cpusByProcessorNumberCache = new Dictionary<uint, IARMSingleSecurityStateCPU>();
         private readonly Dictionary<IARMSingleSecurityStateCPU, CPUEntry> cpuEntries = new Dictionary<IARMSingleSecurityStateCPU, CPUEntry>();
 
-        private readonly List<Interrupt> pendingInterrupts = new List<Interrupt>();
+        private readonly PendingInterruptsQueue<Interrupt> pendingSharedInterrupts = new PendingInterruptsQueue<Interrupt>();
+        // Owners of the SGIs and PPIs changed since the CPUs were last updated, see `LockExecuteAndUpdateChangedCPUs`
+        private readonly List<CPUEntry> cpusWithChangedInterrupts = new List<CPUEntry>();
 
         private readonly List<IGPIO> automaticallyConnectedGPIOs = new List<IGPIO>();
         private readonly InterruptSignalType[] supportedInterruptSignals;
@@ -2296,7 +2444,7 @@ public CPUEntry(ARM_GenericInterruptController gic, IARMSingleSecurityStateCPU c
                 PrivatePeripheralInterrupts = new ReadOnlyDictionary<InterruptId, Interrupt>(ppiIds.ToDictionary(id => id, id => new Interrupt(id, this)));
                 foreach(var irq in PrivatePeripheralInterrupts.Values)
                 {
-                    irq.State.OnPendingChange += gic.UpdatePendingInterruptsListHandler(irq);
+                    gic.SubscribeToInterruptChanges(irq);
                 }
 
                 Groups = new GroupCollection(this, groupTypes);
@@ -2606,6 +2754,10 @@ public InterruptPriority PriorityMask
 
             public Interrupt BestPending { get; set; }
 
+            public PendingInterruptsQueue<Interrupt> PendingPrivateInterrupts { get; } = new PendingInterruptsQueue<Interrupt>();
+
+            public bool InterruptsChanged { get; set; }
+
             public bool VirtualFIQEnabled { get; set; }
 
             public bool VirtualCPUInterfaceEnabled { get; set; }
@@ -2714,7 +2866,8 @@ protected virtual InterruptSignalType GetBestPendingInterruptSignalType()
                 var irqs = new ReadOnlyDictionary<InterruptId, SoftwareGeneratedInterrupt>(configs.ToDictionary(config => config.Key, config => new SoftwareGeneratedInterrupt(config.Key, config.Value, requester, this)));
                 foreach(var irq in irqs.Values)
                 {
-                    irq.State.OnPendingChange += gic.UpdatePendingInterruptsListHandler(irq);
+                    // SGIs with a same requester share a config, so each of them is moved when it changes
+                    gic.SubscribeToInterruptChanges(irq);
                 }
                 return irqs;
             }
@@ -3213,7 +3366,20 @@ public void AssertAsPending(bool signal)
                 }
             }
 
-            public bool Active { get; set; }
+            public bool Active
+            {
+                get => active;
+                set
+                {
+                    if(value == active)
+                    {
+                        return;
+                    }
+
+                    active = value;
+                    OnActiveChange?.Invoke();
+                }
+            }
 
             public bool IsInactive => !Active && !Pending;
 
@@ -3248,8 +3414,11 @@ public ulong Bits
 
             public event Action OnPendingChange;
 
+            public event Action OnActiveChange;
+
             protected virtual InterruptTriggerType DefaultTriggerType => default(InterruptTriggerType);
 
+            private bool active;
             private bool pending;
         }
 
@@ -3269,7 +3438,20 @@ public virtual void Reset()
 
             public bool GroupModifierBit { get; set; }
 
-            public InterruptPriority Priority { get; set; }
+            public InterruptPriority Priority
+            {
+                get => priority;
+                set
+                {
+                    if(value == priority)
+                    {
+                        return;
+                    }
+
+                    priority = value;
+                    OnPriorityChange?.Invoke();
+                }
+            }
 
             public GroupType GroupType
             {
@@ -3289,6 +3471,10 @@ public GroupType GroupType
                     }
                 }
             }
+
+            public event Action OnPriorityChange;
+
+            private InterruptPriority priority;
         }
 
         public class Interrupt
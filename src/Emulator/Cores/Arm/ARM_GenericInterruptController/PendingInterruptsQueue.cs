@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System.Collections.Generic;
+using System.Numerics;
+
+namespace Antmicro.Renode.Peripherals.IRQControllers.ARM_GenericInterruptControllerModel
+{
+    // Keeps the pending interrupts in buckets of their priorities with a bitmap of the non-empty buckets,
+    // so that looking for the best pending interrupt starts at the highest priority with any pending interrupts
+    // instead of visiting all of them. Each bucket is kept in the order in which its interrupts became pending.
+    public class PendingInterruptsQueue<T> where T : class
+    {
+        public PendingInterruptsQueue()
+        {
+            buckets = new List<T>[PrioritiesCount];
+            nonEmptyBuckets = new ulong[PrioritiesCount / BitsPerWord];
+        }
+
+        public void Add(T irq, byte priority)
+        {
+            if(entries.ContainsKey(irq))
+            {
+                return;
+            }
+            var entry = new Entry(priority, nextSequence++);
+            entries[irq] = entry;
+            Insert(irq, entry);
+        }
+
+        public void Remove(T irq)
+        {
+            if(!entries.TryGetValue(irq, out var entry))
+            {
+                return;
+            }
+            entries.Remove(irq);
+            RemoveFromBucket(irq, entry.Priority);
+        }
+
+        // Moves the interrupt to the bucket of its new priority, where it keeps the position of when it became pending
+        public void UpdatePriority(T irq, byte priority)
+        {
+            if(!entries.TryGetValue(irq, out var entry) || entry.Priority == priority)
+            {
+                return;
+            }
+            RemoveFromBucket(irq, entry.Priority);
+            entry = new Entry(priority, entry.Sequence);
+            entries[irq] = entry;
+            Insert(irq, entry);
+        }
+
+        // Returns the first priority value starting from `priority`, i.e. the highest priority not higher than it,
+        // with any pending interrupts or `NoPriority` if there are none
+        public int FindNextPriority(int priority)
+        {
+            for(var word = priority / BitsPerWord; word < nonEmptyBuckets.Length; word++)
+            {
+                var bits = nonEmptyBuckets[word];
+                if(word == priority / BitsPerWord)
+                {
+                    bits &= ulong.MaxValue << (priority % BitsPerWord);
+                }
+                if(bits != 0)
+                {
+                    return word * BitsPerWord + BitOperations.TrailingZeroCount(bits);
+                }
+            }
+            return NoPriority;
+        }
+
+        public List<T> GetInterrupts(int priority)
+        {
+            return buckets[priority];
+        }
+
+        public const int NoPriority = PrioritiesCount;
+
+        private void Insert(T irq, Entry entry)
+        {
+            var bucket = buckets[entry.Priority];
+            if(bucket == null)
+            {
+                bucket = new List<T>();
+                buckets[entry.Priority] = bucket;
+            }
+            // Interrupts are only inserted in the middle if their priority changed while they were pending
+            var index = bucket.Count;
+            while(index > 0 && entries[bucket[index - 1]].Sequence > entry.Sequence)
+            {
+                index--;
+            }
+            bucket.Insert(index, irq);
+            nonEmptyBuckets[entry.Priority / BitsPerWord] |= 1ul << (entry.Priority % BitsPerWord);
+        }
+
+        private void RemoveFromBucket(T irq, byte priority)
+        {
+            var bucket = buckets[priority];
+            bucket.Remove(irq);
+            if(bucket.Count == 0)
+            {
+                nonEmptyBuckets[priority / BitsPerWord] &= ~(1ul << (priority % BitsPerWord));
+            }
+        }
+
+        private ulong nextSequence;
+
+        private readonly List<T>[] buckets;
+        private readonly ulong[] nonEmptyBuckets;
+        private readonly Dictionary<T, Entry> entries = new Dictionary<T, Entry>();
+
+        private const int PrioritiesCount = byte.MaxValue + 1;
+        private const int BitsPerWord = 64;
+
+        private struct Entry
+        {
+            public Entry(byte priority, ulong sequence)
+            {
+                Priority = priority;
+                Sequence = sequence;
+            }
+
+            public byte Priority { get; }
+
+            public ulong Sequence { get; }
+        }
+    }
+}
@@ -93,12 +93,32 @@ public override void Reset()
         {
             semihostingHandler?.Reset();
             base.Reset();
+            UpdateNativeSemihosting();
             foreach(var config in defaultTCMConfiguration)
             {
                 RegisterTCMRegion(config);
             }
         }
 
+        /// <summary>
+        /// Registers a 32-bit CP15 register which only stores the written value. Its accesses are handled without leaving
+        /// the translation library, unless <paramref name="writeHandler"/> is given, which is called with the new value after every write.
+        /// </summary>
+        public void RegisterStorageCP15Register(uint opc1, uint crn, uint crm, uint opc2, uint resetValue = 0, uint writableMask = uint.MaxValue, Action<ulong> writeHandler = null)
+        {
+            var instruction = new Coprocessor32BitMoveInstruction(opc1, crn, crm, opc2);
+            DeclareStorageRegister(StorageRegisterSpace.Coprocessor32BitMove, instruction.FieldsOnly, Coprocessor32BitMoveInstruction.FieldsMask, resetValue, writableMask, writeHandler);
+        }
+
+        /// <summary>
+        /// Registers a 64-bit CP15 register which only stores the written value, see <see cref="RegisterStorageCP15Register"/>.
+        /// </summary>
+        public void RegisterStorageCP15Register64(uint opc1, uint crm, ulong resetValue = 0, ulong writableMask = ulong.MaxValue, Action<ulong> writeHandler = null)
+        {
+            var instruction = new Coprocessor64BitMoveInstruction(opc1, crm);
+            DeclareStorageRegister(StorageRegisterSpace.Coprocessor64BitMove, instruction.FieldsOnly, Coprocessor64BitMoveInstruction.FieldsMask, resetValue, writableMask, writeHandler);
+        }
+
         public bool EvaluateConditionCode(uint condition)
         {
             return TlibEvaluateConditionCode(condition) > 0;
@@ -139,12 +159,38 @@ public void Register(SemihostingHandler peripheral, NullRegistrationPoint regist
             semihostingHandler = peripheral;
             semihostingHandler.AttachCpu(this);
             machine.RegisterAsAChildOf(this, peripheral, registrationPoint);
+            UpdateNativeSemihosting();
         }
 
         public void Unregister(SemihostingHandler peripheral)
         {
             semihostingHandler = null;
             machine.UnregisterAsAChildOf(this, peripheral);
+            UpdateNativeSemihosting();
+        }
+
+        public override ExecutionResult ExecuteInstructions(ulong numberOfInstructionsToExecute, out ulong numberOfExecutedInstructions)
+        {
+            var result = base.ExecuteInstructions(numberOfInstructionsToExecute, out numberOfExecutedInstructions);
+            // The console output of semihosting is buffered by tlib, it has to be shown at least once per quantum
+            RenodeArmSemihostingFlush();
+            return result;
+        }
+
+        // Has to be called whenever the semihosting console or its descriptors change, so that tlib handles console writes itself
+        internal void UpdateNativeSemihosting()
+        {
+            var handler = semihostingHandler;
+            var enabled = IsSemihostingEnabled && handler != null;
+            RenodeArmSemihostingConfigure(enabled ? 1u : 0u, enabled && handler.HasConsole ? 1u : 0u);
+            if(!enabled)
+            {
+                return;
+            }
+            foreach(var console in handler.ConsoleHandles)
+            {
+                RenodeArmSemihostingSetConsoleHandle(console.Key, (uint)console.Value);
+            }
         }
 
         public void Register(ArmPerformanceMonitoringUnit peripheral, NullRegistrationPoint registrationPoint)
@@ -170,7 +216,15 @@ public bool GetArmFeature(ArmFeatures feature)
             return TlibGetArmFeature((int)feature) > 0;
         }
 
-        public bool IsSemihostingEnabled { get; set; } = true;
+        public bool IsSemihostingEnabled
+        {
+            get => isSemihostingEnabled;
+            set
+            {
+                isSemihostingEnabled = value;
+                UpdateNativeSemihosting();
+            }
+        }
 
         public virtual uint ExceptionVectorAddress
         {
@@ -347,9 +401,19 @@ protected override Interrupt DecodeInterrupt(int number)
             }
         }
 
+        protected override void AfterLoad(IntPtr statePtr)
+        {
+            base.AfterLoad(statePtr);
+            UpdateNativeSemihosting();
+        }
+
         [Export]
         protected void Write64CP15(uint instruction, ulong value)
         {
+            if(NotifyStorageRegisterWrite(StorageRegisterSpace.Coprocessor64BitMove, instruction, Coprocessor64BitMoveInstruction.FieldsMask))
+            {
+                return;
+            }
             Write64CP15Inner(new Coprocessor64BitMoveInstruction(instruction), value);
         }
 
@@ -362,6 +426,10 @@ protected ulong Read64CP15(uint instruction)
         [Export]
         protected void Write32CP15(uint instruction, uint value)
         {
+            if(NotifyStorageRegisterWrite(StorageRegisterSpace.Coprocessor32BitMove, instruction, Coprocessor32BitMoveInstruction.FieldsMask))
+            {
+                return;
+            }
             Write32CP15Inner(new Coprocessor32BitMoveInstruction(instruction), value);
         }
 
@@ -388,8 +456,9 @@ private void FillConfigurationSignalsState(IntPtr allocatedStatePointer)
             signalsUnit?.FillConfigurationStateStruct(allocatedStatePointer, this);
         }
 
+        // `lastNativeOperation` is the last operation completed by tlib since the previous call, 0 if there was none
         [Export]
-        private uint DoSemihosting()
+        private uint DoSemihosting(uint lastNativeOperation)
         {
             if(!IsSemihostingEnabled)
             {
@@ -407,10 +476,35 @@ private uint DoSemihosting()
             }
             using(ObtainGenericPauseGuard())
             {
+                if(lastNativeOperation != 0)
+                {
+                    semihostingHandler.CompleteNativeOperation(lastNativeOperation);
+                }
                 return semihostingHandler.DoSemihosting(operationNumber: (uint)R[0], argumentsAddress: (uint)R[1]);
             }
         }
 
+        // Console writes are buffered by tlib, which passes them here in chunks. It's called both from tlib and from C#, so without the pause guard.
+        [Export]
+        private void FlushSemihostingConsole(uint stream, IntPtr data, uint length)
+        {
+            semihostingHandler?.WriteConsole((SemihostingHandler.Stdio)stream, data, length);
+        }
+
+        // SYS_WRITE and SYS_READ of files with buffers in the memory mapped by tlib, which are passed as host pointers
+        [Export]
+        private uint DoSemihostingTransfer(uint write, uint handle, IntPtr buffer, uint length)
+        {
+            if(semihostingHandler == null)
+            {
+                return length;
+            }
+            using(ObtainGenericPauseGuard())
+            {
+                return semihostingHandler.DoSemihostingTransfer(write != 0, handle, buffer, length);
+            }
+        }
+
         [Export]
         private uint IsWfiAsNop()
         {
@@ -490,6 +584,7 @@ private void ReportPMUOverflow(int counter)
 
         private ArmPerformanceMonitoringUnit performanceMonitoringUnit;
         private bool warnedAboutSemihosting = false;
+        private bool isSemihostingEnabled = true;
 
         // 649:  Field '...' is never assigned to, and will always have its default value null
 #pragma warning disable 649
@@ -536,6 +631,15 @@ private void ReportPMUOverflow(int counter)
 
         [Import]
         private readonly Action<uint, ulong, ulong> TlibRegisterTcmRegion;
+
+        [Import]
+        private readonly Action<uint, uint> RenodeArmSemihostingConfigure;
+
+        [Import]
+        private readonly Action<uint, uint> RenodeArmSemihostingSetConsoleHandle;
+
+        [Import]
+        private readonly Action RenodeArmSemihostingFlush;
 #pragma warning restore 649
 
         private readonly string[] ExceptionDescriptions =
@@ -650,6 +754,13 @@ public Coprocessor64BitMoveInstruction(uint instruction)
                 FieldsOnly = instruction & FieldsMask;
             }
 
+            public Coprocessor64BitMoveInstruction(uint opc1, uint crm)
+            {
+                Opc1 = opc1;
+                CRm = crm;
+                FieldsOnly = (Opc1 << Opc1Offset) | (CRm << CRmOffset);
+            }
+
             public override string ToString()
             {
                 return $"op1={Opc1}, crm={CRm}";
@@ -68,6 +68,7 @@ public void Register(SemihostingUart peripheral, NumberRegistrationPoint<Stdio>
             }
 
             machine.RegisterAsAChildOf(this, peripheral, registrationPoint);
+            cpu?.UpdateNativeSemihosting();
         }
 
         public void Unregister(SemihostingUart peripheral)
@@ -82,6 +83,47 @@ public void Unregister(SemihostingUart peripheral)
                 stdErr = null;
             }
             machine.UnregisterAsAChildOf(this, peripheral);
+            cpu?.UpdateNativeSemihosting();
+        }
+
+        // Writes the console output of SYS_WRITEC, SYS_WRITE0 and SYS_WRITE buffered by the CPU
+        public unsafe void WriteConsole(Stdio stream, IntPtr data, uint length)
+        {
+            var console = stream == Stdio.Error ? stdErr : stdInOut;
+            if(console == null)
+            {
+                LogFailure("Console write", $"Semihosting UART for {stream} isn't registered, dropping {length} bytes");
+                return;
+            }
+            console.SemihostingWriteBytes(new ReadOnlySpan<byte>((void*)data, (int)length));
+        }
+
+        // Handles SYS_WRITE and SYS_READ of buffers mapped by the CPU, which copies them directly from and to the host memory.
+        // Returns the number of bytes which weren't transferred, like these operations.
+        public unsafe uint DoSemihostingTransfer(bool write, uint handle, IntPtr buffer, uint length)
+        {
+            var operation = write ? Operation.SYS_WRITE : Operation.SYS_READ;
+            var operationName = operation.ToString();
+            lastOperation = operation;
+            LogReceived(operationName, "args: {0} / host 0x{1:X} / {2}", handle, buffer, length);
+
+            if(!TryGetSemihostingDescriptor(operationName, handle, out var descriptor))
+            {
+                return length;
+            }
+            var bytes = new Span<byte>((void*)buffer, (int)length);
+            if(write)
+            {
+                return descriptor.TryWrite(operationName, bytes, ref semihostingErrno) ? 0 : length;
+            }
+            return descriptor.TryRead(operationName, bytes, out var bytesCount, ref semihostingErrno) ? length - (uint)bytesCount : length;
+        }
+
+        // Console writes completed by the CPU are only reported before the next operation handled here, they leave the state
+        // the same as DoSemihosting would after writing to the console successfully, which doesn't change the errno
+        public void CompleteNativeOperation(uint operationNumber)
+        {
+            lastOperation = (Operation)operationNumber;
         }
 
         public uint DoSemihosting(uint operationNumber, uint argumentsAddress)
@@ -562,6 +604,14 @@ public string WorkingDirectory
 
         public string AttachedToCPU => cpu.GetName();
 
+        // The debug channel of SYS_WRITEC and SYS_WRITE0 is available
+        public bool HasConsole => stdInOut != null;
+
+        // Handles of the console opened for writing, with the streams they write to
+        public IEnumerable<KeyValuePair<uint, Stdio>> ConsoleHandles => semihostingDescriptors
+            .Select(descriptor => new KeyValuePair<uint, Stdio>(descriptor.Key, GetConsoleStream(descriptor.Value.ConsoleOutput)))
+            .Where(console => console.Value != Stdio.None);
+
         public string TemporaryFilesDirectory { get; set; }
 
         public const uint MaxNumberOfTemporaryFiles = 256;
@@ -660,6 +710,20 @@ private bool TryGetConsole(string operationName, out SemihostingUart console)
             }
         }
 
+        private Stdio GetConsoleStream(SemihostingUart uart)
+        {
+            if(uart == null)
+            {
+                return Stdio.None;
+            }
+            if(uart == stdInOut)
+            {
+                return Stdio.InputOutput;
+            }
+            // The UART of a descriptor could have been unregistered since it was opened
+            return uart == stdErr ? Stdio.Error : Stdio.None;
+        }
+
         private bool TryGetSemihostingDescriptor(string operationName, uint handle, out SemihostingDescriptor semihostingDescriptor)
         {
             if(semihostingDescriptors.TryGetValue(handle, out semihostingDescriptor))
@@ -751,6 +815,10 @@ private uint AddDescriptor(string operationName, string path, uint mode)
                 descriptorNumber = freeDescriptors.Dequeue();
             }
             semihostingDescriptors.Add(descriptorNumber, descriptor);
+            if(descriptor.ConsoleOutput != null)
+            {
+                cpu?.UpdateNativeSemihosting();
+            }
 
             this.Log(LogLevel.Debug, "{0}: '{1}' opened as {2}", operationName, path, descriptorNumber);
             return descriptorNumber;
@@ -763,6 +831,10 @@ private bool RemoveDescriptor(string operationName, uint handle)
                 descriptor.Close();
                 semihostingDescriptors.Remove(handle);
                 freeDescriptors.Enqueue(handle, handle);
+                if(descriptor.ConsoleOutput != null)
+                {
+                    cpu?.UpdateNativeSemihosting();
+                }
                 return true;
             }
             else
@@ -781,6 +853,7 @@ private void ClearDescriptors()
             semihostingDescriptors.Clear();
             freeDescriptors.Clear();
             highestFileDescriptor = 0;
+            cpu?.UpdateNativeSemihosting();
         }
 
         private SemihostingUart StdInOut
@@ -842,8 +915,10 @@ public SemihostingDescriptor(SemihostingHandler handler, string path, ISOCMode m
 
                 if(path == SemihostingHandler.ConsolePath)
                 {
-                    backingStream = OpenUartWithISOCMode(mode);
+                    var uartStream = OpenUartWithISOCMode(mode);
+                    backingStream = uartStream;
                     isConsole = true;
+                    ConsoleOutput = uartStream.CanWrite ? uartStream.Uart : null;
                 }
                 else if(path == SemihostingHandler.FeaturesPath)
                 {
@@ -918,12 +993,17 @@ public bool TryGetLength(out uint length, ref Errno errno)
             public bool TryRead(string operationName, int length, out int bytesCount, out byte[] bytesRead, ref Errno errno)
             {
                 bytesRead = new byte[length];
+                return TryRead(operationName, bytesRead, out bytesCount, ref errno);
+            }
+
+            public bool TryRead(string operationName, Span<byte> bytesRead, out int bytesCount, ref Errno errno)
+            {
                 bytesCount = 0;
                 if(backingStream?.CanRead ?? false)
                 {
                     try
                     {
-                        bytesCount = backingStream.Read(bytesRead, 0, length);
+                        bytesCount = backingStream.Read(bytesRead);
                         return true;
                     }
                     catch(Exception e)
@@ -962,13 +1042,13 @@ public bool TrySeek(long offset, ref Errno errno)
                 return false;
             }
 
-            public bool TryWrite(string operationName, byte[] bytes, ref Errno errno)
+            public bool TryWrite(string operationName, ReadOnlySpan<byte> bytes, ref Errno errno)
             {
                 if(backingStream?.CanWrite ?? false)
                 {
                     try
                     {
-                        backingStream.Write(bytes, 0, bytes.Length);
+                        backingStream.Write(bytes);
                         return true;
                     }
                     catch(Exception e)
@@ -987,6 +1067,9 @@ public bool TryWrite(string operationName, byte[] bytes, ref Errno errno)
 
             public bool IsConsole => isConsole;
 
+            // The UART written to if it's the console opened for writing
+            public SemihostingUart ConsoleOutput { get; }
+
             private FileStream OpenFileWithISOCMode(string path, ISOCMode mode)
             {
                 // The same for the binary versions of these modes.
@@ -1104,6 +1187,15 @@ public override void Write(byte[] buffer, int offset, int count)
                 uart.SemihostingWriteBytes(buffer, offset, count);
             }
 
+            public override void Write(ReadOnlySpan<byte> buffer)
+            {
+                if(!CanWrite)
+                {
+                    throw new NotSupportedException();
+                }
+                uart.SemihostingWriteBytes(buffer);
+            }
+
             public override int ReadByte()
             {
                 if(!CanRead)
@@ -1148,6 +1240,8 @@ public override void SetLength(long value)
 
             public override long Position { get => throw new NotSupportedException(); set => throw new NotSupportedException(); }
 
+            public SemihostingUart Uart => uart;
+
             private readonly SemihostingUart uart;
             private readonly bool canRead;
             private readonly bool canWrite;
@@ -57,6 +57,21 @@ public ulong ReadRegisterAArch64(uint offset)
             return value;
         }
 
+        // Reads of the '*Count' registers have no side effects, unless logged, and their values only change with the time of the machine.
+        public bool IsCountRegisterAArch64(uint offset)
+        {
+            switch((RegistersAArch64)offset)
+            {
+            case RegistersAArch64.PhysicalCount:
+            case RegistersAArch64.VirtualCount:
+            case RegistersAArch64.PhysicalSelfSynchronizedCount:
+            case RegistersAArch64.VirtualSelfSynchronizedCount:
+                return !EnableCountReadLogs;
+            default:
+                return false;
+            }
+        }
+
         public void WriteDoubleWordRegisterAArch32(uint offset, uint value)
         {
             this.Log(LogLevel.Debug, "Write to {0} (0x{1:X}) AArch32 register, value 0x{2:X}", (DoubleWordRegistersAArch32)offset, offset, value);
@@ -72,6 +72,16 @@ public void SetAvailableExceptionLevels(bool el2Enabled, bool el3Enabled)
             }
         }
 
+        /// <summary>
+        /// Registers a system register of the interrupt controller's CPU interface which only stores the written value, served instead of the GIC.
+        /// Its accesses are handled without leaving the translation library, unless <paramref name="writeHandler"/> is given,
+        /// which is called with the new value after every write.
+        /// </summary>
+        public void RegisterStorageInterruptCPUInterfaceRegister(uint offset, ulong resetValue = 0, ulong writableMask = ulong.MaxValue, Action<ulong> writeHandler = null)
+        {
+            DeclareStorageRegister(StorageRegisterSpace.InterruptCPUInterface, offset, uint.MaxValue, resetValue, writableMask, writeHandler);
+        }
+
         public void Register(ARM_GenericTimer peripheral, NullRegistrationPoint registrationPoint)
         {
             if(timer != null)
@@ -193,6 +203,10 @@ protected ulong ReadSystemRegisterInterruptCPUInterface(uint offset)
         [Export]
         protected void WriteSystemRegisterInterruptCPUInterface(uint offset, ulong value)
         {
+            if(NotifyStorageRegisterWrite(StorageRegisterSpace.InterruptCPUInterface, offset, uint.MaxValue))
+            {
+                return;
+            }
             gic.WriteSystemRegisterCPUInterface(offset, value);
         }
 
@@ -218,6 +232,10 @@ protected ulong ReadSystemRegisterGenericTimer64(uint offset)
                 this.Log(LogLevel.Error, "Trying to read a register of the ARM Generic Timer, but the timer was not found.");
                 return 0;
             }
+            if(timer.IsCountRegisterAArch64(offset))
+            {
+                return ReadTimeCounter(offset, () => timer.ReadRegisterAArch64(offset));
+            }
             return timer.ReadRegisterAArch64(offset);
         }
 
@@ -8,12 +8,14 @@
 using System.Collections.Generic;
 using System.IO;
 using System.Linq;
+using System.Runtime.InteropServices;
 
 using Antmicro.Migrant;
 using Antmicro.Migrant.Hooks;
 using Antmicro.Renode.Core;
 using Antmicro.Renode.Exceptions;
 using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.Bus;
 using Antmicro.Renode.Time;
 using Antmicro.Renode.Utilities;
 using Antmicro.Renode.Utilities.Binding;
@@ -25,13 +27,15 @@
 namespace Antmicro.Renode.Peripherals.CPU
 {
     [SupportedRID("linux")]
-    public abstract class KVMCPU : BaseCPU, IGPIOReceiver, ICPUWithRegisters, IControllableCPU, ICPUWithMappedMemory, ICPUWithMMU, ICpuSupportingGdb
+    public abstract partial class KVMCPU : BaseCPU, IGPIOReceiver, ICPUWithRegisters, IControllableCPU, ICPUWithMappedMemory, ICPUWithMMU, ICPUWithGuestMemoryAccess, ICpuSupportingGdb
     {
         public KVMCPU(string cpuType, IMachine machine, Endianess endianess, CpuBitness cpuBitness, uint cpuId = 0)
             : base(cpuId, cpuType, machine, endianess, cpuBitness)
         {
             currentMappings = new List<SegmentMappingWithSlotNumber>();
             hooks = new HookDescriptor(this);
+            watchpoints = new Dictionary<ulong, CpuAddressHook>();
+            portBlockTransfers = new PortBlockTransfers(machine, this, IoPortBaseAddress);
             InitBinding();
             Init();
             machine.PeripheralsChanged += OnMachinePeripheralsChanged;
@@ -59,9 +63,12 @@ public void MapMemory(IMappedSegment segment)
                 var mapping = new SegmentMappingWithSlotNumber(segment, slotNumber);
                 var range = segment.GetRange();
                 mapping.Segment.Touch();
-                currentMappings.Add(mapping);
+                lock(currentMappings)
+                {
+                    currentMappings.Add(mapping);
+                    KvmMapRange(slotNumber, segment.StartingOffset, segment.Size, (ulong)mapping.Segment.Pointer);
+                }
                 mappedMemory.Add(range);
-                KvmMapRange(slotNumber, segment.StartingOffset, segment.Size, (ulong)mapping.Segment.Pointer);
                 this.NoisyLog("Registered memory at {0}", range);
             }
         }
@@ -90,15 +97,107 @@ public void UnmapMemory(Range range)
                     );
                 }
 
-                var mappingsToRemove = currentMappings.Where(x => range.Contains(x.Segment.GetRange())).ToList();
-                mappingsToRemove.ForEach(x => KvmUnmapRange(x.SlotNumber));
+                lock(currentMappings)
+                {
+                    var mappingsToRemove = currentMappings.Where(x => range.Contains(x.Segment.GetRange())).ToList();
+                    mappingsToRemove.ForEach(x => KvmUnmapRange(x.SlotNumber));
 
-                currentMappings.RemoveAll(x => range.Contains(x.Segment.GetRange()));
+                    currentMappings.RemoveAll(x => range.Contains(x.Segment.GetRange()));
+                }
 
                 mappedMemory.Remove(range);
             }
         }
 
+        // Reads from read-only memory are handled by KVM without exiting, only writes exit to Renode.
+        // With `trapWrites` they are passed to the system bus, so that e.g. a flash controller owning the memory can handle them,
+        // otherwise they are ignored. Only whole mapped segments can be made read-only.
+        public void SetMappedMemoryReadOnly(Range range, bool readOnly, bool trapWrites = false)
+        {
+            using(machine?.ObtainPausedState(true))
+            {
+                var mappings = currentMappings.Where(x => x.Segment.GetRange().Intersects(range)).ToList();
+                if(mappings.Any(x => !range.Contains(x.Segment.GetRange())))
+                {
+                    throw new RecoverableException($"Range {range} has to contain whole mapped segments");
+                }
+
+                foreach(var mapping in mappings)
+                {
+                    KvmSetReadOnly(mapping.SlotNumber, readOnly ? 1u : 0u, trapWrites ? 1u : 0u);
+                    mapping.ReadOnly = readOnly;
+                    mapping.TrapWrites = trapWrites;
+                }
+            }
+        }
+
+        public void SetDirtyPagesLogging(Range range, bool enabled)
+        {
+            using(machine?.ObtainPausedState(true))
+            {
+                foreach(var mapping in currentMappings.Where(x => x.Segment.GetRange().Intersects(range)))
+                {
+                    KvmSetDirtyLogging(mapping.SlotNumber, enabled ? 1u : 0u);
+                    mapping.DirtyPagesLogging = enabled;
+                }
+            }
+        }
+
+        // Returns addresses of pages within the range written by the guest since the previous call.
+        // Dirty state of the returned pages is cleared. Hosts without manual dirty log protection clear
+        // the state of whole memory segments intersecting the range.
+        public IEnumerable<ulong> GetDirtyPages(Range range)
+        {
+            var dirtyPages = new List<ulong>();
+            using(machine?.ObtainPausedState(true))
+            {
+                foreach(var mapping in currentMappings.Where(x => x.Segment.GetRange().Intersects(range)))
+                {
+                    if(!mapping.DirtyPagesLogging)
+                    {
+                        throw new RecoverableException($"Dirty pages logging is not enabled for {mapping.Segment.GetRange()}");
+                    }
+
+                    var pagesCount = (mapping.Segment.Size + DirtyLogPageSize - 1) / DirtyLogPageSize;
+                    var bitmap = new ulong[(pagesCount + 63) / 64];
+                    var handle = GCHandle.Alloc(bitmap, GCHandleType.Pinned);
+                    try
+                    {
+                        var bitmapPointer = (ulong)handle.AddrOfPinnedObject();
+                        KvmGetDirtyLog(mapping.SlotNumber, bitmapPointer);
+
+                        for(var word = 0; word < bitmap.Length; word++)
+                        {
+                            for(var bit = 0; bit < 64; bit++)
+                            {
+                                if((bitmap[word] & (1UL << bit)) == 0)
+                                {
+                                    continue;
+                                }
+                                var address = mapping.Segment.StartingOffset + ((ulong)word * 64 + (ulong)bit) * DirtyLogPageSize;
+                                if(range.Contains(address))
+                                {
+                                    dirtyPages.Add(address);
+                                }
+                                else
+                                {
+                                    // Keep the dirty state of pages outside of the requested range
+                                    bitmap[word] &= ~(1UL << bit);
+                                }
+                            }
+                        }
+
+                        KvmClearDirtyLog(mapping.SlotNumber, bitmapPointer);
+                    }
+                    finally
+                    {
+                        handle.Free();
+                    }
+                }
+            }
+            return dirtyPages;
+        }
+
         public ulong TranslateAddress(ulong logicalAddress, MpuAccess accessType)
         {
             if(TryTranslateAddress(logicalAddress, accessType, out var physicalAddress))
@@ -117,6 +216,66 @@ public bool TryTranslateAddress(ulong logicalAddress, MpuAccess accessType, out
             return physicalAddress != ulong.MaxValue;
         }
 
+        // Returns physical addresses of all pages overlapping the range, translated without a syscall per page.
+        // The first entry corresponds to `logicalAddress`, the following ones to the starts of consecutive pages.
+        // Unmapped pages are reported as `ulong.MaxValue`.
+        public ulong[] TranslateAddressRange(ulong logicalAddress, ulong size)
+        {
+            if(size == 0)
+            {
+                return new ulong[0];
+            }
+            if(size - 1 > ulong.MaxValue - logicalAddress)
+            {
+                throw new RecoverableException($"Range of 0x{size:X} bytes at 0x{logicalAddress:X} exceeds the address space");
+            }
+            var firstPage = logicalAddress / PageSize;
+            var lastPage = (logicalAddress + size - 1) / PageSize;
+            var physicalAddresses = new ulong[lastPage - firstPage + 1];
+            var handle = GCHandle.Alloc(physicalAddresses, GCHandleType.Pinned);
+            try
+            {
+                KvmTranslateGuestVirtualRange(logicalAddress, size, (ulong)handle.AddrOfPinnedObject(), (uint)physicalAddresses.Length);
+            }
+            finally
+            {
+                handle.Free();
+            }
+            return physicalAddresses;
+        }
+
+        // Called by MappedMemory when it is written through the system bus, e.g. by the debugger or a loader.
+        // Translated code isn't cached by KVM, but written memory could hold guest page tables.
+        public void OrderTranslationBlocksInvalidation(IntPtr start, IntPtr end, bool delayInvalidation = false)
+        {
+            KvmFlushTranslationCache();
+        }
+
+        // Reads guest physical memory copying directly from segments mapped to KVM, without per-page lookups on the system bus.
+        // Parts of the range not mapped to KVM, e.g. peripherals, are read through the system bus.
+        public byte[] ReadGuestMemory(ulong address, int count)
+        {
+            var data = new byte[count];
+            CopyGuestMemory(address, data, 0, count, write: false);
+            return data;
+        }
+
+        public void ReadGuestMemory(ulong address, byte[] destination, int startIndex, int count)
+        {
+            CopyGuestMemory(address, destination, startIndex, count, write: false);
+        }
+
+        // Written pages are reported by GetDirtyPages, writes are not blocked by read-only mappings.
+        public void WriteGuestMemory(ulong address, byte[] data)
+        {
+            CopyGuestMemory(address, data, 0, data.Length, write: true);
+        }
+
+        public void WriteGuestMemory(ulong address, byte[] data, int startIndex, int count)
+        {
+            CopyGuestMemory(address, data, startIndex, count, write: true);
+        }
+
         public void AddHookAtInterruptBegin(Action<ulong> hook)
         {
             throw new RecoverableException("AddHookAtInterruptBegin is not implemented");
@@ -142,6 +301,32 @@ public void AddHookAtWfiStateChange(Action<bool> hook)
 
         public void RemoveAllHooks() => hooks.RemoveAllHooks();
 
+        // Watchpoints are set using the CPU debug registers, so they also trap accesses to memory mapped into the guest.
+        // Debug registers are shared with breakpoints, at most 4 watchpoints and breakpoints are handled this way.
+        // The hook is called with the address of the instruction following the access.
+        public void AddWatchpoint(ulong address, SysbusAccessWidth width, Access access, CpuAddressHook hook)
+        {
+            if(watchpoints.ContainsKey(address))
+            {
+                watchpoints[address] += hook;
+                return;
+            }
+            if(KvmAddWatchpoint(address, (uint)width, (uint)access) == 0)
+            {
+                throw new RecoverableException($"Could not add a watchpoint at 0x{address:X}");
+            }
+            watchpoints[address] = hook;
+        }
+
+        public void RemoveWatchpoint(ulong address)
+        {
+            if(!watchpoints.Remove(address))
+            {
+                throw new RecoverableException($"There is no watchpoint at 0x{address:X}");
+            }
+            KvmRemoveWatchpoint(address);
+        }
+
         public void RegisterAccessFlags(ulong startAddress, ulong size, bool isIoMemory = false)
         {
             // all ArrayMemory is set as executable by default
@@ -191,8 +376,16 @@ public override ExecutionResult ExecuteInstructions(ulong numberOfInstructionsTo
             // Due to intricacies of modern CPUs this will also be non-deterministic between runs.
             var time = TimeInterval.FromCPUCycles(numberOfInstructionsToExecute, PerformanceInMips, out var cyclesResiduum).TotalMicroseconds;
 
+            if(virtualTsc)
+            {
+                var guestTsc = TimeHandle.TotalElapsedTime.ToCPUCycles(PerformanceInMips, out var _);
+                KvmSynchronizeVirtualTsc(guestTsc, PerformanceInMips * 1000UL);
+            }
+
             numberOfExecutedInstructions = numberOfInstructionsToExecute;
-            return (ExecutionResult)KvmExecute((ulong)time);
+            var executionResult = (ExecutionResult)KvmExecute((ulong)time);
+            exitStatisticsTracer?.Sample();
+            return executionResult;
         }
 
         public void EnterSingleStepModeSafely(HaltArguments args)
@@ -235,6 +428,31 @@ public virtual IEnumerable<CPURegister> GetAllRegisters()
 
         public virtual uint PageSize => 4096;
 
+        // When enabled, a guest halted with HLT ends the quantum with WaitingForInterrupt, so that the virtual time can advance
+        // without waiting for the quantum to pass in the host time. Interrupts generated by the in-kernel LAPIC timer and PIT
+        // still depend on the host time.
+        public bool DetectHalt
+        {
+            get => detectHalt;
+            set
+            {
+                KvmSetHaltDetection(value ? 1u : 0u);
+                detectHalt = value;
+            }
+        }
+
+        // When enabled, guest TSC ticks at PerformanceInMips MHz and is synchronized with the virtual time at quantum boundaries.
+        // Otherwise it follows the host TSC, compensated for the time spent outside of the guest.
+        public bool VirtualTsc
+        {
+            get => virtualTsc;
+            set
+            {
+                KvmSetVirtualTsc(value ? 1u : 0u);
+                virtualTsc = value;
+            }
+        }
+
         public abstract string GDBArchitecture { get; }
 
         public abstract List<GDBFeatureDescriptor> GDBFeatures { get; }
@@ -246,6 +464,7 @@ protected virtual void InitializeRegisters()
         protected override void DisposeInner(bool silent = false)
         {
             base.DisposeInner(silent);
+            DisableExitStatisticsTrace();
             RemoveAllHooks();
             KvmDispose();
             TimeHandle.Dispose();
@@ -276,6 +495,15 @@ protected override bool ExecutionFinished(ExecutionResult result)
                 hooks.DeactivateHooks(PC);
                 return true;
             }
+            if(result == ExecutionResult.StoppedAtWatchpoint)
+            {
+                this.Trace();
+                if(watchpoints.TryGetValue(KvmGetHitWatchpointAddress(), out var hook))
+                {
+                    hook(this, PC);
+                }
+                return true;
+            }
             return false;
         }
 
@@ -293,12 +521,6 @@ protected virtual void OnMachinePeripheralsChanged(IMachine machine, Peripherals
             }
         }
 
-        [PreSerialization]
-        protected virtual void BeforeSerialization()
-        {
-            throw new NonSerializableTypeException($"Serialization of {this.GetType()} is not implemented");
-        }
-
         [Export]
         protected void LogAsCpu(int level, string s)
         {
@@ -403,6 +625,18 @@ protected void WriteDoubleWordToPort(ushort address, uint value)
             WriteDoubleWordToBus(IoPortBaseAddress + address, (uint)value);
         }
 
+        [Export]
+        protected void ReadBlockFromPort(ushort address, uint width, uint count, IntPtr buffer)
+        {
+            portBlockTransfers.Read(address, width, count, buffer);
+        }
+
+        [Export]
+        protected void WriteBlockToPort(ushort address, uint width, uint count, IntPtr buffer)
+        {
+            portBlockTransfers.Write(address, width, count, buffer);
+        }
+
         // 649:  Field '...' is never assigned to, and will always have its default value null
 #pragma warning disable 649
 
@@ -430,10 +664,24 @@ protected void WriteDoubleWordToPort(ushort address, uint value)
         [Import]
         protected Action<int, int> KvmSetIrq;
 
+        [Import]
+        protected Action<int, uint> KvmSetDirtyLogging;
+
+        [Import]
+        protected Action<int, uint, uint> KvmSetReadOnly;
+
+        [Import]
+        protected Action<int, ulong> KvmGetDirtyLog;
+
+        [Import]
+        protected Action<int, ulong> KvmClearDirtyLog;
+
 #pragma warning restore 649
 
+        [Transient]
         protected string libraryFile;
 
+        [Transient]
         protected NativeBinder binder;
 
         protected int numberOfSegmentSlots;
@@ -446,6 +694,9 @@ protected void WriteDoubleWordToPort(ushort address, uint value)
 
         protected const int MaxRedirectionTableEntries = 24;
 
+        // KVM tracks dirty pages with the granularity of host pages
+        protected const ulong DirtyLogPageSize = 4096;
+
         private void InitBinding()
         {
             libraryFile = PlatformFileLoader.CopyPlatformFile($"kvm-{Architecture}.so");
@@ -453,22 +704,181 @@ private void InitBinding()
             binder = new NativeBinder(this, libraryFile);
         }
 
+        [PreSerialization]
+        private void PrepareState()
+        {
+            var size = checked((int)KvmGetStateSize());
+            var statePtr = Marshal.AllocHGlobal(size);
+            try
+            {
+                KvmSaveState((ulong)statePtr);
+                cpuState = new byte[size];
+                Marshal.Copy(statePtr, cpuState, 0, size);
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(statePtr);
+            }
+        }
+
+        [PostSerialization]
+        private void FreeState()
+        {
+            cpuState = null;
+        }
+
+        [LatePostDeserialization]
+        private void RestoreState()
+        {
+            InitBinding();
+            Init();
+
+            // Memory segments are already restored, so they can be mapped directly instead of replaying the boot
+            foreach(var mapping in currentMappings)
+            {
+                mapping.Segment.Touch();
+                KvmMapRange(mapping.SlotNumber, mapping.Segment.StartingOffset, mapping.Segment.Size, (ulong)mapping.Segment.Pointer);
+                if(mapping.DirtyPagesLogging)
+                {
+                    KvmSetDirtyLogging(mapping.SlotNumber, 1u);
+                }
+                if(mapping.ReadOnly)
+                {
+                    KvmSetReadOnly(mapping.SlotNumber, 1u, mapping.TrapWrites ? 1u : 0u);
+                }
+            }
+
+            var statePtr = Marshal.AllocHGlobal(cpuState.Length);
+            try
+            {
+                Marshal.Copy(cpuState, 0, statePtr, cpuState.Length);
+                KvmRestoreState((ulong)statePtr, (ulong)cpuState.Length);
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(statePtr);
+            }
+            FreeState();
+
+            // Collected statistics are not a part of the snapshot, only whether they are being collected
+            KvmSetStatisticsEnabled(exitStatisticsEnabled ? 1u : 0u);
+            KvmSetVirtualTsc(virtualTsc ? 1u : 0u);
+            KvmSetHaltDetection(detectHalt ? 1u : 0u);
+        }
+
+        private void CopyGuestMemory(ulong address, byte[] buffer, int startIndex, int count, bool write)
+        {
+            if(startIndex < 0 || count < 0 || startIndex + count > buffer.Length)
+            {
+                throw new RecoverableException($"Range of {count} bytes at index {startIndex} does not fit in the {buffer.Length} bytes buffer");
+            }
+
+            var handle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+            try
+            {
+                var pointer = (ulong)handle.AddrOfPinnedObject() + (ulong)startIndex;
+                var offset = 0;
+                while(offset < count)
+                {
+                    var current = address + (ulong)offset;
+                    var remaining = (ulong)(count - offset);
+                    ulong nextMapping;
+                    // Segments can be mapped and unmapped by other threads, the system bus is accessed without holding the lock
+                    lock(currentMappings)
+                    {
+                        var copied = write
+                            ? KvmWriteGuestMemory(current, pointer + (ulong)offset, remaining)
+                            : KvmReadGuestMemory(current, pointer + (ulong)offset, remaining);
+                        offset += (int)copied;
+                        if(offset == count)
+                        {
+                            break;
+                        }
+
+                        current = address + (ulong)offset;
+                        nextMapping = currentMappings.Select(x => x.Segment.StartingOffset).Where(x => x > current).DefaultIfEmpty(ulong.MaxValue).Min();
+                    }
+
+                    // Access the part not mapped to KVM through the system bus, up to the next mapped segment
+                    var length = (int)Math.Min((ulong)(count - offset), nextMapping - current);
+                    if(write)
+                    {
+                        machine.SystemBus.WriteBytes(buffer, current, startIndex + offset, length, context: this);
+                    }
+                    else
+                    {
+                        machine.SystemBus.ReadBytes(current, length, buffer, startIndex + offset, context: this);
+                    }
+                    offset += length;
+                }
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
         private bool singleStepAfterHook;
+        private bool virtualTsc;
+        private bool detectHalt;
+
+        private byte[] cpuState;
 
 #pragma warning disable 649
 
         [Import]
         private readonly Func<ulong, ulong> KvmTranslateGuestVirtualAddress;
 
+        [Import]
+        private readonly Func<ulong, ulong, ulong, uint, uint> KvmTranslateGuestVirtualRange;
+
+        [Import]
+        private readonly Action KvmFlushTranslationCache;
+
+        [Import]
+        private readonly Func<ulong, ulong, ulong, ulong> KvmReadGuestMemory;
+
+        [Import]
+        private readonly Func<ulong, ulong, ulong, ulong> KvmWriteGuestMemory;
+
         [Import]
         private readonly Action<ulong> KvmAddBreakpoint;
 
         [Import]
         private readonly Action<ulong>  KvmRemoveBreakpoint;
 
+        [Import]
+        private readonly Func<ulong, uint, uint, uint> KvmAddWatchpoint;
+
+        [Import]
+        private readonly Action<ulong> KvmRemoveWatchpoint;
+
+        [Import]
+        private readonly Func<ulong> KvmGetHitWatchpointAddress;
+
+        [Import]
+        private readonly Action<uint> KvmSetHaltDetection;
+
+        [Import]
+        private readonly Action<uint> KvmSetVirtualTsc;
+
+        [Import]
+        private readonly Action<ulong, ulong> KvmSynchronizeVirtualTsc;
+
+        [Import]
+        private readonly Func<ulong> KvmGetStateSize;
+
+        [Import]
+        private readonly Action<ulong> KvmSaveState;
+
+        [Import]
+        private readonly Action<ulong, ulong> KvmRestoreState;
+
 #pragma warning restore 649
 
         private readonly HookDescriptor hooks;
+        private readonly PortBlockTransfers portBlockTransfers;
+        private readonly Dictionary<ulong, CpuAddressHook> watchpoints;
 
         protected class SegmentMappingWithSlotNumber : SegmentMapping
         {
@@ -478,6 +888,12 @@ public SegmentMappingWithSlotNumber(IMappedSegment segment, int slotNumber) : ba
             }
 
             public int SlotNumber { get; set; }
+
+            public bool DirtyPagesLogging { get; set; }
+
+            public bool ReadOnly { get; set; }
+
+            public bool TrapWrites { get; set; }
         }
 
         private class HookDescriptor : HookDescriptorBase
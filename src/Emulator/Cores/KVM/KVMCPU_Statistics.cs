@@ -0,0 +1,289 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Runtime.InteropServices;
+
+using Antmicro.Migrant;
+using Antmicro.Renode.Exceptions;
+using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.CPU.GuestProfiling.ProtoBuf;
+using Antmicro.Renode.Utilities.Binding;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    public abstract partial class KVMCPU
+    {
+        public void EnableExitStatistics(bool enabled = true)
+        {
+            KvmSetStatisticsEnabled(enabled ? 1u : 0u);
+            exitStatisticsEnabled = enabled;
+        }
+
+        public void ResetExitStatistics()
+        {
+            KvmResetStatistics();
+            exitStatisticsTracer?.Reset();
+        }
+
+        // Returns exit counts per reason, time breakdown and the most frequently accessed IO ports and MMIO addresses.
+        // Time spent in KVM_RUN includes both guest execution and exits handled by the kernel.
+        public string[,] GetExitStatistics(int topAddresses = 10)
+        {
+            if(!exitStatisticsEnabled)
+            {
+                throw new RecoverableException("Exit statistics are disabled, enable them with `EnableExitStatistics`");
+            }
+
+            var rows = new List<string[]>();
+            rows.Add(new[] { "Statistic", "Value" });
+
+            for(var reason = 0u; reason < ExitReasonsCount; reason++)
+            {
+                var count = KvmGetExitCount(reason);
+                if(count != 0)
+                {
+                    rows.Add(new[] { $"Exits: {GetExitReasonName(reason)}", count.ToString() });
+                }
+            }
+            rows.Add(new[] { "Interrupted runs", KvmGetInterruptedRunsCount().ToString() });
+
+            foreach(StatisticsTimeType type in Enum.GetValues(typeof(StatisticsTimeType)))
+            {
+                rows.Add(new[] { $"Time: {type} [ms]", (KvmGetTimeStatistic((uint)type) / 1e6).ToString("F3") });
+            }
+
+            foreach(StatisticsAccessType type in Enum.GetValues(typeof(StatisticsAccessType)))
+            {
+                foreach(var counter in GetAccessStatistics(type).Take(topAddresses))
+                {
+                    rows.Add(new[] { $"{type} accesses: 0x{counter.Address:X}", counter.Count.ToString() });
+                }
+                var untracked = KvmGetUntrackedAccessesCount((uint)type);
+                if(untracked != 0)
+                {
+                    rows.Add(new[] { $"{type} accesses: other", untracked.ToString() });
+                }
+            }
+
+            var table = new string[rows.Count, 2];
+            for(var i = 0; i < rows.Count; i++)
+            {
+                table[i, 0] = rows[i][0];
+                table[i, 1] = rows[i][1];
+            }
+            return table;
+        }
+
+        // Writes exit counts and time breakdown of each quantum as Perfetto counter tracks.
+        public void EnableExitStatisticsTrace(string filename)
+        {
+            DisableExitStatisticsTrace();
+            EnableExitStatistics();
+            try
+            {
+                exitStatisticsTracer = new ExitStatisticsTracer(this, filename);
+            }
+            catch(IOException e)
+            {
+                throw new RecoverableException($"There was an error when preparing the trace file {filename}: {e.Message}");
+            }
+        }
+
+        public void DisableExitStatisticsTrace()
+        {
+            exitStatisticsTracer?.Dispose();
+            exitStatisticsTracer = null;
+        }
+
+        private IEnumerable<AccessCounter> GetAccessStatistics(StatisticsAccessType type)
+        {
+            var counters = new AccessCounter[AccessCountersTableSize];
+            var handle = GCHandle.Alloc(counters, GCHandleType.Pinned);
+            try
+            {
+                var count = KvmGetAccessStatistics((uint)type, (ulong)handle.AddrOfPinnedObject(), (uint)counters.Length);
+                return counters.Take((int)count).OrderByDescending(x => x.Count).ToArray();
+            }
+            finally
+            {
+                handle.Free();
+            }
+        }
+
+        private static string GetExitReasonName(uint reason)
+        {
+            return Enum.IsDefined(typeof(KvmExitReason), reason) ? ((KvmExitReason)reason).ToString() : $"reason {reason}";
+        }
+
+        private bool exitStatisticsEnabled;
+
+        [Transient]
+        private ExitStatisticsTracer exitStatisticsTracer;
+
+#pragma warning disable 649
+
+        [Import]
+        private readonly Action<uint> KvmSetStatisticsEnabled;
+
+        [Import]
+        private readonly Action KvmResetStatistics;
+
+        [Import]
+        private readonly Func<uint, ulong> KvmGetExitCount;
+
+        [Import]
+        private readonly Func<ulong> KvmGetInterruptedRunsCount;
+
+        [Import]
+        private readonly Func<uint, ulong> KvmGetTimeStatistic;
+
+        [Import]
+        private readonly Func<uint, ulong, uint, uint> KvmGetAccessStatistics;
+
+        [Import]
+        private readonly Func<uint, ulong> KvmGetUntrackedAccessesCount;
+
+#pragma warning restore 649
+
+        // Has to match STATS_EXIT_REASONS_COUNT and STATS_ADDRESSES_COUNT in stats.h
+        private const uint ExitReasonsCount = 64;
+        private const int AccessCountersTableSize = 256;
+
+        [StructLayout(LayoutKind.Sequential)]
+        private struct AccessCounter
+        {
+            public ulong Address;
+            public ulong Count;
+        }
+
+        // Has to match StatsTimeType in stats.h
+        private enum StatisticsTimeType : uint
+        {
+            KvmRun = 0,
+            Userspace = 1,
+            Callbacks = 2,
+        }
+
+        // Has to match StatsAccessType in stats.h
+        private enum StatisticsAccessType : uint
+        {
+            IoPort = 0,
+            Mmio = 1,
+        }
+
+        // Values of KVM_EXIT_* from linux/kvm.h
+        private enum KvmExitReason : uint
+        {
+            Unknown = 0,
+            Exception = 1,
+            Io = 2,
+            Hypercall = 3,
+            Debug = 4,
+            Hlt = 5,
+            Mmio = 6,
+            IrqWindowOpen = 7,
+            Shutdown = 8,
+            FailEntry = 9,
+            Intr = 10,
+            SetTpr = 11,
+            TprAccess = 12,
+            Nmi = 16,
+            InternalError = 17,
+            SystemEvent = 24,
+            IoapicEoi = 26,
+            X86Rdmsr = 29,
+            X86Wrmsr = 30,
+            X86BusLock = 33,
+        }
+
+        private class ExitStatisticsTracer : IDisposable
+        {
+            public ExitStatisticsTracer(KVMCPU cpu, string filename)
+            {
+                this.cpu = cpu;
+                fileStream = File.Open(filename, FileMode.Create);
+                writer = new PerfettoTraceWriter();
+                previousValues = new ulong[Tracks.Length];
+                foreach(var track in Tracks)
+                {
+                    writer.CreateTrack($"{cpu.GetName()}: {track.Name}", TrackId(track), isCounterTrack: true);
+                }
+                Reset();
+            }
+
+            // Called after each quantum, values are stored as deltas against the previous quantum
+            public void Sample()
+            {
+                var timestamp = cpu.machine.LocalTimeSource.ElapsedVirtualTime.TotalNanoseconds;
+                for(var i = 0; i < Tracks.Length; i++)
+                {
+                    var value = Tracks[i].Read(cpu);
+                    writer.CreateEventCounter(timestamp, (long)(value - previousValues[i]), TrackId(Tracks[i]));
+                    previousValues[i] = value;
+                }
+
+                if(writer.PacketCount > BufferFlushLevel)
+                {
+                    writer.FlushBuffer(fileStream);
+                }
+            }
+
+            public void Reset()
+            {
+                for(var i = 0; i < Tracks.Length; i++)
+                {
+                    previousValues[i] = Tracks[i].Read(cpu);
+                }
+            }
+
+            public void Dispose()
+            {
+                writer.FlushBuffer(fileStream);
+                fileStream.Close();
+                cpu.Log(LogLevel.Info, "Exit statistics trace has been saved to {0}", fileStream.Name);
+            }
+
+            private ulong TrackId(TrackDescription track) => (ulong)cpu.UniqueObjectId << 8 | (ulong)Array.IndexOf(Tracks, track);
+
+            private readonly KVMCPU cpu;
+            private readonly FileStream fileStream;
+            private readonly PerfettoTraceWriter writer;
+            private readonly ulong[] previousValues;
+
+            private static readonly TrackDescription[] Tracks =
+            {
+                new TrackDescription("IO exits", c => c.KvmGetExitCount((uint)KvmExitReason.Io)),
+                new TrackDescription("MMIO exits", c => c.KvmGetExitCount((uint)KvmExitReason.Mmio)),
+                new TrackDescription("Other exits", c => Enumerable.Range(0, (int)ExitReasonsCount)
+                    .Where(x => x != (int)KvmExitReason.Io && x != (int)KvmExitReason.Mmio)
+                    .Aggregate(0UL, (sum, x) => sum + c.KvmGetExitCount((uint)x))),
+                new TrackDescription("Interrupted runs", c => c.KvmGetInterruptedRunsCount()),
+                new TrackDescription("KVM_RUN time [ns]", c => c.KvmGetTimeStatistic((uint)StatisticsTimeType.KvmRun)),
+                new TrackDescription("Userspace time [ns]", c => c.KvmGetTimeStatistic((uint)StatisticsTimeType.Userspace)),
+                new TrackDescription("Callbacks time [ns]", c => c.KvmGetTimeStatistic((uint)StatisticsTimeType.Callbacks)),
+            };
+
+            private const int BufferFlushLevel = 10000;
+
+            private class TrackDescription
+            {
+                public TrackDescription(string name, Func<KVMCPU, ulong> read)
+                {
+                    Name = name;
+                    Read = read;
+                }
+
+                public string Name { get; }
+
+                public Func<KVMCPU, ulong> Read { get; }
+            }
+        }
+    }
+}
@@ -0,0 +1,145 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+using Antmicro.Migrant;
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Services string port I/O (`rep ins`/`rep outs`) exits of KVMCPU. Peripherals implementing IPortBlockPeripheral
+    // receive the whole block in one call, other ones are accessed element by element through the system bus.
+    public class PortBlockTransfers
+    {
+        public PortBlockTransfers(IMachine machine, IPeripheral context, ulong portsBaseAddress)
+        {
+            this.machine = machine;
+            this.context = context;
+            this.portsBaseAddress = portsBaseAddress;
+            machine.PeripheralsChanged += OnMachinePeripheralsChanged;
+        }
+
+        public void Read(ushort port, uint width, uint count, IntPtr buffer)
+        {
+            var length = checked((int)(width * count));
+            if(TryGetPortBlockPeripheral(port, out var peripheral, out var offset))
+            {
+                var data = GetBuffer(length);
+                peripheral.ReadPortBlock(offset, (SysbusAccessWidth)width, data, (int)count);
+                Marshal.Copy(data, 0, buffer, length);
+                return;
+            }
+
+            var address = portsBaseAddress + port;
+            for(var position = 0; position < length; position += (int)width)
+            {
+                switch(width)
+                {
+                case 1:
+                    Marshal.WriteByte(buffer, position, machine.SystemBus.ReadByte(address, context));
+                    break;
+                case 2:
+                    Marshal.WriteInt16(buffer, position, unchecked((short)machine.SystemBus.ReadWord(address, context)));
+                    break;
+                case 4:
+                    Marshal.WriteInt32(buffer, position, unchecked((int)machine.SystemBus.ReadDoubleWord(address, context)));
+                    break;
+                default:
+                    throw new CpuAbortException($"Invalid io access width: {width} bytes");
+                }
+            }
+        }
+
+        public void Write(ushort port, uint width, uint count, IntPtr buffer)
+        {
+            var length = checked((int)(width * count));
+            if(TryGetPortBlockPeripheral(port, out var peripheral, out var offset))
+            {
+                var data = GetBuffer(length);
+                Marshal.Copy(buffer, data, 0, length);
+                peripheral.WritePortBlock(offset, (SysbusAccessWidth)width, data, (int)count);
+                return;
+            }
+
+            var address = portsBaseAddress + port;
+            for(var position = 0; position < length; position += (int)width)
+            {
+                switch(width)
+                {
+                case 1:
+                    machine.SystemBus.WriteByte(address, Marshal.ReadByte(buffer, position), context);
+                    break;
+                case 2:
+                    machine.SystemBus.WriteWord(address, unchecked((ushort)Marshal.ReadInt16(buffer, position)), context);
+                    break;
+                case 4:
+                    machine.SystemBus.WriteDoubleWord(address, unchecked((uint)Marshal.ReadInt32(buffer, position)), context);
+                    break;
+                default:
+                    throw new CpuAbortException($"Invalid io access width: {width} bytes");
+                }
+            }
+        }
+
+        private void OnMachinePeripheralsChanged(IMachine machine, PeripheralsChangedEventArgs args)
+        {
+            // The cache is replaced rather than cleared, as it can be used by the CPU thread at the same time
+            portBlockPeripherals = null;
+        }
+
+        // Lookups are cached per port, including the ones which didn't find a port block peripheral, until the peripherals change
+        private bool TryGetPortBlockPeripheral(ushort port, out IPortBlockPeripheral peripheral, out long offset)
+        {
+            var cache = portBlockPeripherals;
+            if(cache == null)
+            {
+                cache = new Dictionary<ushort, PortBlockPeripheral>();
+                portBlockPeripherals = cache;
+            }
+
+            if(!cache.TryGetValue(port, out var entry))
+            {
+                var busAddress = portsBaseAddress + port;
+                var registered = machine.SystemBus.WhatIsAt(busAddress, context);
+                entry.Peripheral = registered?.Peripheral as IPortBlockPeripheral;
+                entry.Offset = entry.Peripheral == null ? 0 : checked((long)(busAddress - registered.RegistrationPoint.Range.StartAddress + registered.RegistrationPoint.Offset));
+                cache[port] = entry;
+            }
+            peripheral = entry.Peripheral;
+            offset = entry.Offset;
+            return peripheral != null;
+        }
+
+        private byte[] GetBuffer(int length)
+        {
+            if(buffer == null || buffer.Length < length)
+            {
+                buffer = new byte[length];
+            }
+            return buffer;
+        }
+
+        [Transient]
+        private byte[] buffer;
+
+        [Transient]
+        private Dictionary<ushort, PortBlockPeripheral> portBlockPeripherals;
+
+        private readonly IMachine machine;
+        private readonly IPeripheral context;
+        private readonly ulong portsBaseAddress;
+
+        private struct PortBlockPeripheral
+        {
+            public IPortBlockPeripheral Peripheral;
+            public long Offset;
+        }
+    }
+}
@@ -152,7 +152,7 @@ protected override string GetExceptionDescription(ulong exceptionIndex)
         [Export]
         private ulong ReadDecrementer()
         {
-            return checked((uint)machine.ClockSource.GetClockEntry(DecrementerHandler).Value);
+            return ReadTimeCounter(DefaultTimeCounterKey, () => checked((uint)machine.ClockSource.GetClockEntry(DecrementerHandler).Value));
         }
 
         [Export]
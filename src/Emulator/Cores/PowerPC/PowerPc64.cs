@@ -145,7 +145,7 @@ protected override Interrupt DecodeInterrupt(int number)
         [Export]
         private ulong ReadDecrementer()
         {
-            return checked((ulong)machine.ClockSource.GetClockEntry(DecrementerHandler).Value);
+            return ReadTimeCounter(DefaultTimeCounterKey, () => checked((ulong)machine.ClockSource.GetClockEntry(DecrementerHandler).Value));
         }
 
         [Export]
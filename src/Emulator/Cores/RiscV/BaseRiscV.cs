@@ -7,6 +7,7 @@
 using System;
 using System.Collections.Generic;
 using System.Diagnostics;
+using System.IO;
 using System.Linq;
 using System.Runtime.InteropServices;
 
@@ -28,7 +29,7 @@
 
 namespace Antmicro.Renode.Peripherals.CPU
 {
-    public abstract class BaseRiscV : TranslationCPU, IPeripheralContainer<ICFU, NumberRegistrationPoint<int>>, IPeripheralContainer<IIndirectCSRPeripheral, BusRangeRegistration>, IRegisterablePeripheral<ExternalPMPBase, NullRegistrationPoint>, ICPUWithPostGprAccessHooks, ICPUWithNMI, ICPUWithDirtyAdressesSharing
+    public abstract class BaseRiscV : TranslationCPU, IPeripheralContainer<ICFU, NumberRegistrationPoint<int>>, IPeripheralContainer<IIndirectCSRPeripheral, BusRangeRegistration>, IRegisterablePeripheral<ExternalPMPBase, NullRegistrationPoint>, IExternalPMPRegionTable, INativeCustomInstructionTarget, ICPUWithPostGprAccessHooks, ICPUWithNMI, ICPUWithDirtyAdressesSharing
     {
         public void Register(ICFU cfu, NumberRegistrationPoint<int> registrationPoint)
         {
@@ -71,6 +72,16 @@ public void SetPMPAddress(uint index, ulong start_address, ulong end_address)
             TlibSetPmpaddr(index, start_address, end_address);
         }
 
+        public void ConfigureExternalPMPRegions(uint regionsCount, ulong addressMask)
+        {
+            RenodeExtpmpConfigure(regionsCount, addressMask);
+        }
+
+        public void SetExternalPMPRegion(uint index, ulong startAddress, ulong endAddress, uint config)
+        {
+            RenodeExtpmpSetRegion(index, startAddress, endAddress, config);
+        }
+
         public void EnablePreStackAccessHook(bool value)
         {
             TlibEnablePreStackAccessHook(value);
@@ -109,15 +120,56 @@ public void EnableCustomOpcodesCounting()
 
         public bool InstallCustomInstruction(string pattern, Action<UInt64> handler, string name = null)
         {
-            if(pattern == null)
-            {
-                throw new ArgumentException("Pattern cannot be null");
-            }
             if(handler == null)
             {
                 throw new ArgumentException("Handler cannot be null");
             }
 
+            var id = InstallCustomInstructionPattern(pattern, name);
+            customInstructionsMapping[id] = handler;
+            return true;
+        }
+
+        /// <summary>
+        /// Installs a custom instruction handled by <paramref name="handlerName"/> function of a native shared library,
+        /// which is called without leaving the translation library. See <c>renode_riscv_plugin.h</c> for its ABI.
+        /// </summary>
+        public bool InstallNativeCustomInstruction(string pattern, string libraryPath, string handlerName, string name = null)
+        {
+            if(libraryPath == null || handlerName == null)
+            {
+                throw new ArgumentException("Library path and handler name cannot be null");
+            }
+            if(!File.Exists(libraryPath))
+            {
+                throw new RecoverableException($"Custom instruction plugin {libraryPath} does not exist");
+            }
+            nativeCustomInstructions.Install(pattern, Path.GetFullPath(libraryPath), handlerName, name);
+            return true;
+        }
+
+        bool INativeCustomInstructionTarget.ResolveNativeCustomInstruction(string libraryPath, string handlerName)
+        {
+            return RenodeRiscvResolveNativeCustomInstruction(libraryPath, handlerName) != 0;
+        }
+
+        ulong INativeCustomInstructionTarget.InstallCustomInstructionPattern(string pattern, string name)
+        {
+            return InstallCustomInstructionPattern(pattern, name);
+        }
+
+        bool INativeCustomInstructionTarget.InstallNativeCustomInstructionHandler(ulong id, string libraryPath, string handlerName)
+        {
+            return RenodeRiscvInstallNativeCustomInstruction(id, libraryPath, handlerName) != 0;
+        }
+
+        private ulong InstallCustomInstructionPattern(string pattern, string name)
+        {
+            if(pattern == null)
+            {
+                throw new ArgumentException("Pattern cannot be null");
+            }
+
             if(pattern.Length != 64 && pattern.Length != 32 && pattern.Length != 16)
             {
                 throw new RecoverableException($"Unsupported custom instruction length: {pattern.Length}. Supported values are: 16, 32, 64 bits");
@@ -136,8 +188,7 @@ public bool InstallCustomInstruction(string pattern, Action<UInt64> handler, str
             }
 
             customOpcodes.Add(Tuple.Create(name ?? pattern, bitPattern, bitMask));
-            customInstructionsMapping[id] = handler;
-            return true;
+            return id;
         }
 
         public void SilenceUnsupportedInstructionSet(InstructionSet set, bool silent = true)
@@ -156,21 +207,49 @@ public void RegisterCustomInternalInterrupt(ulong id, bool mipTriggered = false,
         public void RegisterCustomCSR(string name, ushort number, PrivilegeLevel mode)
         {
             var customCSR = new SimpleCSR(name, number, mode);
-            if(simpleCSRs.Keys.Any(x => x.Number == customCSR.Number))
+            if(simpleCSRs.Any(x => x.Number == customCSR.Number))
             {
                 throw new ConstructionException($"Cannot register CSR {customCSR.Name}, because its number 0x{customCSR.Number:X} is already registered");
             }
-            simpleCSRs.Add(customCSR, 0);
-            RegisterCSR(customCSR.Number, () => simpleCSRs[customCSR], value => simpleCSRs[customCSR] = value, name);
+            RegisterStorageCSR(customCSR.Number, name: name);
+            simpleCSRs.Add(customCSR);
+        }
+
+        /// <summary>
+        /// Registers a CSR which only stores the written value. Its accesses are handled without leaving the translation library,
+        /// unless <paramref name="writeHandler"/> is given, which is called with the new value of the CSR after every write.
+        /// Writes done by the guest only change the bits set in <paramref name="writableMask"/>, use <see cref="SetStorageCSR"/> to change the others.
+        /// </summary>
+        public void RegisterStorageCSR(ushort csr, ulong resetValue = 0, ulong writableMask = ulong.MaxValue, Action<ulong> writeHandler = null, string name = null)
+        {
+            // The storage is declared first, so that the CSR is never installed without it
+            DeclareStorageRegister(StorageRegisterSpace.ControlAndStatusRegister, csr, ulong.MaxValue, resetValue, writableMask, writeHandler,
+                install: () => RegisterCSR(csr,
+                    () => GetStorageRegister(StorageRegisterSpace.ControlAndStatusRegister, csr),
+                    value => SetStorageRegister(StorageRegisterSpace.ControlAndStatusRegister, csr, ulong.MaxValue, value),
+                    name));
+        }
+
+        /// <summary>
+        /// Sets all the bits of a CSR registered with <see cref="RegisterStorageCSR"/>, including the ones which aren't writable by the guest.
+        /// Its write handler isn't called.
+        /// </summary>
+        public void SetStorageCSR(ushort csr, ulong value)
+        {
+            SetStorageRegisterUnmasked(StorageRegisterSpace.ControlAndStatusRegister, csr, ulong.MaxValue, value);
         }
 
         public void RegisterCSR(ushort csr, Func<ulong> readOperation, Action<ulong> writeOperation, string name = null)
         {
-            nonstandardCSR.Add(csr, new NonstandardCSR(readOperation, writeOperation, name));
+            if(nonstandardCSR.ContainsKey(csr))
+            {
+                throw new ConstructionException($"Cannot register CSR 0x{csr:X}, because it's already registered");
+            }
             if(TlibInstallCustomCSR(csr) == -1)
             {
                 throw new ConstructionException($"CSR limit exceeded. Cannot register CSR 0x{csr:X}");
             }
+            nonstandardCSR.Add(csr, new NonstandardCSR(readOperation, writeOperation, name));
         }
 
         public void RegisterCSRStub(IConvertible csr, string name, ulong returnValue = 0)
@@ -276,10 +355,6 @@ public override void Reset()
             pcWrittenFlag = false;
             ShouldEnterDebugMode = true;
             EnableArchitectureVariants();
-            foreach(var key in simpleCSRs.Keys.ToArray())
-            {
-                simpleCSRs[key] = 0;
-            }
             UserState.Clear();
             SetPCFromResetVector();
             TlibSetPmpaddrBits(PMPNumberOfAddrBits);
@@ -303,6 +378,8 @@ public void Register(ExternalPMPBase externalPMP, NullRegistrationPoint registra
         public void Unregister(ExternalPMPBase peripheral)
         {
             this.externalPMP = null;
+            // Pass all the checks to C# again, where they fail without an external PMP
+            RenodeExtpmpConfigure(0, 0);
             TlibEnableExternalPmp(false);
             machine.UnregisterAsAChildOf(this, peripheral);
         }
@@ -508,6 +585,7 @@ public bool WfiAsNop
             shouldEnterDebugMode = true;
             nonstandardCSR = new Dictionary<ulong, NonstandardCSR>();
             customInstructionsMapping = new Dictionary<ulong, Action<UInt64>>();
+            nativeCustomInstructions = new NativeCustomInstructionTable(this);
             indirectCsrPeripherals = new Dictionary<BusRangeRegistration, IIndirectCSRPeripheral>();
             this.nmiVectorLength = nmiVectorLength;
             this.nmiVectorAddress = nmiVectorAddress;
@@ -635,6 +713,20 @@ protected override Interrupt DecodeInterrupt(int number)
             return Interrupt.Hard;
         }
 
+        protected override void AfterLoad(IntPtr statePtr)
+        {
+            base.AfterLoad(statePtr);
+            // Plugins are loaded again, so they start with a fresh state
+            nativeCustomInstructions.Restore((libraryPath, handlerName) =>
+                this.Log(LogLevel.Error, "Could not restore native custom instruction handler {0} from {1}", handlerName, libraryPath));
+        }
+
+        protected override void DisposeInner(bool silent = false)
+        {
+            RenodeRiscvUnloadCustomInstructionPlugins();
+            base.DisposeInner(silent);
+        }
+
         protected bool TryGetCustomCSR(int register, out RegisterValue value)
         {
             value = default(RegisterValue);
@@ -975,7 +1067,9 @@ private ulong GetCPUTime()
             }
 
             SyncTime();
-            return timeProvider.TimerValue;
+            var value = timeProvider.TimerValue;
+            PublishLinearTimeCounter(DefaultTimeCounterKey, timeProvider as ILinearTimer);
+            return value;
         }
 
         [Export]
@@ -1158,7 +1252,9 @@ private void WriteCSR(ulong csr, ulong value)
 
         private readonly Dictionary<ulong, Action<UInt64>> customInstructionsMapping;
 
-        private readonly Dictionary<SimpleCSR, ulong> simpleCSRs = new Dictionary<SimpleCSR, ulong>();
+        private readonly NativeCustomInstructionTable nativeCustomInstructions;
+
+        private readonly HashSet<SimpleCSR> simpleCSRs = new HashSet<SimpleCSR>();
 
         private readonly ArchitectureDecoder architectureDecoder;
 
@@ -1211,6 +1307,21 @@ private void WriteCSR(ulong csr, ulong value)
         [Import]
         private readonly Action<uint, ulong, ulong> TlibSetPmpaddr;
 
+        [Import]
+        private readonly Action<uint, ulong> RenodeExtpmpConfigure;
+
+        [Import]
+        private readonly Action<uint, ulong, ulong, uint> RenodeExtpmpSetRegion;
+
+        [Import]
+        private readonly Func<string, string, uint> RenodeRiscvResolveNativeCustomInstruction;
+
+        [Import]
+        private readonly Func<ulong, string, string, uint> RenodeRiscvInstallNativeCustomInstruction;
+
+        [Import]
+        private readonly Action RenodeRiscvUnloadCustomInstructionPlugins;
+
         [Import]
         private readonly Func<ulong, ulong, ulong, ulong> TlibInstallCustomInstruction;
 
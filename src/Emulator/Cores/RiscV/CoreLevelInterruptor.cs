@@ -16,7 +16,7 @@
 namespace Antmicro.Renode.Peripherals.IRQControllers
 {
     [AllowedTranslations(AllowedTranslation.QuadWordToDoubleWord)]
-    public class CoreLevelInterruptor : IDoubleWordPeripheral, IKnownSize, INumberedGPIOOutput, IRiscVTimeProvider
+    public class CoreLevelInterruptor : IDoubleWordPeripheral, IKnownSize, INumberedGPIOOutput, IRiscVTimeProvider, ILinearTimer
     {
         public CoreLevelInterruptor(IMachine machine, ulong frequency, int numberOfTargets = 1, ulong divider = 1)
         {
@@ -121,6 +121,11 @@ public void Reset()
             }
         }
 
+        public bool TryGetLinearState(out LinearTimerState state)
+        {
+            return mTimers[0].TryGetLinearState(out state);
+        }
+
         public uint ReadDoubleWord(long offset)
         {
             return registers.Read(offset);
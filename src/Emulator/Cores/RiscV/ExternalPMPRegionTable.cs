@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+namespace Antmicro.Renode.Peripherals.Miscellaneous
+{
+    // Implemented by BaseRiscV, whose native library checks the accesses against the published regions
+    // instead of asking the external PMP about each of them
+    public interface IExternalPMPRegionTable
+    {
+        // Clears all the regions, tables with more regions than the native library supports are never used
+        void ConfigureExternalPMPRegions(uint regionsCount, ulong addressMask);
+
+        void SetExternalPMPRegion(uint index, ulong startAddress, ulong endAddress, uint config);
+    }
+
+    // Publishes the regions of an external PMP, keeping what was sent last, so that only the regions that changed are sent
+    public class ExternalPMPRegionTable
+    {
+        public ExternalPMPRegionTable(IExternalPMPRegionTable target)
+        {
+            this.target = target;
+        }
+
+        public void Configure(uint regionsCount, ulong addressMask)
+        {
+            target.ConfigureExternalPMPRegions(regionsCount, addressMask);
+            // Regions start zeroed in the native table
+            published = new Region[regionsCount];
+        }
+
+        // Ranges are inclusive, `permissions` are encoded the same way as the result of `ExternalPMPBase.GetAccess`
+        public void SetRegion(int index, ulong startAddress, ulong endAddress, byte permissions, bool enabled, bool locked)
+        {
+            var region = new Region
+            {
+                StartAddress = startAddress,
+                EndAddress = endAddress,
+                Config = EncodeConfig(permissions, enabled, locked),
+            };
+            if(published[index].Equals(region))
+            {
+                return;
+            }
+            published[index] = region;
+            target.SetExternalPMPRegion((uint)index, startAddress, endAddress, region.Config);
+        }
+
+        public static uint EncodeConfig(byte permissions, bool enabled, bool locked)
+        {
+            var config = (uint)permissions & PermissionsMask;
+            config |= enabled ? RegionEnabled : 0;
+            config |= locked ? RegionLocked : 0;
+            return config;
+        }
+
+        // Have to match the region config bits in renode_riscv_callbacks.c
+        public const uint PermissionsMask = 0x7;
+        public const uint RegionEnabled = 1 << 3;
+        public const uint RegionLocked = 1 << 4;
+
+        private Region[] published = new Region[0];
+
+        private readonly IExternalPMPRegionTable target;
+
+        private struct Region
+        {
+            public ulong StartAddress;
+            public ulong EndAddress;
+            public uint Config;
+        }
+    }
+}
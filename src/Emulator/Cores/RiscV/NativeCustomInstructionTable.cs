@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+
+using Antmicro.Renode.Exceptions;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Implemented by BaseRiscV, whose native library calls the handlers from the plugins without leaving tlib
+    public interface INativeCustomInstructionTarget
+    {
+        // Loads the plugin and looks up the handler without installing it
+        bool ResolveNativeCustomInstruction(string libraryPath, string handlerName);
+
+        // Returns the id of the instruction in tlib, which can't uninstall it
+        ulong InstallCustomInstructionPattern(string pattern, string name);
+
+        bool InstallNativeCustomInstructionHandler(ulong id, string libraryPath, string handlerName);
+    }
+
+    // Installs native custom instructions, keeping them to install their handlers again after the emulation is loaded,
+    // as the plugins aren't part of the serialized state
+    public class NativeCustomInstructionTable
+    {
+        public NativeCustomInstructionTable(INativeCustomInstructionTarget target)
+        {
+            this.target = target;
+        }
+
+        public ulong Install(string pattern, string libraryPath, string handlerName, string name)
+        {
+            // The pattern is only installed once the handler is known to be installable, as it can't be uninstalled
+            if(!target.ResolveNativeCustomInstruction(libraryPath, handlerName))
+            {
+                throw new ConstructionException($"Could not install native custom instruction handler {handlerName} from {libraryPath}, see the log for details");
+            }
+            var id = target.InstallCustomInstructionPattern(pattern, name);
+            if(!target.InstallNativeCustomInstructionHandler(id, libraryPath, handlerName))
+            {
+                throw new ConstructionException($"Could not install native custom instruction handler {handlerName} from {libraryPath}, see the log for details");
+            }
+            instructions.Add(new NativeCustomInstruction { Id = id, LibraryPath = libraryPath, HandlerName = handlerName });
+            return id;
+        }
+
+        // The patterns are restored by tlib, only the handlers are installed again. `onFailure` gets the library path and the handler name.
+        public void Restore(Action<string, string> onFailure)
+        {
+            foreach(var instruction in instructions)
+            {
+                if(!target.InstallNativeCustomInstructionHandler(instruction.Id, instruction.LibraryPath, instruction.HandlerName))
+                {
+                    onFailure(instruction.LibraryPath, instruction.HandlerName);
+                }
+            }
+        }
+
+        private readonly INativeCustomInstructionTarget target;
+        private readonly List<NativeCustomInstruction> instructions = new List<NativeCustomInstruction>();
+
+        private struct NativeCustomInstruction
+        {
+            public ulong Id;
+            public string LibraryPath;
+            public string HandlerName;
+        }
+    }
+}
@@ -23,13 +23,13 @@ public Ri5cy(IMachine machine, IRiscVTimeProvider timeProvider = null, uint hart
 
             // register custom CSRs
             // TODO: add support for HW loops
-            RegisterCSR((ushort)0x7b0, () => 0u, _ => { }); //lpstart0
-            RegisterCSR((ushort)0x7b1, () => 0u, _ => { }); //lpend1
-            RegisterCSR((ushort)0x7b2, () => 0u, _ => { }); //lpcount0
+            RegisterStorageCSR((ushort)0x7b0, writableMask: 0); //lpstart0
+            RegisterStorageCSR((ushort)0x7b1, writableMask: 0); //lpend1
+            RegisterStorageCSR((ushort)0x7b2, writableMask: 0); //lpcount0
 
-            RegisterCSR((ushort)0x7b4, () => 0u, _ => { }); //lpstart1
-            RegisterCSR((ushort)0x7b5, () => 0u, _ => { }); //lpend1
-            RegisterCSR((ushort)0x7b6, () => 0u, _ => { }); //lpcount1
+            RegisterStorageCSR((ushort)0x7b4, writableMask: 0); //lpstart1
+            RegisterStorageCSR((ushort)0x7b5, writableMask: 0); //lpend1
+            RegisterStorageCSR((ushort)0x7b6, writableMask: 0); //lpcount1
         }
     }
 }
\ No newline at end of file
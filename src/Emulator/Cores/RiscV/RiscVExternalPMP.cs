@@ -1,5 +1,5 @@
 //
-// Copyright (c) 2010-2025 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 //
 // This file is licensed under the MIT License.
 // Full license text is available in 'licenses/MIT.txt'.
@@ -9,6 +9,7 @@
 using System.Linq;
 using System.Numerics;
 
+using Antmicro.Migrant;
 using Antmicro.Renode.Core;
 using Antmicro.Renode.Exceptions;
 using Antmicro.Renode.Logging;
@@ -53,6 +54,7 @@ public override void RegisterCPU(BaseRiscV cpu)
                 configRegisters.Add(CreateConfigRegister());
                 addressRanges.Add(new Range(0, UInt64.MaxValue));
             }
+            ConfigureNativeRegionTable();
         }
 
         public override byte GetAccess(ulong address, ulong size, AccessType accessType)
@@ -131,6 +133,7 @@ public override void Reset()
                 addressRanges[i] = new Range(0, UInt64.MaxValue);
             }
             isPMPDisabled = true;
+            ConfigureNativeRegionTable();
         }
 
         public override void ConfigCSRWrite(uint registerIndex, ulong value)
@@ -265,11 +268,32 @@ protected virtual void UpdateRule(int index)
 
             addressRanges[index] = range;
             cpu.SetPMPAddress((uint)index, range.StartAddress, range.EndAddress);
+            nativeRegionTable?.SetRegion(index, range.StartAddress, range.EndAddress, cfg.EncodeAccess(), cfg.Mode != AddressMatchingMode.Off, cfg.Lock);
 
             // If all rules are off the PMP is inactive
             isPMPDisabled = configRegisters.All(config => config.Mode == AddressMatchingMode.Off);
         }
 
+        // Lets tlib check the accesses against a copy of the regions, kept up to date by `UpdateRule`,
+        // instead of calling `GetAccess`, `TryGetOverlappingRegion` and `IsAnyRegionLocked` on every check
+        protected void ConfigureNativeRegionTable()
+        {
+            if(!UsesNativeRegionTable)
+            {
+                return;
+            }
+            if(nativeRegionTable == null)
+            {
+                nativeRegionTable = new ExternalPMPRegionTable(cpu);
+            }
+            nativeRegionTable.Configure(numberOfPMPEntries, MaskAddress(UInt64.MaxValue));
+            for(var i = 0; i < numberOfPMPEntries; i++)
+            {
+                var cfg = configRegisters[i];
+                nativeRegionTable.SetRegion(i, addressRanges[i].StartAddress, addressRanges[i].EndAddress, cfg.EncodeAccess(), cfg.Mode != AddressMatchingMode.Off, cfg.Lock);
+            }
+        }
+
         protected Range DecodeNAPOT(ulong addressReg)
         {
             if(addressReg == UInt64.MaxValue)
@@ -338,6 +362,10 @@ protected PrivilegeLevel GetEffectivePrivilege(AccessType accessType)
             return priv;
         }
 
+        // The native table follows the rules implemented here, so derived classes which change how the accesses
+        // are checked have to opt in after making sure they only customize the rules and config registers
+        protected virtual bool UsesNativeRegionTable => GetType() == typeof(RiscVExternalPMP);
+
         protected List<ConfigRegister> configRegisters;
         protected List<ulong> addressRegisters;
         protected List<Range> addressRanges;
@@ -348,6 +376,10 @@ protected PrivilegeLevel GetEffectivePrivilege(AccessType accessType)
         protected int entriesPerCSR;
         protected readonly uint numberOfPMPEntries;
 
+        // The native table isn't serialized, the accesses are checked in C# until it's configured again
+        [Transient]
+        private ExternalPMPRegionTable nativeRegionTable;
+
         protected const int MSTATUSIndex = 833;
 
         protected class ConfigRegister
@@ -6,7 +6,9 @@
 //
 using System;
 using System.Collections.Generic;
+using System.Runtime.InteropServices;
 
+using Antmicro.Migrant;
 using Antmicro.Renode.Core;
 using Antmicro.Renode.Core.Structure;
 using Antmicro.Renode.Exceptions;
@@ -48,6 +50,7 @@ public void Register(SemihostingUart peripheral, NullRegistrationPoint registrat
             }
             semihostingUart = peripheral;
             machine.RegisterAsAChildOf(this, peripheral, registrationPoint);
+            RenodeXtensaSemihostingConfigure(1);
         }
 
         public override void Reset()
@@ -58,10 +61,19 @@ public override void Reset()
 
         public void Unregister(SemihostingUart peripheral)
         {
+            RenodeXtensaSemihostingConfigure(0);
             semihostingUart = null;
             machine.UnregisterAsAChildOf(this, peripheral);
         }
 
+        public override ExecutionResult ExecuteInstructions(ulong numberOfInstructionsToExecute, out ulong numberOfExecutedInstructions)
+        {
+            var result = base.ExecuteInstructions(numberOfInstructionsToExecute, out numberOfExecutedInstructions);
+            // Console writes are buffered by tlib, they have to be shown at least once per quantum
+            RenodeXtensaSemihostingFlush();
+            return result;
+        }
+
         public override string GetLLVMTriple(uint flags) => AllLLVMTriples[0];
 
         public override string Architecture { get { return "xtensa"; } }
@@ -95,6 +107,37 @@ protected override Interrupt DecodeInterrupt(int number)
             return Interrupt.Hard;
         }
 
+        protected override void AfterLoad(IntPtr statePtr)
+        {
+            base.AfterLoad(statePtr);
+            RenodeXtensaSemihostingConfigure(semihostingUart != null ? 1u : 0u);
+        }
+
+        // WRITE simcalls to the console are handled by tlib, which passes them here in chunks.
+        // It's called both from tlib and from C#, so without the pause guard.
+        [Export]
+        private void FlushSemihostingConsole(uint stream, IntPtr data, uint length)
+        {
+            if(semihostingUart == null)
+            {
+                return;
+            }
+            if(consoleBuffer == null || consoleBuffer.Length < length)
+            {
+                consoleBuffer = new byte[Math.Max(length, ConsoleBufferSize)];
+            }
+            Marshal.Copy(data, consoleBuffer, 0, (int)length);
+            // The same characters as written by the managed WRITE simcall, which decodes them as ASCII
+            for(var i = 0; i < length; i++)
+            {
+                if(consoleBuffer[i] > 0x7F)
+                {
+                    consoleBuffer[i] = (byte)'?';
+                }
+            }
+            semihostingUart.SemihostingWriteBytes(consoleBuffer, 0, (int)length);
+        }
+
         [Export]
         /* AKA SIMCALL. After the simcall: "a return code will be stored to a2 and an error number to a3." */
         private void DoSemihosting()
@@ -144,7 +187,9 @@ private void DoSemihosting()
         private ulong GetCPUTime()
         {
             SyncTime();
-            return innerTimers[0].Value;
+            var value = innerTimers[0].Value;
+            PublishLinearTimeCounter(DefaultTimeCounterKey, innerTimers[0]);
+            return value;
         }
 
         private void HandleCompareReached(int id)
@@ -169,6 +214,8 @@ private void TimerMod(uint id, ulong value)
         }
 
         private SemihostingUart semihostingUart = null;
+        [Transient]
+        private byte[] consoleBuffer;
 
 #pragma warning disable 649
         // 649:  Field '...' is never assigned to, and will always have its default value null
@@ -177,11 +224,19 @@ private void TimerMod(uint id, ulong value)
 
         [Import]
         private readonly Action<uint> TlibSetSingleStep;
+
+        [Import]
+        private readonly Action<uint> RenodeXtensaSemihostingConfigure;
+
+        [Import]
+        private readonly Action RenodeXtensaSemihostingFlush;
 #pragma warning restore 649
 
         private readonly ComparingTimer[] innerTimers;
 
         private const int InnerTimersCount = 3;
+        // The size of the buffer in tlib, only larger writes need a larger one
+        private const uint ConsoleBufferSize = 4096;
 
         private enum XtensaSimcallOperation : uint
         {
@@ -6,12 +6,16 @@
 // Full license text is available in 'licenses/MIT.txt' file.
 //
 
+#include <stdbool.h>
+
 #include "arch_callbacks.h"
 #include "renode_imports.h"
+#include "renode_registers.h"
+#include "../../../tlib/include/unwind.h"
 
 #ifdef TARGET_PROTO_ARM_M
-EXTERNAL_AS(int32_t, AcknowledgeIRQ, tlib_nvic_acknowledge_irq)
-EXTERNAL_AS(int32_t, CompleteIRQ, tlib_nvic_complete_irq, int32_t)
+EXTERNAL_AS(int32_t, AcknowledgeIRQ, managed_nvic_acknowledge_irq)
+EXTERNAL_AS(int32_t, CompleteIRQ, managed_nvic_complete_irq, int32_t)
 EXTERNAL_AS(void, SetPendingIRQ, tlib_nvic_set_pending_irq, int32_t)
 EXTERNAL_AS(int32_t, SetPendingSynchronousFault, tlib_nvic_set_pending_synchronous_fault, int32_t)
 EXTERNAL_AS(int32_t, SetPendingStackingFault, tlib_nvic_set_pending_stacking_fault, int32_t, int32_t)
@@ -19,21 +23,586 @@ EXTERNAL_AS(int32_t, SetPendingVectorFault, tlib_nvic_set_pending_vector_fault,
 EXTERNAL_AS(uint32_t, GetFpccrReadyBits, tlib_nvic_get_fpccr_ready_bits, int32_t, int32_t)
 EXTERNAL_AS(int32_t, SetPendingLazyFpFault, tlib_nvic_set_pending_lazy_fp_fault, int32_t, uint32_t)
 EXTERNAL_AS(void, OnLockupStateChange, tlib_on_lockup_state_change, int32_t)
-EXTERNAL_AS(int32_t, FindPendingIRQ, tlib_nvic_find_pending_irq)
-EXTERNAL_AS(void, OnBASEPRIWrite, tlib_nvic_write_basepri, int32_t, uint32_t)
-EXTERNAL_AS(int32_t, PendingMaskedIRQ, tlib_nvic_get_pending_masked_irq)
+EXTERNAL_AS(int32_t, FindPendingIRQ, managed_nvic_find_pending_irq)
+EXTERNAL_AS(void, OnBASEPRIWrite, managed_nvic_write_basepri, int32_t, uint32_t)
+EXTERNAL_AS(int32_t, PendingMaskedIRQ, managed_nvic_get_pending_masked_irq)
 EXTERNAL_AS(uint32_t, HasEnabledTrustZone, tlib_has_enabled_trustzone)
 EXTERNAL_AS(uint32_t, InterruptTargetsSecure, tlib_nvic_interrupt_targets_secure, int32_t)
 EXTERNAL_AS(int32_t, CustomIdauHandler, tlib_custom_idau_handler, voidptr, voidptr, voidptr)
+
+uint32_t tlib_get_primask(uint32_t secure);
+uint32_t tlib_get_faultmask(uint32_t secure);
+void tlib_set_irq(int32_t interrupt, int32_t state);
+
+//  Exceptions without the Secure banked ones. Has to match IRQCount in NVIC.cs
+#define NVIC_EXCEPTIONS   (512 + 16 + 1)
+//  The Secure banked exceptions follow the other ones, as in ExceptionSimpleArray in NVIC.cs
+#define NVIC_SLOTS        (NVIC_EXCEPTIONS + 7)
+#define NVIC_WORDS        ((NVIC_SLOTS + 63) / 64)
+#define NVIC_NMI          2
+#define NVIC_NO_PRIORITY  0x100
+#define NVIC_SECURE_BIT   (1 << 30)
+#define NVIC_OPERATIONS   32
+//  Interrupt.Hard in TranslationCPU.cs, the input the NVIC drives
+#define NVIC_CPU_IRQ      (1 << 1)
+
+//  Has to match NVICNativeFlags in NVICNativeState.cs
+#define NVIC_FLAG_LOCKED_UP  (1 << 0)
+#define NVIC_FLAG_TRUSTZONE  (1 << 1)
+#define NVIC_FLAG_PRIS       (1 << 2)
+#define NVIC_FLAG_BFHFNMINS  (1 << 3)
+
+//  Has to match NVICNativeOperationType in NVICNativeState.cs
+typedef enum {
+    NVIC_OPERATION_NONE,
+    NVIC_OPERATION_ACKNOWLEDGE,
+    NVIC_OPERATION_COMPLETE,
+    NVIC_OPERATION_WRITE_BASEPRI_NS,
+    NVIC_OPERATION_WRITE_BASEPRI_S,
+} nvic_operation_type_t;
+
+//  Mirror of the NVIC state, published by NVIC.cs after each of its arbitrations. tlib's queries are arbitrated here,
+//  with the current PRIMASK and FAULTMASK. Acknowledging and completing exceptions and writing BASEPRI update the mirror
+//  and are recorded, NVIC.cs applies them to its own state when it's used next. C# is only called if the IRQ line would
+//  be raised, as that's done through the CPU's GPIO, for what NVIC.cs reports as errors, or while the mirror is invalid.
+//  The NVIC invalidates it when it takes the recorded operations, until the next publication.
+//  Exceptions are kept in slots, which are their numbers except for the Secure banked ones.
+typedef struct {
+    //  odd while the NVIC or one of the operations updates the mirror
+    uint32_t sequence;
+    uint32_t valid;
+    //  pending, enabled and not active exceptions
+    uint64_t candidates[NVIC_WORDS];
+    //  exceptions on the active stack, which define the execution priority
+    uint64_t active[NVIC_WORDS];
+    //  enabled exceptions with the input still asserted, which become pending again when completed
+    uint64_t running[NVIC_WORDS];
+    //  enabled active exceptions which are pending too
+    uint64_t pending_active[NVIC_WORDS];
+    //  the last one is the only one which can be completed
+    int16_t active_stack[NVIC_SLOTS];
+    uint32_t active_depth;
+    //  numbers of the Secure banked exceptions
+    int32_t banked_numbers[NVIC_SLOTS - NVIC_EXCEPTIONS];
+    //  negative for the exceptions with fixed priorities
+    int16_t priorities[NVIC_SLOTS];
+    int16_t group_priorities[NVIC_SLOTS];
+    //  indexed with the Security state, Non-secure first
+    uint32_t binary_points[2];
+    uint32_t basepri[2];
+    uint32_t priority_mask;
+    uint32_t flags;
+    uint32_t irq_line;
+    uint32_t masked_irq_present;
+    //  operations done since the publication, oldest first
+    uint64_t operations[NVIC_OPERATIONS];
+    uint32_t operations_head;
+    uint32_t operations_count;
+} nvic_state_t;
+
+typedef struct {
+    //  -1 if no exception can preempt the active ones
+    int32_t slot;
+    bool irq_line;
+    bool masked_irq_present;
+} nvic_arbitration_t;
+
+typedef enum {
+    NVIC_ARBITRATED,
+    NVIC_OUTPUTS_CHANGED,
+    NVIC_STALE,
+} nvic_arbitration_result_t;
+
+static nvic_state_t nvic;
+
+static inline bool nvic_test_bit(const uint64_t *bitmap, int32_t slot)
+{
+    return (bitmap[slot / 64] >> (slot % 64)) & 1;
+}
+
+static inline void nvic_assign_bit(uint64_t *bitmap, int32_t slot, bool value)
+{
+    if(value) {
+        bitmap[slot / 64] |= 1ULL << (slot % 64);
+    } else {
+        bitmap[slot / 64] &= ~(1ULL << (slot % 64));
+    }
+}
+
+static inline int32_t nvic_min(int32_t a, int32_t b)
+{
+    return a < b ? a : b;
+}
+
+static inline int32_t nvic_number(int32_t slot)
+{
+    return slot < NVIC_EXCEPTIONS ? slot : nvic.banked_numbers[slot - NVIC_EXCEPTIONS];
+}
+
+static int32_t nvic_slot(int32_t number)
+{
+    if((number & NVIC_SECURE_BIT) == 0) {
+        return number >= 0 && number < NVIC_EXCEPTIONS ? number : -1;
+    }
+    for(int32_t slot = NVIC_EXCEPTIONS; slot < NVIC_SLOTS; slot++) {
+        if(nvic_number(slot) == number) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+//  ComparePriorities() of the Armv8-M ARM: the full priority, then the exception number, then the Secure state
+static bool nvic_preempts(int32_t slot, int32_t other_slot)
+{
+    if(nvic.priorities[slot] != nvic.priorities[other_slot]) {
+        return nvic.priorities[slot] < nvic.priorities[other_slot];
+    }
+    int32_t number = nvic_number(slot);
+    int32_t other_number = nvic_number(other_slot);
+    if((number & ~NVIC_SECURE_BIT) != (other_number & ~NVIC_SECURE_BIT)) {
+        return (number & ~NVIC_SECURE_BIT) < (other_number & ~NVIC_SECURE_BIT);
+    }
+    return (number & NVIC_SECURE_BIT) != 0;
+}
+
+static inline int32_t nvic_group(uint32_t priority, bool secure)
+{
+    return priority & ~((1 << (nvic.binary_points[secure] + 1)) - 1);
+}
+
+//  Follows GetPriorityBoost in NVIC.cs
+static int32_t nvic_priority_boost(bool ignore_primask)
+{
+    int32_t boost = NVIC_NO_PRIORITY;
+    if(!(nvic.flags & NVIC_FLAG_TRUSTZONE)) {
+        if(nvic.basepri[0] != 0) {
+            boost = nvic_group(nvic.basepri[0], false);
+        }
+        if(!ignore_primask && tlib_get_primask(0) != 0) {
+            boost = nvic_min(boost, 0);
+        }
+        if(tlib_get_faultmask(0) != 0) {
+            boost = nvic_min(boost, -1);
+        }
+        return boost;
+    }
+
+    bool prioritize_secure = nvic.flags & NVIC_FLAG_PRIS;
+    bool bfhfnmins = nvic.flags & NVIC_FLAG_BFHFNMINS;
+    if(nvic.basepri[0] != 0) {
+        boost = nvic_group(nvic.basepri[0], false);
+        if(prioritize_secure) {
+            boost = (boost >> 1) | 0x80;
+        }
+    }
+    if(nvic.basepri[1] != 0) {
+        boost = nvic_min(boost, nvic_group(nvic.basepri[1], true));
+    }
+    int32_t restricted_non_secure_priority = prioritize_secure ? 0x80 : 0;
+    if(!ignore_primask) {
+        if(tlib_get_primask(0) != 0) {
+            boost = nvic_min(boost, restricted_non_secure_priority);
+        }
+        if(tlib_get_primask(1) != 0) {
+            boost = nvic_min(boost, 0);
+        }
+    }
+    if(tlib_get_faultmask(0) != 0) {
+        boost = nvic_min(boost, bfhfnmins ? -1 : restricted_non_secure_priority);
+    }
+    if(tlib_get_faultmask(1) != 0) {
+        boost = nvic_min(boost, bfhfnmins ? -3 : -1);
+    }
+    return boost;
+}
+
+//  Follows FindPendingInterrupt in NVIC.cs, on the mirror as it is now
+static void nvic_arbitrate_state(nvic_arbitration_t *result)
+{
+    int32_t best = -1;
+    for(int word = 0; word < NVIC_WORDS; word++) {
+        for(uint64_t bits = nvic.candidates[word]; bits != 0; bits &= bits - 1) {
+            int32_t slot = word * 64 + __builtin_ctzll(bits);
+            if((nvic.flags & NVIC_FLAG_LOCKED_UP) && nvic_number(slot) != NVIC_NMI) {
+                continue;
+            }
+            if(best == -1 || nvic_preempts(slot, best)) {
+                best = slot;
+            }
+        }
+    }
+
+    int32_t raw_execution_priority = NVIC_NO_PRIORITY;
+    for(uint32_t i = 0; i < nvic.active_depth; i++) {
+        raw_execution_priority = nvic_min(raw_execution_priority, nvic.group_priorities[nvic.active_stack[i]]);
+    }
+
+    result->slot = -1;
+    result->irq_line = false;
+    result->masked_irq_present = false;
+    if(best != -1 && nvic.group_priorities[best] < raw_execution_priority) {
+        result->slot = best;
+        result->irq_line = nvic.group_priorities[best] < nvic_priority_boost(false);
+        //  WFI ignores PRIMASK, but not BASEPRI and FAULTMASK
+        result->masked_irq_present = nvic.group_priorities[best] < nvic_priority_boost(true);
+    }
+}
+
+static nvic_arbitration_result_t nvic_arbitrate(nvic_arbitration_t *result)
+{
+    uint32_t sequence = __atomic_load_n(&nvic.sequence, __ATOMIC_ACQUIRE);
+    if((sequence & 1) || !__atomic_load_n(&nvic.valid, __ATOMIC_ACQUIRE)) {
+        return NVIC_STALE;
+    }
+
+    nvic_arbitrate_state(result);
+    bool outputs_changed = result->irq_line != nvic.irq_line || result->masked_irq_present != nvic.masked_irq_present;
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&nvic.sequence, __ATOMIC_RELAXED) != sequence || !__atomic_load_n(&nvic.valid, __ATOMIC_RELAXED)) {
+        return NVIC_STALE;
+    }
+    return outputs_changed ? NVIC_OUTPUTS_CHANGED : NVIC_ARBITRATED;
+}
+
+//  The mirror is changed by one writer at a time: the NVIC publishing it or taking the operations, or an operation.
+//  Operations don't wait, they are passed to C# instead.
+static bool nvic_try_lock()
+{
+    uint32_t sequence = __atomic_load_n(&nvic.sequence, __ATOMIC_RELAXED);
+    return !(sequence & 1)
+           && __atomic_compare_exchange_n(&nvic.sequence, &sequence, sequence + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+static void nvic_lock()
+{
+    while(!nvic_try_lock()) {
+    }
+}
+
+static void nvic_unlock()
+{
+    __atomic_store_n(&nvic.sequence, nvic.sequence + 1, __ATOMIC_RELEASE);
+}
+
+//  Returns with the mirror locked if an operation can be done natively
+static bool nvic_begin_operation()
+{
+    if(!nvic_try_lock()) {
+        return false;
+    }
+    if(!__atomic_load_n(&nvic.valid, __ATOMIC_RELAXED) || nvic.operations_count == NVIC_OPERATIONS) {
+        nvic_unlock();
+        return false;
+    }
+    return true;
+}
+
+static void nvic_end_operation(nvic_operation_type_t type, int32_t argument, const nvic_arbitration_t *outputs)
+{
+    nvic.operations[(nvic.operations_head + nvic.operations_count) % NVIC_OPERATIONS] = ((uint64_t)type << 32) | (uint32_t)argument;
+    nvic.operations_count++;
+
+    bool lower_irq_line = nvic.irq_line && !outputs->irq_line;
+    nvic.irq_line = outputs->irq_line;
+    nvic.masked_irq_present = outputs->masked_irq_present;
+    nvic_unlock();
+
+    //  NVIC.cs catches up with its IRQ output when it applies the operation
+    if(lower_irq_line) {
+        tlib_set_irq(NVIC_CPU_IRQ, 0);
+    }
+}
+
+int32_t tlib_nvic_find_pending_irq()
+{
+    nvic_arbitration_t arbitration;
+    if(nvic_arbitrate(&arbitration) == NVIC_ARBITRATED) {
+        return arbitration.slot == -1 ? 0 : nvic_number(arbitration.slot);
+    }
+    return managed_nvic_find_pending_irq();
+}
+
+int32_t tlib_nvic_get_pending_masked_irq()
+{
+    nvic_arbitration_t arbitration;
+    switch(nvic_arbitrate(&arbitration)) {
+        case NVIC_ARBITRATED:
+            return arbitration.masked_irq_present;
+        case NVIC_OUTPUTS_CHANGED:
+            //  let the NVIC update its outputs, the flag is one of them
+            managed_nvic_find_pending_irq();
+            break;
+        case NVIC_STALE:
+            break;
+    }
+    return managed_nvic_get_pending_masked_irq();
+}
+
+//  Follows AcknowledgeIRQ in NVIC.cs: the best pending exception becomes active and the IRQ line is lowered
+int32_t tlib_nvic_acknowledge_irq()
+{
+    if(nvic_begin_operation()) {
+        nvic_arbitration_t arbitration;
+        nvic_arbitrate_state(&arbitration);
+        if(arbitration.slot == -1) {
+            if(!nvic.irq_line && !nvic.masked_irq_present) {
+                //  nothing to acknowledge and the outputs stay as they are
+                nvic_unlock();
+                return 0;
+            }
+        } else {
+            int32_t slot = arbitration.slot;
+            nvic_assign_bit(nvic.candidates, slot, false);
+            nvic_assign_bit(nvic.active, slot, true);
+            nvic.active_stack[nvic.active_depth++] = slot;
+            //  The pending masked interrupt flag is left as arbitrated before the acknowledgement, as by NVIC.cs
+            arbitration.irq_line = false;
+            nvic_end_operation(NVIC_OPERATION_ACKNOWLEDGE, nvic_number(slot), &arbitration);
+            return nvic_number(slot);
+        }
+        nvic_unlock();
+    }
+    return managed_nvic_acknowledge_irq();
+}
+
+//  Follows CompleteIRQ in NVIC.cs for the exception on the top of the active stack, the other ones are errors reported by the NVIC
+int32_t tlib_nvic_complete_irq(int32_t number)
+{
+    if(nvic_begin_operation()) {
+        int32_t slot = nvic_slot(number);
+        if(slot != -1 && nvic.active_depth != 0 && nvic.active_stack[nvic.active_depth - 1] == slot && nvic_test_bit(nvic.active, slot)) {
+            bool was_candidate = nvic_test_bit(nvic.candidates, slot);
+            bool was_pending = nvic_test_bit(nvic.pending_active, slot);
+            nvic.active_depth--;
+            nvic_assign_bit(nvic.active, slot, false);
+            nvic_assign_bit(nvic.pending_active, slot, false);
+            nvic_assign_bit(nvic.candidates, slot, was_pending || nvic_test_bit(nvic.running, slot));
+
+            nvic_arbitration_t arbitration;
+            nvic_arbitrate_state(&arbitration);
+            if(!arbitration.irq_line || nvic.irq_line) {
+                nvic_end_operation(NVIC_OPERATION_COMPLETE, number, &arbitration);
+                return 1;
+            }
+            //  e.g. tail-chaining, an exception can be taken now
+            nvic_assign_bit(nvic.candidates, slot, was_candidate);
+            nvic_assign_bit(nvic.pending_active, slot, was_pending);
+            nvic_assign_bit(nvic.active, slot, true);
+            nvic.active_depth++;
+        }
+        nvic_unlock();
+    }
+    return managed_nvic_complete_irq(number);
+}
+
+//  Follows BASEPRI_S and BASEPRI_NS in NVIC.cs
+void tlib_nvic_write_basepri(int32_t value, uint32_t secure)
+{
+    if(nvic_begin_operation()) {
+        bool bank = secure != 0;
+        uint32_t previous = nvic.basepri[bank];
+        uint32_t normalized = value & nvic.priority_mask;
+        if(normalized == previous) {
+            nvic_unlock();
+            return;
+        }
+
+        nvic.basepri[bank] = normalized;
+        nvic_arbitration_t arbitration;
+        nvic_arbitrate_state(&arbitration);
+        if(!arbitration.irq_line || nvic.irq_line) {
+            nvic_end_operation(bank ? NVIC_OPERATION_WRITE_BASEPRI_S : NVIC_OPERATION_WRITE_BASEPRI_NS, normalized, &arbitration);
+            return;
+        }
+        //  lowering BASEPRI unmasked an exception
+        nvic.basepri[bank] = previous;
+        nvic_unlock();
+    }
+    managed_nvic_write_basepri(value, secure);
+}
+
+void renode_nvic_begin_state_update()
+{
+    nvic_lock();
+    __atomic_store_n(&nvic.valid, 0, __ATOMIC_RELAXED);
+}
+
+EXC_VOID_0(renode_nvic_begin_state_update)
+
+void renode_nvic_set_candidate_exceptions(int32_t word, uint64_t bits)
+{
+    if(word >= 0 && word < NVIC_WORDS) {
+        nvic.candidates[word] = bits;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_candidate_exceptions, int32_t, word, uint64_t, bits)
+
+void renode_nvic_set_active_exceptions(int32_t word, uint64_t bits)
+{
+    if(word >= 0 && word < NVIC_WORDS) {
+        nvic.active[word] = bits;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_active_exceptions, int32_t, word, uint64_t, bits)
+
+void renode_nvic_set_running_exceptions(int32_t word, uint64_t bits)
+{
+    if(word >= 0 && word < NVIC_WORDS) {
+        nvic.running[word] = bits;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_running_exceptions, int32_t, word, uint64_t, bits)
+
+void renode_nvic_set_pending_active_exceptions(int32_t word, uint64_t bits)
+{
+    if(word >= 0 && word < NVIC_WORDS) {
+        nvic.pending_active[word] = bits;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_pending_active_exceptions, int32_t, word, uint64_t, bits)
+
+void renode_nvic_set_active_stack_entry(int32_t index, int32_t slot)
+{
+    if(index >= 0 && index < NVIC_SLOTS && slot >= 0 && slot < NVIC_SLOTS) {
+        nvic.active_stack[index] = slot;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_active_stack_entry, int32_t, index, int32_t, slot)
+
+void renode_nvic_set_exception_number(int32_t slot, int32_t number)
+{
+    if(slot >= NVIC_EXCEPTIONS && slot < NVIC_SLOTS) {
+        nvic.banked_numbers[slot - NVIC_EXCEPTIONS] = number;
+    }
+}
+
+EXC_VOID_2(renode_nvic_set_exception_number, int32_t, slot, int32_t, number)
+
+void renode_nvic_set_priority(int32_t slot, int32_t priority, int32_t group_priority)
+{
+    if(slot >= 0 && slot < NVIC_SLOTS) {
+        nvic.priorities[slot] = priority;
+        nvic.group_priorities[slot] = group_priority;
+    }
+}
+
+EXC_VOID_3(renode_nvic_set_priority, int32_t, slot, int32_t, priority, int32_t, group_priority)
+
+void renode_nvic_set_priority_boost_state(uint32_t non_secure_basepri, uint32_t secure_basepri, uint32_t non_secure_binary_point,
+                                          uint32_t secure_binary_point)
+{
+    nvic.basepri[0] = non_secure_basepri;
+    nvic.basepri[1] = secure_basepri;
+    nvic.binary_points[0] = non_secure_binary_point;
+    nvic.binary_points[1] = secure_binary_point;
+}
+
+EXC_VOID_4(renode_nvic_set_priority_boost_state, uint32_t, non_secure_basepri, uint32_t, secure_basepri, uint32_t,
+           non_secure_binary_point, uint32_t, secure_binary_point)
+
+void renode_nvic_set_execution_state(uint32_t flags, uint32_t active_depth, uint32_t priority_mask)
+{
+    nvic.flags = flags;
+    nvic.active_depth = active_depth <= NVIC_SLOTS ? active_depth : 0;
+    nvic.priority_mask = priority_mask;
+}
+
+EXC_VOID_3(renode_nvic_set_execution_state, uint32_t, flags, uint32_t, active_depth, uint32_t, priority_mask)
+
+void renode_nvic_end_state_update(uint32_t irq_line, uint32_t masked_irq_present)
+{
+    nvic.irq_line = irq_line != 0;
+    nvic.masked_irq_present = masked_irq_present != 0;
+    __atomic_store_n(&nvic.valid, 1, __ATOMIC_RELAXED);
+    nvic_unlock();
+}
+
+EXC_VOID_2(renode_nvic_end_state_update, uint32_t, irq_line, uint32_t, masked_irq_present)
+
+void renode_nvic_invalidate_state()
+{
+    nvic_lock();
+    __atomic_store_n(&nvic.valid, 0, __ATOMIC_RELAXED);
+    nvic_unlock();
+}
+
+EXC_VOID_0(renode_nvic_invalidate_state)
+
+//  Invalidates the mirror, so that no more operations are done natively until it's published again,
+//  and returns the oldest operation not taken yet, 0 if there is none
+uint64_t renode_nvic_take_operation()
+{
+    nvic_lock();
+    __atomic_store_n(&nvic.valid, 0, __ATOMIC_RELAXED);
+    uint64_t operation = NVIC_OPERATION_NONE;
+    if(nvic.operations_count != 0) {
+        operation = nvic.operations[nvic.operations_head];
+        nvic.operations_head = (nvic.operations_head + 1) % NVIC_OPERATIONS;
+        nvic.operations_count--;
+    }
+    nvic_unlock();
+    return operation;
+}
+
+EXC_INT_0(uint64_t, renode_nvic_take_operation)
+
+//  IRQ line in bit 0, pending masked interrupt flag in bit 1, as left by the operations
+uint32_t renode_nvic_get_outputs()
+{
+    return nvic.irq_line | (nvic.masked_irq_present << 1);
+}
+
+EXC_INT_0(uint32_t, renode_nvic_get_outputs)
 #endif
 
-EXTERNAL_AS(uint32_t, Read32CP15, tlib_read_cp15_32, uint32_t)
-EXTERNAL_AS(void, Write32CP15, tlib_write_cp15_32, uint32_t, uint32_t)
-EXTERNAL_AS(uint64_t, Read64CP15, tlib_read_cp15_64, uint32_t)
-EXTERNAL_AS(void, Write64CP15, tlib_write_cp15_64, uint32_t, uint64_t)
+EXTERNAL_AS(uint32_t, Read32CP15, managed_read_cp15_32, uint32_t)
+EXTERNAL_AS(void, Write32CP15, managed_write_cp15_32, uint32_t, uint32_t)
+EXTERNAL_AS(uint64_t, Read64CP15, managed_read_cp15_64, uint32_t)
+EXTERNAL_AS(void, Write64CP15, managed_write_cp15_64, uint32_t, uint64_t)
+
+uint32_t tlib_read_cp15_32(uint32_t instruction)
+{
+    uint64_t value;
+    if(renode_read_storage_register(STORAGE_REGISTER_SPACE_CP15_32, instruction, &value)) {
+        return (uint32_t)value;
+    }
+    return managed_read_cp15_32(instruction);
+}
+
+void tlib_write_cp15_32(uint32_t instruction, uint32_t value)
+{
+    if(renode_write_storage_register(STORAGE_REGISTER_SPACE_CP15_32, instruction, value) != STORAGE_REGISTER_WRITTEN) {
+        managed_write_cp15_32(instruction, value);
+    }
+}
+
+uint64_t tlib_read_cp15_64(uint32_t instruction)
+{
+    uint64_t value;
+    if(renode_read_storage_register(STORAGE_REGISTER_SPACE_CP15_64, instruction, &value)) {
+        return value;
+    }
+    return managed_read_cp15_64(instruction);
+}
+
+void tlib_write_cp15_64(uint32_t instruction, uint64_t value)
+{
+    if(renode_write_storage_register(STORAGE_REGISTER_SPACE_CP15_64, instruction, value) != STORAGE_REGISTER_WRITTEN) {
+        managed_write_cp15_64(instruction, value);
+    }
+}
+
 EXTERNAL_AS(uint32_t, IsWfiAsNop, tlib_is_wfi_as_nop)
 EXTERNAL_AS(uint32_t, IsWfeAndSevAsNop, tlib_is_wfe_and_sev_as_nop)
-EXTERNAL_AS(uint32_t, DoSemihosting, tlib_do_semihosting)
+//  Console writes and transfers to mapped memory are handled first, see renode_arm_semihosting.c
+EXTERNAL_AS(uint32_t, DoSemihosting, managed_do_semihosting, uint32_t)
 EXTERNAL_AS(void, SetSystemEvent, tlib_set_system_event, int32_t)
 EXTERNAL_AS(void, ReportPMUOverflow, tlib_report_pmu_overflow, int32_t)
 EXTERNAL_AS(void, FillConfigurationSignalsState, tlib_fill_configuration_signals_state, voidptr)
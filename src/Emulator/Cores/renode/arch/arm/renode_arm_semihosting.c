@@ -0,0 +1,183 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "renode_imports.h"
+#include "renode_semihosting.h"
+#include "../../../tlib/include/unwind.h"
+
+#define SYS_WRITEC         0x03
+#define SYS_WRITE0         0x04
+#define SYS_WRITE          0x05
+#define SYS_READ           0x06
+#define NO_OPERATION       0x00
+
+#define REGISTER_R0        0
+#define REGISTER_R1        1
+#define MAX_CONSOLE_HANDLE 64
+
+//  Defined in renode_arm_callbacks.c
+uint32_t managed_do_semihosting(uint32_t last_native_operation);
+uint32_t tlib_get_register_value_32(int reg_number);
+
+EXTERNAL_AS(void, FlushSemihostingConsole, managed_flush_semihosting_console, uint32_t, voidptr, uint32_t)
+EXTERNAL_AS(uint32_t, DoSemihostingTransfer, managed_do_semihosting_transfer, uint32_t, uint32_t, voidptr, uint32_t)
+
+static struct {
+    bool enabled;
+    bool debug_channel;
+    //  The stream written by SYS_WRITE for each handle opened as the console, SEMIHOSTING_STREAM_NONE for the others
+    uint8_t console_handles[MAX_CONSOLE_HANDLE];
+    //  The last operation completed here since C# handled one, C# has to know it to answer SYS_ISERROR
+    uint32_t last_operation;
+} semihosting;
+
+static semihosting_console_t console = {
+    .flush = managed_flush_semihosting_console,
+};
+
+static bool get_arguments(uint32_t address, uint32_t *arguments, uint32_t count)
+{
+    void *buffer = renode_semihosting_get_guest_buffer(address, count * sizeof(uint32_t), false);
+    if(buffer == NULL) {
+        return false;
+    }
+    memcpy(arguments, buffer, count * sizeof(uint32_t));
+    return true;
+}
+
+static uint32_t get_console_stream(uint32_t handle)
+{
+    return handle < MAX_CONSOLE_HANDLE ? semihosting.console_handles[handle] : SEMIHOSTING_STREAM_NONE;
+}
+
+static bool try_write_console(uint32_t operation, uint32_t arguments_address, uint32_t *result)
+{
+    const void *data;
+    uint32_t length;
+    uint32_t stream = SEMIHOSTING_STREAM_OUTPUT;
+    uint32_t arguments[3];
+
+    switch(operation) {
+        case SYS_WRITEC:
+            //  The parameter points to the character
+            length = 1;
+            data = renode_semihosting_get_guest_buffer(arguments_address, length, false);
+            if(!semihosting.debug_channel || data == NULL) {
+                return false;
+            }
+            break;
+        case SYS_WRITE0:
+            if(!semihosting.debug_channel || !renode_semihosting_get_guest_string(arguments_address, (const char **)&data, &length)) {
+                return false;
+            }
+            break;
+        case SYS_WRITE:
+            if(!get_arguments(arguments_address, arguments, 3)) {
+                return false;
+            }
+            stream = get_console_stream(arguments[0]);
+            length = arguments[2];
+            data = renode_semihosting_get_guest_buffer(arguments[1], length, false);
+            if(stream == SEMIHOSTING_STREAM_NONE || data == NULL) {
+                return false;
+            }
+            break;
+        default:
+            return false;
+    }
+
+    renode_semihosting_console_write(&console, stream, data, length);
+    semihosting.last_operation = operation;
+    //  SYS_WRITEC and SYS_WRITE0 corrupt the return register, it's set to 0 like in C#
+    *result = 0;
+    return true;
+}
+
+//  The data is copied by C# directly between the file and the mapped memory
+static bool try_transfer(uint32_t operation, uint32_t arguments_address, uint32_t *result)
+{
+    uint32_t arguments[3];
+    if(!get_arguments(arguments_address, arguments, 3) || get_console_stream(arguments[0]) != SEMIHOSTING_STREAM_NONE) {
+        return false;
+    }
+    bool write = operation == SYS_WRITE;
+    void *buffer = renode_semihosting_get_guest_buffer(arguments[1], arguments[2], !write);
+    if(buffer == NULL) {
+        return false;
+    }
+    *result = managed_do_semihosting_transfer(write ? 1 : 0, arguments[0], buffer, arguments[2]);
+    if(!write && *result < arguments[2]) {
+        //  The data was copied by C# without going through the bus
+        renode_semihosting_invalidate_guest_buffer(arguments[1], arguments[2] - *result);
+    }
+    //  It's already recorded by C#
+    semihosting.last_operation = NO_OPERATION;
+    return true;
+}
+
+static bool try_do_semihosting(uint32_t operation, uint32_t arguments_address, uint32_t *result)
+{
+    switch(operation) {
+        case SYS_WRITEC:
+        case SYS_WRITE0:
+            return try_write_console(operation, arguments_address, result);
+        case SYS_WRITE:
+            return try_write_console(operation, arguments_address, result) || try_transfer(operation, arguments_address, result);
+        case SYS_READ:
+            return try_transfer(operation, arguments_address, result);
+        default:
+            return false;
+    }
+}
+
+uint32_t tlib_do_semihosting()
+{
+    uint32_t operation = tlib_get_register_value_32(REGISTER_R0);
+    uint32_t arguments_address = tlib_get_register_value_32(REGISTER_R1);
+    uint32_t result;
+
+    if(semihosting.enabled && try_do_semihosting(operation, arguments_address, &result)) {
+        return result;
+    }
+
+    //  The console output has to reach C# before the result of any other operation
+    renode_semihosting_console_flush(&console);
+    uint32_t last_native_operation = semihosting.last_operation;
+    semihosting.last_operation = NO_OPERATION;
+    return managed_do_semihosting(last_native_operation);
+}
+
+void renode_arm_semihosting_configure(uint32_t enabled, uint32_t debug_channel)
+{
+    renode_semihosting_console_flush(&console);
+    semihosting.enabled = enabled != 0;
+    semihosting.debug_channel = debug_channel != 0;
+    semihosting.last_operation = NO_OPERATION;
+    memset(semihosting.console_handles, SEMIHOSTING_STREAM_NONE, sizeof(semihosting.console_handles));
+}
+
+EXC_VOID_2(renode_arm_semihosting_configure, uint32_t, enabled, uint32_t, debug_channel)
+
+//  Handles above the limit are always served by C#
+void renode_arm_semihosting_set_console_handle(uint32_t handle, uint32_t stream)
+{
+    if(handle < MAX_CONSOLE_HANDLE) {
+        semihosting.console_handles[handle] = stream;
+    }
+}
+
+EXC_VOID_2(renode_arm_semihosting_set_console_handle, uint32_t, handle, uint32_t, stream)
+
+void renode_arm_semihosting_flush()
+{
+    renode_semihosting_console_flush(&console);
+}
+
+EXC_VOID_0(renode_arm_semihosting_flush)
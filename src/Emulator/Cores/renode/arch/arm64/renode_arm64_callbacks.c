@@ -7,13 +7,41 @@
 
 #include "arch_callbacks.h"
 #include "renode_imports.h"
+#include "renode_registers.h"
+#include "renode_time.h"
 
-EXTERNAL_AS(uint64_t, ReadSystemRegisterInterruptCPUInterface, tlib_read_system_register_interrupt_cpu_interface, uint32_t)
-EXTERNAL_AS(void, WriteSystemRegisterInterruptCPUInterface, tlib_write_system_register_interrupt_cpu_interface, uint32_t, uint64_t)
+EXTERNAL_AS(uint64_t, ReadSystemRegisterInterruptCPUInterface, managed_read_system_register_interrupt_cpu_interface, uint32_t)
+EXTERNAL_AS(void, WriteSystemRegisterInterruptCPUInterface, managed_write_system_register_interrupt_cpu_interface, uint32_t, uint64_t)
+
+uint64_t tlib_read_system_register_interrupt_cpu_interface(uint32_t offset)
+{
+    uint64_t value;
+    if(renode_read_storage_register(STORAGE_REGISTER_SPACE_INTERRUPT_CPU_INTERFACE, offset, &value)) {
+        return value;
+    }
+    return managed_read_system_register_interrupt_cpu_interface(offset);
+}
+
+void tlib_write_system_register_interrupt_cpu_interface(uint32_t offset, uint64_t value)
+{
+    if(renode_write_storage_register(STORAGE_REGISTER_SPACE_INTERRUPT_CPU_INTERFACE, offset, value) != STORAGE_REGISTER_WRITTEN) {
+        managed_write_system_register_interrupt_cpu_interface(offset, value);
+    }
+}
 
 EXTERNAL_AS(void, OnTcmMappingUpdate, tlib_on_tcm_mapping_update, int32_t, uint64_t, uint32_t, uint32_t)
 
-EXTERNAL_AS(uint64_t, ReadSystemRegisterGenericTimer64, tlib_read_system_register_generic_timer_64, uint32_t)
+EXTERNAL_AS(uint64_t, ReadSystemRegisterGenericTimer64, managed_read_system_register_generic_timer_64, uint32_t)
+
+uint64_t tlib_read_system_register_generic_timer_64(uint32_t offset)
+{
+    uint64_t value;
+    if(renode_read_time_counter(offset, &value)) {
+        return value;
+    }
+    return managed_read_system_register_generic_timer_64(offset);
+}
+
 EXTERNAL_AS(void, WriteSystemRegisterGenericTimer64, tlib_write_system_register_generic_timer_64, uint32_t, uint64_t)
 
 EXTERNAL_AS(uint32_t, ReadSystemRegisterGenericTimer32, tlib_read_system_register_generic_timer_32, uint32_t)
@@ -8,9 +8,20 @@
 
 #include "arch_callbacks.h"
 #include "renode_imports.h"
+#include "renode_time.h"
 
 EXTERNAL_AS(uint32_t, ReadTbl, tlib_read_tbl)
 EXTERNAL_AS(uint32_t, ReadTbu, tlib_read_tbu)
-EXTERNAL_AS(uint64_t, ReadDecrementer, tlib_read_decrementer)
+EXTERNAL_AS(uint64_t, ReadDecrementer, managed_read_decrementer)
+
+uint64_t tlib_read_decrementer()
+{
+    uint64_t value;
+    if(renode_read_time_counter(TIME_COUNTER_DEFAULT_KEY, &value)) {
+        return value;
+    }
+    return managed_read_decrementer();
+}
+
 EXTERNAL_AS(void, WriteDecrementer, tlib_write_decrementer, uint64_t)
 EXTERNAL_AS(uint32_t, IsVleEnabled, tlib_is_vle_enabled)
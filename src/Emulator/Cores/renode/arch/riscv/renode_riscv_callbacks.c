@@ -5,16 +5,49 @@
 // Full license text is available in 'licenses/MIT.txt' file.
 //
 
+#include <stdbool.h>
+#include <string.h>
+
 #include "arch_callbacks.h"
 #include "renode_imports.h"
+#include "renode_registers.h"
+#include "renode_time.h"
+#include "../../../tlib/include/unwind.h"
+
+EXTERNAL_AS(uint64_t, GetCPUTime, managed_get_cpu_time)
+
+uint64_t tlib_get_cpu_time()
+{
+    uint64_t value;
+    if(renode_read_time_counter(TIME_COUNTER_DEFAULT_KEY, &value)) {
+        return value;
+    }
+    return managed_get_cpu_time();
+}
 
-EXTERNAL_AS(uint64_t, GetCPUTime, tlib_get_cpu_time)
+EXTERNAL_AS(uint64_t, ReadCSR, managed_read_csr, uint64_t)
+EXTERNAL_AS(void, WriteCSR, managed_write_csr, uint64_t, uint64_t)
+
+uint64_t tlib_read_csr(uint64_t csr)
+{
+    uint64_t value;
+    if(renode_read_storage_register(STORAGE_REGISTER_SPACE_CSR, csr, &value)) {
+        return value;
+    }
+    return managed_read_csr(csr);
+}
+
+void tlib_write_csr(uint64_t csr, uint64_t value)
+{
+    if(renode_write_storage_register(STORAGE_REGISTER_SPACE_CSR, csr, value) != STORAGE_REGISTER_WRITTEN) {
+        managed_write_csr(csr, value);
+    }
+}
 
-EXTERNAL_AS(uint64_t, ReadCSR, tlib_read_csr, uint64_t)
-EXTERNAL_AS(void, WriteCSR, tlib_write_csr, uint64_t, uint64_t)
 EXTERNAL(void, tlib_mip_changed, uint64_t)
 
-EXTERNAL_AS(int32_t, HandleCustomInstruction, tlib_handle_custom_instruction,
+//  Native handlers are looked up first, see renode_riscv_plugin_host.c
+EXTERNAL_AS(int32_t, HandleCustomInstruction, managed_handle_custom_instruction,
             uint64_t, uint64_t)
 EXTERNAL_AS(void, HandlePostGprAccessHook, tlib_handle_post_gpr_access_hook,
             uint32_t, uint32_t)
@@ -27,6 +60,162 @@ EXTERNAL_AS(void, ExternalPMPConfigCSRWrite, tlib_extpmp_cfg_csr_write, uint32_t
 EXTERNAL_AS(uint64_t, ExternalPMPConfigCSRRead, tlib_extpmp_cfg_csr_read, uint32_t)
 EXTERNAL_AS(void, ExternalPMPAddressCSRWrite, tlib_extpmp_address_csr_write, uint32_t, uint64_t)
 EXTERNAL_AS(uint64_t, ExternalPMPAddressCSRRead, tlib_extpmp_address_csr_read, uint32_t)
-EXTERNAL_AS(int32_t, ExternalPMPGetAccess, tlib_extpmp_get_access, uint64_t, uint64_t, int32_t)
-EXTERNAL_AS(int32_t, ExternalPMPGetOverlappingRegion, tlib_extpmp_find_overlapping, uint64_t, uint64_t, int32_t)
-EXTERNAL_AS(int32_t, ExternalPMPIsAnyRegionLocked, tlib_extpmp_is_any_region_locked)
+EXTERNAL_AS(int32_t, ExternalPMPGetAccess, managed_extpmp_get_access, uint64_t, uint64_t, int32_t)
+EXTERNAL_AS(int32_t, ExternalPMPGetOverlappingRegion, managed_extpmp_find_overlapping, uint64_t, uint64_t, int32_t)
+EXTERNAL_AS(int32_t, ExternalPMPIsAnyRegionLocked, managed_extpmp_is_any_region_locked)
+
+uint32_t tlib_get_current_priv(void);
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+uint32_t tlib_get_register_value_32(int reg_number);
+#else
+uint64_t tlib_get_register_value_64(int reg_number);
+#endif
+
+#define EXTPMP_MAX_REGIONS        64
+#define EXTPMP_PERMISSIONS_MASK   0x7
+#define EXTPMP_REGION_ENABLED     (1 << 3)
+#define EXTPMP_REGION_LOCKED      (1 << 4)
+#define EXTPMP_ACCESS_READ        0
+#define EXTPMP_ACCESS_WRITE       1
+#define EXTPMP_PRIV_MACHINE       3
+#define EXTPMP_MSTATUS_INDEX      833
+#define EXTPMP_MSTATUS_MPRV       (1ULL << 17)
+#define EXTPMP_MSTATUS_MPP_OFFSET 11
+
+//  Copy of the regions configured in the external PMP, pushed by it whenever any of its CSRs changes.
+//  Ranges are inclusive. With `regions_count` equal to 0 all the queries are passed to C#.
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint32_t config;
+} extpmp_region_t;
+
+static struct {
+    uint32_t regions_count;
+    uint64_t address_mask;
+    extpmp_region_t regions[EXTPMP_MAX_REGIONS];
+} extpmp;
+
+static inline bool extpmp_region_contains(extpmp_region_t *region, uint64_t address)
+{
+    return address >= region->start && address <= region->end;
+}
+
+static uint32_t extpmp_get_effective_priv(int32_t access_type)
+{
+    uint32_t priv = tlib_get_current_priv();
+    if(access_type == EXTPMP_ACCESS_READ || access_type == EXTPMP_ACCESS_WRITE) {
+        //  On RV32 the CSRs are only accessible through the 32-bit getter
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+        uint64_t mstatus = tlib_get_register_value_32(EXTPMP_MSTATUS_INDEX);
+#else
+        uint64_t mstatus = tlib_get_register_value_64(EXTPMP_MSTATUS_INDEX);
+#endif
+        if(mstatus & EXTPMP_MSTATUS_MPRV) {
+            priv = (mstatus >> EXTPMP_MSTATUS_MPP_OFFSET) & 0x3;
+        }
+    }
+    return priv;
+}
+
+//  Same rules as `RiscVExternalPMP.GetAccess`
+int32_t tlib_extpmp_get_access(uint64_t address, uint64_t size, int32_t access_type)
+{
+    uint32_t count = __atomic_load_n(&extpmp.regions_count, __ATOMIC_ACQUIRE);
+    if(count == 0) {
+        return managed_extpmp_get_access(address, size, access_type);
+    }
+
+    bool any_enabled = false;
+    for(uint32_t i = 0; i < count; i++) {
+        any_enabled |= (extpmp.regions[i].config & EXTPMP_REGION_ENABLED) != 0;
+    }
+    if(!any_enabled) {
+        return EXTPMP_PERMISSIONS_MASK;
+    }
+
+    uint32_t priv = extpmp_get_effective_priv(access_type);
+    int32_t permissions = priv == EXTPMP_PRIV_MACHINE ? EXTPMP_PERMISSIONS_MASK : 0;
+    for(uint32_t i = 0; i < count; i++) {
+        extpmp_region_t *region = &extpmp.regions[i];
+        if(!(region->config & EXTPMP_REGION_ENABLED)) {
+            continue;
+        }
+        bool first_byte_in_range = extpmp_region_contains(region, address);
+        bool last_byte_in_range = extpmp_region_contains(region, address + size - 1);
+        if(first_byte_in_range != last_byte_in_range) {
+            return 0;
+        }
+        if(first_byte_in_range) {
+            if(priv != EXTPMP_PRIV_MACHINE || (region->config & EXTPMP_REGION_LOCKED)) {
+                permissions = region->config & EXTPMP_PERMISSIONS_MASK;
+            }
+            break;
+        }
+    }
+    return permissions;
+}
+
+int32_t tlib_extpmp_find_overlapping(uint64_t address, uint64_t size, int32_t starting_index)
+{
+    uint32_t count = __atomic_load_n(&extpmp.regions_count, __ATOMIC_ACQUIRE);
+    //  Invalid ranges are left for C# to report
+    if(count == 0 || size == 0 || starting_index < 0) {
+        return managed_extpmp_find_overlapping(address, size, starting_index);
+    }
+    address &= extpmp.address_mask;
+    uint64_t last_address = address + size - 1;
+    if(last_address < address) {
+        return managed_extpmp_find_overlapping(address, size, starting_index);
+    }
+
+    for(uint32_t i = starting_index; i < count; i++) {
+        extpmp_region_t *region = &extpmp.regions[i];
+        if((region->config & EXTPMP_REGION_ENABLED) && address >= region->start && last_address <= region->end) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int32_t tlib_extpmp_is_any_region_locked()
+{
+    uint32_t count = __atomic_load_n(&extpmp.regions_count, __ATOMIC_ACQUIRE);
+    if(count == 0) {
+        return managed_extpmp_is_any_region_locked();
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        if(extpmp.regions[i].config & EXTPMP_REGION_LOCKED) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//  Regions have to be set after the table is configured, configuring it again clears them.
+//  Tables with more regions than EXTPMP_MAX_REGIONS are never used.
+void renode_extpmp_configure(uint32_t regions_count, uint64_t address_mask)
+{
+    __atomic_store_n(&extpmp.regions_count, 0, __ATOMIC_RELEASE);
+    memset(extpmp.regions, 0, sizeof(extpmp.regions));
+    extpmp.address_mask = address_mask;
+    if(regions_count <= EXTPMP_MAX_REGIONS) {
+        __atomic_store_n(&extpmp.regions_count, regions_count, __ATOMIC_RELEASE);
+    }
+}
+
+EXC_VOID_2(renode_extpmp_configure, uint32_t, regions_count, uint64_t, address_mask)
+
+void renode_extpmp_set_region(uint32_t index, uint64_t start, uint64_t end, uint32_t config)
+{
+    if(index >= EXTPMP_MAX_REGIONS) {
+        return;
+    }
+    extpmp.regions[index] = (extpmp_region_t) {
+        .start = start,
+        .end = end,
+        .config = config,
+    };
+}
+
+EXC_VOID_4(renode_extpmp_set_region, uint32_t, index, uint64_t, start, uint64_t, end, uint32_t, config)
@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include "renode_imports.h"
+#include "renode_riscv_plugin_host.h"
+#include "../../../tlib/include/unwind.h"
+
+//  Implemented in renode_riscv_plugin_host.c
+
+EXC_VALUE_2(uint32_t, renode_riscv_resolve_native_custom_instruction, 0, charptr, library_path, charptr, handler_name)
+
+EXC_VALUE_3(uint32_t, renode_riscv_install_native_custom_instruction, 0, uint64_t, id, charptr, library_path, charptr, handler_name)
+
+EXC_VOID_0(renode_riscv_unload_custom_instruction_plugins)
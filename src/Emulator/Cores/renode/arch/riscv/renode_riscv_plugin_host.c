@@ -0,0 +1,316 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "renode_memory.h"
+#include "renode_riscv_plugin.h"
+#include "renode_riscv_plugin_host.h"
+
+#define MAX_NATIVE_CUSTOM_INSTRUCTIONS 64
+#define MAX_PLUGINS                    16
+#define LOG_LEVEL_ERROR                3
+
+//  Defined in renode_riscv_callbacks.c and renode_callbacks.c
+int32_t managed_handle_custom_instruction(uint64_t id, uint64_t opcode);
+void tlib_log(int32_t level, char *message);
+uint64_t tlib_read_byte(uint64_t address, uint64_t cpu_state);
+uint64_t tlib_read_word(uint64_t address, uint64_t cpu_state);
+uint64_t tlib_read_double_word(uint64_t address, uint64_t cpu_state);
+uint64_t tlib_read_quad_word(uint64_t address, uint64_t cpu_state);
+void tlib_write_byte(uint64_t address, uint64_t value, uint64_t cpu_state);
+void tlib_write_word(uint64_t address, uint64_t value, uint64_t cpu_state);
+void tlib_write_double_word(uint64_t address, uint64_t value, uint64_t cpu_state);
+void tlib_write_quad_word(uint64_t address, uint64_t value, uint64_t cpu_state);
+
+uint64_t tlib_get_cpu_state_for_memory_transaction(void);
+void tlib_invalidate_translation_blocks(uintptr_t *regions, uint64_t count);
+uint64_t tlib_translate_to_physical_address(uint64_t address, uint32_t access_type);
+uint64_t tlib_get_register_value_64(int reg_number);
+void tlib_set_register_value_64(int reg_number, uint64_t value);
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+uint32_t tlib_get_register_value_32(int reg_number);
+void tlib_set_register_value_32(int reg_number, uint32_t value);
+#endif
+
+typedef struct {
+    char *path;
+    void *handle;
+    void *user_data;
+} plugin_t;
+
+typedef struct {
+    uint64_t id;
+    renode_riscv_custom_instruction_handler_t handler;
+    plugin_t *plugin;
+} native_custom_instruction_t;
+
+static plugin_t plugins[MAX_PLUGINS];
+static uint32_t plugins_count;
+static native_custom_instruction_t native_custom_instructions[MAX_NATIVE_CUSTOM_INSTRUCTIONS];
+static uint32_t native_custom_instructions_count;
+static bool pc_written;
+
+static void log_error(const char *format, const char *argument, const char *detail)
+{
+    char message[512];
+    snprintf(message, sizeof(message), format, argument, detail);
+    tlib_log(LOG_LEVEL_ERROR, message);
+}
+
+static void *open_library(const char *path)
+{
+#ifdef _WIN32
+    return (void *)LoadLibraryA(path);
+#else
+    return dlopen(path, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+static void *find_symbol(void *handle, const char *name)
+{
+#ifdef _WIN32
+    return (void *)GetProcAddress((HMODULE)handle, name);
+#else
+    return dlsym(handle, name);
+#endif
+}
+
+static void close_library(void *handle)
+{
+#ifdef _WIN32
+    FreeLibrary((HMODULE)handle);
+#else
+    dlclose(handle);
+#endif
+}
+
+static const char *get_library_error()
+{
+#ifdef _WIN32
+    return "see the Windows error code";
+#else
+    const char *error = dlerror();
+    return error != NULL ? error : "unknown error";
+#endif
+}
+
+static bool is_32bit_register(int32_t index)
+{
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+    //  Floating-point registers are always accessed as 64-bit ones, GPRs, PC and CSRs are XLEN-wide
+    return index < RENODE_RISCV_REGISTER_F0 || index > RENODE_RISCV_REGISTER_F31;
+#else
+    return false;
+#endif
+}
+
+static uint64_t api_get_register(int32_t index)
+{
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+    if(is_32bit_register(index)) {
+        return tlib_get_register_value_32(index);
+    }
+#endif
+    return tlib_get_register_value_64(index);
+}
+
+static void api_set_register(int32_t index, uint64_t value)
+{
+    if(index == RENODE_RISCV_REGISTER_PC) {
+        pc_written = true;
+    }
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+    if(is_32bit_register(index)) {
+        tlib_set_register_value_32(index, (uint32_t)value);
+        return;
+    }
+#endif
+    tlib_set_register_value_64(index, value);
+}
+
+static uint64_t api_translate_address(uint64_t virtual_address, renode_riscv_access_type_t access_type)
+{
+    return tlib_translate_to_physical_address(virtual_address, access_type);
+}
+
+static uint64_t api_read_memory(uint64_t physical_address, uint32_t width)
+{
+    uint64_t cpu_state = tlib_get_cpu_state_for_memory_transaction();
+    switch(width) {
+        case 1:
+            return tlib_read_byte(physical_address, cpu_state);
+        case 2:
+            return tlib_read_word(physical_address, cpu_state);
+        case 4:
+            return tlib_read_double_word(physical_address, cpu_state);
+        case 8:
+            return tlib_read_quad_word(physical_address, cpu_state);
+        default:
+            tlib_log(LOG_LEVEL_ERROR, "Custom instruction plugin tried to read memory with an unsupported width");
+            return 0;
+    }
+}
+
+static void api_write_memory(uint64_t physical_address, uint32_t width, uint64_t value)
+{
+    uint64_t cpu_state = tlib_get_cpu_state_for_memory_transaction();
+    switch(width) {
+        case 1:
+            tlib_write_byte(physical_address, value, cpu_state);
+            break;
+        case 2:
+            tlib_write_word(physical_address, value, cpu_state);
+            break;
+        case 4:
+            tlib_write_double_word(physical_address, value, cpu_state);
+            break;
+        case 8:
+            tlib_write_quad_word(physical_address, value, cpu_state);
+            break;
+        default:
+            tlib_log(LOG_LEVEL_ERROR, "Custom instruction plugin tried to write memory with an unsupported width");
+            return;
+    }
+    //  The handler may modify code, e.g. when it emulates a store, so the blocks translated from it can't be used anymore
+    uintptr_t range[] = { physical_address, physical_address + width };
+    tlib_invalidate_translation_blocks(range, 1);
+}
+
+static void api_log(int32_t level, const char *message)
+{
+    tlib_log(level, (char *)message);
+}
+
+static const renode_riscv_plugin_api_t plugin_api = {
+    .abi_version = RENODE_RISCV_PLUGIN_ABI_VERSION,
+    .get_register = api_get_register,
+    .set_register = api_set_register,
+    .translate_address = api_translate_address,
+    .get_host_pointer = renode_guest_physical_to_host_ptr,
+    .read_memory = api_read_memory,
+    .write_memory = api_write_memory,
+    .log = api_log,
+};
+
+static native_custom_instruction_t *find_native_custom_instruction(uint64_t id)
+{
+    for(uint32_t i = 0; i < native_custom_instructions_count; i++) {
+        if(native_custom_instructions[i].id == id) {
+            return &native_custom_instructions[i];
+        }
+    }
+    return NULL;
+}
+
+int32_t tlib_handle_custom_instruction(uint64_t id, uint64_t opcode)
+{
+    native_custom_instruction_t *instruction = find_native_custom_instruction(id);
+    if(instruction == NULL) {
+        return managed_handle_custom_instruction(id, opcode);
+    }
+    pc_written = false;
+    instruction->handler(&plugin_api, opcode, instruction->plugin->user_data);
+    return pc_written ? 1 : 0;
+}
+
+static plugin_t *get_plugin(const char *path)
+{
+    for(uint32_t i = 0; i < plugins_count; i++) {
+        if(strcmp(plugins[i].path, path) == 0) {
+            return &plugins[i];
+        }
+    }
+    if(plugins_count == MAX_PLUGINS) {
+        log_error("Cannot load custom instruction plugin %s%s, the limit of plugins is exceeded", path, "");
+        return NULL;
+    }
+
+    void *handle = open_library(path);
+    if(handle == NULL) {
+        log_error("Cannot load custom instruction plugin %s: %s", path, get_library_error());
+        return NULL;
+    }
+
+    void *user_data = NULL;
+    renode_riscv_plugin_init_t init = (renode_riscv_plugin_init_t)find_symbol(handle, RENODE_RISCV_PLUGIN_INIT_SYMBOL);
+    if(init != NULL && init(&plugin_api, &user_data) != 0) {
+        log_error("Custom instruction plugin %s failed to initialize%s", path, "");
+        close_library(handle);
+        return NULL;
+    }
+
+    plugin_t *plugin = &plugins[plugins_count++];
+    plugin->path = strdup(path);
+    plugin->handle = handle;
+    plugin->user_data = user_data;
+    return plugin;
+}
+
+static renode_riscv_custom_instruction_handler_t resolve_handler(bool new_instruction, char *library_path, char *handler_name, plugin_t **plugin)
+{
+    if(new_instruction && native_custom_instructions_count == MAX_NATIVE_CUSTOM_INSTRUCTIONS) {
+        log_error("Cannot install native handler %s from %s, the limit of native custom instructions is exceeded", handler_name, library_path);
+        return NULL;
+    }
+
+    *plugin = get_plugin(library_path);
+    if(*plugin == NULL) {
+        return NULL;
+    }
+    renode_riscv_custom_instruction_handler_t handler = (renode_riscv_custom_instruction_handler_t)find_symbol((*plugin)->handle, handler_name);
+    if(handler == NULL) {
+        log_error("Cannot find custom instruction handler %s in %s", handler_name, library_path);
+    }
+    return handler;
+}
+
+uint32_t renode_riscv_resolve_native_custom_instruction(char *library_path, char *handler_name)
+{
+    plugin_t *plugin;
+    return resolve_handler(true, library_path, handler_name, &plugin) != NULL ? 1 : 0;
+}
+
+uint32_t renode_riscv_install_native_custom_instruction(uint64_t id, char *library_path, char *handler_name)
+{
+    plugin_t *plugin;
+    native_custom_instruction_t *instruction = find_native_custom_instruction(id);
+    renode_riscv_custom_instruction_handler_t handler = resolve_handler(instruction == NULL, library_path, handler_name, &plugin);
+    if(handler == NULL) {
+        return 0;
+    }
+
+    if(instruction == NULL) {
+        instruction = &native_custom_instructions[native_custom_instructions_count++];
+    }
+    instruction->id = id;
+    instruction->handler = handler;
+    instruction->plugin = plugin;
+    return 1;
+}
+
+void renode_riscv_unload_custom_instruction_plugins(void)
+{
+    native_custom_instructions_count = 0;
+    for(uint32_t i = 0; i < plugins_count; i++) {
+        renode_riscv_plugin_exit_t exit_plugin = (renode_riscv_plugin_exit_t)find_symbol(plugins[i].handle, RENODE_RISCV_PLUGIN_EXIT_SYMBOL);
+        if(exit_plugin != NULL) {
+            exit_plugin(plugins[i].user_data);
+        }
+        close_library(plugins[i].handle);
+        free(plugins[i].path);
+    }
+    plugins_count = 0;
+}
@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#ifndef RENODE_RISCV_PLUGIN_HOST_H_
+#define RENODE_RISCV_PLUGIN_HOST_H_
+
+#include <stdint.h>
+
+//  Loading of native custom instruction plugins and the API they get, exported to C# in renode_riscv_custom_instructions.c.
+//  It only depends on the tlib functions it declares, so it can also be built against fake ones.
+
+//  Loads the library and looks up the handler without installing it, so that the instruction pattern is only installed
+//  in tlib, which can't uninstall it, if `renode_riscv_install_native_custom_instruction` is going to succeed
+uint32_t renode_riscv_resolve_native_custom_instruction(char *library_path, char *handler_name);
+
+//  `id` is the one returned by `tlib_install_custom_instruction`, its instructions are then handled by `handler_name` from the library
+uint32_t renode_riscv_install_native_custom_instruction(uint64_t id, char *library_path, char *handler_name);
+
+void renode_riscv_unload_custom_instruction_plugins(void);
+
+//  Called by tlib for every installed custom instruction, the ones without a native handler are handled in C#.
+//  Returns 1 if the handler wrote PC.
+int32_t tlib_handle_custom_instruction(uint64_t id, uint64_t opcode);
+
+#endif
@@ -5,9 +5,76 @@
 // Full license text is available in 'licenses/MIT.txt' file.
 //
 
+#include <stdbool.h>
+
 #include "arch_callbacks.h"
 #include "renode_imports.h"
+#include "renode_semihosting.h"
+#include "renode_time.h"
+#include "../../../tlib/include/unwind.h"
+
+#define SIMCALL_WRITE  4
+#define REGISTER_A2    91
+#define REGISTER_A3    92
+#define REGISTER_A4    93
+#define REGISTER_A5    94
+#define STDOUT_FILENO  1
+#define STDERR_FILENO  2
+
+uint32_t tlib_get_register_value_32(int reg_number);
+void tlib_set_register_value_32(int reg_number, uint32_t value);
+
+EXTERNAL_AS(void, DoSemihosting, managed_do_semihosting)
+EXTERNAL_AS(void, FlushSemihostingConsole, managed_flush_semihosting_console, uint32_t, voidptr, uint32_t)
+
+static bool semihosting_enabled;
+
+static semihosting_console_t console = {
+    .flush = managed_flush_semihosting_console,
+};
+
+//  Writes to the console are buffered, the other simcalls are handled by C#
+void tlib_do_semihosting()
+{
+    if(semihosting_enabled && tlib_get_register_value_32(REGISTER_A2) == SIMCALL_WRITE) {
+        uint32_t fd = tlib_get_register_value_32(REGISTER_A3);
+        uint32_t length = tlib_get_register_value_32(REGISTER_A5);
+        void *data = renode_semihosting_get_guest_buffer(tlib_get_register_value_32(REGISTER_A4), length, false);
+        if((fd == STDOUT_FILENO || fd == STDERR_FILENO) && data != NULL) {
+            renode_semihosting_console_write(&console, SEMIHOSTING_STREAM_OUTPUT, data, length);
+            tlib_set_register_value_32(REGISTER_A2, length);
+            //  errno
+            tlib_set_register_value_32(REGISTER_A3, 0);
+            return;
+        }
+    }
+    renode_semihosting_console_flush(&console);
+    managed_do_semihosting();
+}
+
+void renode_xtensa_semihosting_configure(uint32_t enabled)
+{
+    renode_semihosting_console_flush(&console);
+    semihosting_enabled = enabled != 0;
+}
+
+EXC_VOID_1(renode_xtensa_semihosting_configure, uint32_t, enabled)
+
+void renode_xtensa_semihosting_flush()
+{
+    renode_semihosting_console_flush(&console);
+}
+
+EXC_VOID_0(renode_xtensa_semihosting_flush)
+EXTERNAL_AS(uint64_t, GetCPUTime, managed_get_cpu_time)
+
+uint64_t tlib_get_cpu_time()
+{
+    uint64_t value;
+    if(renode_read_time_counter(TIME_COUNTER_DEFAULT_KEY, &value)) {
+        return value;
+    }
+    return managed_get_cpu_time();
+}
 
-EXTERNAL_AS(void, DoSemihosting, tlib_do_semihosting)
-EXTERNAL_AS(uint64_t, GetCPUTime, tlib_get_cpu_time)
 EXTERNAL_AS(void, TimerMod, tlib_timer_mod, uint32_t, uint64_t)
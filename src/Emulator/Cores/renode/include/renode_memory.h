@@ -0,0 +1,10 @@
+#ifndef RENODE_MEMORY_H_
+#define RENODE_MEMORY_H_
+
+#include <stdint.h>
+
+/* Unlike `tlib_guest_offset_to_host_ptr`, it doesn't fail if there's no memory at `address`. It calls back to C# only to map
+ * a MappedMemory segment that hasn't been touched yet. Returns NULL if the whole range isn't in one memory block. */
+void *renode_guest_physical_to_host_ptr(uint64_t address, uint64_t size);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef RENODE_REGISTERS_H_
+#define RENODE_REGISTERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Registers declared by C# as plain storage, served without calling back. Each architecture callback looking them up
+ * uses its own space, with `id_mask` selecting the bits of the callback argument which identify the register. */
+typedef enum {
+    STORAGE_REGISTER_SPACE_CP15_32 = 0,
+    STORAGE_REGISTER_SPACE_CP15_64 = 1,
+    STORAGE_REGISTER_SPACE_CSR = 2,
+    STORAGE_REGISTER_SPACE_INTERRUPT_CPU_INTERFACE = 3,
+    STORAGE_REGISTER_SPACES_COUNT,
+} storage_register_space_t;
+
+typedef struct {
+    uint64_t id;
+    uint64_t id_mask;
+    uint64_t reset_value;
+    uint64_t writable_mask;
+    uint32_t space;
+    /* Writes are stored and then passed to the callback too, so that C# can react to them */
+    uint32_t notify_on_write;
+} storage_register_t;
+
+typedef enum {
+    STORAGE_REGISTER_NOT_FOUND,
+    STORAGE_REGISTER_WRITTEN,
+    STORAGE_REGISTER_WRITTEN_NOTIFY,
+} storage_register_write_result_t;
+
+/* Returns false if there is no such register and the access has to go through the callback */
+bool renode_read_storage_register(uint32_t space, uint64_t id, uint64_t *value);
+
+storage_register_write_result_t renode_write_storage_register(uint32_t space, uint64_t id, uint64_t value);
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef RENODE_RISCV_PLUGIN_H_
+#define RENODE_RISCV_PLUGIN_H_
+
+#include <stdint.h>
+
+/* ABI of native handlers of RISC-V custom instructions, loaded from shared libraries with `InstallNativeCustomInstruction`.
+ * The library has to export the handler with the `renode_riscv_custom_instruction_handler_t` signature and may export
+ * `renode_riscv_plugin_init` and `renode_riscv_plugin_exit`, called once per CPU after loading and before unloading it. */
+
+#define RENODE_RISCV_PLUGIN_ABI_VERSION 1
+
+#define RENODE_RISCV_PLUGIN_INIT_SYMBOL "renode_riscv_plugin_init"
+#define RENODE_RISCV_PLUGIN_EXIT_SYMBOL "renode_riscv_plugin_exit"
+
+/* Register indices, the same as in the register enums of the RISC-V CPUs. The floating-point registers are always
+ * 64-bit, the others, including CSRs at RENODE_RISCV_REGISTER_CSR(number), are XLEN-wide. */
+#define RENODE_RISCV_REGISTER_X0          0
+#define RENODE_RISCV_REGISTER_PC          32
+#define RENODE_RISCV_REGISTER_F0          33
+#define RENODE_RISCV_REGISTER_F31         64
+#define RENODE_RISCV_REGISTER_CSR(number) (65 + (number))
+
+typedef enum {
+    RENODE_RISCV_ACCESS_READ = 0,
+    RENODE_RISCV_ACCESS_WRITE = 1,
+    RENODE_RISCV_ACCESS_FETCH = 2,
+} renode_riscv_access_type_t;
+
+typedef struct renode_riscv_plugin_api {
+    uint32_t abi_version;
+
+    uint64_t (*get_register)(int32_t index);
+    /* Writing PC makes the CPU continue from the new address after the handler returns */
+    void (*set_register)(int32_t index, uint64_t value);
+
+    /* Returns UINT64_MAX if the virtual address isn't mapped */
+    uint64_t (*translate_address)(uint64_t virtual_address, renode_riscv_access_type_t access_type);
+    /* Pointer to the host memory backing `size` bytes of guest RAM at the physical address, NULL if it's not RAM,
+     * e.g. a peripheral, or if the range crosses a memory block. RAM that wasn't accessed yet is mapped on the first call,
+     * so NULL never means untouched RAM. It stays valid until the handler returns.
+     * Writes through it don't invalidate the code translated from that memory, so it mustn't be used to modify code,
+     * use `write_memory` for that instead. */
+    void *(*get_host_pointer)(uint64_t physical_address, uint64_t size);
+    /* Accesses through the system bus, `width` in bytes: 1, 2, 4 or 8. Writes invalidate the code translated from the written memory. */
+    uint64_t (*read_memory)(uint64_t physical_address, uint32_t width);
+    void (*write_memory)(uint64_t physical_address, uint32_t width, uint64_t value);
+
+    /* Levels as in Renode's LogLevel, e.g. 2 - warning, 3 - error */
+    void (*log)(int32_t level, const char *message);
+} renode_riscv_plugin_api_t;
+
+typedef void (*renode_riscv_custom_instruction_handler_t)(const renode_riscv_plugin_api_t *api, uint64_t opcode, void *user_data);
+
+/* Returning non-zero fails the installation of the handler, `user_data` is then passed to the handlers of the library */
+typedef int32_t (*renode_riscv_plugin_init_t)(const renode_riscv_plugin_api_t *api, void **user_data);
+
+typedef void (*renode_riscv_plugin_exit_t)(void *user_data);
+
+#endif
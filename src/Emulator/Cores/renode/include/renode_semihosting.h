@@ -0,0 +1,43 @@
+#ifndef RENODE_SEMIHOSTING_H_
+#define RENODE_SEMIHOSTING_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SEMIHOSTING_CONSOLE_BUFFER_SIZE 4096
+
+/* Streams of the console, i.e. the UARTs of the semihosting handler */
+typedef enum {
+    SEMIHOSTING_STREAM_NONE = 0,
+    SEMIHOSTING_STREAM_OUTPUT = 1,
+    SEMIHOSTING_STREAM_ERROR = 2,
+} semihosting_stream_t;
+
+/* Passes the buffered characters to C#, which writes them to the UART of `stream` */
+typedef void (*semihosting_console_flush_t)(uint32_t stream, void *data, uint32_t length);
+
+/* Console writes of the guest are gathered here and passed to C# in chunks, when the buffer fills up,
+ * the guest writes to another stream, an operation has to be handled by C# or C# asks for it,
+ * e.g. at the end of each quantum. */
+typedef struct {
+    semihosting_console_flush_t flush;
+    uint32_t stream;
+    uint32_t length;
+    uint8_t data[SEMIHOSTING_CONSOLE_BUFFER_SIZE];
+} semihosting_console_t;
+
+void renode_semihosting_console_write(semihosting_console_t *console, uint32_t stream, const void *data, uint32_t length);
+void renode_semihosting_console_flush(semihosting_console_t *console);
+
+/* Returns the host pointer to `length` bytes of the guest memory at `virtual_address`, or NULL if they aren't
+ * in a single block of memory already mapped by C#, in which case the operation has to be handled by C#. */
+void *renode_semihosting_get_guest_buffer(uint64_t virtual_address, uint64_t length, bool write);
+
+/* Has to be called after writing to a buffer returned by `renode_semihosting_get_guest_buffer`, as the bus would do,
+ * so that the code translated from it isn't used anymore */
+void renode_semihosting_invalidate_guest_buffer(uint64_t virtual_address, uint64_t length);
+
+/* Looks for the null character within the mapped memory, returns false if it isn't there */
+bool renode_semihosting_get_guest_string(uint64_t virtual_address, const char **string, uint32_t *length);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef RENODE_TIME_H_
+#define RENODE_TIME_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Counters published by C# after being read through a callback. Until the clock source of the machine changes,
+ * their values are computed here from the number of instructions executed since then, i.e.
+ * value + (executed * numerator + residuum) / denominator, as long as fewer than `limit` instructions were executed.
+ * Counters which only change when the time of the machine advances are published with a zero numerator. */
+typedef struct {
+    uint64_t value;
+    uint64_t instructions;
+    uint64_t limit;
+    uint64_t numerator;
+    uint64_t denominator;
+    uint64_t residuum;
+    uint32_t key;
+    uint32_t valid;
+} time_counter_t;
+
+/* Key of the counter of architectures exposing a single one, the others use the register numbers */
+#define TIME_COUNTER_DEFAULT_KEY 0
+
+/* Returns false if the counter identified by `key` has to be read through the callback */
+bool renode_read_time_counter(uint32_t key, uint64_t *value);
+
+#endif
@@ -8,9 +8,11 @@
 
 #include <callbacks.h>
 #include "renode_imports.h"
+#include "renode_memory.h"
 #include "../tlib/include/unwind.h"
 
 EXTERNAL(void, touch_host_block, uint64_t)
+EXTERNAL(uint32_t, touch_host_block_if_mapped, uint64_t)
 
 typedef struct {
   uint64_t start;
@@ -93,6 +95,41 @@ try_find_block:
   goto try_find_block;
 }
 
+static void *find_host_ptr(uint64_t address, uint64_t size)
+{
+  host_memory_block_lists_t *host_blocks_list_cached = lists;
+  if(host_blocks_list_cached == NULL)
+  {
+      return NULL;
+  }
+
+  for(uint32_t i = 0; i < host_blocks_list_cached->size; i++)
+  {
+      host_memory_block_t *block = &host_blocks_list_cached->elements[i];
+      if(address >= block->start && address - block->start < block->size && size <= block->size - (address - block->start))
+      {
+          return block->host_pointer + (address - block->start);
+      }
+  }
+  return NULL;
+}
+
+void *renode_guest_physical_to_host_ptr(uint64_t address, uint64_t size)
+{
+  if(size == 0)
+  {
+      return NULL;
+  }
+
+  void *host_pointer = find_host_ptr(address, size);
+  // Segments of MappedMemory are only mapped once touched, the lookup is retried if one gets mapped
+  while(host_pointer == NULL && touch_host_block_if_mapped(address))
+  {
+      host_pointer = find_host_ptr(address, size);
+  }
+  return host_pointer;
+}
+
 static void free_list(host_memory_block_lists_t **lists)
 {
     if(*lists == NULL)
@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include <stddef.h>
+#include "include/renode_imports.h"
+#include "include/renode_registers.h"
+#include "../tlib/include/unwind.h"
+
+//  Has to be a power of 2
+#define STORAGE_REGISTERS_SLOTS 256
+
+typedef struct {
+    storage_register_t declaration;
+    uint64_t value;
+    bool used;
+} storage_register_slot_t;
+
+static storage_register_slot_t storage_registers[STORAGE_REGISTERS_SLOTS];
+static uint64_t id_masks[STORAGE_REGISTER_SPACES_COUNT];
+static uint32_t storage_registers_count;
+
+static inline uint32_t get_first_slot(uint32_t space, uint64_t id)
+{
+    uint64_t hash = (id ^ ((uint64_t)space << 32)) * 0x9E3779B97F4A7C15ULL;
+    return (uint32_t)(hash >> 32) & (STORAGE_REGISTERS_SLOTS - 1);
+}
+
+//  Open addressing, undeclared registers keep their slots so the first unused slot ends the search
+static storage_register_slot_t *find_slot(uint32_t space, uint64_t id)
+{
+    for(uint32_t i = 0, index = get_first_slot(space, id); i < STORAGE_REGISTERS_SLOTS; i++, index = (index + 1) & (STORAGE_REGISTERS_SLOTS - 1)) {
+        storage_register_slot_t *slot = &storage_registers[index];
+        if(!slot->used || (slot->declaration.space == space && slot->declaration.id == id)) {
+            return slot;
+        }
+    }
+    return NULL;
+}
+
+static storage_register_slot_t *find_register(uint32_t space, uint64_t id)
+{
+    if(storage_registers_count == 0 || space >= STORAGE_REGISTER_SPACES_COUNT) {
+        return NULL;
+    }
+    storage_register_slot_t *slot = find_slot(space, id & id_masks[space]);
+    return slot != NULL && slot->used ? slot : NULL;
+}
+
+bool renode_read_storage_register(uint32_t space, uint64_t id, uint64_t *value)
+{
+    storage_register_slot_t *slot = find_register(space, id);
+    if(slot == NULL) {
+        return false;
+    }
+    *value = slot->value;
+    return true;
+}
+
+storage_register_write_result_t renode_write_storage_register(uint32_t space, uint64_t id, uint64_t value)
+{
+    storage_register_slot_t *slot = find_register(space, id);
+    if(slot == NULL) {
+        return STORAGE_REGISTER_NOT_FOUND;
+    }
+    uint64_t writable_mask = slot->declaration.writable_mask;
+    slot->value = (slot->value & ~writable_mask) | (value & writable_mask);
+    return slot->declaration.notify_on_write ? STORAGE_REGISTER_WRITTEN_NOTIFY : STORAGE_REGISTER_WRITTEN;
+}
+
+//  All the registers of a space have to use the same `id_mask`.
+//  Returns 0 if the register can't be declared, i.e. it already exists or there are no free slots.
+uint32_t renode_declare_storage_register(storage_register_t *declaration)
+{
+    if(declaration->space >= STORAGE_REGISTER_SPACES_COUNT) {
+        return 0;
+    }
+    uint64_t id = declaration->id & declaration->id_mask;
+    //  Keep a free slot so that the lookups of registers that weren't declared always end
+    if(storage_registers_count + 1 >= STORAGE_REGISTERS_SLOTS) {
+        return 0;
+    }
+    storage_register_slot_t *slot = find_slot(declaration->space, id);
+    if(slot == NULL || slot->used) {
+        return 0;
+    }
+    slot->declaration = *declaration;
+    slot->declaration.id = id;
+    slot->value = declaration->reset_value;
+    slot->used = true;
+    id_masks[declaration->space] = declaration->id_mask;
+    storage_registers_count++;
+    return 1;
+}
+
+EXC_VALUE_1(uint32_t, renode_declare_storage_register, 0, storage_register_t *, declaration)
+
+//  The slot is left used with an invalid space, so that it still continues the searches of other registers
+void renode_undeclare_storage_register(uint32_t space, uint64_t id)
+{
+    storage_register_slot_t *slot = find_register(space, id);
+    if(slot != NULL) {
+        slot->declaration.space = STORAGE_REGISTER_SPACES_COUNT;
+    }
+}
+
+EXC_VOID_2(renode_undeclare_storage_register, uint32_t, space, uint64_t, id)
+
+uint64_t renode_get_storage_register(uint32_t space, uint64_t id)
+{
+    uint64_t value = 0;
+    renode_read_storage_register(space, id, &value);
+    return value;
+}
+
+EXC_VALUE_2(uint64_t, renode_get_storage_register, 0, uint32_t, space, uint64_t, id)
+
+//  Writes done by C# respect the writable mask as well, but they don't notify it
+void renode_set_storage_register(uint32_t space, uint64_t id, uint64_t value)
+{
+    renode_write_storage_register(space, id, value);
+}
+
+EXC_VOID_3(renode_set_storage_register, uint32_t, space, uint64_t, id, uint64_t, value)
+
+//  Changes the bits which aren't writable too, e.g. when restoring the state
+void renode_set_storage_register_value(uint32_t space, uint64_t id, uint64_t value)
+{
+    storage_register_slot_t *slot = find_register(space, id);
+    if(slot != NULL) {
+        slot->value = value;
+    }
+}
+
+EXC_VOID_3(renode_set_storage_register_value, uint32_t, space, uint64_t, id, uint64_t, value)
+
+void renode_reset_storage_registers()
+{
+    for(uint32_t i = 0; i < STORAGE_REGISTERS_SLOTS; i++) {
+        if(storage_registers[i].used) {
+            storage_registers[i].value = storage_registers[i].declaration.reset_value;
+        }
+    }
+}
+
+EXC_VOID_0(renode_reset_storage_registers)
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include <string.h>
+#include "include/renode_memory.h"
+#include "include/renode_semihosting.h"
+
+#define ACCESS_TYPE_READ     0
+#define ACCESS_TYPE_WRITE    1
+#define MAX_GUEST_STRING     4096
+//  The smallest page size of the supported MMUs, buffers crossing it are translated page by page
+#define GUEST_PAGE_SIZE      1024
+
+uint64_t tlib_translate_to_physical_address(uint64_t address, uint32_t access_type);
+void tlib_invalidate_translation_blocks(uintptr_t *regions, uint64_t count);
+
+void renode_semihosting_console_flush(semihosting_console_t *console)
+{
+    if(console->length == 0) {
+        return;
+    }
+    //  The buffer can be written to again by the callback, e.g. if it resumes the emulation
+    uint32_t length = console->length;
+    console->length = 0;
+    console->flush(console->stream, console->data, length);
+}
+
+void renode_semihosting_console_write(semihosting_console_t *console, uint32_t stream, const void *data, uint32_t length)
+{
+    if(console->stream != stream || console->length + length > SEMIHOSTING_CONSOLE_BUFFER_SIZE) {
+        renode_semihosting_console_flush(console);
+        console->stream = stream;
+    }
+    if(length > SEMIHOSTING_CONSOLE_BUFFER_SIZE) {
+        console->flush(stream, (void *)data, length);
+        return;
+    }
+    memcpy(console->data + console->length, data, length);
+    console->length += length;
+}
+
+void *renode_semihosting_get_guest_buffer(uint64_t virtual_address, uint64_t length, bool write)
+{
+    uint32_t access_type = write ? ACCESS_TYPE_WRITE : ACCESS_TYPE_READ;
+    uint64_t physical_address = tlib_translate_to_physical_address(virtual_address, access_type);
+    if(physical_address == UINT64_MAX) {
+        return NULL;
+    }
+    //  The buffer has to be contiguous in the physical memory too
+    uint64_t page = (virtual_address | (GUEST_PAGE_SIZE - 1)) + 1;
+    for(; page - virtual_address < length; page += GUEST_PAGE_SIZE) {
+        if(tlib_translate_to_physical_address(page, access_type) != physical_address + (page - virtual_address)) {
+            return NULL;
+        }
+    }
+    return renode_guest_physical_to_host_ptr(physical_address, length);
+}
+
+void renode_semihosting_invalidate_guest_buffer(uint64_t virtual_address, uint64_t length)
+{
+    uint64_t physical_address = tlib_translate_to_physical_address(virtual_address, ACCESS_TYPE_WRITE);
+    if(length == 0 || physical_address == UINT64_MAX) {
+        return;
+    }
+    uintptr_t range[] = { physical_address, physical_address + length };
+    tlib_invalidate_translation_blocks(range, 1);
+}
+
+bool renode_semihosting_get_guest_string(uint64_t virtual_address, const char **string, uint32_t *length)
+{
+    const char *start = NULL;
+    uint32_t scanned = 0;
+    while(scanned < MAX_GUEST_STRING) {
+        uint64_t address = virtual_address + scanned;
+        uint32_t chunk = GUEST_PAGE_SIZE - (address % GUEST_PAGE_SIZE);
+        const char *host = renode_semihosting_get_guest_buffer(address, chunk, false);
+        if(host == NULL || (start != NULL && host != start + scanned)) {
+            return false;
+        }
+        if(start == NULL) {
+            start = host;
+        }
+        const char *end = memchr(host, '\0', chunk);
+        if(end != NULL) {
+            *string = start;
+            *length = scanned + (end - host);
+            return true;
+        }
+        scanned += chunk;
+    }
+    return false;
+}
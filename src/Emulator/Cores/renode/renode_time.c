@@ -0,0 +1,83 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under MIT License.
+// Full license text is available in 'licenses/MIT.txt' file.
+//
+
+#include <string.h>
+#include "include/renode_imports.h"
+#include "include/renode_time.h"
+#include "../tlib/include/unwind.h"
+
+#define TIME_COUNTERS_COUNT 4
+
+uint64_t tlib_get_total_executed_instructions(void);
+
+static time_counter_t time_counters[TIME_COUNTERS_COUNT];
+//  Odd while the counter in the same slot is being replaced, the counters are only replaced on the CPU thread
+static uint32_t sequences[TIME_COUNTERS_COUNT];
+
+bool renode_read_time_counter(uint32_t key, uint64_t *value)
+{
+    for(int i = 0; i < TIME_COUNTERS_COUNT; i++) {
+        uint32_t sequence = __atomic_load_n(&sequences[i], __ATOMIC_ACQUIRE);
+        if((sequence & 1) || !__atomic_load_n(&time_counters[i].valid, __ATOMIC_ACQUIRE)) {
+            continue;
+        }
+        time_counter_t counter;
+        memcpy(&counter, &time_counters[i], sizeof(time_counter_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if(__atomic_load_n(&sequences[i], __ATOMIC_RELAXED) != sequence || !__atomic_load_n(&time_counters[i].valid, __ATOMIC_RELAXED)) {
+            //  Replaced or invalidated while being copied
+            continue;
+        }
+        if(counter.key != key) {
+            continue;
+        }
+        uint64_t executed = counter.numerator == 0 ? 0 : tlib_get_total_executed_instructions() - counter.instructions;
+        if(executed >= counter.limit) {
+            return false;
+        }
+        *value = counter.value + (uint64_t)(((unsigned __int128)executed * counter.numerator + counter.residuum) / counter.denominator);
+        return true;
+    }
+    return false;
+}
+
+void renode_set_time_counter(time_counter_t *counter)
+{
+    //  Replaces the counter with the same key, the slot is picked by the key otherwise
+    int index = counter->key % TIME_COUNTERS_COUNT;
+    for(int i = 0; i < TIME_COUNTERS_COUNT; i++) {
+        if(time_counters[i].key == counter->key) {
+            index = i;
+            break;
+        }
+    }
+
+    time_counter_t *slot = &time_counters[index];
+    __atomic_store_n(&slot->valid, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&sequences[index], sequences[index] + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->value = counter->value;
+    slot->instructions = counter->instructions;
+    slot->limit = counter->limit;
+    slot->numerator = counter->numerator;
+    slot->denominator = counter->denominator;
+    slot->residuum = counter->residuum;
+    slot->key = counter->key;
+    __atomic_store_n(&slot->valid, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&sequences[index], sequences[index] + 1, __ATOMIC_RELEASE);
+}
+
+EXC_VOID_1(renode_set_time_counter, time_counter_t *, counter)
+
+void renode_invalidate_time_counters()
+{
+    for(int i = 0; i < TIME_COUNTERS_COUNT; i++) {
+        __atomic_store_n(&time_counters[i].valid, 0, __ATOMIC_RELEASE);
+    }
+}
+
+EXC_VOID_0(renode_invalidate_time_counters)
@@ -0,0 +1,384 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <dlfcn.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "renode_riscv_plugin.h"
+#include "renode_riscv_plugin_host.h"
+
+#define CPU_STATE         0xC5
+#define BUS_BASE          0x1000
+#define BUS_SIZE          64
+#define RAM_BASE          0x2000
+#define RAM_SIZE          64
+#define VIRTUAL_BASE      0x80000000
+#define LOG_LEVEL_ERROR   3
+#define MAX_INSTRUCTIONS  64
+#define REGISTERS_COUNT   (RENODE_RISCV_REGISTER_F31 + 1)
+
+/* R-type opcode of the custom-0 major opcode, the handlers only decode the register fields */
+#define OPCODE(rd, rs1, rs2) (((uint64_t)(rs2) << 20) | ((uint64_t)(rs1) << 15) | ((uint64_t)(rd) << 7) | 0x0b)
+
+static int failures;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if(!(condition)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while(0)
+
+/* Fake tlib functions and C# callbacks, standing in for the ones the host is linked with in tlib, record the calls */
+
+static struct {
+    uint64_t registers[REGISTERS_COUNT];
+    uint32_t accesses_32;
+    uint32_t accesses_64;
+    uint8_t bus[BUS_SIZE];
+    uint32_t last_width;
+    bool wrong_cpu_state;
+    uint8_t ram[RAM_SIZE];
+    uint32_t last_access_type;
+    uintptr_t invalidated[2];
+    uint32_t invalidations;
+    uint32_t errors;
+    uint64_t managed_id;
+    uint32_t managed_calls;
+} cpu;
+
+static void reset_cpu()
+{
+    memset(&cpu, 0, sizeof(cpu));
+}
+
+int32_t managed_handle_custom_instruction(uint64_t id, uint64_t opcode)
+{
+    cpu.managed_id = id;
+    cpu.managed_calls++;
+    return 0;
+}
+
+void tlib_log(int32_t level, char *message)
+{
+    if(level == LOG_LEVEL_ERROR) {
+        cpu.errors++;
+    }
+}
+
+uint64_t tlib_get_cpu_state_for_memory_transaction(void)
+{
+    return CPU_STATE;
+}
+
+static uint64_t read_bus(uint64_t address, uint64_t cpu_state, uint32_t width)
+{
+    uint64_t value = 0;
+    cpu.last_width = width;
+    cpu.wrong_cpu_state |= cpu_state != CPU_STATE;
+    if(address >= BUS_BASE && address - BUS_BASE + width <= BUS_SIZE) {
+        memcpy(&value, &cpu.bus[address - BUS_BASE], width);
+    }
+    return value;
+}
+
+static void write_bus(uint64_t address, uint64_t value, uint64_t cpu_state, uint32_t width)
+{
+    cpu.last_width = width;
+    cpu.wrong_cpu_state |= cpu_state != CPU_STATE;
+    if(address >= BUS_BASE && address - BUS_BASE + width <= BUS_SIZE) {
+        memcpy(&cpu.bus[address - BUS_BASE], &value, width);
+    }
+}
+
+uint64_t tlib_read_byte(uint64_t address, uint64_t cpu_state)
+{
+    return read_bus(address, cpu_state, 1);
+}
+
+uint64_t tlib_read_word(uint64_t address, uint64_t cpu_state)
+{
+    return read_bus(address, cpu_state, 2);
+}
+
+uint64_t tlib_read_double_word(uint64_t address, uint64_t cpu_state)
+{
+    return read_bus(address, cpu_state, 4);
+}
+
+uint64_t tlib_read_quad_word(uint64_t address, uint64_t cpu_state)
+{
+    return read_bus(address, cpu_state, 8);
+}
+
+void tlib_write_byte(uint64_t address, uint64_t value, uint64_t cpu_state)
+{
+    write_bus(address, value, cpu_state, 1);
+}
+
+void tlib_write_word(uint64_t address, uint64_t value, uint64_t cpu_state)
+{
+    write_bus(address, value, cpu_state, 2);
+}
+
+void tlib_write_double_word(uint64_t address, uint64_t value, uint64_t cpu_state)
+{
+    write_bus(address, value, cpu_state, 4);
+}
+
+void tlib_write_quad_word(uint64_t address, uint64_t value, uint64_t cpu_state)
+{
+    write_bus(address, value, cpu_state, 8);
+}
+
+void tlib_invalidate_translation_blocks(uintptr_t *regions, uint64_t count)
+{
+    cpu.invalidations++;
+    cpu.invalidated[0] = regions[0];
+    cpu.invalidated[1] = regions[1];
+}
+
+/* Virtual addresses from VIRTUAL_BASE are mapped to the bus */
+uint64_t tlib_translate_to_physical_address(uint64_t address, uint32_t access_type)
+{
+    cpu.last_access_type = access_type;
+    if(address < VIRTUAL_BASE || address - VIRTUAL_BASE >= BUS_SIZE) {
+        return UINT64_MAX;
+    }
+    return address - VIRTUAL_BASE + BUS_BASE;
+}
+
+uint64_t tlib_get_register_value_64(int reg_number)
+{
+    cpu.accesses_64++;
+    return cpu.registers[reg_number];
+}
+
+void tlib_set_register_value_64(int reg_number, uint64_t value)
+{
+    cpu.accesses_64++;
+    cpu.registers[reg_number] = value;
+}
+
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+uint32_t tlib_get_register_value_32(int reg_number)
+{
+    cpu.accesses_32++;
+    return (uint32_t)cpu.registers[reg_number];
+}
+
+void tlib_set_register_value_32(int reg_number, uint32_t value)
+{
+    cpu.accesses_32++;
+    cpu.registers[reg_number] = value;
+}
+#endif
+
+void *renode_guest_physical_to_host_ptr(uint64_t address, uint64_t size)
+{
+    if(size == 0 || address < RAM_BASE || address - RAM_BASE + size > RAM_SIZE) {
+        return NULL;
+    }
+    return &cpu.ram[address - RAM_BASE];
+}
+
+/* Counters of the test plugin, read through a separate handle of the library */
+static int32_t *plugin_init_calls;
+static int32_t *plugin_exit_calls;
+static void **plugin_exit_user_data;
+
+static uint32_t resolve(const char *library_path, const char *handler_name)
+{
+    return renode_riscv_resolve_native_custom_instruction((char *)library_path, (char *)handler_name);
+}
+
+static uint32_t install(uint64_t id, const char *handler_name)
+{
+    return renode_riscv_install_native_custom_instruction(id, TEST_PLUGIN_PATH, (char *)handler_name);
+}
+
+static void test_resolve_reports_missing_library_and_handler()
+{
+    reset_cpu();
+
+    CHECK(resolve(TEST_PLUGIN_PATH ".missing", "test_add") == 0);
+    CHECK(resolve(TEST_PLUGIN_PATH, "missing_handler") == 0);
+    CHECK(cpu.errors == 2);
+    /* The library stays loaded after the handler lookup failed */
+    CHECK(*plugin_init_calls == 1);
+}
+
+static void test_resolve_does_not_install_handler()
+{
+    reset_cpu();
+
+    CHECK(resolve(TEST_PLUGIN_PATH, "test_add") == 1);
+    CHECK(tlib_handle_custom_instruction(1, OPCODE(3, 1, 2)) == 0);
+    CHECK(cpu.managed_calls == 1);
+    CHECK(cpu.managed_id == 1);
+    CHECK(*plugin_init_calls == 1);
+}
+
+static void test_handler_accesses_registers()
+{
+    reset_cpu();
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 1] = 5;
+    cpu.registers[RENODE_RISCV_REGISTER_F0 + 2] = 7;
+
+    CHECK(install(1, "test_add") == 1);
+    CHECK(tlib_handle_custom_instruction(1, OPCODE(3, 1, 2)) == 0);
+    CHECK(cpu.managed_calls == 0);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_X0 + 3] == 12);
+#if defined(TARGET_LONG_BITS) && TARGET_LONG_BITS == 32
+    /* GPRs are XLEN-wide, floating-point registers are always 64-bit */
+    CHECK(cpu.accesses_32 == 2);
+    CHECK(cpu.accesses_64 == 1);
+#else
+    CHECK(cpu.accesses_64 == 3);
+#endif
+}
+
+static void test_handler_writing_pc_is_reported()
+{
+    reset_cpu();
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 1] = 0x4000;
+
+    CHECK(install(2, "test_jump") == 1);
+    CHECK(tlib_handle_custom_instruction(2, OPCODE(4, 1, 0)) == 1);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_PC] == 0x4000);
+    /* The state set up by the initialization of the library is shared by its handlers */
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_X0 + 4] == 2);
+
+    /* Only the instruction which wrote PC is reported */
+    CHECK(tlib_handle_custom_instruction(1, OPCODE(3, 1, 2)) == 0);
+}
+
+static void test_handler_accesses_memory_through_bus()
+{
+    reset_cpu();
+    const uint32_t word = 0x12345678;
+    memcpy(&cpu.bus[8], &word, sizeof(word));
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 1] = VIRTUAL_BASE + 8;
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 2] = 0xABCD;
+
+    CHECK(install(3, "test_memory") == 1);
+    CHECK(tlib_handle_custom_instruction(3, OPCODE(5, 1, 2)) == 0);
+
+    CHECK(cpu.last_access_type == RENODE_RISCV_ACCESS_WRITE);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_X0 + 5] == word);
+    CHECK(cpu.bus[12] == 0xCD);
+    CHECK(cpu.bus[13] == 0xAB);
+    CHECK(cpu.bus[14] == 0);
+    CHECK(!cpu.wrong_cpu_state);
+    /* The written memory can't be executed from stale translations */
+    CHECK(cpu.invalidations == 1);
+    CHECK(cpu.invalidated[0] == BUS_BASE + 12);
+    CHECK(cpu.invalidated[1] == BUS_BASE + 14);
+    /* The unsupported width is reported and doesn't access the bus */
+    CHECK(cpu.errors == 1);
+    CHECK(cpu.last_width == 2);
+}
+
+static void test_handler_accesses_host_memory()
+{
+    reset_cpu();
+    cpu.ram[16] = 41;
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 1] = RAM_BASE + 16;
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 2] = BUS_BASE;
+
+    CHECK(install(4, "test_host_pointer") == 1);
+    CHECK(tlib_handle_custom_instruction(4, OPCODE(6, 1, 0)) == 0);
+    CHECK(cpu.ram[16] == 42);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_X0 + 6] == 1);
+
+    CHECK(tlib_handle_custom_instruction(4, OPCODE(6, 2, 0)) == 0);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_X0 + 6] == 0);
+}
+
+static void test_installing_again_replaces_handler()
+{
+    reset_cpu();
+    cpu.registers[RENODE_RISCV_REGISTER_X0 + 1] = 0x5000;
+
+    /* It's what restoring the handlers after loading the emulation does */
+    CHECK(install(1, "test_jump") == 1);
+    CHECK(tlib_handle_custom_instruction(1, OPCODE(3, 1, 0)) == 1);
+    CHECK(cpu.registers[RENODE_RISCV_REGISTER_PC] == 0x5000);
+    CHECK(*plugin_init_calls == 1);
+}
+
+static void test_limit_of_instructions_is_enforced()
+{
+    reset_cpu();
+
+    /* 4 instructions are already installed */
+    for(uint64_t id = 5; id <= MAX_INSTRUCTIONS; id++) {
+        CHECK(install(id, "test_add") == 1);
+    }
+    CHECK(cpu.errors == 0);
+    CHECK(resolve(TEST_PLUGIN_PATH, "test_add") == 0);
+    CHECK(install(MAX_INSTRUCTIONS + 1, "test_add") == 0);
+    CHECK(cpu.errors == 2);
+
+    /* Installed instructions can still be replaced */
+    CHECK(install(MAX_INSTRUCTIONS, "test_jump") == 1);
+}
+
+static void test_unload_calls_exit_and_uninstalls_handlers()
+{
+    reset_cpu();
+
+    renode_riscv_unload_custom_instruction_plugins();
+    CHECK(*plugin_exit_calls == 1);
+    CHECK(*plugin_exit_user_data != NULL);
+    CHECK(tlib_handle_custom_instruction(1, OPCODE(3, 1, 2)) == 0);
+    CHECK(cpu.managed_calls == 1);
+
+    /* The library is initialized again when it's needed after unloading */
+    CHECK(install(1, "test_add") == 1);
+    CHECK(*plugin_init_calls == 2);
+    renode_riscv_unload_custom_instruction_plugins();
+    CHECK(*plugin_exit_calls == 2);
+}
+
+#define RUN_TEST(test)                                                              \
+    do {                                                                            \
+        const int failures_before = failures;                                       \
+        test();                                                                     \
+        printf("%-60s %s\n", #test, failures == failures_before ? "OK" : "FAILED"); \
+    } while(0)
+
+/* Tests of the native custom instruction plugins of RISC-V CPUs, run against fake tlib functions and riscv_test_plugin.c */
+int main()
+{
+    /* Keeps the library loaded after the host unloads it, so that its counters can be checked */
+    void *plugin = dlopen(TEST_PLUGIN_PATH, RTLD_NOW | RTLD_LOCAL);
+    if(plugin == NULL) {
+        fprintf(stderr, "Cannot load %s: %s\n", TEST_PLUGIN_PATH, dlerror());
+        return EXIT_FAILURE;
+    }
+    plugin_init_calls = dlsym(plugin, "test_plugin_init_calls");
+    plugin_exit_calls = dlsym(plugin, "test_plugin_exit_calls");
+    plugin_exit_user_data = dlsym(plugin, "test_plugin_exit_user_data");
+
+    RUN_TEST(test_resolve_reports_missing_library_and_handler);
+    RUN_TEST(test_resolve_does_not_install_handler);
+    RUN_TEST(test_handler_accesses_registers);
+    RUN_TEST(test_handler_writing_pc_is_reported);
+    RUN_TEST(test_handler_accesses_memory_through_bus);
+    RUN_TEST(test_handler_accesses_host_memory);
+    RUN_TEST(test_installing_again_replaces_handler);
+    RUN_TEST(test_limit_of_instructions_is_enforced);
+    RUN_TEST(test_unload_calls_exit_and_uninstalls_handlers);
+
+    dlclose(plugin);
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
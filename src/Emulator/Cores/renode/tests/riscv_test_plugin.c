@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+/* Custom instruction plugin used by riscv_plugin_host_tests.c. The handlers take their operands from the registers
+ * encoded in the opcode like R-type instructions: rd at bits 7-11, rs1 at bits 15-19 and rs2 at bits 20-24. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "renode_riscv_plugin.h"
+
+#define RD(opcode)  (((opcode) >> 7) & 0x1f)
+#define RS1(opcode) (((opcode) >> 15) & 0x1f)
+#define RS2(opcode) (((opcode) >> 20) & 0x1f)
+
+typedef struct {
+    uint64_t handled;
+} plugin_state_t;
+
+static plugin_state_t state;
+
+/* Read by the test through its own handle of the library */
+int32_t test_plugin_init_calls;
+int32_t test_plugin_exit_calls;
+void *test_plugin_exit_user_data;
+
+int32_t renode_riscv_plugin_init(const renode_riscv_plugin_api_t *api, void **user_data)
+{
+    test_plugin_init_calls++;
+    if(api->abi_version != RENODE_RISCV_PLUGIN_ABI_VERSION) {
+        return 1;
+    }
+    memset(&state, 0, sizeof(state));
+    *user_data = &state;
+    return 0;
+}
+
+void renode_riscv_plugin_exit(void *user_data)
+{
+    test_plugin_exit_calls++;
+    test_plugin_exit_user_data = user_data;
+}
+
+/* rd = rs1 + rs2, rs2 is a floating-point register to check the access to them */
+void test_add(const renode_riscv_plugin_api_t *api, uint64_t opcode, void *user_data)
+{
+    ((plugin_state_t *)user_data)->handled++;
+    uint64_t sum = api->get_register(RENODE_RISCV_REGISTER_X0 + RS1(opcode)) + api->get_register(RENODE_RISCV_REGISTER_F0 + RS2(opcode));
+    api->set_register(RENODE_RISCV_REGISTER_X0 + RD(opcode), sum);
+}
+
+/* pc = rs1, rd = number of the handled instructions */
+void test_jump(const renode_riscv_plugin_api_t *api, uint64_t opcode, void *user_data)
+{
+    plugin_state_t *plugin_state = user_data;
+    plugin_state->handled++;
+    api->set_register(RENODE_RISCV_REGISTER_PC, api->get_register(RENODE_RISCV_REGISTER_X0 + RS1(opcode)));
+    api->set_register(RENODE_RISCV_REGISTER_X0 + RD(opcode), plugin_state->handled);
+}
+
+/* Reads a word from the virtual address in rs1 to rd and writes rs2 as a half-word after it */
+void test_memory(const renode_riscv_plugin_api_t *api, uint64_t opcode, void *user_data)
+{
+    ((plugin_state_t *)user_data)->handled++;
+    uint64_t address = api->translate_address(api->get_register(RENODE_RISCV_REGISTER_X0 + RS1(opcode)), RENODE_RISCV_ACCESS_WRITE);
+    if(address == UINT64_MAX) {
+        api->log(3, "test_memory: unmapped address");
+        return;
+    }
+    api->set_register(RENODE_RISCV_REGISTER_X0 + RD(opcode), api->read_memory(address, 4));
+    api->write_memory(address + 4, 2, api->get_register(RENODE_RISCV_REGISTER_X0 + RS2(opcode)));
+    /* Unsupported, logged by the host */
+    api->read_memory(address, 3);
+}
+
+/* Increments the double word at the physical address in rs1 in place, rd = 1 if it's RAM */
+void test_host_pointer(const renode_riscv_plugin_api_t *api, uint64_t opcode, void *user_data)
+{
+    ((plugin_state_t *)user_data)->handled++;
+    uint32_t *pointer = api->get_host_pointer(api->get_register(RENODE_RISCV_REGISTER_X0 + RS1(opcode)), sizeof(uint32_t));
+    if(pointer != NULL) {
+        (*pointer)++;
+    }
+    api->set_register(RENODE_RISCV_REGISTER_X0 + RD(opcode), pointer != NULL);
+}
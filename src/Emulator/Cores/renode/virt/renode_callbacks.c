@@ -20,6 +20,9 @@ EXTERNAL_AS(void, WriteWordToPort, kvm_io_port_write_word, uint16_t, uint32_t)
 EXTERNAL_AS(void, WriteDoubleWordToPort,
             kvm_io_port_write_double_word, uint16_t, uint32_t)
 
+EXTERNAL_AS(void, ReadBlockFromPort, kvm_io_port_read_block, uint16_t, uint32_t, uint32_t, voidptr)
+EXTERNAL_AS(void, WriteBlockToPort, kvm_io_port_write_block, uint16_t, uint32_t, uint32_t, voidptr)
+
 EXTERNAL_AS(uint64_t, ReadByteFromBus, kvm_sysbus_read_byte, uint64_t)
 EXTERNAL_AS(uint64_t, ReadWordFromBus, kvm_sysbus_read_word, uint64_t)
 EXTERNAL_AS(uint64_t, ReadDoubleWordFromBus, kvm_sysbus_read_double_word, uint64_t)
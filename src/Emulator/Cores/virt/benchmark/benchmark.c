@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "callbacks.h"
+#include "fake_kvm.h"
+#include "stats.h"
+#include "utils.h"
+
+/* Exported by the library, not declared in its headers as they are only bound from C# */
+void kvm_init();
+uint64_t kvm_execute(uint64_t time_in_us);
+void kvm_dispose();
+
+#define DEFAULT_EXITS_COUNT 10000000
+#define EXITS_PER_RUN       10000
+/* Long enough for the quantum to always end with the scripted EINTR, not the timer */
+#define QUANTUM_US          10000000
+#define READ_VALUE_PATTERN  0x5A5A5A5A5A5A5A5AULL
+
+/* Stub callbacks, standing in for the ones bound from C#, only count the calls */
+
+static uint64_t callbacks_count;
+static volatile uint64_t written_values;
+
+static uint64_t stub_read(uint64_t address)
+{
+    callbacks_count++;
+    return address ^ READ_VALUE_PATTERN;
+}
+
+static void stub_write(uint64_t address, uint64_t value)
+{
+    callbacks_count++;
+    written_values += value;
+}
+
+void kvm_log(int level, char *message)
+{
+    if(level >= LOG_LEVEL_WARNING) {
+        fprintf(stderr, "[%d] %s\n", level, message);
+    }
+}
+
+void kvm_abort(char *message)
+{
+    fprintf(stderr, "Abort: %s\n", message);
+    exit(EXIT_FAILURE);
+}
+
+void kvm_runtime_abort(char *message, uint64_t pc)
+{
+    fprintf(stderr, "Runtime abort at 0x%" PRIx64 ": %s\n", pc, message);
+    exit(EXIT_FAILURE);
+}
+
+uint32_t kvm_io_port_read_byte(uint16_t address)
+{
+    return (uint8_t)stub_read(address);
+}
+
+uint32_t kvm_io_port_read_word(uint16_t address)
+{
+    return (uint16_t)stub_read(address);
+}
+
+uint32_t kvm_io_port_read_double_word(uint16_t address)
+{
+    return (uint32_t)stub_read(address);
+}
+
+void kvm_io_port_write_byte(uint16_t address, uint32_t value)
+{
+    stub_write(address, value);
+}
+
+void kvm_io_port_write_word(uint16_t address, uint32_t value)
+{
+    stub_write(address, value);
+}
+
+void kvm_io_port_write_double_word(uint16_t address, uint32_t value)
+{
+    stub_write(address, value);
+}
+
+uint64_t kvm_sysbus_read_byte(uint64_t address)
+{
+    return (uint8_t)stub_read(address);
+}
+
+uint64_t kvm_sysbus_read_word(uint64_t address)
+{
+    return (uint16_t)stub_read(address);
+}
+
+uint64_t kvm_sysbus_read_double_word(uint64_t address)
+{
+    return (uint32_t)stub_read(address);
+}
+
+uint64_t kvm_sysbus_read_quad_word(uint64_t address)
+{
+    return stub_read(address);
+}
+
+void kvm_sysbus_write_byte(uint64_t address, uint64_t value)
+{
+    stub_write(address, value);
+}
+
+void kvm_sysbus_write_word(uint64_t address, uint64_t value)
+{
+    stub_write(address, value);
+}
+
+void kvm_sysbus_write_double_word(uint64_t address, uint64_t value)
+{
+    stub_write(address, value);
+}
+
+void kvm_sysbus_write_quad_word(uint64_t address, uint64_t value)
+{
+    stub_write(address, value);
+}
+
+typedef struct Scenario {
+    const char *name;
+    FakeExit exits[4];
+    uint32_t count;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    { "MMIO read (4 B)", { { FAKE_EXIT_MMIO_READ, 0xF0000000, 4, 0, 1 } }, 1 },
+    { "MMIO write (4 B)", { { FAKE_EXIT_MMIO_WRITE, 0xF0000004, 4, 0x12345678, 1 } }, 1 },
+    { "PIO in (1 B)", { { FAKE_EXIT_IO_IN, 0x3F8, 1, 0, 1 } }, 1 },
+    { "PIO out (1 B)", { { FAKE_EXIT_IO_OUT, 0x3F8, 1, 0x41, 1 } }, 1 },
+    { "Mixed",
+      {
+          { FAKE_EXIT_MMIO_READ, 0xF0000000, 4, 0, 1 },
+          { FAKE_EXIT_MMIO_WRITE, 0xF0000004, 2, 0x1234, 1 },
+          { FAKE_EXIT_IO_IN, 0x60, 1, 0, 1 },
+          { FAKE_EXIT_IO_OUT, 0x3F8, 4, 0x41424344, 1 },
+      },
+      4 },
+};
+
+static uint64_t timestamp_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void run_scenario(const Scenario *scenario, uint64_t exits_count)
+{
+    fake_kvm_set_script(scenario->exits, scenario->count, EXITS_PER_RUN);
+    callbacks_count = 0;
+
+    const uint64_t start = timestamp_ns();
+    while(fake_kvm_get_exits_count() < exits_count) {
+        kvm_execute(QUANTUM_US);
+    }
+    const uint64_t elapsed = timestamp_ns() - start;
+
+    const uint64_t exits = fake_kvm_get_exits_count();
+    if(callbacks_count != exits) {
+        fprintf(stderr, "%s: %" PRIu64 " exits, but %" PRIu64 " callbacks\n", scenario->name, exits, callbacks_count);
+        exit(EXIT_FAILURE);
+    }
+    printf("%-20s %12" PRIu64 " exits %14.0f exits/s %10.1f ns/exit\n", scenario->name, exits, exits * 1e9 / elapsed,
+           (double)elapsed / exits);
+}
+
+/* Usage: kvm-x86_64-benchmark [exits per scenario] [--stats] */
+int main(int argc, char **argv)
+{
+    uint64_t exits_count = DEFAULT_EXITS_COUNT;
+    bool statistics = false;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "--stats") == 0) {
+            statistics = true;
+        } else {
+            exits_count = strtoull(argv[i], NULL, 0);
+        }
+    }
+
+    kvm_init();
+    kvm_set_statistics_enabled(statistics);
+    printf("Exit statistics: %s\n", statistics ? "enabled" : "disabled");
+
+    for(size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        run_scenario(&scenarios[i], exits_count);
+    }
+
+    /* The value returned by the stub has to reach the exit buffer read back by the fake KVM */
+    const FakeExit read_exit = { FAKE_EXIT_MMIO_READ, 0xF0000008, 4, 0, 1 };
+    fake_kvm_set_script(&read_exit, 1, 1);
+    kvm_execute(QUANTUM_US);
+    if(fake_kvm_get_last_read_value() != (uint32_t)(read_exit.address ^ READ_VALUE_PATTERN)) {
+        fprintf(stderr, "MMIO read returned 0x%" PRIx64 " to the guest\n", fake_kvm_get_last_read_value());
+        return EXIT_FAILURE;
+    }
+
+    kvm_dispose();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/kvm.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <x86intrin.h>
+
+#include "fake_kvm.h"
+
+#define FAKE_API_VERSION  12
+#define FAKE_TSC_KHZ      1000000
+/* The exit data of IO exits is placed on the second page, as done by KVM */
+#define FAKE_RUN_SIZE     (2 * 4096)
+#define FAKE_IO_DATA_PAGE 4096
+#define FAKE_IO_DATA_SIZE 4096
+#define FAKE_MSRS_COUNT   64
+#define FAKE_IOCTLS_COUNT 64
+
+#define MSR_IA32_TSC               0x10
+#define MSR_IA32_TSC_DEADLINE      0x6e0
+#define APIC_LVTT                  0x320
+#define APIC_LVT_TIMER_MASK        (3 << 17)
+#define APIC_LVT_TIMER_TSCDEADLINE (2 << 17)
+
+int __real_open(const char *path, int flags, ...);
+int __real_ioctl(int fd, unsigned long request, ...);
+void *__real_mmap(void *address, size_t length, int protection, int flags, int fd, off_t offset);
+
+static struct {
+    int kvm_fd;
+    int vm_fd;
+    int vcpu_fd;
+    struct kvm_run *run;
+
+    struct kvm_regs regs;
+    struct kvm_sregs sregs;
+    struct kvm_lapic_state lapic;
+    /* MSRs written so far, the ones never written read as 0 */
+    struct kvm_msr_entry msrs[FAKE_MSRS_COUNT];
+    uint32_t msr_count;
+    uint32_t tsc_khz;
+    uint64_t tsc_offset;
+
+    /* calls of the vCPU ioctls other than KVM_RUN */
+    struct {
+        unsigned long request;
+        uint64_t count;
+    } ioctls[FAKE_IOCTLS_COUNT];
+    uint32_t ioctls_count;
+
+    const FakeExit *script;
+    uint32_t script_length;
+    uint32_t script_position;
+    uint64_t exits_per_run;
+    uint64_t exits_in_run;
+    uint64_t exits_count;
+    /* without a script KVM_RUN waits for a signal, as if the guest was running or halted */
+    bool guest_idle;
+    bool guest_halted;
+
+    /* the exit buffer is read back on the next KVM_RUN, as KVM completes the instruction then */
+    const FakeExit *pending_read;
+    uint64_t last_read_value;
+    uint8_t last_read_data[FAKE_IO_DATA_SIZE];
+} fake = {
+    .kvm_fd = -1,
+    .vm_fd = -1,
+    .vcpu_fd = -1,
+};
+
+void fake_kvm_set_script(const FakeExit *exits, uint32_t count, uint64_t exits_per_run)
+{
+    fake.script = exits;
+    fake.script_length = count;
+    fake.script_position = 0;
+    fake.exits_per_run = exits_per_run;
+    fake.exits_in_run = 0;
+    fake.exits_count = 0;
+    fake.pending_read = NULL;
+    fake.guest_idle = false;
+    fake.guest_halted = false;
+}
+
+void fake_kvm_set_idle_guest(bool halted)
+{
+    fake_kvm_set_script(NULL, 0, 0);
+    fake.guest_idle = true;
+    fake.guest_halted = halted;
+}
+
+uint64_t fake_kvm_get_exits_count()
+{
+    return fake.exits_count;
+}
+
+uint64_t fake_kvm_get_last_read_value()
+{
+    return fake.last_read_value;
+}
+
+const uint8_t *fake_kvm_get_last_read_data()
+{
+    return fake.last_read_data;
+}
+
+uint64_t fake_kvm_get_ioctl_count(unsigned long request)
+{
+    for(uint32_t i = 0; i < fake.ioctls_count; i++) {
+        if(fake.ioctls[i].request == request) {
+            return fake.ioctls[i].count;
+        }
+    }
+    return 0;
+}
+
+uint64_t fake_kvm_get_guest_tsc()
+{
+    /* KVM scales the host TSC to the guest frequency and adds the offset */
+    return (uint64_t)((unsigned __int128)__rdtsc() * fake.tsc_khz / FAKE_TSC_KHZ) + fake.tsc_offset;
+}
+
+static void count_ioctl(unsigned long request)
+{
+    for(uint32_t i = 0; i < fake.ioctls_count; i++) {
+        if(fake.ioctls[i].request == request) {
+            fake.ioctls[i].count++;
+            return;
+        }
+    }
+    if(fake.ioctls_count < FAKE_IOCTLS_COUNT) {
+        fake.ioctls[fake.ioctls_count].request = request;
+        fake.ioctls[fake.ioctls_count++].count = 1;
+    }
+}
+
+static uint32_t io_count(const FakeExit *exit)
+{
+    return exit->count > 1 ? exit->count : 1;
+}
+
+static int fail(int error)
+{
+    errno = error;
+    return -1;
+}
+
+static void complete_pending_read(struct kvm_run *run)
+{
+    const FakeExit *exit = fake.pending_read;
+    if(exit == NULL) {
+        return;
+    }
+
+    uint64_t value = 0;
+    if(exit->type == FAKE_EXIT_MMIO_READ) {
+        memcpy(&value, run->mmio.data, exit->size);
+    } else {
+        memcpy(&value, (uint8_t *)run + run->io.data_offset, exit->size);
+        memcpy(fake.last_read_data, (uint8_t *)run + run->io.data_offset, exit->size * io_count(exit));
+    }
+    fake.last_read_value = value;
+    fake.pending_read = NULL;
+}
+
+static void prepare_exit(struct kvm_run *run, const FakeExit *exit)
+{
+    switch(exit->type) {
+        case FAKE_EXIT_MMIO_READ:
+        case FAKE_EXIT_MMIO_WRITE:
+            run->exit_reason = KVM_EXIT_MMIO;
+            run->mmio.phys_addr = exit->address;
+            run->mmio.len = exit->size;
+            run->mmio.is_write = exit->type == FAKE_EXIT_MMIO_WRITE;
+            memcpy(run->mmio.data, &exit->value, sizeof(run->mmio.data));
+            break;
+        case FAKE_EXIT_IO_IN:
+        case FAKE_EXIT_IO_OUT:
+            run->exit_reason = KVM_EXIT_IO;
+            run->io.port = (uint16_t)exit->address;
+            run->io.size = exit->size;
+            run->io.count = io_count(exit);
+            run->io.direction = exit->type == FAKE_EXIT_IO_OUT ? KVM_EXIT_IO_OUT : KVM_EXIT_IO_IN;
+            run->io.data_offset = FAKE_IO_DATA_PAGE;
+            if(run->io.count == 1) {
+                memcpy((uint8_t *)run + FAKE_IO_DATA_PAGE, &exit->value, sizeof(exit->value));
+                break;
+            }
+            for(uint32_t i = 0; i < exit->size * run->io.count; i++) {
+                ((uint8_t *)run)[FAKE_IO_DATA_PAGE + i] = (uint8_t)(exit->value + i);
+            }
+            break;
+    }
+    if(exit->type == FAKE_EXIT_MMIO_READ || exit->type == FAKE_EXIT_IO_IN) {
+        fake.pending_read = exit;
+    }
+}
+
+/* Blocks until a signal is handled, unless KVM_RUN was asked to exit immediately */
+static void wait_for_signal(struct kvm_run *run)
+{
+    /* The signal is blocked until sigsuspend, so that it can't be handled between the check and the wait */
+    sigset_t blocked, previous;
+    sigemptyset(&blocked);
+    sigaddset(&blocked, SIGALRM);
+    sigprocmask(SIG_BLOCK, &blocked, &previous);
+    if(!run->immediate_exit) {
+        sigsuspend(&previous);
+    }
+    sigprocmask(SIG_SETMASK, &previous, NULL);
+}
+
+static int kvm_run_ioctl()
+{
+    struct kvm_run *run = fake.run;
+    complete_pending_read(run);
+
+    if(fake.guest_idle) {
+        wait_for_signal(run);
+        return fail(EINTR);
+    }
+
+    if(run->immediate_exit || fake.script_length == 0 || fake.exits_in_run == fake.exits_per_run) {
+        fake.exits_in_run = 0;
+        return fail(EINTR);
+    }
+
+    prepare_exit(run, &fake.script[fake.script_position]);
+    fake.script_position = (fake.script_position + 1) % fake.script_length;
+    fake.exits_in_run++;
+    fake.exits_count++;
+    return 0;
+}
+
+static bool lapic_in_tsc_deadline_mode()
+{
+    uint32_t lvtt;
+    memcpy(&lvtt, &fake.lapic.regs[APIC_LVTT], sizeof(lvtt));
+    return (lvtt & APIC_LVT_TIMER_MASK) == APIC_LVT_TIMER_TSCDEADLINE;
+}
+
+static struct kvm_msr_entry *find_msr(uint32_t index)
+{
+    for(uint32_t i = 0; i < fake.msr_count; i++) {
+        if(fake.msrs[i].index == index) {
+            return &fake.msrs[i];
+        }
+    }
+    return NULL;
+}
+
+static int get_msrs(struct kvm_msrs *msrs)
+{
+    for(uint32_t i = 0; i < msrs->nmsrs; i++) {
+        if(msrs->entries[i].index == MSR_IA32_TSC) {
+            msrs->entries[i].data = fake_kvm_get_guest_tsc();
+            continue;
+        }
+        const struct kvm_msr_entry *msr = find_msr(msrs->entries[i].index);
+        msrs->entries[i].data = msr == NULL ? 0 : msr->data;
+    }
+    return msrs->nmsrs;
+}
+
+static int set_msrs(const struct kvm_msrs *msrs)
+{
+    for(uint32_t i = 0; i < msrs->nmsrs; i++) {
+        const struct kvm_msr_entry *entry = &msrs->entries[i];
+        /* As in KVM, the TSC deadline write succeeds, but is ignored unless the LAPIC timer is in the TSC-deadline mode */
+        if(entry->index == MSR_IA32_TSC_DEADLINE && !lapic_in_tsc_deadline_mode()) {
+            continue;
+        }
+        struct kvm_msr_entry *msr = find_msr(entry->index);
+        if(msr == NULL) {
+            if(fake.msr_count == FAKE_MSRS_COUNT) {
+                return i;
+            }
+            msr = &fake.msrs[fake.msr_count++];
+        }
+        *msr = *entry;
+    }
+    return msrs->nmsrs;
+}
+
+static void set_lapic(const struct kvm_lapic_state *lapic)
+{
+    fake.lapic = *lapic;
+    /* Setting the LAPIC state cancels the timer, including a pending TSC deadline */
+    struct kvm_msr_entry *deadline = find_msr(MSR_IA32_TSC_DEADLINE);
+    if(deadline != NULL) {
+        deadline->data = 0;
+    }
+}
+
+static int system_ioctl(unsigned long request, void *argument)
+{
+    switch(request) {
+        case KVM_GET_API_VERSION:
+            return FAKE_API_VERSION;
+        case KVM_CREATE_VM:
+            fake.vm_fd = dup(fake.kvm_fd);
+            return fake.vm_fd;
+        case KVM_GET_VCPU_MMAP_SIZE:
+            return FAKE_RUN_SIZE;
+        case KVM_GET_SUPPORTED_CPUID:
+            ((struct kvm_cpuid2 *)argument)->nent = 0;
+            return 0;
+        case KVM_GET_TSC_KHZ:
+            return FAKE_TSC_KHZ;
+        case KVM_CHECK_EXTENSION:
+            /* TSC scaling is the only optional capability */
+            return (int)(intptr_t)argument == KVM_CAP_TSC_CONTROL;
+        default:
+            return fail(EINVAL);
+    }
+}
+
+static int vm_ioctl(unsigned long request, void *argument)
+{
+    switch(request) {
+        case KVM_CREATE_VCPU:
+            memset(&fake.lapic, 0, sizeof(fake.lapic));
+            fake.msr_count = 0;
+            fake.tsc_khz = FAKE_TSC_KHZ;
+            fake.tsc_offset = 0;
+            fake.vcpu_fd = dup(fake.kvm_fd);
+            return fake.vcpu_fd;
+        default:
+            /* irqchip, PIT, memory slots and IRQ lines are accepted and ignored */
+            return 0;
+    }
+}
+
+static int vcpu_ioctl(unsigned long request, void *argument)
+{
+    if(request == KVM_RUN) {
+        return kvm_run_ioctl();
+    }
+
+    count_ioctl(request);
+    switch(request) {
+        case KVM_GET_REGS:
+            memcpy(argument, &fake.regs, sizeof(fake.regs));
+            return 0;
+        case KVM_SET_REGS:
+            memcpy(&fake.regs, argument, sizeof(fake.regs));
+            return 0;
+        case KVM_GET_SREGS:
+            memcpy(argument, &fake.sregs, sizeof(fake.sregs));
+            return 0;
+        case KVM_SET_SREGS:
+            memcpy(&fake.sregs, argument, sizeof(fake.sregs));
+            return 0;
+        case KVM_GET_LAPIC:
+            memcpy(argument, &fake.lapic, sizeof(fake.lapic));
+            return 0;
+        case KVM_SET_LAPIC:
+            set_lapic(argument);
+            return 0;
+        case KVM_GET_MSRS:
+            return get_msrs(argument);
+        case KVM_SET_MSRS:
+            return set_msrs(argument);
+        case KVM_GET_TSC_KHZ:
+            return fake.tsc_khz;
+        case KVM_SET_TSC_KHZ:
+            fake.tsc_khz = (uint32_t)(uintptr_t)argument;
+            return 0;
+        case KVM_HAS_DEVICE_ATTR:
+            /* TSC offset control is supported */
+            return 0;
+        case KVM_GET_DEVICE_ATTR:
+            *(uint64_t *)((struct kvm_device_attr *)argument)->addr = fake.tsc_offset;
+            return 0;
+        case KVM_SET_DEVICE_ATTR:
+            fake.tsc_offset = *(uint64_t *)((struct kvm_device_attr *)argument)->addr;
+            return 0;
+        case KVM_GET_MP_STATE:
+            ((struct kvm_mp_state *)argument)->mp_state = fake.guest_halted ? KVM_MP_STATE_HALTED : KVM_MP_STATE_RUNNABLE;
+            return 0;
+        case KVM_TRANSLATE:
+            ((struct kvm_translation *)argument)->valid = 0;
+            return 0;
+        default:
+            /* vCPU events, guest debug and CPUID are accepted and ignored */
+            return 0;
+    }
+}
+
+int __wrap_open(const char *path, int flags, ...)
+{
+    mode_t mode = 0;
+    if(flags & O_CREAT) {
+        va_list ap;
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+
+    if(strcmp(path, "/dev/kvm") != 0) {
+        return __real_open(path, flags, mode);
+    }
+    /* Any valid descriptor will do, it is only used to tell the KVM objects apart and to be closed */
+    fake.kvm_fd = __real_open("/dev/null", O_RDWR);
+    return fake.kvm_fd;
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+    va_list ap;
+    va_start(ap, request);
+    void *argument = va_arg(ap, void *);
+    va_end(ap);
+
+    if(fd == fake.vcpu_fd) {
+        return vcpu_ioctl(request, argument);
+    }
+    if(fd == fake.vm_fd) {
+        return vm_ioctl(request, argument);
+    }
+    if(fd == fake.kvm_fd) {
+        return system_ioctl(request, argument);
+    }
+    return __real_ioctl(fd, request, argument);
+}
+
+void *__wrap_mmap(void *address, size_t length, int protection, int flags, int fd, off_t offset)
+{
+    if(fd != fake.vcpu_fd || fd < 0) {
+        return __real_mmap(address, length, protection, flags, fd, offset);
+    }
+    /* Anonymous memory can be released with the regular munmap in kvm_dispose */
+    fake.run = __real_mmap(NULL, length, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return fake.run;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Fake KVM replaces `open`, `ioctl` and `mmap` of the library sources (see `-Wl,--wrap` in CMakeLists.txt).
+ * Opening /dev/kvm returns a descriptor of /dev/null, ioctls on it and on the VM and vCPU descriptors
+ * are emulated, and KVM_RUN replays a script of synthetic exits instead of running a guest. */
+
+typedef enum {
+    FAKE_EXIT_MMIO_READ,
+    FAKE_EXIT_MMIO_WRITE,
+    FAKE_EXIT_IO_IN,
+    FAKE_EXIT_IO_OUT,
+} FakeExitType;
+
+typedef struct FakeExit {
+    FakeExitType type;
+    uint64_t address;
+    /* access width in bytes */
+    uint32_t size;
+    uint64_t value;
+    /* number of elements of string IO (rep ins/outs), 0 means a single access.
+     * The data of string outs is a sequence of bytes counting up from the lowest byte of `value` */
+    uint32_t count;
+} FakeExit;
+
+/* Exits are replayed cyclically, KVM_RUN fails with EINTR (i.e. the quantum ends) after every `exits_per_run` exits */
+void fake_kvm_set_script(const FakeExit *exits, uint32_t count, uint64_t exits_per_run);
+
+/* Replaces the script with a guest that never exits, KVM_RUN fails with EINTR only after a signal is handled.
+ * KVM_GET_MP_STATE reports the guest as halted or runnable */
+void fake_kvm_set_idle_guest(bool halted);
+
+/* Number of KVM_RUN calls that ended with an exit, since the last `fake_kvm_set_script` */
+uint64_t fake_kvm_get_exits_count();
+
+/* Value stored in the exit buffer by the handler of the last MMIO read or IO in exit */
+uint64_t fake_kvm_get_last_read_value();
+
+/* Data stored in the exit buffer by the handler of the last IO in exit, `count` elements of `size` bytes */
+const uint8_t *fake_kvm_get_last_read_data();
+
+/* Number of calls of a vCPU ioctl other than KVM_RUN, since the start */
+uint64_t fake_kvm_get_ioctl_count(unsigned long request);
+
+/* Current guest TSC, following the host TSC scaled with KVM_SET_TSC_KHZ and shifted by the TSC offset */
+uint64_t fake_kvm_get_guest_tsc();
@@ -12,6 +12,11 @@
                                                     \
     NAME(PARAM1, PARAM2) { }
 
+#define DEFAULT_VOID_HANDLER4(NAME, PARAM1, PARAM2, PARAM3, PARAM4) \
+    NAME(PARAM1, PARAM2, PARAM3, PARAM4) __attribute__((weak));     \
+                                                                    \
+    NAME(PARAM1, PARAM2, PARAM3, PARAM4) { }
+
 #define DEFAULT_INT_HANDLER1(NAME, PARAM1) \
     NAME(PARAM1) __attribute__((weak));    \
                                            \
@@ -32,6 +37,10 @@ void kvm_io_port_write_byte(uint16_t address, uint32_t value);
 void kvm_io_port_write_word(uint16_t address, uint32_t value);
 void kvm_io_port_write_double_word(uint16_t address, uint32_t value);
 
+/* String I/O: `count` elements of `width` bytes each are transferred through `buffer` in one call */
+void kvm_io_port_read_block(uint16_t address, uint32_t width, uint32_t count, void *buffer);
+void kvm_io_port_write_block(uint16_t address, uint32_t width, uint32_t count, void *buffer);
+
 uint64_t kvm_sysbus_read_byte(uint64_t address);
 uint64_t kvm_sysbus_read_word(uint64_t address);
 uint64_t kvm_sysbus_read_double_word(uint64_t address);
@@ -11,6 +11,8 @@
 
 #include "debug.h"
 #include "memory_range.h"
+#include "stats.h"
+#include "translation.h"
 
 #ifndef SYS_gettid
 #error "SYS_gettid unavailable on this system"
@@ -64,13 +66,29 @@ typedef struct CpuState {
 
     bool cpu_supports_tsc_offset;
 
+    /* KVM_GET_DIRTY_LOG does not clear the log, KVM_CLEAR_DIRTY_LOG has to be used */
+    bool manual_dirty_log_protect;
+
     /* TSC is 64bit so any overfow will work as expected */
     uint64_t missed_tsc_ticks;
     uint64_t exit_host_tsc;
 
+    /* Guest TSC follows the virtual time, see kvm_set_virtual_tsc */
+    bool virtual_tsc;
+    uint64_t virtual_tsc_khz;
+    uint64_t virtual_tsc_offset;
+    uint64_t host_tsc_khz;
+
     /* Flag set when KVM is set to single stepping mode */
     bool single_step;
 
+    /* Halted guest ends the quantum, see kvm_set_halt_detection */
+    bool halt_detection;
+    uint64_t execution_deadline_ns;
+    uint64_t halt_check_period_us;
+    /* set by kvm_interrupt_execution, distinguishes the interruption from a halt check */
+    volatile bool execution_interrupted;
+
     /* cached special register state */
     struct kvm_regs regs;
     RegisterState regs_state;
@@ -79,13 +97,29 @@ typedef struct CpuState {
     struct kvm_sregs sregs;
     RegisterState sregs_state;
 
-    LIST_HEAD(, MemoryRegion) memory_regions;
+    /* mapped memory slots, sorted by guest physical address */
+    MemoryRegion *memory_regions;
+    uint32_t memory_regions_count;
+    uint32_t memory_regions_capacity;
+    /* number of read-only memory regions with ignore_writes set */
+    uint32_t write_ignoring_regions;
 
     LIST_HEAD(, Breakpoint) breakpoints;
 
+    TranslationCache translation_cache;
+
+    /* breakpoints and watchpoints set using debug registers */
+    HardwareBreakpoint hw_breakpoints[HW_BREAKPOINTS_COUNT];
+    /* address of the last watchpoint hit, valid after STOPPED_AT_WATCHPOINT */
+    uint64_t hit_watchpoint_address;
+
+    ExitStatistics stats;
+
 #ifdef TARGET_X86KVM
     Detected64BitBehaviour on64BitDetected;
 #endif
 } CpuState;
 
 extern struct CpuState *cpu;
+
+void set_guest_tsc_offset(uint64_t tsc_offset);
@@ -13,8 +13,34 @@ typedef struct Breakpoint {
     LIST_ENTRY(Breakpoint) list;
 } Breakpoint;
 
+/* Number of address debug registers (DR0-DR3) */
+#define HW_BREAKPOINTS_COUNT 4
+
+typedef enum {
+    HW_BREAKPOINT_UNUSED = 0,
+    HW_BREAKPOINT_EXECUTE = 1,
+    HW_WATCHPOINT_WRITE = 2,
+    HW_WATCHPOINT_ACCESS = 3,
+} HardwareBreakpointType;
+
+typedef struct HardwareBreakpoint {
+    uint64_t address;
+    uint32_t length;
+    uint32_t type; /* HardwareBreakpointType */
+} HardwareBreakpoint;
+
 bool is_breakpoint_address(uint64_t address);
 
-/* Translates guest's virtual address into guest physical address.
- * On failiure returns UINT64_MAX. */
-uint64_t kvm_translate_guest_virtual_address(uint64_t address);
+/* Returns true if one of the hardware watchpoints was hit, `dr6` is the debug status reported by KVM.
+ * Address of the watchpoint is stored in `cpu->hit_watchpoint_address` */
+bool is_watchpoint_hit(uint64_t dr6);
+
+/* Sets KVM guest debug flags together with the hardware breakpoints currently in use */
+void set_debug_flags(uint32_t flags);
+
+/* Software breakpoint interception is enabled only while there are breakpoints in guest memory,
+ * as it makes every guest exception exit to userspace */
+void set_default_debug_flags();
+
+/* Recreates a breakpoint saved in a snapshot, `code_byte` is the original value overshadowed by TRAP_OPCODE */
+void restore_breakpoint(uint64_t address, uint8_t code_byte);
@@ -1,16 +1,44 @@
 #pragma once
 
 #include <linux/kvm.h>
+#include <stdbool.h>
 #include <stdint.h>
-#include <sys/queue.h>
+
+#define KVM_PAGE_SIZE 4096
 
 typedef struct MemoryRegion {
     struct kvm_userspace_memory_region kvm_memory_region;
-    LIST_ENTRY(MemoryRegion) list;
+    /* guest writes to a read-only region are dropped instead of being passed to the sysbus */
+    bool ignore_writes;
+    /* pages written by kvm_write_guest_memory, which KVM doesn't log, allocated only while dirty pages logging is enabled */
+    uint64_t *written_pages;
 } MemoryRegion;
 
 void kvm_map_range(int32_t slot, uint64_t address, uint64_t size, uint64_t pointer);
 
 void kvm_unmap_range(int32_t slot);
 
+void kvm_set_dirty_logging(int32_t slot, uint32_t enabled);
+
+void kvm_set_read_only(int32_t slot, uint32_t read_only, uint32_t trap_writes);
+
+/* Returns true if the address belongs to a read-only region which ignores writes */
+bool is_write_ignored(uint64_t address);
+
+void kvm_get_dirty_log(int32_t slot, uint64_t bitmap);
+
+void kvm_clear_dirty_log(int32_t slot, uint64_t bitmap);
+
+/* Frees the bookkeeping of all regions, KVM slots are released with the VM */
+void free_memory_regions();
+
 void *kvm_translate_guest_physical_to_host(uint64_t address, uint64_t *size);
+
+/* Copies `size` bytes of guest physical memory starting at `address` to the buffer at `pointer`.
+ * Copying stops at the first address not mapped to KVM, returns the number of bytes copied. */
+uint64_t kvm_read_guest_memory(uint64_t address, uint64_t pointer, uint64_t size);
+
+/* Copies `size` bytes from the buffer at `pointer` to guest physical memory starting at `address`.
+ * Copying stops at the first address not mapped to KVM, returns the number of bytes copied.
+ * Written pages are reported by kvm_get_dirty_log, writes are not blocked by read-only slots. */
+uint64_t kvm_write_guest_memory(uint64_t address, uint64_t pointer, uint64_t size);
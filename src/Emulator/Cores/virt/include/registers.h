@@ -14,5 +14,8 @@ typedef uint32_t reg_t;
 void kvm_registers_synchronize();
 void kvm_registers_invalidate();
 
+/* Returns cached special registers, fetching them from KVM if needed */
+const struct kvm_sregs *get_special_registers();
+
 reg_t get_register_value(Registers reg_number);
 void set_register_value(Registers reg_number, reg_t value);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <linux/kvm.h>
+#include <stdint.h>
+
+#include "debug.h"
+
+#define SNAPSHOT_MAGIC    0x4b564d53 /* "KVMS" */
+#define SNAPSHOT_VERSION  2
+#define SNAPSHOT_MAX_MSRS 64
+
+typedef struct SnapshotBreakpoint {
+    uint64_t pc;
+    uint8_t code_byte;
+} SnapshotBreakpoint;
+
+/* Complete state of the VM that is not kept in the guest memory.
+ * Guest memory is serialized by Renode together with the memory peripherals. */
+typedef struct Snapshot {
+    uint32_t magic;
+    uint32_t version;
+
+    struct kvm_regs regs;
+    struct kvm_sregs sregs;
+
+    /* XSAVE area is used when available, it is a superset of the legacy FPU state */
+    uint32_t has_xsave;
+    struct kvm_xsave xsave;
+    struct kvm_fpu fpu;
+    uint32_t has_xcrs;
+    struct kvm_xcrs xcrs;
+
+    struct kvm_debugregs debugregs;
+    struct kvm_vcpu_events events;
+    struct kvm_mp_state mp_state;
+    struct kvm_lapic_state lapic;
+
+    struct kvm_irqchip pic_master;
+    struct kvm_irqchip pic_slave;
+    struct kvm_irqchip ioapic;
+    struct kvm_pit_state2 pit;
+
+    uint32_t msr_count;
+    struct kvm_msr_entry msrs[SNAPSHOT_MAX_MSRS];
+
+    /* Guest TSC value at the moment of saving, restored regardless of the host TSC */
+    uint64_t guest_tsc;
+
+    uint32_t on64BitDetected;
+
+    HardwareBreakpoint hw_breakpoints[HW_BREAKPOINTS_COUNT];
+
+    uint32_t breakpoint_count;
+    SnapshotBreakpoint breakpoints[];
+} Snapshot;
+
+uint64_t kvm_get_state_size();
+
+void kvm_save_state(uint64_t pointer);
+
+void kvm_restore_state(uint64_t pointer, uint64_t size);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Exit reasons above this value are counted together in the last entry */
+#define STATS_EXIT_REASONS_COUNT 64
+/* Size of the per-address counters table, has to be a power of 2 */
+#define STATS_ADDRESSES_COUNT 256
+
+typedef enum {
+    STATS_ACCESS_IO_PORT = 0,
+    STATS_ACCESS_MMIO = 1,
+    STATS_ACCESS_TYPES_COUNT,
+} StatsAccessType;
+
+typedef enum {
+    /* time spent inside KVM_RUN, i.e. executing the guest and handling exits in kernel */
+    STATS_TIME_KVM_RUN = 0,
+    /* time spent handling exits in userspace, without the Renode callbacks */
+    STATS_TIME_USERSPACE = 1,
+    /* time spent in Renode callbacks handling IO and MMIO exits */
+    STATS_TIME_CALLBACKS = 2,
+    STATS_TIME_TYPES_COUNT,
+} StatsTimeType;
+
+typedef struct AccessCounter {
+    uint64_t address;
+    uint64_t count;
+} AccessCounter;
+
+typedef struct ExitStatistics {
+    bool enabled;
+
+    uint64_t exits[STATS_EXIT_REASONS_COUNT];
+    /* KVM_RUN calls that ended with EINTR, i.e. quantum ends and execution interruptions */
+    uint64_t interrupted_runs;
+
+    uint64_t time_ns[STATS_TIME_TYPES_COUNT];
+    uint64_t run_exit_ns;
+    uint64_t callback_start_ns;
+
+    AccessCounter accesses[STATS_ACCESS_TYPES_COUNT][STATS_ADDRESSES_COUNT];
+    /* accesses to addresses that did not fit in the table */
+    uint64_t untracked_accesses[STATS_ACCESS_TYPES_COUNT];
+} ExitStatistics;
+
+static inline uint64_t stats_timestamp_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void stats_loop_entry(ExitStatistics *stats);
+
+void stats_run_entry(ExitStatistics *stats);
+
+void stats_run_exit(ExitStatistics *stats, bool interrupted, uint32_t exit_reason);
+
+void stats_callback_entry(ExitStatistics *stats, StatsAccessType type, uint64_t address);
+
+void stats_callback_exit(ExitStatistics *stats);
+
+void kvm_set_statistics_enabled(uint32_t enabled);
+
+void kvm_reset_statistics();
+
+uint64_t kvm_get_exit_count(uint32_t exit_reason);
+
+uint64_t kvm_get_interrupted_runs_count();
+
+uint64_t kvm_get_time_statistic(uint32_t type);
+
+/* Copies at most `max_count` AccessCounter entries with non-zero count to the buffer at `pointer`.
+ * Returns the number of entries copied. */
+uint32_t kvm_get_access_statistics(uint32_t type, uint64_t pointer, uint32_t max_count);
+
+uint64_t kvm_get_untracked_accesses_count(uint32_t type);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+#define TRANSLATION_CACHE_SIZE 64
+
+typedef struct TranslationCacheEntry {
+    uint64_t virtual_page;
+    uint64_t physical_page;
+    uint64_t generation;
+} TranslationCacheEntry;
+
+/* Translations are cached until the guest executes again or paging control registers change */
+typedef struct TranslationCache {
+    uint64_t generation;
+    uint64_t cr0;
+    uint64_t cr3;
+    uint64_t cr4;
+    uint64_t efer;
+    TranslationCacheEntry entries[TRANSLATION_CACHE_SIZE];
+} TranslationCache;
+
+/* Guest page tables may have been modified, invalidates all cached translations */
+void translation_cache_flush();
+
+/* Exported variant of translation_cache_flush, used when Renode writes to guest memory outside of KVM */
+void kvm_flush_translation_cache();
+
+/* Translates guest's virtual address into guest physical address.
+ * On failiure returns UINT64_MAX. */
+uint64_t kvm_translate_guest_virtual_address(uint64_t address);
+
+/* Translates every 4 KiB page overlapping [address, address + size), writing physical addresses of the pages to the
+ * uint64_t array at `pointer`, UINT64_MAX for unmapped ones. The first entry is the translation of `address` itself,
+ * the following ones are page aligned. Returns the number of entries written, at most `max_count`. */
+uint32_t kvm_translate_guest_virtual_range(uint64_t address, uint64_t size, uint64_t pointer, uint32_t max_count);
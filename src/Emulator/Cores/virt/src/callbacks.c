@@ -28,6 +28,10 @@ DEFAULT_VOID_HANDLER2(void kvm_io_port_write_word, uint16_t address, uint32_t va
 
 DEFAULT_VOID_HANDLER2(void kvm_io_port_write_double_word, uint16_t address, uint32_t value)
 
+DEFAULT_VOID_HANDLER4(void kvm_io_port_read_block, uint16_t address, uint32_t width, uint32_t count, void *buffer)
+
+DEFAULT_VOID_HANDLER4(void kvm_io_port_write_block, uint16_t address, uint32_t width, uint32_t count, void *buffer)
+
 DEFAULT_VOID_HANDLER2(void kvm_write_quad_word, uint64_t address, uint64_t value)
 
 DEFAULT_INT_HANDLER1(uint64_t kvm_sysbus_read_byte, uint64_t address)
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2025 Antmicro
+ * Copyright (c) 2010-2026 Antmicro
  *
  * This file is licensed under the MIT License.
  */
@@ -16,26 +16,145 @@
 #include "cpu.h"
 #include "debug.h"
 #include "memory_range.h"
+#include "registers.h"
+#include "translation.h"
 #include "utils.h"
 #include "unwind.h"
 
-void kvm_add_breakpoint(uint64_t address)
+/* DR7 bit layout, see Intel SDM Vol. 3B, 18.2.4 */
+#define DR7_GLOBAL_ENABLE(n) (1ULL << ((n) * 2 + 1))
+#define DR7_RW_SHIFT(n)      (16 + (n) * 4)
+#define DR7_LEN_SHIFT(n)     (18 + (n) * 4)
+#define DR7_RW_EXECUTE       0x0
+#define DR7_RW_WRITE         0x1
+#define DR7_RW_ACCESS        0x3
+
+#define HW_WATCHPOINT_ACCESS_READ  1
+#define HW_WATCHPOINT_ACCESS_WRITE 2
+
+static bool has_hw_breakpoints()
 {
-    if(is_breakpoint_address(address)) {
-        return;
+    for(int i = 0; i < HW_BREAKPOINTS_COUNT; i++) {
+        if(cpu->hw_breakpoints[i].type != HW_BREAKPOINT_UNUSED) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t get_dr7_length_bits(uint32_t length)
+{
+    switch(length) {
+        case 1:
+            return 0x0;
+        case 2:
+            return 0x1;
+        case 8:
+            return 0x2;
+        case 4:
+            return 0x3;
+        default:
+            kvm_runtime_abortf("Unsupported hardware watchpoint length: %u", length);
+    }
+    return 0;
+}
+
+static void fill_debug_registers(struct kvm_guest_debug *debug)
+{
+    uint64_t dr7 = 0;
+    for(int i = 0; i < HW_BREAKPOINTS_COUNT; i++) {
+        HardwareBreakpoint *hw_bp = &cpu->hw_breakpoints[i];
+        uint64_t rw_bits;
+        switch(hw_bp->type) {
+            case HW_BREAKPOINT_UNUSED:
+                continue;
+            case HW_BREAKPOINT_EXECUTE:
+                /* Instruction breakpoints always have length of 1 byte */
+                rw_bits = DR7_RW_EXECUTE;
+                break;
+            case HW_WATCHPOINT_WRITE:
+                rw_bits = DR7_RW_WRITE;
+                break;
+            case HW_WATCHPOINT_ACCESS:
+                rw_bits = DR7_RW_ACCESS;
+                break;
+            default:
+                kvm_runtime_abortf("Unknown hardware breakpoint type: %u", hw_bp->type);
+                continue;
+        }
+        debug->arch.debugreg[i] = hw_bp->address;
+        dr7 |= DR7_GLOBAL_ENABLE(i) | (rw_bits << DR7_RW_SHIFT(i)) | (get_dr7_length_bits(hw_bp->length) << DR7_LEN_SHIFT(i));
+    }
+    debug->arch.debugreg[7] = dr7;
+}
+
+void set_debug_flags(uint32_t flags)
+{
+    /* Changing debug flags may alter sregs, make sure they are up to date */
+    kvm_registers_synchronize();
+    struct kvm_guest_debug debug = {
+        .control = flags,
+    };
+    if(has_hw_breakpoints()) {
+        /* Debug registers are loaded on VM entry, so they cost no additional exits */
+        debug.control |= KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_USE_HW_BP;
+        fill_debug_registers(&debug);
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_GUEST_DEBUG, &debug) < 0) {
+        kvm_runtime_abortf("KVM_SET_GUEST_DEBUG: %s", strerror(errno));
     }
+}
+
+void set_default_debug_flags()
+{
+    uint32_t flags = 0;
+    if(!LIST_EMPTY(&cpu->breakpoints)) {
+        flags |= KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_USE_SW_BP;
+    }
+    set_debug_flags(flags);
+}
+
+static int find_hw_breakpoint(uint64_t address, bool watchpoint)
+{
+    for(int i = 0; i < HW_BREAKPOINTS_COUNT; i++) {
+        HardwareBreakpoint *hw_bp = &cpu->hw_breakpoints[i];
+        if(hw_bp->type == HW_BREAKPOINT_UNUSED || hw_bp->address != address) {
+            continue;
+        }
+        if((hw_bp->type == HW_BREAKPOINT_EXECUTE) != watchpoint) {
+            return i;
+        }
+    }
+    return -1;
+}
 
+static bool insert_hw_breakpoint(uint64_t address, uint32_t length, HardwareBreakpointType type)
+{
+    for(int i = 0; i < HW_BREAKPOINTS_COUNT; i++) {
+        HardwareBreakpoint *hw_bp = &cpu->hw_breakpoints[i];
+        if(hw_bp->type == HW_BREAKPOINT_UNUSED) {
+            hw_bp->address = address;
+            hw_bp->length = length;
+            hw_bp->type = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static Breakpoint *insert_breakpoint(uint64_t address)
+{
     uint64_t phys_address = kvm_translate_guest_virtual_address(address);
     if(phys_address == UINT64_MAX) {
         kvm_logf(LOG_LEVEL_WARNING, "Cannot add a breakpoint on address 0x%lx, it is outside mapped memory", address);
-        return;
+        return NULL;
     }
 
     uint64_t size;
     void *host_address = kvm_translate_guest_physical_to_host(phys_address, &size);
     if(host_address == NULL) {
         kvm_logf(LOG_LEVEL_WARNING, "Cannot add a breakpoint on address 0x%lx, it does not map to memory", address);
-        return;
+        return NULL;
     }
 
     Breakpoint *bp = malloc(sizeof(Breakpoint));
@@ -50,11 +169,42 @@ void kvm_add_breakpoint(uint64_t address)
     *(bp->host_code_position) = TRAP_OPCODE;
 
     LIST_INSERT_HEAD(&cpu->breakpoints, bp, list);
+    return bp;
+}
+
+void kvm_add_breakpoint(uint64_t address)
+{
+    if(is_breakpoint_address(address)) {
+        return;
+    }
+
+    /* Debug registers are preferred as they do not require patching guest code
+     * and do not cause all guest exceptions to be intercepted */
+    if(!insert_hw_breakpoint(address, 1, HW_BREAKPOINT_EXECUTE)) {
+        insert_breakpoint(address);
+    }
+    set_default_debug_flags();
 }
 EXC_VOID_1(kvm_add_breakpoint, uint64_t, address)
 
+void restore_breakpoint(uint64_t address, uint8_t code_byte)
+{
+    /* Guest memory restored from a snapshot already contains TRAP_OPCODE at this address */
+    Breakpoint *bp = insert_breakpoint(address);
+    if(bp != NULL) {
+        bp->code_byte = code_byte;
+    }
+}
+
 void kvm_remove_breakpoint(uint64_t address)
 {
+    int index = find_hw_breakpoint(address, false);
+    if(index >= 0) {
+        cpu->hw_breakpoints[index].type = HW_BREAKPOINT_UNUSED;
+        set_default_debug_flags();
+        return;
+    }
+
     Breakpoint *bp;
     LIST_FOREACH(bp, &cpu->breakpoints, list)
     {
@@ -62,6 +212,7 @@ void kvm_remove_breakpoint(uint64_t address)
             *(bp->host_code_position) = bp->code_byte;
             LIST_REMOVE(bp, list);
             free(bp);
+            set_default_debug_flags();
             return;
         }
     }
@@ -70,8 +221,68 @@ void kvm_remove_breakpoint(uint64_t address)
 }
 EXC_VOID_1(kvm_remove_breakpoint, uint64_t, address)
 
+/* Returns false if all debug registers are already in use or the watchpoint cannot be expressed with them */
+uint32_t kvm_add_watchpoint(uint64_t address, uint32_t length, uint32_t access)
+{
+#ifdef TARGET_X86_64KVM
+    bool valid_length = length == 1 || length == 2 || length == 4 || length == 8;
+#else
+    bool valid_length = length == 1 || length == 2 || length == 4;
+#endif
+    if(!valid_length || (address & (length - 1)) != 0) {
+        kvm_logf(LOG_LEVEL_WARNING, "Cannot add a watchpoint on address 0x%lx, %u byte long watchpoints have to be aligned",
+                 address, length);
+        return false;
+    }
+
+    /* x86 debug registers cannot trap on reads only */
+    HardwareBreakpointType type = access == HW_WATCHPOINT_ACCESS_WRITE ? HW_WATCHPOINT_WRITE : HW_WATCHPOINT_ACCESS;
+    if(!insert_hw_breakpoint(address, length, type)) {
+        kvm_logf(LOG_LEVEL_WARNING, "Cannot add a watchpoint on address 0x%lx, all %d debug registers are in use", address,
+                 HW_BREAKPOINTS_COUNT);
+        return false;
+    }
+    set_default_debug_flags();
+    return true;
+}
+EXC_INT_3(uint32_t, kvm_add_watchpoint, uint64_t, address, uint32_t, length, uint32_t, access)
+
+void kvm_remove_watchpoint(uint64_t address)
+{
+    int index = find_hw_breakpoint(address, true);
+    if(index < 0) {
+        kvm_logf(LOG_LEVEL_WARNING, "Watchpoint on address 0x%lx does not exist", address);
+        return;
+    }
+    cpu->hw_breakpoints[index].type = HW_BREAKPOINT_UNUSED;
+    set_default_debug_flags();
+}
+EXC_VOID_1(kvm_remove_watchpoint, uint64_t, address)
+
+uint64_t kvm_get_hit_watchpoint_address()
+{
+    return cpu->hit_watchpoint_address;
+}
+EXC_VALUE_0(uint64_t, kvm_get_hit_watchpoint_address, 0)
+
+bool is_watchpoint_hit(uint64_t dr6)
+{
+    for(int i = 0; i < HW_BREAKPOINTS_COUNT; i++) {
+        HardwareBreakpoint *hw_bp = &cpu->hw_breakpoints[i];
+        if((dr6 & (1ULL << i)) && hw_bp->type != HW_BREAKPOINT_UNUSED && hw_bp->type != HW_BREAKPOINT_EXECUTE) {
+            cpu->hit_watchpoint_address = hw_bp->address;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool is_breakpoint_address(uint64_t address)
 {
+    if(find_hw_breakpoint(address, false) >= 0) {
+        return true;
+    }
+
     Breakpoint *bp;
     LIST_FOREACH(bp, &cpu->breakpoints, list)
     {
@@ -82,16 +293,3 @@ bool is_breakpoint_address(uint64_t address)
 
     return false;
 }
-
-uint64_t kvm_translate_guest_virtual_address(uint64_t address)
-{
-    struct kvm_translation address_translation = (struct kvm_translation) { .linear_address = address };
-
-    /* Currently 'KVM_TRANSLATE' is only supported on x86 cpus */
-    if(ioctl(cpu->vcpu_fd, KVM_TRANSLATE, &address_translation) < 0) {
-        kvm_logf(LOG_LEVEL_WARNING, "KVM_TRANSLATE: %s", strerror(errno));
-        return UINT64_MAX;
-    }
-    return address_translation.physical_address;
-}
-EXC_VALUE_1(uint64_t, kvm_translate_guest_virtual_address, 0, uint64_t, address)
@@ -12,6 +12,7 @@
 #include "debug.h"
 #include "memory_range.h"
 #include "registers.h"
+#include "translation.h"
 #include "utils.h"
 #include "unwind.h"
 #include "x86intrin.h"
@@ -32,6 +33,12 @@
 #include <sys/time.h>
 
 #define USEC_IN_SEC 1000000
+#define NSEC_IN_USEC 1000
+
+/* The guest is checked for being halted after the first period, the period doubles
+ * while the guest keeps running, up to the maximum. See kvm_set_halt_detection */
+#define HALT_CHECK_MIN_PERIOD_US 50
+#define HALT_CHECK_MAX_PERIOD_US 1000
 
 #define CPUID_APIC (1 << 9)
 #define CPUID_ACPI (1 << 22)
@@ -40,7 +47,6 @@
 #define CPUID_FEATURE_INFO          0x1
 #define CPUID_FEATURE_INFO_EXTENDED 0x80000001
 
-#define DEFAULT_DEBUG_FLAGS     (KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_USE_SW_BP)
 #define SINGLE_STEP_DEBUG_FLAGS (KVM_GUESTDBG_ENABLE | KVM_GUESTDBG_SINGLESTEP)
 
 /* KVM_VCPU_TSC_{CTRL/OFFSET} may not be defined on older systems.
@@ -55,6 +61,8 @@
 #define KVM_VCPU_TSC_OFFSET 0
 #endif
 
+#define MSR_IA32_TSC 0x10
+
 static void kvm_filter_out_hypercall_cpuid(struct kvm_cpuid2 *cpuid)
 {
     bool is_kvm_leaf = false;
@@ -97,18 +105,6 @@ static void kvm_set_cpuid(CpuState *s)
     free(kvm_cpuid);
 }
 
-static void set_debug_flags(uint32_t flags)
-{
-    /* Changing debug flags may alter sregs, make sure they are up to date */
-    kvm_registers_synchronize();
-    struct kvm_guest_debug debug = {
-        .control = flags,
-    };
-    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_GUEST_DEBUG, &debug) < 0) {
-        kvm_runtime_abortf("KVM_SET_GUEST_DEBUG: %s", strerror(errno));
-    }
-}
-
 static void cpu_init(CpuState *s)
 {
     int ret;
@@ -142,6 +138,14 @@ static void cpu_init(CpuState *s)
         kvm_abortf("KVM_SET_TSS_ADDR: %s", strerror(errno));
     }
 
+    /* Lets dirty pages be collected and write-protected again in separate steps */
+    struct kvm_enable_cap enable_cap = {
+        .cap = KVM_CAP_MANUAL_DIRTY_LOG_PROTECT2,
+        .args = { KVM_DIRTY_LOG_MANUAL_PROTECT_ENABLE },
+    };
+    s->manual_dirty_log_protect = ioctl_with_retry(s->kvm_fd, KVM_CHECK_EXTENSION, KVM_CAP_MANUAL_DIRTY_LOG_PROTECT2) > 0
+                                  && ioctl_with_retry(s->vm_fd, KVM_ENABLE_CAP, &enable_cap) == 0;
+
     if(ioctl_with_retry(s->vm_fd, KVM_CREATE_IRQCHIP, 0) < 0) {
         kvm_abortf("KVM_CREATE_IRQCHIP: %s", strerror(errno));
     }
@@ -179,7 +183,7 @@ static void cpu_init(CpuState *s)
         kvm_abortf("mmap kvm_run: %s", strerror(errno));
     }
 
-    set_debug_flags(DEFAULT_DEBUG_FLAGS);
+    set_default_debug_flags();
 
     const int tsc_khz = ioctl_with_retry(s->kvm_fd, KVM_GET_TSC_KHZ);
     if(tsc_khz == -EIO) {
@@ -192,6 +196,8 @@ static void cpu_init(CpuState *s)
     cpu->single_step = false;
     cpu->regs_state = cpu->sregs_state = CLEAR;
     cpu->is_executing = false;
+    /* Cache entries are valid only for the current generation, which has to differ from the zeroed ones */
+    translation_cache_flush();
 }
 
 static void kill_cpu_thread(int sig)
@@ -265,40 +271,47 @@ EXC_VOID_1(kvm_set64_bit_behaviour, uint32_t, on64BitDetected)
 static void kvm_exit_io(CpuState *s, struct kvm_run *run)
 {
     uint8_t *ptr;
-    int i;
     ptr = (uint8_t *)run + run->io.data_offset;
 
-    for(i = 0; i < run->io.count; i++) {
+    if(run->io.size != 1 && run->io.size != 2 && run->io.size != 4) {
+        kvm_runtime_abortf("invalid io access width: %d bytes", run->io.size);
+    }
+
+    /* String I/O (rep ins/outs) is handed to Renode as a single block transfer,
+     * instead of crossing into managed code once per element */
+    if(run->io.count > 1) {
         if(run->io.direction == KVM_EXIT_IO_OUT) {
-            switch(run->io.size) {
-                case 1:
-                    kvm_io_port_write_byte(run->io.port, *(uint8_t *)ptr);
-                    break;
-                case 2:
-                    kvm_io_port_write_word(run->io.port, *(uint16_t *)ptr);
-                    break;
-                case 4:
-                    kvm_io_port_write_double_word(run->io.port, *(uint32_t *)ptr);
-                    break;
-                default:
-                    kvm_runtime_abortf("invalid io access width: %d bytes", run->io.size);
-            }
+            kvm_io_port_write_block(run->io.port, run->io.size, run->io.count, ptr);
         } else {
-            switch(run->io.size) {
-                case 1:
-                    *(uint8_t *)ptr = kvm_io_port_read_byte(run->io.port);
-                    break;
-                case 2:
-                    *(uint16_t *)ptr = kvm_io_port_read_word(run->io.port);
-                    break;
-                case 4:
-                    *(uint32_t *)ptr = kvm_io_port_read_double_word(run->io.port);
-                    break;
-                default:
-                    kvm_runtime_abortf("invalid io access width: %d bytes", run->io.size);
-            }
+            kvm_io_port_read_block(run->io.port, run->io.size, run->io.count, ptr);
+        }
+        return;
+    }
+
+    if(run->io.direction == KVM_EXIT_IO_OUT) {
+        switch(run->io.size) {
+            case 1:
+                kvm_io_port_write_byte(run->io.port, *(uint8_t *)ptr);
+                break;
+            case 2:
+                kvm_io_port_write_word(run->io.port, *(uint16_t *)ptr);
+                break;
+            case 4:
+                kvm_io_port_write_double_word(run->io.port, *(uint32_t *)ptr);
+                break;
+        }
+    } else {
+        switch(run->io.size) {
+            case 1:
+                *(uint8_t *)ptr = kvm_io_port_read_byte(run->io.port);
+                break;
+            case 2:
+                *(uint16_t *)ptr = kvm_io_port_read_word(run->io.port);
+                break;
+            case 4:
+                *(uint32_t *)ptr = kvm_io_port_read_double_word(run->io.port);
+                break;
         }
-        ptr += run->io.size;
     }
 }
 
@@ -314,6 +327,10 @@ static void kvm_exit_mmio(CpuState *s, struct kvm_run *run)
 #endif
 
     if(run->mmio.is_write) {
+        if(is_write_ignored(addr)) {
+            kvm_logf(LOG_LEVEL_WARNING, "Ignoring %d byte write to read-only memory at 0x%" PRIx64, run->mmio.len, addr);
+            return;
+        }
         switch(run->mmio.len) {
             case 1:
                 kvm_sysbus_write_byte(addr, *(uint8_t *)data);
@@ -356,7 +373,14 @@ static void kvm_exit_mmio(CpuState *s, struct kvm_run *run)
     }
 }
 
-static void execution_timer_set(uint64_t timeout_in_us)
+static uint64_t monotonic_time_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * USEC_IN_SEC * NSEC_IN_USEC + ts.tv_nsec;
+}
+
+static void execution_timer_arm(uint64_t timeout_in_us)
 {
     struct itimerval ival;
     ival.it_interval.tv_sec = 0;
@@ -377,6 +401,19 @@ static void execution_timer_set(uint64_t timeout_in_us)
     }
 }
 
+static void execution_timer_set(uint64_t timeout_in_us)
+{
+    if(cpu->halt_detection) {
+        /* The timer is one-shot, it's rearmed after each halt check for the next one or the rest of the quantum */
+        cpu->execution_deadline_ns = monotonic_time_ns() + timeout_in_us * NSEC_IN_USEC;
+        cpu->halt_check_period_us = HALT_CHECK_MIN_PERIOD_US;
+        if(timeout_in_us > HALT_CHECK_MIN_PERIOD_US) {
+            timeout_in_us = HALT_CHECK_MIN_PERIOD_US;
+        }
+    }
+    execution_timer_arm(timeout_in_us);
+}
+
 static void execution_timer_disarm()
 {
     struct itimerval ival;
@@ -389,7 +426,7 @@ static void execution_timer_disarm()
     }
 }
 
-static void set_guest_tsc_offset(uint64_t tsc_offset)
+void set_guest_tsc_offset(uint64_t tsc_offset)
 {
     struct kvm_device_attr device_attr;
     device_attr.group = KVM_VCPU_TSC_CTRL;
@@ -400,6 +437,112 @@ static void set_guest_tsc_offset(uint64_t tsc_offset)
     }
 }
 
+static uint64_t get_guest_tsc_offset()
+{
+    uint64_t tsc_offset;
+    struct kvm_device_attr device_attr;
+    device_attr.group = KVM_VCPU_TSC_CTRL;
+    device_attr.attr = KVM_VCPU_TSC_OFFSET;
+    device_attr.addr = (__u64)&tsc_offset;
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_DEVICE_ATTR, &device_attr)) {
+        kvm_runtime_abortf("KVM_GET_DEVICE_ATTR: %s", strerror(errno));
+    }
+    return tsc_offset;
+}
+
+static struct kvm_msr_entry *guest_tsc_msr(struct kvm_msrs *msrs)
+{
+    msrs->nmsrs = 1;
+    msrs->entries[0].index = MSR_IA32_TSC;
+    return &msrs->entries[0];
+}
+
+static void set_guest_tsc(uint64_t value)
+{
+    struct {
+        struct kvm_msrs header;
+        struct kvm_msr_entry entry;
+    } msrs = { 0 };
+    guest_tsc_msr(&msrs.header)->data = value;
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_MSRS, &msrs) != 1) {
+        kvm_runtime_abortf("Could not write the guest TSC: %s", strerror(errno));
+    }
+}
+
+static void set_tsc_khz(uint64_t tsc_khz)
+{
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_TSC_KHZ, tsc_khz) < 0) {
+        kvm_runtime_abortf("KVM_SET_TSC_KHZ(%lu): %s", tsc_khz, strerror(errno));
+    }
+    cpu->virtual_tsc_khz = tsc_khz;
+}
+
+/* Converts host TSC ticks to the guest TSC frequency of the virtual TSC mode, the same way KVM scales the guest TSC */
+static uint64_t scale_host_tsc(uint64_t host_tsc)
+{
+    return (uint64_t)((unsigned __int128)host_tsc * cpu->virtual_tsc_khz / cpu->host_tsc_khz);
+}
+
+/* In the virtual TSC mode guest TSC frequency is set with KVM_SET_TSC_KHZ. The TSC offset is only reprogrammed
+ * at quantum boundaries by kvm_synchronize_virtual_tsc, which freezes the guest TSC for the time between quanta
+ * and moves it forward to the virtual time. */
+void kvm_set_virtual_tsc(uint32_t enabled)
+{
+    if(enabled == cpu->virtual_tsc) {
+        return;
+    }
+
+    if(enabled) {
+        if(ioctl_with_retry(cpu->kvm_fd, KVM_CHECK_EXTENSION, KVM_CAP_TSC_CONTROL) <= 0) {
+            kvm_runtime_abortf("Host does not support TSC frequency scaling required by the virtual TSC mode");
+        }
+        cpu->host_tsc_khz = ioctl_with_retry(cpu->vcpu_fd, KVM_GET_TSC_KHZ);
+        cpu->virtual_tsc_khz = cpu->host_tsc_khz;
+        if(cpu->cpu_supports_tsc_offset) {
+            cpu->virtual_tsc_offset = get_guest_tsc_offset();
+        }
+        cpu->exit_host_tsc = __rdtsc();
+    } else {
+        set_tsc_khz(cpu->host_tsc_khz);
+        /* Continue compensating the missed ticks from the current offset, guest TSC is not rescaled */
+        cpu->missed_tsc_ticks = -cpu->virtual_tsc_offset;
+        cpu->exit_host_tsc = __rdtsc();
+    }
+    cpu->virtual_tsc = enabled;
+}
+EXC_VOID_1(kvm_set_virtual_tsc, uint32_t, enabled)
+
+/* Sets the guest TSC frequency and moves the guest TSC to `guest_tsc`, the value corresponding to the current virtual time */
+void kvm_synchronize_virtual_tsc(uint64_t guest_tsc, uint64_t tsc_khz)
+{
+    if(!cpu->virtual_tsc) {
+        return;
+    }
+
+    if(!cpu->cpu_supports_tsc_offset) {
+        if(tsc_khz != cpu->virtual_tsc_khz) {
+            set_tsc_khz(tsc_khz);
+        }
+        set_guest_tsc(guest_tsc);
+        return;
+    }
+
+    /* The offset is known, as it is only changed here, so the guest TSC is computed instead of read with KVM_GET_MSRS.
+     * It continues from the value it had when the previous quantum ended. If that is ahead of the virtual time,
+     * it waits for the virtual time to catch up, as guest software expects the TSC to be monotonic. */
+    const uint64_t frozen_guest_tsc = scale_host_tsc(cpu->exit_host_tsc) + cpu->virtual_tsc_offset;
+    if(tsc_khz != cpu->virtual_tsc_khz) {
+        set_tsc_khz(tsc_khz);
+    }
+    const uint64_t resumed_guest_tsc = (int64_t)(guest_tsc - frozen_guest_tsc) > 0 ? guest_tsc : frozen_guest_tsc;
+    const uint64_t offset = resumed_guest_tsc - scale_host_tsc(__rdtsc());
+    if(offset != cpu->virtual_tsc_offset) {
+        cpu->virtual_tsc_offset = offset;
+        set_guest_tsc_offset(offset);
+    }
+}
+EXC_VOID_2(kvm_synchronize_virtual_tsc, uint64_t, guest_tsc, uint64_t, tsc_khz)
+
 static void restore_cpu_events()
 {
     if(cpu->restore_events) {
@@ -436,14 +579,17 @@ static bool kvm_run()
      * Note that this does not make TSC completely stable as the 'missed ticks' will not include
      * time spent in KVM_RUN, but before and after KVM thread execution. Also not taken into account
      * will be the time not spent on CPU if scheduler decides to preempt KVM thread. */
-    if(cpu->cpu_supports_tsc_offset) {
+    if(cpu->cpu_supports_tsc_offset && !cpu->virtual_tsc) {
         const uint64_t entry_host_tsc = __rdtsc();
         const uint64_t missed_host_ticks = entry_host_tsc - cpu->exit_host_tsc;
         cpu->missed_tsc_ticks += missed_host_ticks;
         set_guest_tsc_offset(-cpu->missed_tsc_ticks);
     }
 
+    stats_run_entry(&cpu->stats);
     const int result = ioctl(cpu->vcpu_fd, KVM_RUN, NULL);
+    /* Guest could have modified its page tables */
+    translation_cache_flush();
 
     cpu->exit_host_tsc = __rdtsc();
 
@@ -455,11 +601,46 @@ static bool kvm_run()
     if(early_exit && errno != EINTR) {
         kvm_runtime_abortf("KVM_RUN: %s", strerror(errno));
     }
+    stats_run_exit(&cpu->stats, early_exit, cpu->kvm_run->exit_reason);
 
     save_cpu_events();
     return early_exit;
 }
 
+/* Called when KVM_RUN was interrupted in the halt detection mode.
+ * Returns true if the quantum is not over yet and the guest is not halted, otherwise sets `result` */
+static bool continue_after_halt_check(ExecutionResult *result)
+{
+    /* Cleared before checking the interruption flag, so that an interruption requested in between is not lost */
+    cpu->kvm_run->immediate_exit = false;
+    const uint64_t now_ns = monotonic_time_ns();
+    if(cpu->execution_interrupted || now_ns >= cpu->execution_deadline_ns) {
+        *result = OK;
+        return false;
+    }
+
+    /* With the in-kernel irqchip HLT never exits to userspace, the vCPU blocks in KVM_RUN until an interrupt arrives */
+    struct kvm_mp_state mp_state;
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_MP_STATE, &mp_state) < 0) {
+        kvm_runtime_abortf("KVM_GET_MP_STATE: %s", strerror(errno));
+    }
+    if(mp_state.mp_state == KVM_MP_STATE_HALTED) {
+        *result = WAITING_FOR_INTERRUPT;
+        return false;
+    }
+
+    /* A running guest is checked less and less often, but the timer never fires after the end of the quantum */
+    if(cpu->halt_check_period_us < HALT_CHECK_MAX_PERIOD_US) {
+        cpu->halt_check_period_us *= 2;
+        if(cpu->halt_check_period_us > HALT_CHECK_MAX_PERIOD_US) {
+            cpu->halt_check_period_us = HALT_CHECK_MAX_PERIOD_US;
+        }
+    }
+    const uint64_t remaining_us = (cpu->execution_deadline_ns - now_ns + NSEC_IN_USEC - 1) / NSEC_IN_USEC;
+    execution_timer_arm(remaining_us < cpu->halt_check_period_us ? remaining_us : cpu->halt_check_period_us);
+    return true;
+}
+
 static ExecutionResult kvm_run_loop()
 {
     kvm_registers_synchronize();
@@ -472,10 +653,14 @@ static ExecutionResult kvm_run_loop()
     ExecutionResult execution_result = OK;
     bool override_exception_capture = false;
 
+    stats_loop_entry(&cpu->stats);
+
     /* timer_expired flag will be set by the SIGALRM handler */
     while(true) {
         if(kvm_run()) {
-            execution_result = OK;
+            if(cpu->halt_detection && continue_after_halt_check(&execution_result)) {
+                continue;
+            }
             goto finalize;
         }
 
@@ -485,14 +670,22 @@ static ExecutionResult kvm_run_loop()
         switch(run->exit_reason) {
             case KVM_EXIT_IO:
                 /* handle IN / OUT instructions */
+                stats_callback_entry(&cpu->stats, STATS_ACCESS_IO_PORT, run->io.port);
                 kvm_exit_io(cpu, run);
+                stats_callback_exit(&cpu->stats);
                 break;
             case KVM_EXIT_MMIO:
                 /* handle sysbus accesses */
+                stats_callback_entry(&cpu->stats, STATS_ACCESS_MMIO, run->mmio.phys_addr);
                 kvm_exit_mmio(cpu, run);
+                stats_callback_exit(&cpu->stats);
                 break;
             case KVM_EXIT_DEBUG:
                 /* this case occurs when single-stepping is enabled or a software event was triggered */
+                if(is_watchpoint_hit(run->debug.arch.dr6)) {
+                    execution_result = STOPPED_AT_WATCHPOINT;
+                    goto finalize;
+                }
                 if(is_breakpoint_address(run->debug.arch.pc)) {
                     execution_result = STOPPED_AT_BREAKPOINT;
                     goto finalize;
@@ -502,16 +695,16 @@ static ExecutionResult kvm_run_loop()
                     goto finalize;
                 }
                 if(override_exception_capture) {
-                    set_debug_flags(DEFAULT_DEBUG_FLAGS);
+                    set_default_debug_flags();
                     override_exception_capture = false;
                     break;
                 }
 
                 /* KVM_GUESTDBG_USE_SW_BP causes us to capture all exceptions, even ones guest software
-                 * would expect to handle by itself. If we encounter an exception and do not expect
-                 * it then this instruction will be single-stepped with exception capture turned off.
-                 * This will allow guest to jump to exception handler from which we can continue to
-                 * capture exceptions */
+                 * would expect to handle by itself, so it is only enabled while software breakpoints are set.
+                 * If we encounter an exception we do not expect, the instruction is single-stepped with
+                 * exception capture turned off. This allows the guest to jump to its exception handler,
+                 * after which we continue to capture exceptions. */
                 kvm_logf(LOG_LEVEL_DEBUG,
                          "KVM_EXIT_DEBUG: exception=0x%lx at pc 0x%lx, turning off interrupt capture for this instruction",
                          run->debug.arch.exception, run->debug.arch.pc);
@@ -542,13 +735,14 @@ finalize:
 uint64_t kvm_execute(uint64_t time_in_us)
 {
     cpu->single_step = false;
+    cpu->execution_interrupted = false;
     cpu->kvm_run->immediate_exit = false;
 
     execution_timer_set(time_in_us);
 
     ExecutionResult result = kvm_run_loop();
-    if(result != OK) {
-        /* Disarm timer if it did not cause the exit */
+    if(result != OK || cpu->halt_detection) {
+        /* Disarm timer if it did not cause the exit or it was rearmed by a halt check */
         execution_timer_disarm();
     }
     return result;
@@ -563,7 +757,7 @@ uint64_t kvm_execute_single_step()
 
     set_debug_flags(SINGLE_STEP_DEBUG_FLAGS);
     ExecutionResult result = kvm_run_loop();
-    set_debug_flags(DEFAULT_DEBUG_FLAGS);
+    set_default_debug_flags();
     return (uint64_t)result;
 }
 EXC_VALUE_0(uint64_t, kvm_execute_single_step, 0)
@@ -571,11 +765,20 @@ EXC_VALUE_0(uint64_t, kvm_execute_single_step, 0)
 void kvm_interrupt_execution()
 {
     execution_timer_disarm();
+    cpu->execution_interrupted = true;
     cpu->kvm_run->immediate_exit = true;
     kill_cpu_thread(SIGALRM);
 }
 EXC_VOID_0(kvm_interrupt_execution)
 
+/* In the halt detection mode a halted guest ends the quantum with WAITING_FOR_INTERRUPT,
+ * instead of blocking inside KVM_RUN until the quantum timer expires */
+void kvm_set_halt_detection(uint32_t enabled)
+{
+    cpu->halt_detection = enabled;
+}
+EXC_VOID_1(kvm_set_halt_detection, uint32_t, enabled)
+
 void kvm_dispose()
 {
     /* Make sure we are not executing KVMCPU before disposing */
@@ -594,12 +797,7 @@ void kvm_dispose()
         bp = next;
     }
 
-    MemoryRegion *mr = LIST_FIRST(&cpu->memory_regions);
-    while(mr != NULL) {
-        MemoryRegion *next = LIST_NEXT(mr, list);
-        free(mr);
-        mr = next;
-    }
+    free_memory_regions();
 
     free(cpu);
 }
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2010-2025 Antmicro
+ * Copyright (c) 2010-2026 Antmicro
  *
  * This file is licensed under the MIT License.
  */
@@ -7,6 +7,7 @@
 #include <linux/kvm.h>
 #include <string.h>
 #include <inttypes.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <sys/ioctl.h>
 
@@ -14,35 +15,132 @@
 #include "unwind.h"
 #include "cpu.h"
 #include "memory_range.h"
+#include "translation.h"
 
-void kvm_map_range(int32_t slot, uint64_t address, uint64_t size, uint64_t pointer)
+/* Returns the index of the first region starting above `address`, the region containing it can only be the previous one */
+static uint32_t upper_bound(uint64_t address)
 {
-    MemoryRegion *memory_region = malloc(sizeof(MemoryRegion));
-    if(memory_region == NULL) {
-        kvm_abortf("Malloc failed");
+    uint32_t low = 0;
+    uint32_t high = cpu->memory_regions_count;
+    while(low < high) {
+        uint32_t middle = low + (high - low) / 2;
+        if(cpu->memory_regions[middle].kvm_memory_region.guest_phys_addr <= address) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
     }
+    return low;
+}
 
-    memory_region->kvm_memory_region = (struct kvm_userspace_memory_region) { .slot = slot,
-                                                                              .flags = 0,
-                                                                              .guest_phys_addr = address,
-                                                                              .memory_size = size,
-                                                                              .userspace_addr = (uintptr_t)pointer };
+static MemoryRegion *find_memory_region_by_address(uint64_t address)
+{
+    uint32_t index = upper_bound(address);
+    if(index == 0) {
+        return NULL;
+    }
 
-    if(ioctl(cpu->vm_fd, KVM_SET_USER_MEMORY_REGION, &memory_region->kvm_memory_region) < 0) {
-        free(memory_region);
+    MemoryRegion *memory_region = &cpu->memory_regions[index - 1];
+    if(address - memory_region->kvm_memory_region.guest_phys_addr >= memory_region->kvm_memory_region.memory_size) {
+        return NULL;
+    }
+    return memory_region;
+}
+
+/* Slots are looked up by number only when they are reconfigured, so a linear search is sufficient */
+static MemoryRegion *find_memory_region(int32_t slot)
+{
+    for(uint32_t i = 0; i < cpu->memory_regions_count; i++) {
+        if(cpu->memory_regions[i].kvm_memory_region.slot == slot) {
+            return &cpu->memory_regions[i];
+        }
+    }
+    return NULL;
+}
+
+static void insert_memory_region(const MemoryRegion *memory_region)
+{
+    if(cpu->memory_regions_count == cpu->memory_regions_capacity) {
+        uint32_t capacity = cpu->memory_regions_capacity == 0 ? 8 : cpu->memory_regions_capacity * 2;
+        MemoryRegion *memory_regions = realloc(cpu->memory_regions, capacity * sizeof(MemoryRegion));
+        if(memory_regions == NULL) {
+            kvm_abortf("Realloc failed");
+        }
+        cpu->memory_regions = memory_regions;
+        cpu->memory_regions_capacity = capacity;
+    }
+
+    uint32_t index = upper_bound(memory_region->kvm_memory_region.guest_phys_addr);
+    memmove(&cpu->memory_regions[index + 1], &cpu->memory_regions[index],
+            (cpu->memory_regions_count - index) * sizeof(MemoryRegion));
+    cpu->memory_regions[index] = *memory_region;
+    cpu->memory_regions_count++;
+}
+
+static uint64_t *allocate_written_pages(const MemoryRegion *memory_region)
+{
+    uint64_t pages = (memory_region->kvm_memory_region.memory_size + KVM_PAGE_SIZE - 1) / KVM_PAGE_SIZE;
+    uint64_t *written_pages = calloc((pages + 63) / 64, sizeof(uint64_t));
+    if(written_pages == NULL) {
+        kvm_abortf("Calloc failed");
+    }
+    return written_pages;
+}
+
+static void mark_written_pages(MemoryRegion *memory_region, uint64_t address, uint64_t size)
+{
+    if(memory_region->written_pages == NULL || size == 0) {
+        return;
+    }
+
+    uint64_t offset = address - memory_region->kvm_memory_region.guest_phys_addr;
+    uint64_t last_page = (offset + size - 1) / KVM_PAGE_SIZE;
+    for(uint64_t page = offset / KVM_PAGE_SIZE; page <= last_page; page++) {
+        memory_region->written_pages[page / 64] |= 1ULL << (page % 64);
+    }
+}
+
+static void remove_memory_region(MemoryRegion *memory_region)
+{
+    if(memory_region->ignore_writes) {
+        cpu->write_ignoring_regions--;
+    }
+    free(memory_region->written_pages);
+
+    uint32_t index = memory_region - cpu->memory_regions;
+    memmove(&cpu->memory_regions[index], &cpu->memory_regions[index + 1],
+            (cpu->memory_regions_count - index - 1) * sizeof(MemoryRegion));
+    cpu->memory_regions_count--;
+}
+
+void kvm_map_range(int32_t slot, uint64_t address, uint64_t size, uint64_t pointer)
+{
+    MemoryRegion memory_region = {
+        .kvm_memory_region = (struct kvm_userspace_memory_region) { .slot = slot,
+                                                                    .flags = 0,
+                                                                    .guest_phys_addr = address,
+                                                                    .memory_size = size,
+                                                                    .userspace_addr = (uintptr_t)pointer },
+        .ignore_writes = false,
+        .written_pages = NULL,
+    };
+
+    if(ioctl(cpu->vm_fd, KVM_SET_USER_MEMORY_REGION, &memory_region.kvm_memory_region) < 0) {
         kvm_abortf("KVM_SET_USER_MEMORY_REGION: %s", strerror(errno));
     }
-    LIST_INSERT_HEAD(&cpu->memory_regions, memory_region, list);
+
+    //  reusing a slot number modifies the existing mapping, which may move it in the sorted array
+    MemoryRegion *existing_region = find_memory_region(slot);
+    if(existing_region != NULL) {
+        remove_memory_region(existing_region);
+    }
+    insert_memory_region(&memory_region);
 }
 EXC_VOID_4(kvm_map_range, int32_t, slot, uint64_t, address, uint64_t, size, uint64_t, pointer)
 
 void kvm_unmap_range(int32_t slot)
 {
-    MemoryRegion *memory_region = LIST_FIRST(&cpu->memory_regions);
-    while(memory_region != NULL && memory_region->kvm_memory_region.slot != slot) {
-        memory_region = LIST_NEXT(memory_region, list);
-    }
-
+    MemoryRegion *memory_region = find_memory_region(slot);
     if(memory_region == NULL) {
         kvm_logf(LOG_LEVEL_ERROR, "KVM unmap range: Unknown KVM memory slot %d", slot);
         return;
@@ -55,24 +153,206 @@ void kvm_unmap_range(int32_t slot)
         kvm_abortf("KVM_SET_USER_MEMORY_REGION: %s", strerror(errno));
     }
 
-    LIST_REMOVE(memory_region, list);
-    free(memory_region);
+    remove_memory_region(memory_region);
 }
 EXC_VOID_1(kvm_unmap_range, int32_t, slot)
 
+void kvm_set_dirty_logging(int32_t slot, uint32_t enabled)
+{
+    MemoryRegion *memory_region = find_memory_region(slot);
+    if(memory_region == NULL) {
+        kvm_logf(LOG_LEVEL_ERROR, "KVM set dirty logging: Unknown KVM memory slot %d", slot);
+        return;
+    }
+
+    //  flags of an existing slot can be changed by registering it again with the same slot number
+    if(enabled) {
+        memory_region->kvm_memory_region.flags |= KVM_MEM_LOG_DIRTY_PAGES;
+        if(memory_region->written_pages == NULL) {
+            memory_region->written_pages = allocate_written_pages(memory_region);
+        }
+    } else {
+        memory_region->kvm_memory_region.flags &= ~KVM_MEM_LOG_DIRTY_PAGES;
+        free(memory_region->written_pages);
+        memory_region->written_pages = NULL;
+    }
+
+    if(ioctl(cpu->vm_fd, KVM_SET_USER_MEMORY_REGION, &memory_region->kvm_memory_region) < 0) {
+        kvm_abortf("KVM_SET_USER_MEMORY_REGION: %s", strerror(errno));
+    }
+}
+EXC_VOID_2(kvm_set_dirty_logging, int32_t, slot, uint32_t, enabled)
+
+/* Reads from a read-only slot are handled by KVM, writes exit to userspace as MMIO.
+ * If `trap_writes` is set, writes are passed to the sysbus so that the peripheral owning the memory can handle them,
+ * otherwise they are dropped. */
+void kvm_set_read_only(int32_t slot, uint32_t read_only, uint32_t trap_writes)
+{
+    MemoryRegion *memory_region = find_memory_region(slot);
+    if(memory_region == NULL) {
+        kvm_logf(LOG_LEVEL_ERROR, "KVM set read only: Unknown KVM memory slot %d", slot);
+        return;
+    }
+
+    if(read_only && ioctl_with_retry(cpu->kvm_fd, KVM_CHECK_EXTENSION, KVM_CAP_READONLY_MEM) <= 0) {
+        kvm_runtime_abortf("Host does not support read-only KVM memory slots");
+    }
+
+    struct kvm_userspace_memory_region *kvm_memory_region = &memory_region->kvm_memory_region;
+    uint32_t flags = read_only ? (kvm_memory_region->flags | KVM_MEM_READONLY) : (kvm_memory_region->flags & ~KVM_MEM_READONLY);
+    if(flags != kvm_memory_region->flags) {
+        //  unlike KVM_MEM_LOG_DIRTY_PAGES, KVM_MEM_READONLY cannot be changed for an existing slot, it has to be recreated
+        uint64_t memory_size = kvm_memory_region->memory_size;
+        kvm_memory_region->memory_size = 0;
+        if(ioctl(cpu->vm_fd, KVM_SET_USER_MEMORY_REGION, kvm_memory_region) < 0) {
+            kvm_abortf("KVM_SET_USER_MEMORY_REGION: %s", strerror(errno));
+        }
+
+        kvm_memory_region->memory_size = memory_size;
+        kvm_memory_region->flags = flags;
+        if(ioctl(cpu->vm_fd, KVM_SET_USER_MEMORY_REGION, kvm_memory_region) < 0) {
+            kvm_abortf("KVM_SET_USER_MEMORY_REGION: %s", strerror(errno));
+        }
+    }
+
+    bool ignore_writes = read_only && !trap_writes;
+    if(ignore_writes != memory_region->ignore_writes) {
+        cpu->write_ignoring_regions += ignore_writes ? 1 : -1;
+        memory_region->ignore_writes = ignore_writes;
+    }
+}
+EXC_VOID_3(kvm_set_read_only, int32_t, slot, uint32_t, read_only, uint32_t, trap_writes)
+
+bool is_write_ignored(uint64_t address)
+{
+    if(cpu->write_ignoring_regions == 0) {
+        return false;
+    }
+
+    MemoryRegion *memory_region = find_memory_region_by_address(address);
+    return memory_region != NULL && memory_region->ignore_writes;
+}
+
+/* Fills `bitmap` with one bit per page of the slot, set for pages written since the last clear,
+ * either by the guest or by kvm_write_guest_memory.
+ * The bitmap has to hold the number of pages in the slot rounded up to a multiple of 64 bits.
+ * If the host does not support manual dirty log protection, reading the log also clears it. */
+void kvm_get_dirty_log(int32_t slot, uint64_t bitmap)
+{
+    struct kvm_dirty_log dirty_log = { .slot = slot, .dirty_bitmap = (void *)bitmap };
+
+    if(ioctl_with_retry(cpu->vm_fd, KVM_GET_DIRTY_LOG, &dirty_log) < 0) {
+        kvm_runtime_abortf("KVM_GET_DIRTY_LOG: %s", strerror(errno));
+    }
+
+    MemoryRegion *memory_region = find_memory_region(slot);
+    if(memory_region == NULL || memory_region->written_pages == NULL) {
+        return;
+    }
+
+    uint64_t *dirty_bitmap = (uint64_t *)bitmap;
+    uint64_t words = (memory_region->kvm_memory_region.memory_size / KVM_PAGE_SIZE + 63) / 64;
+    for(uint64_t i = 0; i < words; i++) {
+        dirty_bitmap[i] |= memory_region->written_pages[i];
+    }
+    if(!cpu->manual_dirty_log_protect) {
+        memset(memory_region->written_pages, 0, words * sizeof(uint64_t));
+    }
+}
+EXC_VOID_2(kvm_get_dirty_log, int32_t, slot, uint64_t, bitmap)
+
+/* Clears the dirty state of pages set in `bitmap`, usually the one returned by kvm_get_dirty_log.
+ * Pages are write-protected again, so the next write to them will be logged. */
+void kvm_clear_dirty_log(int32_t slot, uint64_t bitmap)
+{
+    if(!cpu->manual_dirty_log_protect) {
+        //  dirty log has already been cleared by KVM_GET_DIRTY_LOG
+        return;
+    }
+
+    MemoryRegion *memory_region = find_memory_region(slot);
+    if(memory_region == NULL) {
+        kvm_logf(LOG_LEVEL_ERROR, "KVM clear dirty log: Unknown KVM memory slot %d", slot);
+        return;
+    }
+
+    if(memory_region->written_pages != NULL) {
+        uint64_t *dirty_bitmap = (uint64_t *)bitmap;
+        uint64_t words = (memory_region->kvm_memory_region.memory_size / KVM_PAGE_SIZE + 63) / 64;
+        for(uint64_t i = 0; i < words; i++) {
+            memory_region->written_pages[i] &= ~dirty_bitmap[i];
+        }
+    }
+
+    struct kvm_clear_dirty_log clear_dirty_log = {
+        .slot = slot,
+        .first_page = 0,
+        .num_pages = memory_region->kvm_memory_region.memory_size / KVM_PAGE_SIZE,
+        .dirty_bitmap = (void *)bitmap,
+    };
+
+    if(ioctl_with_retry(cpu->vm_fd, KVM_CLEAR_DIRTY_LOG, &clear_dirty_log) < 0) {
+        kvm_runtime_abortf("KVM_CLEAR_DIRTY_LOG: %s", strerror(errno));
+    }
+}
+EXC_VOID_2(kvm_clear_dirty_log, int32_t, slot, uint64_t, bitmap)
+
+void free_memory_regions()
+{
+    for(uint32_t i = 0; i < cpu->memory_regions_count; i++) {
+        free(cpu->memory_regions[i].written_pages);
+    }
+    free(cpu->memory_regions);
+}
+
 void *kvm_translate_guest_physical_to_host(uint64_t address, uint64_t *size)
 {
-    MemoryRegion *memory_region = LIST_FIRST(&cpu->memory_regions);
-    while(memory_region != NULL) {
-        uint64_t guest_phys_address = memory_region->kvm_memory_region.guest_phys_addr;
-        uint64_t memory_size = memory_region->kvm_memory_region.memory_size;
-        if(guest_phys_address <= address && address < guest_phys_address + memory_size) {
-            uint64_t offset = address - guest_phys_address;
-            *size = memory_size - offset;
-            return (void *)(memory_region->kvm_memory_region.userspace_addr + offset);
+    MemoryRegion *memory_region = find_memory_region_by_address(address);
+    if(memory_region == NULL) {
+        return NULL;
+    }
+
+    uint64_t offset = address - memory_region->kvm_memory_region.guest_phys_addr;
+    *size = memory_region->kvm_memory_region.memory_size - offset;
+    return (void *)(memory_region->kvm_memory_region.userspace_addr + offset);
+}
+
+/* Copies between the buffer and guest memory spanning any number of adjacent slots */
+static uint64_t copy_guest_memory(uint64_t address, uint8_t *buffer, uint64_t size, bool write)
+{
+    uint64_t copied = 0;
+    while(copied < size) {
+        MemoryRegion *memory_region = find_memory_region_by_address(address + copied);
+        if(memory_region == NULL) {
+            break;
         }
-        memory_region = LIST_NEXT(memory_region, list);
+
+        uint64_t offset = address + copied - memory_region->kvm_memory_region.guest_phys_addr;
+        uint64_t available = memory_region->kvm_memory_region.memory_size - offset;
+        uint8_t *host_address = (uint8_t *)(uintptr_t)(memory_region->kvm_memory_region.userspace_addr + offset);
+
+        uint64_t chunk = available < size - copied ? available : size - copied;
+        if(write) {
+            memcpy(host_address, buffer + copied, chunk);
+            mark_written_pages(memory_region, address + copied, chunk);
+        } else {
+            memcpy(buffer + copied, host_address, chunk);
+        }
+        copied += chunk;
     }
+    return copied;
+}
 
-    return NULL;
+uint64_t kvm_read_guest_memory(uint64_t address, uint64_t pointer, uint64_t size)
+{
+    return copy_guest_memory(address, (uint8_t *)pointer, size, false);
+}
+EXC_VALUE_3(uint64_t, kvm_read_guest_memory, 0, uint64_t, address, uint64_t, pointer, uint64_t, size)
+
+uint64_t kvm_write_guest_memory(uint64_t address, uint64_t pointer, uint64_t size)
+{
+    /* Written memory could hold guest page tables */
+    translation_cache_flush();
+    return copy_guest_memory(address, (uint8_t *)pointer, size, true);
 }
+EXC_VALUE_3(uint64_t, kvm_write_guest_memory, 0, uint64_t, address, uint64_t, pointer, uint64_t, size)
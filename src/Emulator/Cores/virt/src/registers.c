@@ -56,6 +56,11 @@ static struct kvm_sregs *get_sregs()
     return &cpu->sregs;
 }
 
+const struct kvm_sregs *get_special_registers()
+{
+    return get_sregs();
+}
+
 static void set_sregs(struct kvm_sregs *sregs)
 {
     if(sregs != &cpu->sregs) {
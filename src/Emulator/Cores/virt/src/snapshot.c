@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <errno.h>
+#include <linux/kvm.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/queue.h>
+
+#include "cpu.h"
+#include "debug.h"
+#include "registers.h"
+#include "snapshot.h"
+#include "translation.h"
+#include "utils.h"
+#include "unwind.h"
+#include "x86intrin.h"
+
+#define MSR_IA32_TSC            0x10
+#define MSR_IA32_SYSENTER_CS    0x174
+#define MSR_IA32_SYSENTER_ESP   0x175
+#define MSR_IA32_SYSENTER_EIP   0x176
+#define MSR_IA32_MISC_ENABLE    0x1a0
+#define MSR_MTRR_PHYS_BASE0     0x200
+#define MSR_MTRR_FIX64K_00000   0x250
+#define MSR_MTRR_FIX16K_80000   0x258
+#define MSR_MTRR_FIX16K_A0000   0x259
+#define MSR_MTRR_FIX4K_C0000    0x268
+#define MSR_PAT                 0x277
+#define MSR_MTRR_DEF_TYPE       0x2ff
+#define MSR_IA32_TSC_DEADLINE   0x6e0
+#define MSR_STAR                0xc0000081
+#define MSR_LSTAR               0xc0000082
+#define MSR_CSTAR               0xc0000083
+#define MSR_SYSCALL_MASK        0xc0000084
+#define MSR_KERNEL_GS_BASE      0xc0000102
+#define MSR_TSC_AUX             0xc0000103
+
+#define MTRR_VARIABLE_REGISTERS 16
+#define MTRR_FIX4K_REGISTERS    8
+
+typedef struct MsrList {
+    struct kvm_msrs header;
+    struct kvm_msr_entry entries[SNAPSHOT_MAX_MSRS];
+} MsrList;
+
+/* MSRs that are not reflected in regs/sregs but hold state the guest software relies on.
+ * MSR_IA32_TSC_DEADLINE has to be written after the TSC and the LAPIC are restored, it is the last one for that reason. */
+static uint32_t get_saved_msr_indices(uint32_t *indices)
+{
+    uint32_t count = 0;
+
+    indices[count++] = MSR_IA32_SYSENTER_CS;
+    indices[count++] = MSR_IA32_SYSENTER_ESP;
+    indices[count++] = MSR_IA32_SYSENTER_EIP;
+    indices[count++] = MSR_IA32_MISC_ENABLE;
+    indices[count++] = MSR_PAT;
+    indices[count++] = MSR_MTRR_DEF_TYPE;
+    indices[count++] = MSR_MTRR_FIX64K_00000;
+    indices[count++] = MSR_MTRR_FIX16K_80000;
+    indices[count++] = MSR_MTRR_FIX16K_A0000;
+    for(int i = 0; i < MTRR_FIX4K_REGISTERS; i++) {
+        indices[count++] = MSR_MTRR_FIX4K_C0000 + i;
+    }
+    for(int i = 0; i < MTRR_VARIABLE_REGISTERS; i++) {
+        indices[count++] = MSR_MTRR_PHYS_BASE0 + i;
+    }
+#ifdef TARGET_X86_64KVM
+    indices[count++] = MSR_STAR;
+    indices[count++] = MSR_LSTAR;
+    indices[count++] = MSR_CSTAR;
+    indices[count++] = MSR_SYSCALL_MASK;
+    indices[count++] = MSR_KERNEL_GS_BASE;
+#endif
+    indices[count++] = MSR_TSC_AUX;
+    indices[count++] = MSR_IA32_TSC_DEADLINE;
+
+    return count;
+}
+
+/* Reads MSRs skipping the ones host KVM does not support.
+ * Returns the number of entries written to `entries`. */
+static uint32_t read_msrs(const uint32_t *indices, uint32_t count, struct kvm_msr_entry *entries)
+{
+    MsrList list;
+    uint32_t saved = 0;
+    uint32_t next = 0;
+
+    while(next < count) {
+        memset(&list, 0, sizeof(list));
+        for(uint32_t i = next; i < count; i++) {
+            list.entries[list.header.nmsrs++].index = indices[i];
+        }
+
+        int read = ioctl_with_retry(cpu->vcpu_fd, KVM_GET_MSRS, &list);
+        if(read < 0) {
+            kvm_runtime_abortf("KVM_GET_MSRS: %s", strerror(errno));
+            return saved;
+        }
+        memcpy(&entries[saved], list.entries, read * sizeof(struct kvm_msr_entry));
+        saved += read;
+
+        /* KVM stops at the first MSR it cannot read, skip it and continue with the rest */
+        next += read + 1;
+    }
+    return saved;
+}
+
+static void write_msrs(const struct kvm_msr_entry *entries, uint32_t count)
+{
+    MsrList list;
+    memset(&list, 0, sizeof(list));
+    list.header.nmsrs = count;
+    memcpy(list.entries, entries, count * sizeof(struct kvm_msr_entry));
+
+    int written = ioctl_with_retry(cpu->vcpu_fd, KVM_SET_MSRS, &list);
+    if(written < 0) {
+        kvm_runtime_abortf("KVM_SET_MSRS: %s", strerror(errno));
+    }
+    if(written < count) {
+        kvm_logf(LOG_LEVEL_WARNING, "Could not restore MSR 0x%x, %d out of %d MSRs restored", entries[written].index, written,
+                 count);
+    }
+}
+
+static void get_irqchip(uint32_t chip_id, struct kvm_irqchip *irqchip)
+{
+    memset(irqchip, 0, sizeof(*irqchip));
+    irqchip->chip_id = chip_id;
+    if(ioctl_with_retry(cpu->vm_fd, KVM_GET_IRQCHIP, irqchip) < 0) {
+        kvm_runtime_abortf("KVM_GET_IRQCHIP: %s", strerror(errno));
+    }
+}
+
+static void set_irqchip(struct kvm_irqchip *irqchip)
+{
+    if(ioctl_with_retry(cpu->vm_fd, KVM_SET_IRQCHIP, irqchip) < 0) {
+        kvm_runtime_abortf("KVM_SET_IRQCHIP: %s", strerror(errno));
+    }
+}
+
+static bool has_extension(int extension)
+{
+    return ioctl_with_retry(cpu->kvm_fd, KVM_CHECK_EXTENSION, extension) > 0;
+}
+
+static uint32_t count_breakpoints()
+{
+    uint32_t count = 0;
+    Breakpoint *bp;
+    LIST_FOREACH(bp, &cpu->breakpoints, list)
+    {
+        count++;
+    }
+    return count;
+}
+
+uint64_t kvm_get_state_size()
+{
+    return sizeof(Snapshot) + count_breakpoints() * sizeof(SnapshotBreakpoint);
+}
+EXC_VALUE_0(uint64_t, kvm_get_state_size, 0)
+
+/* Saves the VM state to the buffer of kvm_get_state_size() bytes pointed by `pointer` */
+void kvm_save_state(uint64_t pointer)
+{
+    if(cpu->is_executing) {
+        kvm_runtime_abortf("Cannot save KVM state while the CPU is running");
+    }
+
+    Snapshot *snapshot = (Snapshot *)pointer;
+    memset(snapshot, 0, sizeof(Snapshot));
+    snapshot->magic = SNAPSHOT_MAGIC;
+    snapshot->version = SNAPSHOT_VERSION;
+
+    /* Make sure registers modified from Renode are visible to KVM before reading them back */
+    kvm_registers_synchronize();
+
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_REGS, &snapshot->regs) < 0) {
+        kvm_runtime_abortf("KVM_GET_REGS: %s", strerror(errno));
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_SREGS, &snapshot->sregs) < 0) {
+        kvm_runtime_abortf("KVM_GET_SREGS: %s", strerror(errno));
+    }
+
+    snapshot->has_xsave = has_extension(KVM_CAP_XSAVE);
+    if(snapshot->has_xsave) {
+        if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_XSAVE, &snapshot->xsave) < 0) {
+            kvm_runtime_abortf("KVM_GET_XSAVE: %s", strerror(errno));
+        }
+    } else if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_FPU, &snapshot->fpu) < 0) {
+        kvm_runtime_abortf("KVM_GET_FPU: %s", strerror(errno));
+    }
+
+    snapshot->has_xcrs = has_extension(KVM_CAP_XCRS);
+    if(snapshot->has_xcrs && ioctl_with_retry(cpu->vcpu_fd, KVM_GET_XCRS, &snapshot->xcrs) < 0) {
+        kvm_runtime_abortf("KVM_GET_XCRS: %s", strerror(errno));
+    }
+
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_DEBUGREGS, &snapshot->debugregs) < 0) {
+        kvm_runtime_abortf("KVM_GET_DEBUGREGS: %s", strerror(errno));
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_VCPU_EVENTS, &snapshot->events) < 0) {
+        kvm_runtime_abortf("KVM_GET_VCPU_EVENTS: %s", strerror(errno));
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_MP_STATE, &snapshot->mp_state) < 0) {
+        kvm_runtime_abortf("KVM_GET_MP_STATE: %s", strerror(errno));
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_GET_LAPIC, &snapshot->lapic) < 0) {
+        kvm_runtime_abortf("KVM_GET_LAPIC: %s", strerror(errno));
+    }
+
+    get_irqchip(KVM_IRQCHIP_PIC_MASTER, &snapshot->pic_master);
+    get_irqchip(KVM_IRQCHIP_PIC_SLAVE, &snapshot->pic_slave);
+    get_irqchip(KVM_IRQCHIP_IOAPIC, &snapshot->ioapic);
+    if(ioctl_with_retry(cpu->vm_fd, KVM_GET_PIT2, &snapshot->pit) < 0) {
+        kvm_runtime_abortf("KVM_GET_PIT2: %s", strerror(errno));
+    }
+
+    uint32_t indices[SNAPSHOT_MAX_MSRS];
+    uint32_t count = get_saved_msr_indices(indices);
+    snapshot->msr_count = read_msrs(indices, count, snapshot->msrs);
+
+    uint32_t tsc_index = MSR_IA32_TSC;
+    struct kvm_msr_entry tsc;
+    if(read_msrs(&tsc_index, 1, &tsc) != 1) {
+        kvm_runtime_abortf("Could not read the guest TSC");
+    }
+    snapshot->guest_tsc = tsc.data;
+
+#ifdef TARGET_X86KVM
+    snapshot->on64BitDetected = cpu->on64BitDetected;
+#endif
+
+    memcpy(snapshot->hw_breakpoints, cpu->hw_breakpoints, sizeof(cpu->hw_breakpoints));
+
+    Breakpoint *bp;
+    LIST_FOREACH(bp, &cpu->breakpoints, list)
+    {
+        snapshot->breakpoints[snapshot->breakpoint_count++] = (SnapshotBreakpoint) { .pc = bp->pc, .code_byte = bp->code_byte };
+    }
+}
+EXC_VOID_1(kvm_save_state, uint64_t, pointer)
+
+static void restore_guest_tsc(uint64_t guest_tsc)
+{
+    if(cpu->cpu_supports_tsc_offset) {
+        /* Account the whole difference as missed ticks so that the offset applied on each KVM_RUN keeps it */
+        cpu->exit_host_tsc = __rdtsc();
+        cpu->missed_tsc_ticks = cpu->exit_host_tsc - guest_tsc;
+        set_guest_tsc_offset(-cpu->missed_tsc_ticks);
+    } else {
+        struct kvm_msr_entry tsc = { .index = MSR_IA32_TSC, .data = guest_tsc };
+        write_msrs(&tsc, 1);
+    }
+}
+
+/* Restores the VM state from a buffer previously filled by kvm_save_state.
+ * Guest memory has to be mapped before calling this function. */
+void kvm_restore_state(uint64_t pointer, uint64_t size)
+{
+    Snapshot *snapshot = (Snapshot *)pointer;
+    if(size < sizeof(Snapshot) || snapshot->magic != SNAPSHOT_MAGIC) {
+        kvm_abortf("Invalid KVM state");
+    }
+    if(snapshot->version != SNAPSHOT_VERSION) {
+        kvm_abortf("Unsupported KVM state version %u, expected %u", snapshot->version, SNAPSHOT_VERSION);
+    }
+    if(size != sizeof(Snapshot) + snapshot->breakpoint_count * sizeof(SnapshotBreakpoint)) {
+        kvm_abortf("Invalid KVM state size");
+    }
+
+    /* sregs go first, as they contain the APIC base required by the LAPIC state */
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_SREGS, &snapshot->sregs) < 0) {
+        kvm_abortf("KVM_SET_SREGS: %s", strerror(errno));
+    }
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_REGS, &snapshot->regs) < 0) {
+        kvm_abortf("KVM_SET_REGS: %s", strerror(errno));
+    }
+    kvm_registers_invalidate();
+    /* Guest page tables come from the restored memory */
+    translation_cache_flush();
+
+    if(snapshot->has_xsave) {
+        if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_XSAVE, &snapshot->xsave) < 0) {
+            kvm_abortf("KVM_SET_XSAVE: %s", strerror(errno));
+        }
+    } else if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_FPU, &snapshot->fpu) < 0) {
+        kvm_abortf("KVM_SET_FPU: %s", strerror(errno));
+    }
+    if(snapshot->has_xcrs && ioctl_with_retry(cpu->vcpu_fd, KVM_SET_XCRS, &snapshot->xcrs) < 0) {
+        kvm_abortf("KVM_SET_XCRS: %s", strerror(errno));
+    }
+
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_MP_STATE, &snapshot->mp_state) < 0) {
+        kvm_abortf("KVM_SET_MP_STATE: %s", strerror(errno));
+    }
+    /* LAPIC goes before the MSRs. KVM ignores MSR_IA32_TSC_DEADLINE unless the LAPIC timer is in the TSC-deadline mode,
+     * and KVM_SET_LAPIC cancels the timer, so the other order would lose a pending deadline */
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_LAPIC, &snapshot->lapic) < 0) {
+        kvm_abortf("KVM_SET_LAPIC: %s", strerror(errno));
+    }
+
+    /* TSC has to be restored before MSR_IA32_TSC_DEADLINE which is relative to it */
+    restore_guest_tsc(snapshot->guest_tsc);
+    write_msrs(snapshot->msrs, snapshot->msr_count);
+
+    /* Events are applied before every KVM_RUN, see restore_cpu_events */
+    cpu->events = snapshot->events;
+    cpu->restore_events = true;
+
+    if(ioctl_with_retry(cpu->vcpu_fd, KVM_SET_DEBUGREGS, &snapshot->debugregs) < 0) {
+        kvm_abortf("KVM_SET_DEBUGREGS: %s", strerror(errno));
+    }
+
+    set_irqchip(&snapshot->pic_master);
+    set_irqchip(&snapshot->pic_slave);
+    set_irqchip(&snapshot->ioapic);
+    if(ioctl_with_retry(cpu->vm_fd, KVM_SET_PIT2, &snapshot->pit) < 0) {
+        kvm_abortf("KVM_SET_PIT2: %s", strerror(errno));
+    }
+
+#ifdef TARGET_X86KVM
+    cpu->on64BitDetected = (Detected64BitBehaviour)snapshot->on64BitDetected;
+#endif
+
+    /* Breakpoints are translated using the restored page tables */
+    for(uint32_t i = 0; i < snapshot->breakpoint_count; i++) {
+        restore_breakpoint(snapshot->breakpoints[i].pc, snapshot->breakpoints[i].code_byte);
+    }
+    memcpy(cpu->hw_breakpoints, snapshot->hw_breakpoints, sizeof(cpu->hw_breakpoints));
+    set_default_debug_flags();
+}
+EXC_VOID_2(kvm_restore_state, uint64_t, pointer, uint64_t, size)
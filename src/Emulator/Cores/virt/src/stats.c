@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cpu.h"
+#include "stats.h"
+#include "utils.h"
+#include "unwind.h"
+
+void stats_run_entry(ExitStatistics *stats)
+{
+    if(!stats->enabled) {
+        return;
+    }
+
+    const uint64_t now = stats_timestamp_ns();
+    /* run_exit_ns is 0 on the first KVM_RUN of the execution loop, time between loops is not accounted */
+    if(stats->run_exit_ns != 0) {
+        stats->time_ns[STATS_TIME_USERSPACE] += now - stats->run_exit_ns;
+    }
+    stats->run_exit_ns = now;
+}
+
+void stats_run_exit(ExitStatistics *stats, bool interrupted, uint32_t exit_reason)
+{
+    if(!stats->enabled) {
+        return;
+    }
+
+    const uint64_t now = stats_timestamp_ns();
+    stats->time_ns[STATS_TIME_KVM_RUN] += now - stats->run_exit_ns;
+    stats->run_exit_ns = now;
+
+    if(interrupted) {
+        stats->interrupted_runs++;
+        return;
+    }
+
+    if(exit_reason >= STATS_EXIT_REASONS_COUNT) {
+        exit_reason = STATS_EXIT_REASONS_COUNT - 1;
+    }
+    stats->exits[exit_reason]++;
+}
+
+static void count_access(ExitStatistics *stats, StatsAccessType type, uint64_t address)
+{
+    AccessCounter *table = stats->accesses[type];
+    /* Fibonacci hashing with linear probing, addresses are never removed from the table */
+    uint32_t index = (uint32_t)((address * 0x9E3779B97F4A7C15ULL) >> 56) & (STATS_ADDRESSES_COUNT - 1);
+    for(int i = 0; i < STATS_ADDRESSES_COUNT; i++) {
+        AccessCounter *counter = &table[(index + i) & (STATS_ADDRESSES_COUNT - 1)];
+        if(counter->count == 0) {
+            counter->address = address;
+        }
+        if(counter->address == address) {
+            counter->count++;
+            return;
+        }
+    }
+    stats->untracked_accesses[type]++;
+}
+
+void stats_loop_entry(ExitStatistics *stats)
+{
+    stats->run_exit_ns = 0;
+}
+
+void stats_callback_entry(ExitStatistics *stats, StatsAccessType type, uint64_t address)
+{
+    if(!stats->enabled) {
+        return;
+    }
+
+    count_access(stats, type, address);
+    stats->callback_start_ns = stats_timestamp_ns();
+}
+
+void stats_callback_exit(ExitStatistics *stats)
+{
+    if(!stats->enabled) {
+        return;
+    }
+
+    const uint64_t elapsed = stats_timestamp_ns() - stats->callback_start_ns;
+    stats->time_ns[STATS_TIME_CALLBACKS] += elapsed;
+    /* Callbacks are executed outside of KVM_RUN, so they would be accounted as userspace time as well */
+    stats->time_ns[STATS_TIME_USERSPACE] -= elapsed;
+}
+
+void kvm_set_statistics_enabled(uint32_t enabled)
+{
+    cpu->stats.enabled = enabled;
+}
+EXC_VOID_1(kvm_set_statistics_enabled, uint32_t, enabled)
+
+void kvm_reset_statistics()
+{
+    bool enabled = cpu->stats.enabled;
+    memset(&cpu->stats, 0, sizeof(cpu->stats));
+    cpu->stats.enabled = enabled;
+}
+EXC_VOID_0(kvm_reset_statistics)
+
+uint64_t kvm_get_exit_count(uint32_t exit_reason)
+{
+    if(exit_reason >= STATS_EXIT_REASONS_COUNT) {
+        return 0;
+    }
+    return cpu->stats.exits[exit_reason];
+}
+EXC_VALUE_1(uint64_t, kvm_get_exit_count, 0, uint32_t, exit_reason)
+
+uint64_t kvm_get_interrupted_runs_count()
+{
+    return cpu->stats.interrupted_runs;
+}
+EXC_VALUE_0(uint64_t, kvm_get_interrupted_runs_count, 0)
+
+uint64_t kvm_get_time_statistic(uint32_t type)
+{
+    if(type >= STATS_TIME_TYPES_COUNT) {
+        kvm_runtime_abortf("Invalid time statistic type: %u", type);
+    }
+    return cpu->stats.time_ns[type];
+}
+EXC_VALUE_1(uint64_t, kvm_get_time_statistic, 0, uint32_t, type)
+
+uint32_t kvm_get_access_statistics(uint32_t type, uint64_t pointer, uint32_t max_count)
+{
+    if(type >= STATS_ACCESS_TYPES_COUNT) {
+        kvm_runtime_abortf("Invalid access statistic type: %u", type);
+    }
+
+    AccessCounter *buffer = (AccessCounter *)pointer;
+    uint32_t count = 0;
+    for(int i = 0; i < STATS_ADDRESSES_COUNT && count < max_count; i++) {
+        if(cpu->stats.accesses[type][i].count != 0) {
+            buffer[count++] = cpu->stats.accesses[type][i];
+        }
+    }
+    return count;
+}
+EXC_INT_3(uint32_t, kvm_get_access_statistics, uint32_t, type, uint64_t, pointer, uint32_t, max_count)
+
+uint64_t kvm_get_untracked_accesses_count(uint32_t type)
+{
+    if(type >= STATS_ACCESS_TYPES_COUNT) {
+        kvm_runtime_abortf("Invalid access statistic type: %u", type);
+    }
+    return cpu->stats.untracked_accesses[type];
+}
+EXC_VALUE_1(uint64_t, kvm_get_untracked_accesses_count, 0, uint32_t, type)
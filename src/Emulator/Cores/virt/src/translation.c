@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <errno.h>
+#include <linux/kvm.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/ioctl.h>
+
+#include "cpu.h"
+#include "memory_range.h"
+#include "registers.h"
+#include "translation.h"
+#include "utils.h"
+#include "unwind.h"
+
+/* Paging structures are described in Intel(R) 64 and IA-32 Architectures Software Developer’s Manual Volume 3 (4.3 - 4.5) */
+#define CR0_PG           (1ULL << 31)
+#define CR4_PSE          (1ULL << 4)
+#define CR4_PAE          (1ULL << 5)
+#define CR4_LA57         (1ULL << 12)
+#define EFER_LMA         (1ULL << 10)
+#define PTE_PRESENT      (1ULL << 0)
+#define PTE_PAGE_SIZE    (1ULL << 7)
+#define PAE_ADDRESS_MASK 0x000FFFFFFFFFF000ULL
+#define PAGE_OFFSET_MASK 0xFFFULL
+
+typedef enum {
+    WALK_OK,
+    WALK_NOT_PRESENT,
+    /* paging structures are not in the memory mapped to KVM */
+    WALK_NOT_IN_MEMORY,
+} WalkResult;
+
+static WalkResult read_guest_physical(uint64_t address, void *value, uint32_t size)
+{
+    uint64_t available;
+    void *host_address = kvm_translate_guest_physical_to_host(address, &available);
+    if(host_address == NULL || available < size) {
+        return WALK_NOT_IN_MEMORY;
+    }
+    memcpy(value, host_address, size);
+    return WALK_OK;
+}
+
+/* 32-bit paging, with 4 MiB pages if enabled in CR4 */
+static WalkResult walk_32bit(const struct kvm_sregs *sregs, uint32_t address, uint64_t *physical)
+{
+    uint32_t pde;
+    WalkResult result = read_guest_physical((sregs->cr3 & 0xFFFFF000) + ((address >> 22) & 0x3FF) * 4, &pde, sizeof(pde));
+    if(result != WALK_OK) {
+        return result;
+    }
+    if(!(pde & PTE_PRESENT)) {
+        return WALK_NOT_PRESENT;
+    }
+    if((pde & PTE_PAGE_SIZE) && (sregs->cr4 & CR4_PSE)) {
+        /* Bits 13-20 of the entry hold bits 32-39 of the page address */
+        *physical = (pde & 0xFFC00000) | ((uint64_t)((pde >> 13) & 0xFF) << 32) | (address & 0x3FFFFF);
+        return WALK_OK;
+    }
+
+    uint32_t pte;
+    result = read_guest_physical((pde & 0xFFFFF000) + ((address >> 12) & 0x3FF) * 4, &pte, sizeof(pte));
+    if(result != WALK_OK) {
+        return result;
+    }
+    if(!(pte & PTE_PRESENT)) {
+        return WALK_NOT_PRESENT;
+    }
+    *physical = (pte & 0xFFFFF000) | (address & PAGE_OFFSET_MASK);
+    return WALK_OK;
+}
+
+/* PAE, 4-level and 5-level paging, `levels` tables starting from the one pointed by `table` */
+static WalkResult walk_pae(uint64_t table, int levels, uint64_t address, uint64_t *physical)
+{
+    for(int level = levels; level > 0; level--) {
+        const int shift = 12 + 9 * (level - 1);
+        uint64_t entry;
+        WalkResult result = read_guest_physical((table & PAE_ADDRESS_MASK) + ((address >> shift) & 0x1FF) * 8, &entry, sizeof(entry));
+        if(result != WALK_OK) {
+            return result;
+        }
+        if(!(entry & PTE_PRESENT)) {
+            return WALK_NOT_PRESENT;
+        }
+        /* 1 GiB pages are mapped by PDPT entries and 2 MiB pages by page directory entries */
+        if(level > 1 && level <= 3 && (entry & PTE_PAGE_SIZE)) {
+            const uint64_t page_mask = (1ULL << shift) - 1;
+            *physical = (entry & PAE_ADDRESS_MASK & ~page_mask) | (address & page_mask);
+            return WALK_OK;
+        }
+        table = entry;
+    }
+    *physical = (table & PAE_ADDRESS_MASK) | (address & PAGE_OFFSET_MASK);
+    return WALK_OK;
+}
+
+static WalkResult walk_page_tables(const struct kvm_sregs *sregs, uint64_t address, uint64_t *physical)
+{
+    if(!(sregs->cr0 & CR0_PG)) {
+        *physical = address;
+        return WALK_OK;
+    }
+    if(sregs->efer & EFER_LMA) {
+        return walk_pae(sregs->cr3, (sregs->cr4 & CR4_LA57) ? 5 : 4, address, physical);
+    }
+    if(sregs->cr4 & CR4_PAE) {
+        uint64_t pdpte;
+        WalkResult result = read_guest_physical((sregs->cr3 & 0xFFFFFFE0) + ((address >> 30) & 0x3) * 8, &pdpte, sizeof(pdpte));
+        if(result != WALK_OK) {
+            return result;
+        }
+        if(!(pdpte & PTE_PRESENT)) {
+            return WALK_NOT_PRESENT;
+        }
+        return walk_pae(pdpte, 2, address, physical);
+    }
+    return walk_32bit(sregs, (uint32_t)address, physical);
+}
+
+static uint64_t translate_with_kvm(uint64_t address)
+{
+    struct kvm_translation address_translation = (struct kvm_translation) { .linear_address = address };
+
+    /* Currently 'KVM_TRANSLATE' is only supported on x86 cpus */
+    if(ioctl(cpu->vcpu_fd, KVM_TRANSLATE, &address_translation) < 0) {
+        kvm_logf(LOG_LEVEL_WARNING, "KVM_TRANSLATE: %s", strerror(errno));
+        return UINT64_MAX;
+    }
+    return address_translation.valid ? address_translation.physical_address : UINT64_MAX;
+}
+
+void translation_cache_flush()
+{
+    cpu->translation_cache.generation++;
+}
+
+void kvm_flush_translation_cache()
+{
+    translation_cache_flush();
+}
+EXC_VOID_0(kvm_flush_translation_cache)
+
+static void update_cache_tags(const struct kvm_sregs *sregs)
+{
+    TranslationCache *cache = &cpu->translation_cache;
+    if(cache->cr0 != sregs->cr0 || cache->cr3 != sregs->cr3 || cache->cr4 != sregs->cr4 || cache->efer != sregs->efer) {
+        translation_cache_flush();
+        cache->cr0 = sregs->cr0;
+        cache->cr3 = sregs->cr3;
+        cache->cr4 = sregs->cr4;
+        cache->efer = sregs->efer;
+    }
+}
+
+static uint64_t translate(const struct kvm_sregs *sregs, uint64_t address)
+{
+    TranslationCache *cache = &cpu->translation_cache;
+    const uint64_t virtual_page = address & ~PAGE_OFFSET_MASK;
+    TranslationCacheEntry *entry = &cache->entries[(virtual_page >> 12) % TRANSLATION_CACHE_SIZE];
+    if(entry->generation == cache->generation && entry->virtual_page == virtual_page) {
+        return entry->physical_page | (address & PAGE_OFFSET_MASK);
+    }
+
+    uint64_t physical;
+    switch(walk_page_tables(sregs, address, &physical)) {
+        case WALK_OK:
+            break;
+        case WALK_NOT_PRESENT:
+            return UINT64_MAX;
+        case WALK_NOT_IN_MEMORY:
+            physical = translate_with_kvm(address);
+            if(physical == UINT64_MAX) {
+                return UINT64_MAX;
+            }
+            break;
+    }
+
+    entry->virtual_page = virtual_page;
+    entry->physical_page = physical & ~PAGE_OFFSET_MASK;
+    entry->generation = cache->generation;
+    return physical;
+}
+
+uint64_t kvm_translate_guest_virtual_address(uint64_t address)
+{
+    const struct kvm_sregs *sregs = get_special_registers();
+    update_cache_tags(sregs);
+    return translate(sregs, address);
+}
+EXC_VALUE_1(uint64_t, kvm_translate_guest_virtual_address, 0, uint64_t, address)
+
+uint32_t kvm_translate_guest_virtual_range(uint64_t address, uint64_t size, uint64_t pointer, uint32_t max_count)
+{
+    uint64_t *physical_addresses = (uint64_t *)pointer;
+    if(size == 0) {
+        return 0;
+    }
+
+    const struct kvm_sregs *sregs = get_special_registers();
+    update_cache_tags(sregs);
+
+    /* The range is clamped at the end of the address space */
+    const uint64_t last_address = size - 1 > UINT64_MAX - address ? UINT64_MAX : address + size - 1;
+    const uint64_t last_page = last_address & ~PAGE_OFFSET_MASK;
+    uint64_t current = address;
+    uint32_t count = 0;
+    while(count < max_count) {
+        physical_addresses[count++] = translate(sregs, current);
+        if((current & ~PAGE_OFFSET_MASK) == last_page) {
+            break;
+        }
+        current = (current & ~PAGE_OFFSET_MASK) + KVM_PAGE_SIZE;
+    }
+    return count;
+}
+EXC_VALUE_4(uint32_t, kvm_translate_guest_virtual_range, 0, uint64_t, address, uint64_t, size, uint64_t, pointer, uint32_t, max_count)
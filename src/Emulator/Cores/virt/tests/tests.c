@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2010-2026 Antmicro
+ *
+ * This file is licensed under the MIT License.
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+
+#include "callbacks.h"
+#include "cpu.h"
+#include "fake_kvm.h"
+#include "snapshot.h"
+#include "utils.h"
+
+/* Exported by the library, not declared in its headers as they are only bound from C# */
+void kvm_init();
+uint64_t kvm_execute(uint64_t time_in_us);
+void kvm_dispose();
+void kvm_set_virtual_tsc(uint32_t enabled);
+void kvm_synchronize_virtual_tsc(uint64_t guest_tsc, uint64_t tsc_khz);
+void kvm_set_halt_detection(uint32_t enabled);
+
+/* Long enough for the quantum to always end with the scripted EINTR, not the timer */
+#define QUANTUM_US 10000000
+
+#define BLOCK_BUFFER_SIZE 4096
+
+#define MSR_IA32_TSC_DEADLINE      0x6e0
+#define APIC_LVTT                  0x320
+#define APIC_LVT_TIMER_TSCDEADLINE (2 << 17)
+
+static int failures;
+
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if(!(condition)) {                                                                \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            failures++;                                                                   \
+        }                                                                                 \
+    } while(0)
+
+/* Stub callbacks, standing in for the ones bound from C#, record the calls */
+
+static struct {
+    uint64_t single_accesses;
+    uint64_t read_blocks;
+    uint64_t write_blocks;
+    uint16_t port;
+    uint32_t width;
+    uint32_t count;
+    uint8_t data[BLOCK_BUFFER_SIZE];
+} port_io;
+
+static void reset_port_io()
+{
+    memset(&port_io, 0, sizeof(port_io));
+}
+
+void kvm_log(int level, char *message)
+{
+    if(level >= LOG_LEVEL_WARNING) {
+        fprintf(stderr, "[%d] %s\n", level, message);
+    }
+}
+
+void kvm_abort(char *message)
+{
+    fprintf(stderr, "Abort: %s\n", message);
+    exit(EXIT_FAILURE);
+}
+
+void kvm_runtime_abort(char *message, uint64_t pc)
+{
+    fprintf(stderr, "Runtime abort at 0x%" PRIx64 ": %s\n", pc, message);
+    exit(EXIT_FAILURE);
+}
+
+uint32_t kvm_io_port_read_byte(uint16_t address)
+{
+    port_io.single_accesses++;
+    return 0;
+}
+
+void kvm_io_port_write_byte(uint16_t address, uint32_t value)
+{
+    port_io.single_accesses++;
+}
+
+void kvm_io_port_read_block(uint16_t address, uint32_t width, uint32_t count, void *buffer)
+{
+    port_io.read_blocks++;
+    port_io.port = address;
+    port_io.width = width;
+    port_io.count = count;
+    /* Data returned to the guest counts down, so that it can't be confused with the string outs of the fake KVM */
+    for(uint32_t i = 0; i < width * count; i++) {
+        ((uint8_t *)buffer)[i] = (uint8_t)(0xFF - i);
+    }
+}
+
+void kvm_io_port_write_block(uint16_t address, uint32_t width, uint32_t count, void *buffer)
+{
+    port_io.write_blocks++;
+    port_io.port = address;
+    port_io.width = width;
+    port_io.count = count;
+    memcpy(port_io.data, buffer, width * count);
+}
+
+static void run_exit(const FakeExit *exit)
+{
+    fake_kvm_set_script(exit, 1, 1);
+    kvm_execute(QUANTUM_US);
+    CHECK(fake_kvm_get_exits_count() == 1);
+}
+
+static void test_string_out_is_passed_as_one_block()
+{
+    const FakeExit exit = { FAKE_EXIT_IO_OUT, 0x1F0, 2, 0x10, 256 };
+    reset_port_io();
+    run_exit(&exit);
+
+    CHECK(port_io.write_blocks == 1);
+    CHECK(port_io.read_blocks == 0);
+    CHECK(port_io.single_accesses == 0);
+    CHECK(port_io.port == 0x1F0);
+    CHECK(port_io.width == 2);
+    CHECK(port_io.count == 256);
+    for(uint32_t i = 0; i < 2 * 256; i++) {
+        CHECK(port_io.data[i] == (uint8_t)(0x10 + i));
+    }
+}
+
+static void test_string_in_is_passed_as_one_block()
+{
+    const FakeExit exit = { FAKE_EXIT_IO_IN, 0x1F0, 4, 0, 16 };
+    reset_port_io();
+    run_exit(&exit);
+
+    CHECK(port_io.read_blocks == 1);
+    CHECK(port_io.write_blocks == 0);
+    CHECK(port_io.single_accesses == 0);
+    CHECK(port_io.port == 0x1F0);
+    CHECK(port_io.width == 4);
+    CHECK(port_io.count == 16);
+    /* The block has to reach the exit buffer read back by the fake KVM */
+    const uint8_t *data = fake_kvm_get_last_read_data();
+    for(uint32_t i = 0; i < 4 * 16; i++) {
+        CHECK(data[i] == (uint8_t)(0xFF - i));
+    }
+}
+
+static void test_single_io_is_not_passed_as_block()
+{
+    const FakeExit exits[] = {
+        { FAKE_EXIT_IO_OUT, 0x3F8, 1, 0x41, 1 },
+        { FAKE_EXIT_IO_IN, 0x3F8, 1, 0, 1 },
+    };
+    for(size_t i = 0; i < sizeof(exits) / sizeof(exits[0]); i++) {
+        reset_port_io();
+        run_exit(&exits[i]);
+        CHECK(port_io.single_accesses == 1);
+        CHECK(port_io.read_blocks + port_io.write_blocks == 0);
+    }
+}
+
+static void set_tsc_deadline(uint64_t deadline)
+{
+    struct {
+        struct kvm_msrs header;
+        struct kvm_msr_entry entry;
+    } msrs = { .header.nmsrs = 1, .entry = { .index = MSR_IA32_TSC_DEADLINE, .data = deadline } };
+    CHECK(ioctl(cpu->vcpu_fd, KVM_SET_MSRS, &msrs) == 1);
+}
+
+static uint64_t get_tsc_deadline()
+{
+    struct {
+        struct kvm_msrs header;
+        struct kvm_msr_entry entry;
+    } msrs = { .header.nmsrs = 1, .entry = { .index = MSR_IA32_TSC_DEADLINE } };
+    CHECK(ioctl(cpu->vcpu_fd, KVM_GET_MSRS, &msrs) == 1);
+    return msrs.entry.data;
+}
+
+static uint32_t get_lapic_timer()
+{
+    struct kvm_lapic_state lapic;
+    CHECK(ioctl(cpu->vcpu_fd, KVM_GET_LAPIC, &lapic) == 0);
+    uint32_t lvtt;
+    memcpy(&lvtt, &lapic.regs[APIC_LVTT], sizeof(lvtt));
+    return lvtt;
+}
+
+static void test_restore_keeps_armed_tsc_deadline()
+{
+    const uint32_t lvtt = APIC_LVT_TIMER_TSCDEADLINE | 0xEC;
+    const uint64_t deadline = 0x123456789ABULL;
+
+    /* The guest switches the LAPIC timer to the TSC-deadline mode and arms it */
+    struct kvm_lapic_state lapic = { 0 };
+    memcpy(&lapic.regs[APIC_LVTT], &lvtt, sizeof(lvtt));
+    CHECK(ioctl(cpu->vcpu_fd, KVM_SET_LAPIC, &lapic) == 0);
+    set_tsc_deadline(deadline);
+    CHECK(get_tsc_deadline() == deadline);
+
+    const uint64_t size = kvm_get_state_size();
+    void *state = malloc(size);
+    kvm_save_state((uint64_t)state);
+
+    /* Restore into a new VM, as done when loading a snapshot */
+    kvm_dispose();
+    kvm_init();
+    CHECK(get_tsc_deadline() == 0);
+    kvm_restore_state((uint64_t)state, size);
+    free(state);
+
+    CHECK(get_lapic_timer() == lvtt);
+    CHECK(get_tsc_deadline() == deadline);
+}
+
+static void test_virtual_tsc_is_synchronized_at_quantum_boundaries()
+{
+    const uint64_t tsc_khz = 250000;
+    const uint64_t quanta = 10;
+    /* The virtual time moves by much more than the host time during each quantum */
+    const uint64_t quantum_ticks = 1000000000;
+
+    kvm_set_virtual_tsc(true);
+    const FakeExit exit = { FAKE_EXIT_MMIO_WRITE, 0xF0000000, 4, 0, 1 };
+    fake_kvm_set_script(&exit, 1, 100);
+
+    const uint64_t tsc_offset_writes = fake_kvm_get_ioctl_count(KVM_SET_DEVICE_ATTR);
+    const uint64_t tsc_khz_writes = fake_kvm_get_ioctl_count(KVM_SET_TSC_KHZ);
+    const uint64_t msr_reads = fake_kvm_get_ioctl_count(KVM_GET_MSRS);
+
+    uint64_t virtual_tsc = fake_kvm_get_guest_tsc();
+    uint64_t guest_tsc = 0;
+    for(uint64_t i = 0; i < quanta; i++) {
+        virtual_tsc += quantum_ticks;
+        kvm_synchronize_virtual_tsc(virtual_tsc, tsc_khz);
+        /* The guest TSC is moved forward to the virtual time, not beyond it */
+        guest_tsc = fake_kvm_get_guest_tsc();
+        CHECK(guest_tsc >= virtual_tsc && guest_tsc - virtual_tsc < quantum_ticks / 10);
+        kvm_execute(QUANTUM_US);
+    }
+
+    /* The offset is reprogrammed once per quantum, not before every KVM_RUN, and the guest TSC is never read back */
+    CHECK(fake_kvm_get_ioctl_count(KVM_SET_DEVICE_ATTR) - tsc_offset_writes == quanta);
+    CHECK(fake_kvm_get_ioctl_count(KVM_SET_TSC_KHZ) - tsc_khz_writes == 1);
+    CHECK(fake_kvm_get_ioctl_count(KVM_GET_MSRS) - msr_reads == 0);
+    CHECK(fake_kvm_get_exits_count() == quanta * 100);
+
+    /* The guest TSC that is ahead of the virtual time waits for it, instead of moving backwards */
+    kvm_synchronize_virtual_tsc(virtual_tsc - quantum_ticks, tsc_khz);
+    CHECK(fake_kvm_get_guest_tsc() >= guest_tsc);
+
+    kvm_set_virtual_tsc(false);
+}
+
+static uint64_t elapsed_us(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000 + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/* The limits leave a margin for the timer and scheduling latency, but are well below the longest halt check interval */
+#define HALT_DETECTION_LATENCY_US 500
+#define QUANTUM_OVERRUN_US        400
+
+static void test_halted_guest_ends_quantum_early()
+{
+    kvm_set_halt_detection(true);
+    fake_kvm_set_idle_guest(true);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(kvm_execute(QUANTUM_US) == WAITING_FOR_INTERRUPT);
+    CHECK(elapsed_us(&start) < HALT_DETECTION_LATENCY_US);
+
+    kvm_set_halt_detection(false);
+}
+
+static void test_halt_detection_does_not_extend_quantum()
+{
+    const uint64_t quantum_us = 2500;
+    kvm_set_halt_detection(true);
+    fake_kvm_set_idle_guest(false);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(kvm_execute(quantum_us) == OK);
+    const uint64_t elapsed = elapsed_us(&start);
+    CHECK(elapsed >= quantum_us && elapsed < quantum_us + QUANTUM_OVERRUN_US);
+
+    kvm_set_halt_detection(false);
+}
+
+#define RUN_TEST(test)                                                              \
+    do {                                                                            \
+        const int failures_before = failures;                                       \
+        test();                                                                     \
+        printf("%-60s %s\n", #test, failures == failures_before ? "OK" : "FAILED"); \
+    } while(0)
+
+/* Exit handling tests, run against the fake KVM from benchmark/fake_kvm.c */
+int main()
+{
+    kvm_init();
+
+    RUN_TEST(test_string_out_is_passed_as_one_block);
+    RUN_TEST(test_string_in_is_passed_as_one_block);
+    RUN_TEST(test_single_io_is_not_passed_as_block);
+    RUN_TEST(test_restore_keeps_armed_tsc_deadline);
+    RUN_TEST(test_virtual_tsc_is_synchronized_at_quantum_boundaries);
+    RUN_TEST(test_halted_guest_ends_quantum_early);
+    RUN_TEST(test_halt_detection_does_not_extend_quantum);
+
+    kvm_dispose();
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -7,6 +7,7 @@
 using System.Text;
 
 using Antmicro.Renode.Exceptions;
+using Antmicro.Renode.Peripherals.CPU;
 
 using Endianess = ELFSharp.ELF.Endianess;
 
@@ -61,7 +62,15 @@ public ReadMemoryCommand(CommandsManager manager) : base(manager)
                         data = BytesFromValue(val, access.Length);
                         break;
                     default:
-                        data = manager.Machine.SystemBus.ReadBytes(access.Address, (int)access.Length, context: manager.Cpu);
+                        if(manager.Cpu is ICPUWithGuestMemoryAccess guestMemoryCpu)
+                        {
+                            data = new byte[access.Length];
+                            guestMemoryCpu.ReadGuestMemory(access.Address, data, 0, data.Length);
+                        }
+                        else
+                        {
+                            data = manager.Machine.SystemBus.ReadBytes(access.Address, (int)access.Length, context: manager.Cpu);
+                        }
                         break;
                     }
                 }
@@ -5,6 +5,7 @@
 // Full license text is available in 'licenses/MIT.txt'.
 //
 using Antmicro.Renode.Logging;
+using Antmicro.Renode.Peripherals.CPU;
 
 using Endianess = ELFSharp.ELF.Endianess;
 
@@ -72,7 +73,14 @@ private PacketData WriteData(ulong address, byte[] data)
                     manager.Machine.SystemBus.WriteQuadWord(access.Address, (ulong)val, context: manager.Cpu);
                     break;
                 default:
-                    manager.Machine.SystemBus.WriteBytes(data, access.Address, startingIndex, (long)access.Length, context: manager.Cpu);
+                    if(manager.Cpu is ICPUWithGuestMemoryAccess guestMemoryCpu)
+                    {
+                        guestMemoryCpu.WriteGuestMemory(access.Address, data, startingIndex, (int)access.Length);
+                    }
+                    else
+                    {
+                        manager.Machine.SystemBus.WriteBytes(data, access.Address, startingIndex, (long)access.Length, context: manager.Cpu);
+                    }
                     break;
                 }
                 startingIndex += (int)access.Length;
@@ -72,7 +72,7 @@ protected void Execute(CompiledCode code, Action<string> errorCallback)
             }
             catch(Exception e)
             {
-                if(e is UnboundNameException || e is MissingMemberException || e is ArithmeticException)
+                if(IsScriptError(e))
                 {
                     errorCallback?.Invoke(e.Message);
                 }
@@ -83,6 +83,23 @@ protected void Execute(CompiledCode code, Action<string> errorCallback)
             }
         }
 
+        // Calls a function defined by the script, which is cheaper than executing the whole script again
+        protected void Execute<T>(Action<T> function, T argument)
+        {
+            try
+            {
+                function(argument);
+            }
+            catch(Exception e)
+            {
+                if(IsScriptError(e))
+                {
+                    throw new RecoverableException($"Python runtime error: {e.Message}");
+                }
+                throw;
+            }
+        }
+
         protected virtual string[] ReservedVariables
         {
             get
@@ -140,6 +157,11 @@ private static ScriptEngine CreateEngine()
             return engine;
         }
 
+        private static bool IsScriptError(Exception e)
+        {
+            return e is UnboundNameException || e is MissingMemberException || e is ArithmeticException;
+        }
+
         private void InnerInit()
         {
             Scope = Engine.CreateScope();
@@ -7,7 +7,10 @@
 //
 using System;
 using System.Collections.Generic;
+using System.Linq;
+using System.Numerics;
 
+using Antmicro.Migrant;
 using Antmicro.Renode.Exceptions;
 using Antmicro.Renode.Logging;
 using Antmicro.Renode.Peripherals;
@@ -191,9 +194,16 @@ public T Read(long offset)
         /// <param name="result">Read value.</param>
         public bool TryRead(long offset, out T result)
         {
-            if(beforeReadHooks.TryGetValue(offset, out var beforeReadHook))
+            var entry = GetDispatchTable().Find(offset);
+            if(entry == null)
             {
-                var hookOutput = beforeReadHook(offset);
+                result = default(T);
+                return false;
+            }
+
+            if(entry.BeforeReadHook != null)
+            {
+                var hookOutput = entry.BeforeReadHook(offset);
                 if(hookOutput != null)
                 {
                     result = (T)hookOutput;
@@ -202,14 +212,14 @@ public bool TryRead(long offset, out T result)
             }
 
             T? output = null;
-            if(registers.TryGetValue(offset, out var register))
+            if(entry.Register != null)
             {
-                output = register.Read();
+                output = entry.Register.Read();
             }
 
-            if(afterReadHooks.TryGetValue(offset, out var afterReadHook))
+            if(entry.AfterReadHook != null)
             {
-                var hookOutput = afterReadHook(offset, output ?? default(T));
+                var hookOutput = entry.AfterReadHook(offset, output ?? default(T));
                 if(hookOutput != null)
                 {
                     output = hookOutput;
@@ -241,24 +251,22 @@ public void Write(long offset, T value)
         /// <param name="value">Value to write.</param>
         public bool TryWrite(long offset, T value)
         {
-            if(registers.TryGetValue(offset, out var register))
+            var entry = GetDispatchTable().Find(offset);
+            if(entry?.Register == null)
             {
-                if(beforeWriteHooks.TryGetValue(offset, out var beforeWriteHook))
-                {
-                    var hookOutput = beforeWriteHook(offset, value);
-                    value = hookOutput ?? value;
-                }
+                return false;
+            }
 
-                register.Write(offset, value);
+            if(entry.BeforeWriteHook != null)
+            {
+                var hookOutput = entry.BeforeWriteHook(offset, value);
+                value = hookOutput ?? value;
+            }
 
-                if(afterWriteHooks.TryGetValue(offset, out var afterWriteHook))
-                {
-                    afterWriteHook(offset, value);
-                }
+            entry.Register.Write(offset, value);
 
-                return true;
-            }
-            return false;
+            entry.AfterWriteHook?.Invoke(offset, value);
+            return true;
         }
 
         /// <summary>
@@ -320,6 +328,7 @@ public void AddBeforeReadHook(long offset, Func<long, T?> hook)
                 throw new RecoverableException($"Before-read hook for 0x{offset:X} is already registered");
             }
             beforeReadHooks.Add(offset, hook);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -338,6 +347,7 @@ public void AddAfterReadHook(long offset, Func<long, T, T?> hook)
                 throw new RecoverableException($"After-read hook for 0x{offset:X} is already registered");
             }
             afterReadHooks.Add(offset, hook);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -356,6 +366,7 @@ public void AddBeforeWriteHook(long offset, Func<long, T, T?> hook)
                 throw new RecoverableException($"Before-write hook for 0x{offset:X} is already registered");
             }
             beforeWriteHooks.Add(offset, hook);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -372,6 +383,7 @@ public void AddAfterWriteHook(long offset, Action<long, T> hook)
                 throw new RecoverableException($"After-write hook for 0x{offset:X} is already registered");
             }
             afterWriteHooks.Add(offset, hook);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -385,6 +397,7 @@ public void RemoveBeforeReadHook(long offset)
                 throw new RecoverableException("Before-read hook for 0x{0:X} doesn't exist");
             }
             beforeReadHooks.Remove(offset);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -398,6 +411,7 @@ public void RemoveAfterReadHook(long offset)
                 throw new RecoverableException("After-read hook for 0x{0:X} doesn't exist");
             }
             afterReadHooks.Remove(offset);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -411,6 +425,7 @@ public void RemoveBeforeWriteHook(long offset)
                 throw new RecoverableException("Before-write hook for 0x{0:X} doesn't exist");
             }
             beforeWriteHooks.Remove(offset);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -424,6 +439,7 @@ public void RemoveAfterWriteHook(long offset)
                 throw new RecoverableException("After-write hook for 0x{0:X} doesn't exist");
             }
             afterWriteHooks.Remove(offset);
+            InvalidateDispatchTable();
         }
 
         /// <summary>
@@ -508,8 +524,23 @@ private void AddRegisterInner(long offset, R register, Func<bool> condition = nu
             {
                 throw new ConstructionException($"At offset 0x{offset:x}: {e.Message}", e);
             }
+            InvalidateDispatchTable();
+        }
+
+        private DispatchTable GetDispatchTable()
+        {
+            return dispatchTable ?? (dispatchTable = new DispatchTable(this));
+        }
+
+        private void InvalidateDispatchTable()
+        {
+            dispatchTable = null;
         }
 
+        // Built on the first access after registers or hooks change, it is not serialized
+        [Transient]
+        private DispatchTable dispatchTable;
+
         private readonly IPeripheral parent;
         private readonly IDictionary<long, RegisterSelector<T>> registers;
 
@@ -517,6 +548,107 @@ private void AddRegisterInner(long offset, R register, Func<bool> condition = nu
         private readonly IDictionary<long, Func<long, T, T?>> afterReadHooks;
         private readonly IDictionary<long, Func<long, T, T?>> beforeWriteHooks;
         private readonly IDictionary<long, Action<long, T>> afterWriteHooks;
+
+        // Gathers the register and the hooks of each offset, so that an access takes a single lookup. If the offsets are dense enough,
+        // the lookup is indexing an array with the offset relative to the first one, divided by the largest power of two dividing them all.
+        private sealed class DispatchTable
+        {
+            public DispatchTable(BaseRegisterCollection<T, R> collection)
+            {
+                var entries = new Dictionary<long, Entry>();
+                Entry GetEntry(long offset)
+                {
+                    if(!entries.TryGetValue(offset, out var entry))
+                    {
+                        entry = new Entry();
+                        entries.Add(offset, entry);
+                    }
+                    return entry;
+                }
+
+                foreach(var pair in collection.registers)
+                {
+                    GetEntry(pair.Key).Register = pair.Value;
+                }
+                foreach(var pair in collection.beforeReadHooks)
+                {
+                    GetEntry(pair.Key).BeforeReadHook = pair.Value;
+                }
+                foreach(var pair in collection.afterReadHooks)
+                {
+                    GetEntry(pair.Key).AfterReadHook = pair.Value;
+                }
+                foreach(var pair in collection.beforeWriteHooks)
+                {
+                    GetEntry(pair.Key).BeforeWriteHook = pair.Value;
+                }
+                foreach(var pair in collection.afterWriteHooks)
+                {
+                    GetEntry(pair.Key).AfterWriteHook = pair.Value;
+                }
+
+                sparseEntries = entries;
+                if(entries.Count == 0)
+                {
+                    return;
+                }
+
+                var first = entries.Keys.Min();
+                var span = (ulong)(entries.Keys.Max() - first);
+                var differences = entries.Keys.Aggregate(0UL, (result, offset) => result | (ulong)(offset - first));
+                var shift = differences == 0 ? 0 : BitOperations.TrailingZeroCount(differences);
+                var size = (span >> shift) + 1;
+                if(size > (ulong)Math.Min(MaximumDenseSize, Math.Max(MinimumDenseSize, (long)entries.Count * MaximumDenseSizePerEntry)))
+                {
+                    return;
+                }
+
+                denseEntries = new Entry[size];
+                foreach(var pair in entries)
+                {
+                    denseEntries[(ulong)(pair.Key - first) >> shift] = pair.Value;
+                }
+                firstOffset = first;
+                offsetShift = shift;
+                sparseEntries = null;
+            }
+
+            public Entry Find(long offset)
+            {
+                if(denseEntries == null)
+                {
+                    sparseEntries.TryGetValue(offset, out var entry);
+                    return entry;
+                }
+
+                // Offsets below the first one wrap around and land above the table
+                var relativeOffset = (ulong)(offset - firstOffset);
+                var index = relativeOffset >> offsetShift;
+                if(index >= (ulong)denseEntries.Length || (index << offsetShift) != relativeOffset)
+                {
+                    return null;
+                }
+                return denseEntries[index];
+            }
+
+            private readonly Entry[] denseEntries;
+            private readonly Dictionary<long, Entry> sparseEntries;
+            private readonly long firstOffset;
+            private readonly int offsetShift;
+
+            private const long MinimumDenseSize = 256;
+            private const long MaximumDenseSize = 65536;
+            private const long MaximumDenseSizePerEntry = 8;
+        }
+
+        private sealed class Entry
+        {
+            public RegisterSelector<T> Register;
+            public Func<long, T?> BeforeReadHook;
+            public Func<long, T, T?> AfterReadHook;
+            public Func<long, T, T?> BeforeWriteHook;
+            public Action<long, T> AfterWriteHook;
+        }
     }
 
     public interface IRegisterCollection
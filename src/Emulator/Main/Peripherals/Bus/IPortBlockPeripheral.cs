@@ -0,0 +1,18 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+
+namespace Antmicro.Renode.Peripherals.Bus
+{
+    // Implemented by peripherals that can service x86 string I/O (`rep ins`/`rep outs`) in one call.
+    // `data` holds `count` consecutive elements of `width` bytes each, in little-endian order.
+    public interface IPortBlockPeripheral : IBusPeripheral
+    {
+        void ReadPortBlock(long offset, SysbusAccessWidth width, byte[] data, int count);
+
+        void WritePortBlock(long offset, SysbusAccessWidth width, byte[] data, int count);
+    }
+}
@@ -39,7 +39,7 @@ internal PeripheralCollection(SystemBus sysbus)
                 blocks = new Block[0];
                 shortBlocks = new Dictionary<ulong, Block>();
                 sync = new ReaderWriterLockSlim(LockRecursionPolicy.SupportsRecursion);
-                InvalidateLastBlock();
+                InitAccessCache();
                 RefreshPeripheralsCache();
             }
 
@@ -138,7 +138,7 @@ public void Move(IBusRegistered<IBusPeripheral> registeredPeripheral, BusRangeRe
                             shortBlocks.Remove(keyToRemove);
                         }
                     }
-                    InvalidateLastBlock();
+                    InvalidateAccessCache();
 
                     var newStart = newRegistration.StartingPoint;
                     var size = newRegistration.Range.Size;
@@ -164,7 +164,7 @@ public void Remove(IPeripheral peripheral)
                     {
                         shortBlocks.Remove(keyToRemove);
                     }
-                    InvalidateLastBlock();
+                    InvalidateAccessCache();
                     RefreshPeripheralsCache();
                 }
                 finally
@@ -184,7 +184,7 @@ public void Remove(ulong start, ulong end)
                     {
                         shortBlocks.Remove(keyToRemove);
                     }
-                    InvalidateLastBlock();
+                    InvalidateAccessCache();
                     RefreshPeripheralsCache();
                 }
                 finally
@@ -217,7 +217,7 @@ public void VisitAccessMethods(IBusPeripheral peripheral, Func<PeripheralAccessM
                         block.AccessMethods = onPam(block.AccessMethods);
                         return new KeyValuePair<ulong, Block>(dEntry.Key, block);
                     }).ToDictionary(x => x.Key, x => x.Value);
-                    InvalidateLastBlock();
+                    InvalidateAccessCache();
                     RefreshPeripheralsCache();
                 }
                 finally
@@ -228,23 +228,32 @@ public void VisitAccessMethods(IBusPeripheral peripheral, Func<PeripheralAccessM
 
             public PeripheralAccessMethods FindAccessMethods(ulong address, out ulong startAddress, out ulong endAddress, out ulong offset)
             {
-                // no need to lock here yet, cause last block is in the thread local storage
-                var lastBlock = lastBlockStorage.Value;
+                // no need to lock here yet, cause the access cache is in the thread local storage
+                // and its entries are validated with the generation of the collection
+                var accessCache = accessCacheStorage.Value;
+                if(accessCache == null)
+                {
+                    accessCache = new AccessCacheEntry[AccessCacheSize];
+                    accessCacheStorage.Value = accessCache;
+                }
+                var page = address >> PageShift;
+                ref var entry = ref accessCache[GetAccessCacheIndex(page)];
+                var generation = Volatile.Read(ref accessCacheGeneration);
 #if DEBUG
                 Interlocked.Increment(ref queryCount);
 #endif
                 /// Note `< End` - End is currently one past the end in reality. Please also change <see cref="ICoalescable{T}.Coalesce"> after changing this.
-                if(address >= lastBlock.Start && address < lastBlock.End)
+                if(entry.Generation == generation && entry.Page == page && address >= entry.Block.Start && address < entry.Block.End)
                 {
 #if DEBUG
-                    Interlocked.Increment(ref lastPeripheralCount);
+                    Interlocked.Increment(ref accessCacheCount);
 #endif
-                    startAddress = lastBlock.Start;
-                    endAddress = lastBlock.End;
-                    offset = lastBlock.Peripheral.RegistrationPoint.Offset;
-                    return lastBlock.AccessMethods;
+                    startAddress = entry.Block.Start;
+                    endAddress = entry.Block.End;
+                    offset = entry.Offset;
+                    return entry.Block.AccessMethods;
                 }
-                sync.EnterWriteLock();
+                sync.EnterReadLock();
                 try
                 {
                     // let's try dictionary
@@ -274,23 +283,24 @@ public PeripheralAccessMethods FindAccessMethods(ulong address, out ulong startA
                     startAddress = block.Start;
                     endAddress = block.End;
                     offset = block.Peripheral.RegistrationPoint.Offset;
-                    lastBlockStorage.Value = block;
+                    // The generation can't change while the lock is held, but it could have changed before it was taken
+                    entry = new AccessCacheEntry { Page = page, Generation = accessCacheGeneration, Offset = offset, Block = block };
                     return block.AccessMethods;
                 }
                 finally
                 {
-                    sync.ExitWriteLock();
+                    sync.ExitReadLock();
                 }
             }
 
 #if DEBUG
             public void ShowStatistics()
             {
-                var misses = queryCount - lastPeripheralCount - dictionaryCount - binarySearchCount;
+                var misses = queryCount - accessCacheCount - dictionaryCount - binarySearchCount;
                 var line = new StringBuilder("\n  Memory queries statistics are as follows:");
                 if(queryCount > 0)
                 {
-                    line.AppendFormat("\tConsecutive hits:   {0:00.00} ({1})\n", 100.0 * lastPeripheralCount / queryCount, lastPeripheralCount)
+                    line.AppendFormat("\tAccess cache hits:  {0:00.00} ({1})\n", 100.0 * accessCacheCount / queryCount, accessCacheCount)
                         .AppendFormat("\tDictionary hits:    {0:00.00} ({1})\n", 100.0 * dictionaryCount / queryCount, dictionaryCount)
                         .AppendFormat("\tBinary search:      {0:00.00} ({1})\n", 100.0 * binarySearchCount / queryCount, binarySearchCount)
                         .AppendFormat("\tMisses:             {0:00.00} ({1})", 100.0 * misses / queryCount, misses);
@@ -305,6 +315,7 @@ public void ShowStatistics()
 
             public void Dispose()
             {
+                accessCacheStorage.Dispose();
                 sync.Dispose();
             }
 
@@ -361,16 +372,36 @@ private int BinarySearch(ulong offset)
                 return -1;
             }
 
-            private void InvalidateLastBlock()
+            // Each thread, i.e. each CPU, has its own direct-mapped table of recently accessed pages.
+            // Bumping the generation invalidates all of them at once, without reallocating.
+            private void InitAccessCache()
+            {
+                accessCacheStorage = new ThreadLocal<AccessCacheEntry[]>();
+                // Entries of the new tables are zeroed, so they must never match
+                accessCacheGeneration = 1;
+            }
+
+            private void InvalidateAccessCache()
             {
-                lastBlockStorage = new ThreadLocal<Block>();
+                Interlocked.Increment(ref accessCacheGeneration);
+            }
+
+            // The higher bits of the page number are folded into the index, so that peripherals
+            // placed at a power-of-two stride don't all end up in the same few entries
+            private static ulong GetAccessCacheIndex(ulong page)
+            {
+                page ^= page >> 32;
+                page ^= page >> 16;
+                page ^= page >> 8;
+                page ^= page >> AccessCacheIndexBits;
+                return page & (AccessCacheSize - 1);
             }
 
             private IBusRegistered<IBusPeripheral>[] peripherals = Array.Empty<IBusRegistered<IBusPeripheral>>();
 
 #if DEBUG
             private long queryCount;
-            private long lastPeripheralCount;
+            private long accessCacheCount;
             private long dictionaryCount;
             private long binarySearchCount;
 #endif
@@ -378,13 +409,25 @@ private void InvalidateLastBlock()
             private Dictionary<ulong, Block> shortBlocks;
             private Block[] blocks;
             [Constructor]
-            private ThreadLocal<Block> lastBlockStorage;
+            private ThreadLocal<AccessCacheEntry[]> accessCacheStorage;
+            private int accessCacheGeneration;
             private readonly ReaderWriterLockSlim sync;
             private readonly SystemBus sysbus;
 
-            private const ulong PageSize = 1 << 11;
+            private const int PageShift = 11;
+            private const ulong PageSize = 1 << PageShift;
             private const ulong PageAlign = PageSize - 1;
             private const long NumOfPagesThreshold = 4;
+            private const int AccessCacheIndexBits = 6;
+            private const ulong AccessCacheSize = 1 << AccessCacheIndexBits;
+
+            private struct AccessCacheEntry
+            {
+                public ulong Page;
+                public int Generation;
+                public ulong Offset;
+                public Block Block;
+            }
 
             private struct Block
             {
@@ -1211,7 +1211,9 @@ public void ZeroRange(Range range, IPeripheral context = null)
 
         public void LoadFileChunks(string path, IEnumerable<FileChunk> chunks, IPeripheral cpu)
         {
-            var minAddr = this.LoadFileChunks(chunks, cpu);
+            var minAddr = cpu is ICPUWithGuestMemoryAccess guestMemoryCpu
+                ? LoadFileChunksToGuestMemory(chunks, guestMemoryCpu)
+                : this.LoadFileChunks(chunks, cpu);
             AddFingerprint(path);
             UpdateLowestLoadedAddress(minAddr);
             this.DebugLog(path + " File loaded.");
@@ -1619,6 +1621,20 @@ private static MappedSegmentWrapper FromRegistrationPointToSegmentWrapper(IMappe
             return match;
         }
 
+        // Returns the lowest touched address, like the generic LoadFileChunks, but copies whole chunks to the memory mapped to the CPU
+        private ulong LoadFileChunksToGuestMemory(IEnumerable<FileChunk> chunks, ICPUWithGuestMemoryAccess cpu)
+        {
+            var minAddr = ulong.MaxValue;
+            foreach(var chunk in chunks)
+            {
+                var chunkData = chunk.Data.ToArray();
+                this.Log(LogLevel.Info, "Loading block of {0} bytes length at 0x{1:X}.", chunkData.Length, chunk.OffsetToLoad);
+                cpu.WriteGuestMemory(chunk.OffsetToLoad, chunkData, 0, chunkData.Length);
+                minAddr = Math.Min(minAddr, chunk.OffsetToLoad);
+            }
+            return minAddr;
+        }
+
         private void HandleChangedSymbols()
         {
             OnSymbolsChanged?.Invoke(Machine);
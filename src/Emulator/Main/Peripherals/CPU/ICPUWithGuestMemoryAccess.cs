@@ -0,0 +1,17 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Implemented by CPUs which copy guest physical memory directly from the memory mapped to them.
+    // Parts of the range which aren't mapped, e.g. peripherals, are accessed through the system bus.
+    public interface ICPUWithGuestMemoryAccess
+    {
+        void ReadGuestMemory(ulong address, byte[] destination, int startIndex, int count);
+
+        void WriteGuestMemory(ulong address, byte[] data, int startIndex, int count);
+    }
+}
@@ -1,15 +1,16 @@
 //
-// Copyright (c) 2010-2025 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 // Copyright (c) 2011-2015 Realtime Embedded
 //
 // This file is licensed under the MIT License.
 // Full license text is available in 'licenses/MIT.txt'.
 //
 using System;
-using System.Linq;
+using System.Buffers;
 
 using Antmicro.Renode.Debugging;
 using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.CPU;
 using Antmicro.Renode.Peripherals.Memory;
 
 namespace Antmicro.Renode.Peripherals.DMA
@@ -27,6 +28,46 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
             var readLengthInBytes = (int)request.ReadTransferType;
             var writeLengthInBytes = (int)request.WriteTransferType;
 
+            // some sanity checks
+            if((request.Size % readLengthInBytes) != 0 || (request.Size % writeLengthInBytes) != 0)
+            {
+                throw new ArgumentException("Request size is not aligned properly to given read or write transfer type (or both).");
+            }
+
+            if(TryCopyDirectly(sysbus, request, context, ref response))
+            {
+                return response;
+            }
+
+            // The buffer is rented, so it has to be cleared, as the transfers below don't fill all of it in some cases
+            var buffer = ArrayPool<byte>.Shared.Rent(request.Size);
+            Array.Clear(buffer, 0, request.Size);
+            try
+            {
+                CopyThroughBuffer(sysbus, request, context, buffer, ref response);
+            }
+            finally
+            {
+                ArrayPool<byte>.Shared.Return(buffer);
+            }
+            return response;
+        }
+
+        public DmaEngine(IBusController systemBus)
+        {
+            sysbus = systemBus;
+        }
+
+        public Response IssueCopy(Request request, IPeripheral context = null)
+        {
+            return IssueCopy(sysbus, request, context);
+        }
+
+        private static void CopyThroughBuffer(IBusController sysbus, Request request, IPeripheral context, byte[] buffer, ref Response response)
+        {
+            var readLengthInBytes = (int)request.ReadTransferType;
+            var writeLengthInBytes = (int)request.WriteTransferType;
+
             // Signed values in C# are represented in two's complement notation.
             // For example Int64 values are represented in 63 bits, with the sixty-fourth bit used as a sign bit.
             // https://github.com/dotnet/docs/blob/99ce0718695bdc617ffe77d7ebfd62d893d43a53/docs/fundamentals/runtime-libraries/system-int64.md#work-with-non-decimal-64-bit-integer-values
@@ -36,13 +77,6 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
             var sourceOffsetStep = request.SourceIncrementStep;
             var destinationOffsetStep = request.DestinationIncrementStep;
 
-            // some sanity checks
-            if((request.Size % readLengthInBytes) != 0 || (request.Size % writeLengthInBytes) != 0)
-            {
-                throw new ArgumentException("Request size is not aligned properly to given read or write transfer type (or both).");
-            }
-
-            var buffer = new byte[request.Size];
             var sourceAddress = request.Source.Address ?? 0;
             var whatIsAtSource = sysbus.WhatIsAt(sourceAddress, context);
             var isSourceContinuousMemory = (whatIsAtSource == null || whatIsAtSource.Peripheral is MappedMemory) // Not a peripheral
@@ -85,13 +119,13 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
                         buffer[transferred] = sysbus.ReadByte(readAddress, context);
                         break;
                     case TransferType.Word:
-                        BitConverter.GetBytes(sysbus.ReadWord(readAddress, context)).CopyTo(buffer, transferred);
+                        BitConverter.TryWriteBytes(buffer.AsSpan(transferred), sysbus.ReadWord(readAddress, context));
                         break;
                     case TransferType.DoubleWord:
-                        BitConverter.GetBytes(sysbus.ReadDoubleWord(readAddress, context)).CopyTo(buffer, transferred);
+                        BitConverter.TryWriteBytes(buffer.AsSpan(transferred), sysbus.ReadDoubleWord(readAddress, context));
                         break;
                     case TransferType.QuadWord:
-                        BitConverter.GetBytes(sysbus.ReadQuadWord(readAddress, context)).CopyTo(buffer, transferred);
+                        BitConverter.TryWriteBytes(buffer.AsSpan(transferred), sysbus.ReadQuadWord(readAddress, context));
                         break;
                     default:
                         throw new ArgumentOutOfRangeException($"Requested read transfer size: {request.ReadTransferType} is not supported by DmaEngine");
@@ -123,7 +157,7 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
                         // Transfer Units |  1  |  2  |  3  |  4  |
                         // Source         |  A  |  B  |  C  |  D  |
                         // Destination    |  A  |  B  |  C  |  D  |
-                        sysbus.WriteBytes(buffer, destinationAddress, context: context);
+                        sysbus.WriteBytes(buffer, destinationAddress, request.Size, context: context);
                     }
                     else
                     {
@@ -132,11 +166,10 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
                         // Source         |  A  |  B  |  C  |  D  |
                         // Destination    |  A  |  A  |  A  |  A  |
                         var chunkStartOffset = 0UL;
-                        var chunk = buffer.Take(writeLengthInBytes).ToArray();
                         while(chunkStartOffset < (ulong)request.Size)
                         {
                             var writeAddress = destinationAddress + chunkStartOffset;
-                            sysbus.WriteBytes(chunk, writeAddress, context: context);
+                            sysbus.WriteBytes(buffer, writeAddress, writeLengthInBytes, context: context);
                             chunkStartOffset += (ulong)writeLengthInBytes;
                         }
                     }
@@ -149,8 +182,8 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
                     // Source         |  A  |  B  |  C  |  D  |
                     // Destination    |  D  |     |     |     |
                     var skipCount = (request.Size == writeLengthInBytes) ? 0 : request.Size - writeLengthInBytes;
-                    DebugHelper.Assert((skipCount + request.Size) <= buffer.Length);
-                    sysbus.WriteBytes(buffer.Skip(skipCount).ToArray(), destinationAddress, context: context);
+                    DebugHelper.Assert((skipCount + writeLengthInBytes) <= request.Size);
+                    sysbus.WriteBytes(buffer, destinationAddress, skipCount, writeLengthInBytes, context: context);
                 }
             }
             else if(whatIsAtDestination != null)
@@ -185,20 +218,151 @@ public static Response IssueCopy(IBusController sysbus, Request request, IPeriph
                     }
                 }
             }
-
-            return response;
         }
 
-        public DmaEngine(IBusController systemBus)
+        // When both sides are mapped memory, the data is copied between the host memory of their segments without staging it in a buffer.
+        // The outcome is the same as of `CopyThroughBuffer`, including its special cases of transfers which don't increment an address.
+        private static bool TryCopyDirectly(IBusController sysbus, Request request, IPeripheral context, ref Response response)
         {
-            sysbus = systemBus;
+            if(!request.Source.Address.HasValue || !request.Destination.Address.HasValue
+                || !MappedSide.TryResolve(sysbus, request.Source.Address.Value, (int)request.ReadTransferType, request.SourceIncrementStep, request.IncrementReadAddress, request.Size, context, out var source)
+                || !MappedSide.TryResolve(sysbus, request.Destination.Address.Value, (int)request.WriteTransferType, request.DestinationIncrementStep, request.IncrementWriteAddress, request.Size, context, out var destination))
+            {
+                return false;
+            }
+            // Only a single memmove handles overlapping ranges, other transfers have to read the whole source before writing
+            if(source.Overlaps(destination) && !(source.IsContinuous && source.Increment && destination.IsContinuous && destination.Increment))
+            {
+                return false;
+            }
+
+            var size = request.Size;
+            var writeLength = destination.UnitLength;
+            if(destination.IsContinuous && destination.Increment)
+            {
+                if(source.IsContinuous && !source.Increment)
+                {
+                    // All the destination units are written with the first unit of the source, the copies are doubled up to the size
+                    CopyFromSource(source, 0, writeLength, destination.Memory, destination.Offset);
+                    for(var filled = (long)writeLength; filled < size; filled *= 2)
+                    {
+                        destination.Memory.CopyFrom(destination.Memory, destination.Offset, destination.Offset + filled, Math.Min(filled, size - filled), invalidate: false);
+                    }
+                }
+                else
+                {
+                    CopyFromSource(source, 0, size, destination.Memory, destination.Offset);
+                }
+            }
+            else if(!destination.Increment)
+            {
+                // Only the last unit remains at the destination
+                CopyFromSource(source, size - writeLength, writeLength, destination.Memory, destination.Offset);
+            }
+            else
+            {
+                for(var unit = 0; unit < destination.Units; unit++)
+                {
+                    CopyFromSource(source, (long)unit * writeLength, writeLength, destination.Memory, destination.Offset + unit * destination.Step);
+                }
+            }
+            // Translated code is invalidated once for the whole written range instead of for each copied unit
+            destination.Memory.InvalidateMemoryFragment(destination.Offset + destination.Low, destination.High - destination.Low);
+
+            if(request.IncrementReadAddress)
+            {
+                response.ReadAddress += (ulong)source.Units * request.SourceIncrementStep;
+            }
+            if(request.IncrementWriteAddress)
+            {
+                response.WriteAddress += (ulong)destination.Units * request.DestinationIncrementStep;
+            }
+            return true;
         }
 
-        public Response IssueCopy(Request request, IPeripheral context = null)
+        // Copies `length` bytes starting at `start` of the data which would be read from the source into the buffer by `CopyThroughBuffer`,
+        // the caller has to invalidate the translated code of the written range
+        private static void CopyFromSource(MappedSide source, long start, long length, MappedMemory destination, long destinationOffset)
         {
-            return IssueCopy(sysbus, request, context);
+            if(source.IsContinuous && !source.Increment)
+            {
+                // Only the first unit is read, the rest of the data is zeros
+                var copied = Math.Clamp(source.UnitLength - start, 0, length);
+                if(copied > 0)
+                {
+                    destination.CopyFrom(source.Memory, source.Offset + start, destinationOffset, copied, invalidate: false);
+                }
+                if(copied < length)
+                {
+                    destination.SetRange(destinationOffset + copied, length - copied, 0, invalidate: false);
+                }
+            }
+            else if(source.IsContinuous)
+            {
+                destination.CopyFrom(source.Memory, source.Offset + start, destinationOffset, length, invalidate: false);
+            }
+            else
+            {
+                var position = 0L;
+                while(position < length)
+                {
+                    var unit = (start + position) / source.UnitLength;
+                    var unitOffset = (start + position) % source.UnitLength;
+                    var count = Math.Min(source.UnitLength - unitOffset, length - position);
+                    var unitStart = source.Increment ? unit * source.Step : 0;
+                    destination.CopyFrom(source.Memory, source.Offset + unitStart + unitOffset, destinationOffset + position, count, invalidate: false);
+                    position += count;
+                }
+            }
         }
 
         private readonly IBusController sysbus;
+
+        private struct MappedSide
+        {
+            public static bool TryResolve(IBusController sysbus, ulong address, int unitLength, ulong step, bool increment, int size, IPeripheral context, out MappedSide side)
+            {
+                side = new MappedSide
+                {
+                    UnitLength = unitLength,
+                    Step = (long)step,
+                    Increment = increment,
+                    IsContinuous = step == (ulong)unitLength,
+                    Units = size / unitLength,
+                };
+                // Accesses failing the permission checks are reported by the bus
+                if(context is BaseCPU cpu && cpu.CheckExternalPermissions(address) == 0)
+                {
+                    return false;
+                }
+
+                var registered = sysbus.WhatIsAt(address + (ulong)side.Low, context);
+                if(!(registered?.Peripheral is MappedMemory memory) || !registered.RegistrationPoint.Range.Contains(address + (ulong)(side.High - 1)))
+                {
+                    return false;
+                }
+                side.Memory = memory;
+                side.Offset = (long)(address - registered.RegistrationPoint.Range.StartAddress + registered.RegistrationPoint.Offset);
+                return true;
+            }
+
+            public bool Overlaps(MappedSide other)
+            {
+                return Memory == other.Memory && Offset + Low < other.Offset + other.High && other.Offset + other.Low < Offset + High;
+            }
+
+            // The range of the accessed bytes relative to the address, the step can be negative
+            public long Low => Increment ? Math.Min(0, (Units - 1) * Step) : 0;
+
+            public long High => (Increment ? Math.Max(0, (Units - 1) * Step) : 0) + UnitLength;
+
+            public MappedMemory Memory;
+            public long Offset;
+            public int UnitLength;
+            public long Step;
+            public bool Increment;
+            public bool IsContinuous;
+            public int Units;
+        }
     }
 }
@@ -35,14 +35,40 @@ namespace Antmicro.Renode.Peripherals.Memory
     [Icon("memory")]
     public sealed class MappedMemory : IBytePeripheral, IWordPeripheral, IDoubleWordPeripheral, IQuadWordPeripheral, IMapped, IDisposable, IKnownSize, ISpeciallySerializable, IMemory, IMultibyteWritePeripheral, ICanLoadFiles, IEndiannessAware, IHasDelayedInvalidationContext
     {
-        public MappedMemory(IMachine machine, long size, int? segmentSize = null, string sharedMemoryFileRoot = null)
+        public MappedMemory(IMachine machine, long size, int? segmentSize = null, string sharedMemoryFileRoot = null, HugePageSize hugePages = HugePageSize.None)
         {
             if(size == 0)
             {
                 throw new ConstructionException("Memory size cannot be 0");
             }
 
-            if(segmentSize == null)
+            if(hugePages != HugePageSize.None)
+            {
+                if(!RuntimeInfo.IsLinux())
+                {
+                    throw new ConstructionException("Huge pages are only supported on Linux");
+                }
+                if(sharedMemoryFileRoot != null)
+                {
+                    throw new ConstructionException("Huge pages cannot be used together with shared memory");
+                }
+                var hugePageSize = (long)hugePages;
+                if(segmentSize == null)
+                {
+                    // Use as few segments as possible, so that each of them can be mapped by a CPU as one large region
+                    segmentSize = (int)Math.Min(MaximalHugePagesSegmentSize, (size + hugePageSize - 1) / hugePageSize * hugePageSize);
+                    this.DebugLog("Segment size automatically calculated to value {0}B", Misc.NormalizeBinary(segmentSize.Value));
+                }
+                else if(segmentSize.Value % hugePageSize != 0)
+                {
+                    throw new ConstructionException($"Segment size has to be a multiple of the huge page size ({Misc.NormalizeBinary(hugePageSize)}B)");
+                }
+                else if(segmentSize.Value > MaximalHugePagesSegmentSize)
+                {
+                    throw new ConstructionException($"Segment size cannot exceed {Misc.NormalizeBinary(MaximalHugePagesSegmentSize)}B");
+                }
+            }
+            else if(segmentSize == null)
             {
                 var proposedSegmentSize = Math.Min(MaximalSegmentSize, Math.Max(MinimalSegmentSize, size / RecommendedNumberOfSegments));
                 // align it
@@ -58,6 +84,12 @@ public MappedMemory(IMachine machine, long size, int? segmentSize = null, string
                 throw new ConstructionException($"Requested {nameof(sharedMemoryFileRoot)} path {sharedMemoryFileRoot} doesn't exist.");
             }
             this.sharedMemoryFileRoot = sharedMemoryFileRoot;
+            this.hugePages = hugePages;
+
+            if(hugePages != HugePageSize.None)
+            {
+                CheckHugePagesAvailability();
+            }
 
             Init();
         }
@@ -69,7 +101,8 @@ public void TouchSegment(int segmentNo)
             {
                 var allocSeg = AllocateSegment(segmentNo);
                 var originalPointer = (long)allocSeg;
-                var alignedPointer = (IntPtr)((originalPointer + Alignment - 1) & ~(Alignment - 1));
+                var alignment = SegmentAlignment;
+                var alignedPointer = (IntPtr)((originalPointer + alignment - 1) & ~(alignment - 1));
                 segments[segmentNo] = alignedPointer;
                 if(UsingSharedMemory)
                 {
@@ -127,13 +160,14 @@ public void Load(PrimitiveReader reader)
         {
             // checking magic
             var magic = reader.ReadUInt32();
-            if(magic != Magic)
+            if(magic != Magic && magic != HugePagesMagic)
             {
                 throw new InvalidOperationException("Memory: Cannot resume state from stream: Invalid magic.");
             }
             SegmentSize = reader.ReadInt32();
             size = reader.ReadInt64();
             ResetByte = reader.ReadByte();
+            hugePages = magic == HugePagesMagic ? (HugePageSize)reader.ReadInt64() : HugePageSize.None;
             if(emptyCtorUsed)
             {
                 Init();
@@ -414,10 +448,14 @@ public void Save(PrimitiveWriter writer)
             var globalStopwatch = Stopwatch.StartNew();
             var realSegmentsCount = 0;
 
-            writer.Write(Magic);
+            writer.Write(hugePages == HugePageSize.None ? Magic : HugePagesMagic);
             writer.Write(SegmentSize);
             writer.Write(size);
             writer.Write(ResetByte);
+            if(hugePages != HugePageSize.None)
+            {
+                writer.Write((long)hugePages);
+            }
             byte[][] outputBuffers = new byte[segments.Length][];
             int[] encodedLengths = new int[segments.Length];
             Parallel.For(0, segments.Length, i =>
@@ -481,14 +519,104 @@ public void WriteBytes(long offset, byte[] value)
             WriteBytes(offset, value, 0, value.Length);
         }
 
-        public void SetRange(long rangeStart, long rangeLength, byte value)
+        public void SetRange(long rangeStart, long rangeLength, byte value, bool invalidate = true)
+        {
+            if(rangeStart < 0 || rangeStart > size - rangeLength)
+            {
+                this.Log(LogLevel.Error, "Tried to set {0} bytes at offset 0x{1:X} outside the range of the peripheral 0x0 - 0x{2:X}", rangeLength, rangeStart, size);
+                return;
+            }
+
+            var written = 0L;
+            while(written < rangeLength)
+            {
+                var currentOffset = rangeStart + written;
+                var localOffset = GetLocalOffset(currentOffset);
+                var segment = segments[GetSegmentNo(currentOffset)];
+                var length = (int)Math.Min(rangeLength - written, SegmentSize - localOffset);
+                LibCWrapper.MemSet(new IntPtr(segment.ToInt64() + localOffset), value, length);
+                written += length;
+
+                if(invalidate)
+                {
+                    InvalidateMemoryFragment(currentOffset, length);
+                }
+            }
+        }
+
+        // Copies the data segment by segment, without staging it in a managed buffer. Like memmove, it handles overlapping ranges of the same memory.
+        // Callers doing many small copies can skip the invalidation with `invalidate` and call `InvalidateMemoryFragment` once for the whole range.
+        public void CopyFrom(MappedMemory source, long sourceOffset, long offset, long count, bool invalidate = true)
         {
-            var array = new byte[rangeLength];
-            for(long i = 0; i < rangeLength; ++i)
+            if(sourceOffset < 0 || sourceOffset > source.size - count || offset < 0 || offset > size - count)
             {
-                array[i] = value;
+                this.Log(LogLevel.Error, "Tried to copy {0} bytes from offset 0x{1:X} to offset 0x{2:X} outside the range of the peripherals", count, sourceOffset, offset);
+                return;
+            }
+
+            var backwards = source == this && offset > sourceOffset && offset < sourceOffset + count;
+            var copied = 0L;
+            while(copied < count)
+            {
+                var remaining = count - copied;
+                long sourcePosition;
+                long position;
+                long length;
+                if(backwards)
+                {
+                    // The part of the segments ending with the last byte which isn't copied yet
+                    length = Math.Min(remaining, Math.Min(source.GetLocalOffset(sourceOffset + remaining - 1), GetLocalOffset(offset + remaining - 1)) + 1);
+                    sourcePosition = sourceOffset + remaining - length;
+                    position = offset + remaining - length;
+                }
+                else
+                {
+                    sourcePosition = sourceOffset + copied;
+                    position = offset + copied;
+                    length = Math.Min(remaining, Math.Min(source.SegmentSize - source.GetLocalOffset(sourcePosition), SegmentSize - GetLocalOffset(position)));
+                }
+
+                unsafe
+                {
+                    var from = (byte*)source.segments[source.GetSegmentNo(sourcePosition)] + source.GetLocalOffset(sourcePosition);
+                    var to = (byte*)segments[GetSegmentNo(position)] + GetLocalOffset(position);
+                    Buffer.MemoryCopy(from, to, length, length);
+                }
+                copied += length;
+
+                if(invalidate)
+                {
+                    InvalidateMemoryFragment(position, length);
+                }
+            }
+        }
+
+        public void InvalidateMemoryFragment(long start, long length)
+        {
+            if(machine == null)
+            {
+                // this peripheral is not connected to any machine, so there is nothing we can do
+                return;
+            }
+
+            this.NoisyLog("Invalidating memory fragment at 0x{0:X} of size {1} bytes.", start, length);
+
+            var registrationPoints = GetRegistrationPoints();
+            foreach(var cpu in machine.SystemBus.GetCPUs().OfType<CPU.ICPU>())
+            {
+                foreach(var regPoint in registrationPoints)
+                {
+                    try
+                    {
+                        //it's dynamic to avoid cyclic dependency to TranslationCPU
+                        ((dynamic)cpu).OrderTranslationBlocksInvalidation(new IntPtr(regPoint + start), new IntPtr(regPoint + start + length), delayedInvalidation);
+                    }
+                    catch(RuntimeBinderException)
+                    {
+                        // CPU does not implement `InvalidateTranslationBlocks`, there is not much we can do
+                    }
+                }
             }
-            WriteBytes(rangeStart, array);
         }
 
         public int SegmentCount
@@ -527,6 +655,8 @@ public bool UsingSharedMemory
 
         public int SegmentSize { get; private set; }
 
+        public HugePageSize HugePages => hugePages;
+
         // The endianness of MappedMemory matches the host endianness because it is directly backed by host memory
         public Endianess Endianness => BitConverter.IsLittleEndian ? Endianess.LittleEndian : Endianess.BigEndian;
 
@@ -567,6 +697,19 @@ private void Free()
                         this.NoisyLog("Shared segment {0} freed.", i);
                     }
                 }
+                else if(hugePages != HugePageSize.None)
+                {
+                    for(var i = 0; i < segments.Length; i++)
+                    {
+                        if(segments[i] != IntPtr.Zero)
+                        {
+                            LibCWrapper.Munmap(originalPointers[i], mappedSegmentLengths[i]);
+                            segments[i] = IntPtr.Zero;
+                            originalPointers[i] = IntPtr.Zero;
+                            this.NoisyLog("Segment {0} freed.", i);
+                        }
+                    }
+                }
                 else
                 {
                     for(var i = 0; i < segments.Length; i++)
@@ -660,38 +803,72 @@ private IntPtr AllocateSegment(int segmentNo)
             {
                 return sharedSegments[segmentNo].Allocate(SegmentSize + Alignment);
             }
+            else if(hugePages != HugePageSize.None)
+            {
+                return AllocateHugePageSegment(segmentNo);
+            }
             else
             {
                 return Marshal.AllocHGlobal(SegmentSize + Alignment);
             }
         }
 
-        private void InvalidateMemoryFragment(long start, int length)
+        private IntPtr AllocateHugePageSegment(int segmentNo)
         {
-            if(machine == null)
+            if(mappedSegmentLengths == null)
             {
-                // this peripheral is not connected to any machine, so there is nothing we can do
-                return;
+                mappedSegmentLengths = new ulong[segments.Length];
             }
 
-            this.NoisyLog("Invalidating memory fragment at 0x{0:X} of size {1} bytes.", start, length);
+            // Reserved huge pages are always aligned to their size
+            var length = (ulong)SegmentSize;
+            var hugePageSizeFlag = BitHelper.GetMostSignificantSetBitIndex((ulong)hugePages) << LibCWrapper.MAP_HUGE_SHIFT;
+            var pointer = LibCWrapper.Mmap(IntPtr.Zero, length, LibCWrapper.PROT_READ | LibCWrapper.PROT_WRITE,
+                LibCWrapper.MAP_PRIVATE | LibCWrapper.MAP_ANONYMOUS | LibCWrapper.MAP_HUGETLB | hugePageSizeFlag, -1, 0);
+            if(pointer != LibCWrapper.MAP_FAILED)
+            {
+                mappedSegmentLengths[segmentNo] = length;
+                return pointer;
+            }
 
-            var registrationPoints = GetRegistrationPoints();
-            foreach(var cpu in machine.SystemBus.GetCPUs().OfType<CPU.ICPU>())
+            length += (ulong)SegmentAlignment;
+
+            this.DebugLog("Could not allocate reserved huge pages: {0}, falling back to transparent huge pages", LibCWrapper.GetLastError());
+            pointer = LibCWrapper.Mmap(IntPtr.Zero, length, LibCWrapper.PROT_READ | LibCWrapper.PROT_WRITE,
+                LibCWrapper.MAP_PRIVATE | LibCWrapper.MAP_ANONYMOUS, -1, 0);
+            if(pointer == LibCWrapper.MAP_FAILED)
             {
-                foreach(var regPoint in registrationPoints)
-                {
-                    try
-                    {
-                        //it's dynamic to avoid cyclic dependency to TranslationCPU
-                        ((dynamic)cpu).OrderTranslationBlocksInvalidation(new IntPtr(regPoint + start), new IntPtr(regPoint + start + length), delayedInvalidation);
-                    }
-                    catch(RuntimeBinderException)
-                    {
-                        // CPU does not implement `InvalidateTranslationBlocks`, there is not much we can do
-                    }
-                }
+                throw new OutOfMemoryException($"Could not allocate memory segment: {LibCWrapper.GetLastError()}");
+            }
+            mappedSegmentLengths[segmentNo] = length;
+
+            var alignedPointer = (IntPtr)(((long)pointer + SegmentAlignment - 1) & ~(SegmentAlignment - 1));
+            if(LibCWrapper.Madvise(alignedPointer, (ulong)SegmentSize, LibCWrapper.MADV_HUGEPAGE) != 0)
+            {
+                this.DebugLog("madvise(MADV_HUGEPAGE) failed: {0}", LibCWrapper.GetLastError());
             }
+            return pointer;
+        }
+
+        private void CheckHugePagesAvailability()
+        {
+            var hugePageSize = (long)hugePages;
+            var freeHugePagesPath = $"/sys/kernel/mm/hugepages/hugepages-{hugePageSize / 1024}kB/free_hugepages";
+            if(File.Exists(freeHugePagesPath)
+                && long.TryParse(File.ReadAllText(freeHugePagesPath).Trim(), out var freeHugePages)
+                && freeHugePages * hugePageSize >= size)
+            {
+                return;
+            }
+
+            const string TransparentHugePagesPath = "/sys/kernel/mm/transparent_hugepage/enabled";
+            if(File.Exists(TransparentHugePagesPath) && !File.ReadAllText(TransparentHugePagesPath).Contains("[never]"))
+            {
+                this.WarningLog("Not enough {0}B huge pages reserved on the host, memory will be backed by transparent huge pages", Misc.NormalizeBinary(hugePageSize));
+                return;
+            }
+
+            this.WarningLog("Huge pages are not available on the host, memory will be backed by regular pages");
         }
 
         private List<long> GetRegistrationPoints()
@@ -712,17 +889,31 @@ private List<long> GetRegistrationPoints()
         private IMappedSegment[] describedSegments;
         private bool disposed;
         private long size;
+        private HugePageSize hugePages;
+        private ulong[] mappedSegmentLengths;
         private readonly string sharedMemoryFileRoot;
 
         private readonly bool emptyCtorUsed;
         private readonly IMachine machine;
 
+        private long SegmentAlignment => hugePages == HugePageSize.None ? Alignment : (long)hugePages;
+
         private const uint Magic = 0xABCD6366;
+        private const uint HugePagesMagic = 0xABCD6367;
         private const int Alignment = 0x1000;
         private const int MinimalSegmentSize = 64 * 1024;
         private const int MaximalSegmentSize = 16 * 1024 * 1024;
+        // Segments are compressed as a whole when saved, so the LZ4 bound of their size has to fit in an int
+        private const int MaximalHugePagesSegmentSize = 1024 * 1024 * 1024;
         private const int RecommendedNumberOfSegments = 16;
 
+        public enum HugePageSize : long
+        {
+            None = 0,
+            Size2MB = 2 * 1024 * 1024,
+            Size1GB = 1024 * 1024 * 1024,
+        }
+
         private class MappedSegment : IMappedSegment
         {
             public MappedSegment(MappedMemory parent, int index, uint size)
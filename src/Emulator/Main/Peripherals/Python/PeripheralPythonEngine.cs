@@ -1,16 +1,18 @@
 //
-// Copyright (c) 2010-2024 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 // Copyright (c) 2011-2015 Realtime Embedded
 //
 // This file is licensed under the MIT License.
 // Full license text is available in 'licenses/MIT.txt'.
 //
 using System;
+using System.Collections.Generic;
 using System.Linq;
 
 using Antmicro.Migrant;
 using Antmicro.Migrant.Hooks;
 using Antmicro.Renode.Core;
+using Antmicro.Renode.Exceptions;
 
 using Microsoft.Scripting.Hosting;
 
@@ -41,6 +43,25 @@ public void ExecuteCode()
             Execute(code);
         }
 
+        // Calls the function named `name`, defined by the script, with the current request. It's looked up in the scope only once.
+        public void ExecuteHandler(string name)
+        {
+            if(!handlers.TryGetValue(name, out var handler))
+            {
+                if(!Scope.TryGetVariable<Action<PythonRequest>>(name, out handler))
+                {
+                    throw new RecoverableException($"Python peripheral script doesn't define the `{name}` handler");
+                }
+                handlers[name] = handler;
+            }
+            Execute(handler, request);
+        }
+
+        public void ClearHandlers()
+        {
+            handlers.Clear();
+        }
+
         public string Code
         {
             get
@@ -122,6 +143,10 @@ private void InitScope(ScriptSource script)
         [Transient]
         private PythonRequest request;
 
+        // Functions of the scope are bound again after deserialization
+        [Constructor]
+        private Dictionary<string, Action<PythonRequest>> handlers = new Dictionary<string, Action<PythonRequest>>();
+
         private readonly PythonPeripheral peripheral;
 
         // naming convention here is pythonic
@@ -6,6 +6,7 @@
 // Full license text is available in 'licenses/MIT.txt'.
 //
 
+using System.Collections.Generic;
 using System.IO;
 
 using Antmicro.Renode.Core;
@@ -91,6 +92,25 @@ public void EnsureInit()
             }
         }
 
+        // Reads of `offset` return `value` without entering the interpreter, e.g. for status registers polled by drivers.
+        // Declarations are meant to be made by the init section of the script and are dropped on reset.
+        public void DeclareConstantRead(long offset, ulong value)
+        {
+            constantReads[offset] = value;
+        }
+
+        // Reads of `offset` call the script's function named `handlerName` with the request instead of executing the whole script
+        public void DeclareReadHandler(long offset, string handlerName)
+        {
+            readHandlers[offset] = handlerName;
+        }
+
+        // Writes to `offset` call the script's function named `handlerName` with the request instead of executing the whole script
+        public void DeclareWriteHandler(long offset, string handlerName)
+        {
+            writeHandlers[offset] = handlerName;
+        }
+
         public void SetAbsoluteAddress(ulong address)
         {
             pythonRunner.Request.Absolute = address;
@@ -170,6 +190,10 @@ public ulong ControlRead(long command, ulong value)
         public void Reset()
         {
             inited = false;
+            constantReads.Clear();
+            readHandlers.Clear();
+            writeHandlers.Clear();
+            pythonRunner.ClearHandlers();
             EnsureInit();
         }
 
@@ -199,11 +223,18 @@ private void HandleRead(long offset)
         {
             EnsureInit();
 
+            if(constantReads.TryGetValue(offset, out var value))
+            {
+                pythonRunner.Request.Value = value;
+                requestCounter++;
+                return;
+            }
+
             pythonRunner.Request.Value = 0;
             pythonRunner.Request.Type = PeripheralPythonEngine.PythonRequest.RequestType.READ;
             pythonRunner.Request.Offset = offset;
             pythonRunner.Request.Counter = requestCounter++;
-            Execute();
+            Execute(readHandlers, offset);
         }
 
         private void HandleWrite(long offset, ulong value)
@@ -214,7 +245,7 @@ private void HandleWrite(long offset, ulong value)
             pythonRunner.Request.Type = PeripheralPythonEngine.PythonRequest.RequestType.WRITE;
             pythonRunner.Request.Offset = offset;
             pythonRunner.Request.Counter = requestCounter++;
-            Execute();
+            Execute(writeHandlers, offset);
         }
 
         private void Execute()
@@ -222,9 +253,25 @@ private void Execute()
             pythonRunner.ExecuteCode();
         }
 
+        private void Execute(Dictionary<long, string> handlers, long offset)
+        {
+            if(handlers.TryGetValue(offset, out var handlerName))
+            {
+                pythonRunner.ExecuteHandler(handlerName);
+            }
+            else
+            {
+                Execute();
+            }
+        }
+
         private bool inited;
         private ulong requestCounter;
 
+        private readonly Dictionary<long, ulong> constantReads = new Dictionary<long, ulong>();
+        private readonly Dictionary<long, string> readHandlers = new Dictionary<long, string>();
+        private readonly Dictionary<long, string> writeHandlers = new Dictionary<long, string>();
+
         private readonly PeripheralPythonEngine pythonRunner;
         private readonly bool initable;
         private readonly int size;
@@ -15,7 +15,7 @@
 
 namespace Antmicro.Renode.Peripherals.Timers
 {
-    public class ComparingTimer : ITimer, IPeripheral
+    public class ComparingTimer : ITimer, IPeripheral, ILinearTimer
     {
         public ComparingTimer(IClockSource clockSource, ulong frequency, IPeripheral owner, string localName, ulong limit = ulong.MaxValue, Direction direction = Direction.Ascending, bool enabled = false, WorkMode workMode = WorkMode.OneShot, bool eventEnabled = false, ulong compare = ulong.MaxValue, ulong divider = 1, ulong step = 1)
         {
@@ -57,6 +57,30 @@ public virtual void Reset()
             InternalReset();
         }
 
+        public bool TryGetLinearState(out LinearTimerState state)
+        {
+            var result = new LinearTimerState();
+            var isLinear = false;
+            if(clockSource is BaseClockSource baseClockSource)
+            {
+                clockSource.GetClockEntryInLockContext(CompareReachedInternal, entry =>
+                {
+                    if(!entry.Enabled || entry.Direction != Direction.Ascending || entry.Ratio.Minus || entry.ValueResiduum.Minus)
+                    {
+                        return;
+                    }
+                    result.Value = valueAccumulatedSoFar + entry.Value;
+                    result.Residuum = entry.ValueResiduum;
+                    result.Ratio = entry.Ratio;
+                    // Any event of the clock source may modify the timer, e.g. through a handler of another entry
+                    result.ValidFor = baseClockSource.NearestLimitIn;
+                    isLinear = true;
+                });
+            }
+            state = result;
+            return isLinear;
+        }
+
         public bool Enabled
         {
             get
@@ -113,11 +137,18 @@ public ulong Value
                     throw new ArgumentException("Value cannot be larger than limit");
                 }
 
+                var valueChanged = false;
                 clockSource.ExchangeClockEntryWith(CompareReachedInternal, entry =>
                 {
+                    valueChanged = valueAccumulatedSoFar + entry.Value != value;
                     valueAccumulatedSoFar = value;
                     return entry.With(period: CalculatePeriod(), value: 0);
                 });
+                if(valueChanged)
+                {
+                    // The entry itself might not change, e.g. if it was just restarted
+                    (clockSource as BaseClockSource)?.NotifyStateChanged();
+                }
 
                 RequestReturnOnCurrentCpu();
             }
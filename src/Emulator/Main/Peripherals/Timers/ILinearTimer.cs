@@ -0,0 +1,29 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using Antmicro.Renode.Time;
+using Antmicro.Renode.Utilities;
+
+namespace Antmicro.Renode.Peripherals.Timers
+{
+    // Timer whose value advances linearly with virtual time until the nearest event of its clock source,
+    // so that it can be computed without querying the clock source, e.g. from the instructions executed by a CPU
+    public interface ILinearTimer
+    {
+        // Returns false if the value doesn't advance linearly at the moment, e.g. when the timer is disabled
+        bool TryGetLinearState(out LinearTimerState state);
+    }
+
+    public struct LinearTimerState
+    {
+        public ulong Value;
+        public Fraction Residuum;
+        // Increment of the value per virtual time tick
+        public Fraction Ratio;
+        // The state is no longer valid after this much virtual time
+        public TimeInterval ValidFor;
+    }
+}
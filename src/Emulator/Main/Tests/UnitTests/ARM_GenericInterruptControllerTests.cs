@@ -0,0 +1,312 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Diagnostics;
+using System.Linq;
+
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.CPU;
+using Antmicro.Renode.Peripherals.IRQControllers;
+using Antmicro.Renode.UnitTests.Mocks;
+
+using NUnit.Framework;
+
+using CPUInterfaceSystemRegisters = Antmicro.Renode.Peripherals.IRQControllers.ARM_GenericInterruptController.CPUInterfaceSystemRegisters;
+using DistributorRegisters = Antmicro.Renode.Peripherals.IRQControllers.ARM_GenericInterruptController.DistributorRegisters;
+using RedistributorRegisters = Antmicro.Renode.Peripherals.IRQControllers.ARM_GenericInterruptController.RedistributorRegisters;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class ARM_GenericInterruptControllerTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            machine = new Machine();
+            EmulationManager.Instance.CurrentEmulation.AddMachine(machine);
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            EmulationManager.Instance.Clear();
+        }
+
+        [Test]
+        public void ShouldAcknowledgeInterruptsInPriorityOrder()
+        {
+            CreateGIC(1);
+            var cpu = cpus[0];
+            SetPrivateInterruptPriority(cpu, 1, 0x80);
+            SetPrivateInterruptPriority(cpu, 2, 0x40);
+
+            GenerateSGI(cpu, cpu, 1);
+            GenerateSGI(cpu, cpu, 2);
+
+            Assert.AreEqual(2u, Acknowledge(cpu));
+            // The running priority masks the pending interrupt with a lower priority
+            Assert.IsFalse(cpu.IsSignalSet(InterruptSignalType.IRQ));
+            Assert.AreEqual(NoPending, Acknowledge(cpu));
+
+            End(cpu, 2);
+            Assert.IsTrue(cpu.IsSignalSet(InterruptSignalType.IRQ));
+            Assert.AreEqual(1u, Acknowledge(cpu));
+            End(cpu, 1);
+            Assert.IsFalse(cpu.IsSignalSet(InterruptSignalType.IRQ));
+        }
+
+        [Test]
+        public void ShouldAcknowledgeFirstPendingOfInterruptsWithEqualPriorities()
+        {
+            CreateGIC(1);
+            var cpu = cpus[0];
+            SetPrivateInterruptPriority(cpu, 1, 0x80);
+            SetPrivateInterruptPriority(cpu, 3, 0x80);
+
+            GenerateSGI(cpu, cpu, 3);
+            GenerateSGI(cpu, cpu, 1);
+
+            Assert.AreEqual(3u, Acknowledge(cpu));
+            End(cpu, 3);
+            Assert.AreEqual(1u, Acknowledge(cpu));
+            End(cpu, 1);
+        }
+
+        [Test]
+        public void ShouldPreferPrivateInterruptToSharedOneWithEqualPriority()
+        {
+            CreateGIC(2);
+            var cpu = cpus[0];
+            EnableSharedInterrupt(SharedInterruptId, 0x80);
+            SetPrivateInterruptPriority(cpu, 1, 0x80);
+
+            // The shared interrupt targets the first CPU after reset and becomes pending first
+            SetSharedInterrupt(SharedInterruptId, true);
+            GenerateSGI(cpu, cpu, 1);
+
+            Assert.AreEqual(1u, Acknowledge(cpu));
+            End(cpu, 1);
+            Assert.AreEqual(SharedInterruptId, Acknowledge(cpu));
+            SetSharedInterrupt(SharedInterruptId, false);
+            End(cpu, SharedInterruptId);
+        }
+
+        [Test]
+        public void ShouldSignalSharedInterruptOnlyToRoutedCPU()
+        {
+            CreateGIC(4);
+            EnableSharedInterrupt(SharedInterruptId, 0x80);
+            RouteSharedInterrupt(SharedInterruptId, cpus[2]);
+
+            SetSharedInterrupt(SharedInterruptId, true);
+
+            CollectionAssert.AreEqual(new[] { false, false, true, false }, cpus.Select(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+            Assert.AreEqual(NoPending, Acknowledge(cpus[0]));
+
+            RouteSharedInterrupt(SharedInterruptId, cpus[3]);
+            CollectionAssert.AreEqual(new[] { false, false, false, true }, cpus.Select(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+            Assert.AreEqual(NoPending, Acknowledge(cpus[2]));
+            Assert.AreEqual(SharedInterruptId, Acknowledge(cpus[3]));
+
+            SetSharedInterrupt(SharedInterruptId, false);
+            End(cpus[3], SharedInterruptId);
+            Assert.IsFalse(cpus.Any(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+        }
+
+        [Test]
+        public void ShouldSignalSoftwareGeneratedInterruptOnlyToTargetCPU([Values(8, 32)] int cpusCount)
+        {
+            CreateGIC(cpusCount);
+            // With 32 CPUs the target is selected with the Range Selector
+            var targetIndex = cpusCount - 3;
+            var target = cpus[targetIndex];
+
+            GenerateSGI(cpus[0], target, 7);
+            CollectionAssert.AreEqual(Enumerable.Range(0, cpusCount).Select(i => i == targetIndex), cpus.Select(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+
+            // Other CPUs don't see the interrupt, acknowledging it on the target only changes the target's signal
+            Assert.AreEqual(NoPending, Acknowledge(cpus[targetIndex - 1]));
+            Assert.AreEqual(7u, Acknowledge(target));
+            Assert.IsFalse(cpus.Any(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+            End(target, 7);
+        }
+
+        [Test]
+        public void ShouldSignalBroadcastSoftwareGeneratedInterruptToOtherCPUs()
+        {
+            CreateGIC(8);
+
+            WriteSystemRegister(cpus[2], CPUInterfaceSystemRegisters.SoftwareGeneratedInterruptGroup1Generate, SGIAllOtherCPUs | 7ul << 24);
+
+            CollectionAssert.AreEqual(Enumerable.Range(0, 8).Select(i => i != 2), cpus.Select(cpu => cpu.IsSignalSet(InterruptSignalType.IRQ)));
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void BenchmarkInterProcessorInterruptLatency([Values(8, 32, 64)] int cpusCount)
+        {
+            const int interruptsCount = 100000;
+            CreateGIC(cpusCount);
+            var source = cpus[0];
+            var target = cpus[cpusCount - 1];
+
+            var stopwatch = new Stopwatch();
+            for(var i = 0; i < interruptsCount; i++)
+            {
+                // The target's signal is set before the write returns
+                stopwatch.Start();
+                GenerateSGI(source, target, 1);
+                stopwatch.Stop();
+
+                Acknowledge(target);
+                End(target, 1);
+            }
+            Assert.IsFalse(target.IsSignalSet(InterruptSignalType.IRQ));
+            Console.WriteLine("{0} CPUs: {1:0.0} ns/IPI", cpusCount, stopwatch.Elapsed.TotalMilliseconds * 1000000 / interruptsCount);
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void BenchmarkInterruptAcknowledgeThroughput([Values(8, 32, 64)] int cpusCount)
+        {
+            const int interruptsCount = 100000;
+            CreateGIC(cpusCount);
+            var cpu = cpus[cpusCount / 2];
+
+            var stopwatch = Stopwatch.StartNew();
+            for(var i = 0; i < interruptsCount; i++)
+            {
+                GenerateSGI(cpu, cpu, 1);
+                Acknowledge(cpu);
+                End(cpu, 1);
+            }
+            stopwatch.Stop();
+            Assert.IsFalse(cpu.IsSignalSet(InterruptSignalType.IRQ));
+            Console.WriteLine("{0} CPUs: {1:0} interrupts/s", cpusCount, interruptsCount / stopwatch.Elapsed.TotalSeconds);
+        }
+
+        // Creates a GICv3 without the Security Extensions using affinity routing with the Group 1 enabled.
+        // All SGIs are enabled Group 1 interrupts with the highest priority.
+        private void CreateGIC(int cpusCount)
+        {
+            gic = new ARM_GenericInterruptController(machine, supportsTwoSecurityStates: false, architectureVersion: ARM_GenericInterruptControllerVersion.GICv3);
+            cpus = new MockARMCPU[cpusCount];
+            for(var i = 0; i < cpusCount; i++)
+            {
+                cpus[i] = new MockARMCPU(machine, (uint)i);
+                machine.SystemBus.Register(cpus[i], new CPURegistrationPoint());
+                gic.AttachCPU(cpus[i]);
+            }
+
+            WriteDistributor(DistributorRegisters.Control, ControlEnableAffinityRouting);
+            WriteDistributor(DistributorRegisters.Control, ControlEnableAffinityRouting | ControlEnableGroup1);
+            foreach(var cpu in cpus)
+            {
+                WriteRedistributor(cpu, RedistributorRegisters.Wake, 0);
+                WriteRedistributor(cpu, RedistributorRegisters.InterruptGroup_0, 0xFFFF);
+                WriteRedistributor(cpu, RedistributorRegisters.InterruptSetEnable_0, 0xFFFF);
+                WriteSystemRegister(cpu, CPUInterfaceSystemRegisters.GroupEnable1, 1);
+            }
+        }
+
+        private void EnableSharedInterrupt(uint id, byte priority)
+        {
+            var flagOffset = (id / 32) * 4;
+            var flag = 1u << (int)(id % 32);
+            WriteDistributor(DistributorRegisters.InterruptGroup_0, flag, flagOffset);
+            WriteDistributor(DistributorRegisters.InterruptSetEnable_0, flag, flagOffset);
+            // Priorities of the other interrupts sharing the register don't matter as they stay disabled
+            WriteDistributor(DistributorRegisters.InterruptPriority_0, (uint)priority << (int)(id % 4 * 8), id & ~3u);
+        }
+
+        private void RouteSharedInterrupt(uint id, MockARMCPU target)
+        {
+            using(machine.SystemBus.SetLocalContext(cpus[0]))
+            {
+                gic.WriteQuadWordToDistributor((long)DistributorRegisters.InterruptRouting_0 + (id - SharedPeripheralFirst) * 8, target.Affinity.AllLevels);
+            }
+        }
+
+        private void SetSharedInterrupt(uint id, bool value)
+        {
+            gic.OnGPIO((int)(id - SharedPeripheralFirst), value);
+        }
+
+        private void SetPrivateInterruptPriority(MockARMCPU cpu, uint id, byte priority)
+        {
+            var entry = gic.GetCPUEntry(cpu.MultiprocessingId);
+            var offset = (long)RedistributorRegisters.InterruptPriority_0 + (id & ~3u);
+            var shift = (int)(id % 4 * 8);
+            using(machine.SystemBus.SetLocalContext(cpu))
+            {
+                gic.LockExecuteAndUpdate(() =>
+                {
+                    var value = entry.RedistributorDoubleWordRegisters.Read(offset);
+                    value = value & ~(0xFFu << shift) | (uint)priority << shift;
+                    entry.RedistributorDoubleWordRegisters.Write(offset, value);
+                });
+            }
+        }
+
+        private void GenerateSGI(MockARMCPU source, MockARMCPU target, uint id)
+        {
+            var targetNumber = target.Affinity.GetLevel(0);
+            var rangeSelector = (ulong)targetNumber / 16;
+            var value = rangeSelector << 44 | (ulong)id << 24 | 1ul << (targetNumber % 16);
+            WriteSystemRegister(source, CPUInterfaceSystemRegisters.SoftwareGeneratedInterruptGroup1Generate, value);
+        }
+
+        private uint Acknowledge(MockARMCPU cpu)
+        {
+            using(machine.SystemBus.SetLocalContext(cpu))
+            {
+                return (uint)gic.ReadSystemRegisterCPUInterface((uint)CPUInterfaceSystemRegisters.InterruptAcknowledgeGroup1);
+            }
+        }
+
+        private void End(MockARMCPU cpu, uint id)
+        {
+            WriteSystemRegister(cpu, CPUInterfaceSystemRegisters.InterruptEndGroup1, id);
+        }
+
+        private void WriteSystemRegister(MockARMCPU cpu, CPUInterfaceSystemRegisters register, ulong value)
+        {
+            using(machine.SystemBus.SetLocalContext(cpu))
+            {
+                gic.WriteSystemRegisterCPUInterface((uint)register, value);
+            }
+        }
+
+        private void WriteDistributor(DistributorRegisters register, uint value, long byteOffset = 0)
+        {
+            using(machine.SystemBus.SetLocalContext(cpus[0]))
+            {
+                gic.WriteDoubleWordToDistributor((long)register + byteOffset, value);
+            }
+        }
+
+        private void WriteRedistributor(MockARMCPU cpu, RedistributorRegisters register, uint value)
+        {
+            var entry = gic.GetCPUEntry(cpu.MultiprocessingId);
+            using(machine.SystemBus.SetLocalContext(cpu))
+            {
+                gic.LockExecuteAndUpdate(() => entry.RedistributorDoubleWordRegisters.Write((long)register, value));
+            }
+        }
+
+        private IMachine machine;
+        private ARM_GenericInterruptController gic;
+        private MockARMCPU[] cpus;
+
+        private const uint NoPending = 1023;
+        private const uint SharedPeripheralFirst = 32;
+        private const uint SharedInterruptId = 40;
+        private const uint ControlEnableGroup1 = 1u << 1;
+        private const uint ControlEnableAffinityRouting = 1u << 4;
+        private const ulong SGIAllOtherCPUs = 1ul << 40;
+    }
+}
@@ -0,0 +1,40 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class ARM_GenericTimerTests
+    {
+        [Test]
+        public void ShouldNotifyClockSourceWhenVirtualOffsetChanges()
+        {
+            var machine = new Machine();
+            var timer = new ARM_GenericTimer(machine, 1000000);
+            var stateChanges = 0;
+            ((BaseClockSource)machine.ClockSource).StateChanged += () => stateChanges++;
+
+            // Counter values published to the translation library have to be invalidated when the virtual count jumps
+            timer.WriteRegisterAArch64(VirtualOffsetRegister, 0x100);
+            Assert.AreNotEqual(0, stateChanges);
+            Assert.AreEqual(unchecked(0UL - 0x100), timer.ReadRegisterAArch64(VirtualCountRegister));
+
+            stateChanges = 0;
+            timer.WriteRegisterAArch64(VirtualOffsetRegister, 0x100);
+            Assert.AreEqual(0, stateChanges);
+        }
+
+        // CNTVOFF_EL2 and CNTVCT_EL0
+        private const uint VirtualOffsetRegister = 0xe703;
+        private const uint VirtualCountRegister = 0xdf02;
+    }
+}
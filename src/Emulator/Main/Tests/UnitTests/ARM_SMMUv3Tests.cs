@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.CPU;
+using Antmicro.Renode.Peripherals.Memory;
+using Antmicro.Renode.Peripherals.MemoryControllers;
+
+using NUnit.Framework;
+
+using Opcode = Antmicro.Renode.Peripherals.MemoryControllers.ARM_SMMUv3.Opcode;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class ARM_SMMUv3Tests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            machine = new Machine();
+            EmulationManager.Instance.CurrentEmulation.AddMachine(machine);
+            sysbus = machine.SystemBus;
+            sysbus.Register(new MappedMemory(machine, MemorySize), new BusPointRegistration(0x0));
+
+            smmu = new ARM_SMMUv3(machine);
+            sysbus.Register(smmu, new BusRangeRegistration(SmmuAddress, (ulong)smmu.Size));
+            stream = new MockBusPeripheral();
+            smmu.Register(stream, new ARM_SMMUv3RegistrationPoint(StreamId));
+            commandsIssued = 0;
+
+            // Stage 1 translation with the context descriptor at CdAddress
+            sysbus.WriteQuadWord(StreamTableAddress, SteValid | SteConfigStage1 | CdAddress);
+            WriteContextDescriptor(FirstAsid);
+            // L0[0] -> L1, L1[0] maps the first 1 GiB as a block
+            sysbus.WriteQuadWord(Level0TableAddress, Level1TableAddress | PteTable);
+            sysbus.WriteQuadWord(Level1TableAddress, OutputAddress | PteBlock);
+
+            smmu.WriteQuadWord(SMMU_STRTAB_BASE, StreamTableAddress);
+            smmu.WriteDoubleWord(SMMU_STRTAB_BASE_CFG, StreamTableShift);
+            smmu.WriteQuadWord(SMMU_CMDQ_BASE, CommandQueueAddress | CommandQueueShift);
+            smmu.WriteDoubleWord(SMMU_CR0, CR0_SMMUEN | CR0_CMDQEN);
+            IssueCommand(Opcode.CMD_CFGI_STE);
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            EmulationManager.Instance.Clear();
+        }
+
+        [Test]
+        public void ShouldHitIotlbOnRepeatedTranslation()
+        {
+            var first = Translate(0x1000);
+            var second = Translate(0x1234);
+
+            Assert.AreSame(first, second);
+            Assert.AreEqual(OutputAddress, (ulong)first.Offset);
+            Assert.AreEqual(1ul, smmu.IotlbMisses);
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+            Assert.AreEqual(1ul, smmu.ConfigurationCacheMisses);
+            Assert.AreEqual(1ul, smmu.ConfigurationCacheHits);
+        }
+
+        [Test]
+        public void ShouldWalkPageTablesAgainAfterTlbiNsnhAll()
+        {
+            Translate(0x1000);
+            IssueCommand(Opcode.CMD_TLBI_NSNH_ALL);
+            Translate(0x1000);
+
+            Assert.AreEqual(2ul, smmu.IotlbMisses);
+            Assert.AreEqual(0ul, smmu.IotlbHits);
+            // The context descriptor isn't invalidated by TLB maintenance
+            Assert.AreEqual(1ul, smmu.ConfigurationCacheMisses);
+            Assert.AreEqual(1ul, smmu.ConfigurationCacheHits);
+        }
+
+        [Test]
+        public void ShouldRereadContextDescriptorAfterCfgiCd([Values(Opcode.CMD_CFGI_CD, Opcode.CMD_CFGI_CD_ALL)] Opcode opcode)
+        {
+            Translate(0x1000);
+            IssueCommand(opcode);
+            Translate(0x1000);
+
+            Assert.AreEqual(2ul, smmu.ConfigurationCacheMisses);
+            Assert.AreEqual(0ul, smmu.ConfigurationCacheHits);
+            // The translation is still cached for the unchanged ASID
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+        }
+
+        [Test]
+        public void ShouldUseAsidOfReloadedContextDescriptor([Values(Opcode.CMD_CFGI_CD, Opcode.CMD_CFGI_CD_ALL)] Opcode opcode)
+        {
+            Translate(0x1000);
+            WriteContextDescriptor(SecondAsid);
+
+            // The cached descriptor is used until it's invalidated
+            Translate(0x1000);
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+
+            IssueCommand(opcode);
+            Translate(0x1000);
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+            Assert.AreEqual(2ul, smmu.IotlbMisses);
+        }
+
+        [Test]
+        public void ShouldKeepTranslationsOfOtherAsidsOnTlbiNhAsid()
+        {
+            Translate(0x1000);
+            IssueCommand(Opcode.CMD_TLBI_NH_ASID, asid: SecondAsid);
+            Translate(0x1000);
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+
+            IssueCommand(Opcode.CMD_TLBI_NH_ASID, asid: FirstAsid);
+            Translate(0x1000);
+            Assert.AreEqual(1ul, smmu.IotlbHits);
+            Assert.AreEqual(2ul, smmu.IotlbMisses);
+        }
+
+        private WindowMMUBusController.MMUWindow Translate(ulong address)
+        {
+            var window = smmu.GetWindowFromPageTable(address, stream, AccessType.Read);
+            Assert.IsNotNull(window);
+            return window;
+        }
+
+        private void WriteContextDescriptor(ushort asid)
+        {
+            sysbus.WriteQuadWord(CdAddress, CdT0SZ | CdValid | CdAA64 | ((ulong)asid << 48));
+            sysbus.WriteQuadWord(CdAddress + 8, Level0TableAddress);
+        }
+
+        private void IssueCommand(Opcode opcode, ushort asid = 0)
+        {
+            var address = CommandQueueAddress + (commandsIssued % CommandQueueEntries) * CommandLength;
+            // StreamID is in bits 32-63 of CFGI_* commands, ASID is in bits 48-63 of TLBI_NH_ASID
+            var streamOrAsid = opcode == Opcode.CMD_TLBI_NH_ASID ? (ulong)asid << 48 : (ulong)StreamId << 32;
+            sysbus.WriteQuadWord(address, (ulong)opcode | streamOrAsid);
+            sysbus.WriteQuadWord(address + 8, 0);
+            commandsIssued++;
+
+            // The index is followed by the wrap bit
+            var produce = (uint)(commandsIssued % (2 * CommandQueueEntries));
+            smmu.WriteDoubleWord(SMMU_CMDQ_PROD, produce);
+            // The command was consumed without an error
+            Assert.AreEqual(produce, smmu.ReadDoubleWord(SMMU_CMDQ_CONS));
+        }
+
+        private IMachine machine;
+        private IBusController sysbus;
+        private ARM_SMMUv3 smmu;
+        private MockBusPeripheral stream;
+        private ulong commandsIssued;
+
+        private const int MemorySize = 0x10000;
+        private const ulong SmmuAddress = 0x10000000;
+        private const int StreamId = 0;
+
+        private const ulong StreamTableAddress = 0x1000;
+        private const uint StreamTableShift = 1;
+        private const ulong CommandQueueAddress = 0x2000;
+        private const ulong CommandQueueShift = 3;
+        private const ulong CommandQueueEntries = 1 << (int)CommandQueueShift;
+        private const ulong CommandLength = 16;
+        private const ulong CdAddress = 0x3000;
+        private const ulong Level0TableAddress = 0x4000;
+        private const ulong Level1TableAddress = 0x5000;
+        private const ulong OutputAddress = 0x40000000;
+        private const ushort FirstAsid = 1;
+        private const ushort SecondAsid = 2;
+
+        private const ulong SteValid = 1 << 0;
+        private const ulong SteConfigStage1 = 0b101 << 1;
+        private const ulong CdT0SZ = 16; // 48-bit input addresses
+        private const ulong CdValid = 1ul << 31;
+        private const ulong CdAA64 = 1ul << 41;
+        private const ulong PteBlock = 0b01;
+        private const ulong PteTable = 0b11;
+
+        private const long SMMU_CR0 = 0x20;
+        private const long SMMU_STRTAB_BASE = 0x80;
+        private const long SMMU_STRTAB_BASE_CFG = 0x88;
+        private const long SMMU_CMDQ_BASE = 0x90;
+        private const long SMMU_CMDQ_PROD = 0x98;
+        private const long SMMU_CMDQ_CONS = 0x9C;
+        private const uint CR0_SMMUEN = 1 << 0;
+        private const uint CR0_CMDQEN = 1 << 3;
+
+        private class MockBusPeripheral : IBusPeripheral
+        {
+            public void Reset()
+            {
+            }
+        }
+    }
+}
@@ -1,5 +1,5 @@
 //
-// Copyright (c) 2010-2024 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 // Copyright (c) 2011-2015 Realtime Embedded
 //
 // This file is licensed under the MIT License.
@@ -9,6 +9,7 @@
 
 using Antmicro.Renode.Peripherals.Timers;
 using Antmicro.Renode.Time;
+using Antmicro.Renode.Utilities;
 
 using NUnit.Framework;
 
@@ -150,5 +151,61 @@ public void ShouldNotGenerateAdditionalCompareEvent()
             Assert.AreEqual(timer.Value, compare);
             Assert.AreEqual(timer.Compare, compare);
         }
+
+        [Test]
+        public void ShouldReportLinearStateUntilCompare()
+        {
+            var clockSource = new BaseClockSource();
+            var timer = new ComparingTimer(clockSource, frequency: 1000000, owner: null,
+                  localName: String.Empty, enabled: true, eventEnabled: true, compare: 100);
+
+            clockSource.Advance(TimeInterval.FromMicroseconds(40), true);
+            Assert.IsTrue(timer.TryGetLinearState(out var state));
+            Assert.AreEqual(40, state.Value);
+            Assert.AreEqual(Fraction.Zero, state.Residuum);
+            Assert.AreEqual(TimeInterval.FromMicroseconds(60), state.ValidFor);
+
+            // The value extrapolated from the state has to match the one read later
+            var elapsed = TimeInterval.FromMicroseconds(25);
+            clockSource.Advance(elapsed, true);
+            Assert.AreEqual(timer.Value, state.Value + (elapsed.Ticks * state.Ratio + state.Residuum).Integer);
+        }
+
+        [Test]
+        public void ShouldNotReportLinearStateWhenDisabled()
+        {
+            var clockSource = new BaseClockSource();
+            var timer = new ComparingTimer(clockSource, frequency: 1000000, owner: null, localName: String.Empty, compare: 100);
+
+            Assert.IsFalse(timer.TryGetLinearState(out var _));
+            timer.Enabled = true;
+            Assert.IsTrue(timer.TryGetLinearState(out var _));
+        }
+
+        [Test]
+        public void ShouldNotifyStateChangesOnlyWhenTheValueProgressionChanges()
+        {
+            var stateChanges = 0;
+            var clockSource = new BaseClockSource();
+            var timer = new ComparingTimer(clockSource, frequency: 1000000, owner: null,
+                  localName: String.Empty, limit: 300, enabled: true, compare: 100);
+            timer.Value = 50;
+            clockSource.StateChanged += () => stateChanges++;
+
+            // Setting the same compare value exchanges the clock entry for an identical one
+            timer.Compare = 100;
+            Assert.AreEqual(0, stateChanges);
+
+            timer.Compare = 150;
+            Assert.AreEqual(1, stateChanges);
+
+            // Both 50 and 200 leave 100 ticks to the next event, so only the value accumulated by the timer differs
+            timer.Value = 200;
+            Assert.AreEqual(2, stateChanges);
+            Assert.AreEqual(200, timer.Value);
+
+            timer.Value = 200;
+            Assert.AreEqual(2, stateChanges);
+        }
     }
 }
\ No newline at end of file
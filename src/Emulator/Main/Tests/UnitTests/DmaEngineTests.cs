@@ -1,10 +1,11 @@
 //
-// Copyright (c) 2010-2025 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 //
 // This file is licensed under the MIT License.
 // Full license text is available in 'licenses/MIT.txt'.
 //
 using System;
+using System.Diagnostics;
 using System.Linq;
 
 using Antmicro.Renode.Core;
@@ -22,7 +23,7 @@ public class DmaEngineTests
         [SetUp]
         public void SetUp()
         {
-            var machine = new Machine();
+            machine = new Machine();
             EmulationManager.Instance.CurrentEmulation.AddMachine(machine);
 
             rawArraySource = new byte[MemorySize];
@@ -78,6 +79,92 @@ public void SetUp()
             Assert.That(dataToTransfer.SequenceEqual(dataTransferred));
         }
 
+        [Test]
+        public void ShouldCopyBetweenMappedMemoriesLikeBetweenPeripherals(
+            [Values(true, false)] bool incrementReadAddress,
+            [Values(true, false)] bool incrementWriteAddress,
+            [Values(4L, 8L, -4L)] long sourceStep,
+            [Values(4L, 12L)] long destinationStep
+        )
+        {
+            // A non-incrementing read of continuous mapped memory only reads the first unit, so the rest of the data differs
+            Assume.That(sourceStep != 4 || incrementReadAddress || (destinationStep == 4 && incrementWriteAddress));
+            // Memories other than MappedMemory are accessed through the bus unit by unit, which is the reference here
+            var data = Enumerable.Range(0, (int)MemorySize).Select(x => (byte)(x * 7)).ToArray();
+            mappedMemorySource.WriteBytes(0, data);
+            arrayMemorySource.WriteBytes(0, data);
+
+            const int numberOfBytesToTransfer = 32;
+            const int sourceOffset = 128;
+            const int destinationOffset = 256;
+            Response Copy(uint sourceStartAddress, uint destinationStartAddress)
+            {
+                return dmaEngine.IssueCopy(new Request(
+                    source: (ulong)(sourceStartAddress + sourceOffset),
+                    destination: (ulong)(destinationStartAddress + destinationOffset),
+                    size: numberOfBytesToTransfer,
+                    readTransferType: TransferType.DoubleWord,
+                    writeTransferType: TransferType.DoubleWord,
+                    sourceIncrementStep: unchecked((ulong)sourceStep),
+                    destinationIncrementStep: unchecked((ulong)destinationStep),
+                    incrementReadAddress: incrementReadAddress,
+                    incrementWriteAddress: incrementWriteAddress
+                ));
+            }
+
+            var mappedResponse = Copy(MappedMemorySourceStartAddress, MappedMemoryDestinationStartAddress);
+            var arrayResponse = Copy(ArrayMemorySourceStartAddress, ArrayMemoryDestinationStartAddress);
+
+            Assert.AreEqual(arrayMemoryDestination.ReadBytes(0, (int)MemorySize), mappedMemoryDestination.ReadBytes(0, (int)MemorySize));
+            Assert.AreEqual(arrayResponse.ReadAddress - ArrayMemorySourceStartAddress, mappedResponse.ReadAddress - MappedMemorySourceStartAddress);
+            Assert.AreEqual(arrayResponse.WriteAddress - ArrayMemoryDestinationStartAddress, mappedResponse.WriteAddress - MappedMemoryDestinationStartAddress);
+        }
+
+        [Test]
+        public void ShouldCopyOverlappingRangesOfMappedMemory()
+        {
+            var data = Enumerable.Range(0, 64).Select(x => (byte)x).ToArray();
+            mappedMemorySource.WriteBytes(0, data);
+
+            dmaEngine.IssueCopy(new Request(
+                source: (ulong)MappedMemorySourceStartAddress,
+                destination: (ulong)(MappedMemorySourceStartAddress + 8),
+                size: 32,
+                readTransferType: TransferType.DoubleWord,
+                writeTransferType: TransferType.DoubleWord
+            ));
+
+            Assert.AreEqual(data.Take(32).ToArray(), mappedMemorySource.ReadBytes(8, 32));
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void BenchmarkMappedMemoryTransfers()
+        {
+            const int transferSize = 4 * 1024 * 1024;
+            const int repetitions = 50;
+            const ulong sourceAddress = 0x10000000;
+            const ulong destinationAddress = 0x20000000;
+            sysbus.Register(new MappedMemory(machine, transferSize), new BusPointRegistration(sourceAddress));
+            sysbus.Register(new MappedMemory(machine, transferSize), new BusPointRegistration(destinationAddress));
+
+            var shapes = new[]
+            {
+                ("Linear copy", new Request(sourceAddress, destinationAddress, transferSize, TransferType.QuadWord, TransferType.QuadWord)),
+                ("Fill from a fixed address", new Request(sourceAddress, destinationAddress, transferSize, TransferType.DoubleWord, TransferType.DoubleWord, incrementReadAddress: false)),
+                ("Strided gather", new Request(sourceAddress, destinationAddress, transferSize / 2, TransferType.DoubleWord, TransferType.DoubleWord, 8, 4)),
+            };
+            foreach(var (description, request) in shapes)
+            {
+                var stopwatch = Stopwatch.StartNew();
+                for(var i = 0; i < repetitions; i++)
+                {
+                    dmaEngine.IssueCopy(request);
+                }
+                stopwatch.Stop();
+                Console.WriteLine("{0}: {1:0.00} GB/s", description, (double)request.Size * repetitions / stopwatch.Elapsed.TotalSeconds / 1e9);
+            }
+        }
+
         private IMultibyteWritePeripheral GetMemory(PlaceType placeType)
         {
             switch(placeType)
@@ -134,6 +221,7 @@ private Place GetPlaceInMemory(PlaceType placeType, int offset)
 
         private static readonly byte[] InitialPattern = new byte[] { 0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF };
 
+        private Machine machine;
         private IBusController sysbus;
         private DmaEngine dmaEngine;
 
@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System.Collections.Generic;
+
+using Antmicro.Renode.Peripherals.Miscellaneous;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class ExternalPMPRegionTableTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            target = new RecordingRegionTable();
+            table = new ExternalPMPRegionTable(target);
+            table.Configure(RegionsCount, AddressMask);
+        }
+
+        [Test]
+        public void ShouldConfigureTable()
+        {
+            Assert.AreEqual(RegionsCount, target.RegionsCount);
+            Assert.AreEqual(AddressMask, target.AddressMask);
+            Assert.IsEmpty(target.Regions);
+        }
+
+        [Test]
+        public void ShouldEncodeRegionConfig()
+        {
+            // Read and execute
+            table.SetRegion(3, 0x1000, 0x1fff, 0x5, enabled: true, locked: false);
+            Assert.AreEqual(new Region(0x1000, 0x1fff, 0x5 | ExternalPMPRegionTable.RegionEnabled), target.Regions[3]);
+
+            table.SetRegion(3, 0x1000, 0x1fff, 0x1, enabled: false, locked: true);
+            Assert.AreEqual(new Region(0x1000, 0x1fff, 0x1 | ExternalPMPRegionTable.RegionLocked), target.Regions[3]);
+        }
+
+        [Test]
+        public void ShouldSendOnlyChangedRegions()
+        {
+            // The native table starts zeroed, so an empty region doesn't have to be sent
+            table.SetRegion(0, 0, 0, 0, enabled: false, locked: false);
+            Assert.AreEqual(0, target.Updates);
+
+            table.SetRegion(1, 0x0, 0xfff, 0x7, enabled: true, locked: false);
+            table.SetRegion(1, 0x0, 0xfff, 0x7, enabled: true, locked: false);
+            Assert.AreEqual(1, target.Updates);
+
+            table.SetRegion(1, 0x0, 0x1fff, 0x7, enabled: true, locked: false);
+            Assert.AreEqual(2, target.Updates);
+            Assert.AreEqual(new Region(0x0, 0x1fff, 0x7 | ExternalPMPRegionTable.RegionEnabled), target.Regions[1]);
+        }
+
+        [Test]
+        public void ShouldSendAllRegionsAfterReconfiguration()
+        {
+            table.SetRegion(1, 0x0, 0xfff, 0x7, enabled: true, locked: false);
+            table.Configure(RegionsCount, AddressMask);
+            Assert.IsEmpty(target.Regions);
+
+            table.SetRegion(1, 0x0, 0xfff, 0x7, enabled: true, locked: false);
+            Assert.AreEqual(new Region(0x0, 0xfff, 0x7 | ExternalPMPRegionTable.RegionEnabled), target.Regions[1]);
+        }
+
+        private RecordingRegionTable target;
+        private ExternalPMPRegionTable table;
+
+        private const uint RegionsCount = 16;
+        private const ulong AddressMask = 0xffffffff;
+
+        private struct Region
+        {
+            public Region(ulong start, ulong end, uint config)
+            {
+                Start = start;
+                End = end;
+                Config = config;
+            }
+
+            public ulong Start;
+            public ulong End;
+            public uint Config;
+        }
+
+        // Keeps the regions the same way as the native table, which is cleared when configured
+        private class RecordingRegionTable : IExternalPMPRegionTable
+        {
+            public void ConfigureExternalPMPRegions(uint regionsCount, ulong addressMask)
+            {
+                RegionsCount = regionsCount;
+                AddressMask = addressMask;
+                Regions.Clear();
+            }
+
+            public void SetExternalPMPRegion(uint index, ulong startAddress, ulong endAddress, uint config)
+            {
+                Assert.Less(index, RegionsCount);
+                Regions[index] = new Region(startAddress, endAddress, config);
+                Updates++;
+            }
+
+            public Dictionary<uint, Region> Regions { get; } = new Dictionary<uint, Region>();
+
+            public uint RegionsCount { get; private set; }
+
+            public ulong AddressMask { get; private set; }
+
+            public int Updates { get; private set; }
+        }
+    }
+}
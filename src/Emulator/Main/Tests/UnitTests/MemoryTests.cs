@@ -1,5 +1,5 @@
 //
-// Copyright (c) 2010-2018 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 // Copyright (c) 2011-2015 Realtime Embedded
 //
 // This file is licensed under the MIT License.
@@ -32,5 +32,26 @@ public void ShouldReadWriteMemoryBiggerThan2GB()
             Assert.AreEqual(0x1, machine.SystemBus.ReadByte(offset1));
             Assert.AreEqual(0x2, machine.SystemBus.ReadByte(offset2));
         }
+
+        [Test]
+        public void ShouldUseSingleAlignedSegmentForHugePageBackedMemory()
+        {
+            if(!RuntimeInfo.IsLinux())
+            {
+                Assert.Ignore("Huge pages are only supported on Linux");
+            }
+
+            const uint memorySize = 6 * 1024 * 1024;
+            var machine = new Machine();
+            var memory = new MappedMemory(machine, memorySize, hugePages: MappedMemory.HugePageSize.Size2MB);
+            machine.SystemBus.Register(memory, 0x0);
+            machine.SystemBus.WriteDoubleWord(0x10, 0x12345678);
+            machine.SystemBus.WriteDoubleWord(memorySize - 4, 0x9ABCDEF0);
+
+            Assert.AreEqual(1, memory.SegmentCount);
+            Assert.AreEqual(0, (long)memory.GetSegment(0) % (long)MappedMemory.HugePageSize.Size2MB);
+            Assert.AreEqual(0x12345678, machine.SystemBus.ReadDoubleWord(0x10));
+            Assert.AreEqual(0x9ABCDEF0, machine.SystemBus.ReadDoubleWord(memorySize - 4));
+        }
     }
 }
\ No newline at end of file
@@ -1,5 +1,5 @@
 //
-// Copyright (c) 2010-2024 Antmicro
+// Copyright (c) 2010-2026 Antmicro
 // Copyright (c) 2011-2015 Realtime Embedded
 //
 // This file is licensed under the MIT License.
@@ -13,7 +13,11 @@ namespace Antmicro.Renode.UnitTests.Mocks
 {
     public class EmptyCPU : BaseCPU
     {
-        public EmptyCPU(IMachine machine, string model = "emptyCPU") : base(0, model, machine, ELFSharp.ELF.Endianess.LittleEndian)
+        public EmptyCPU(IMachine machine, string model = "emptyCPU") : this(0, machine, model)
+        {
+        }
+
+        protected EmptyCPU(uint id, IMachine machine, string model) : base(id, model, machine, ELFSharp.ELF.Endianess.LittleEndian)
         {
         }
 
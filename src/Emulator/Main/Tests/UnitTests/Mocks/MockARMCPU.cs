@@ -0,0 +1,43 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.CPU;
+
+namespace Antmicro.Renode.UnitTests.Mocks
+{
+    // Its Affinity matches the Multiprocessing ID, so the GIC uses it as the Processor Number
+    [GPIO(NumberOfInputs = 4)]
+    public class MockARMCPU : EmptyCPU, IARMSingleSecurityStateCPU
+    {
+        public MockARMCPU(IMachine machine, uint id) : base(id, machine, "mockARM")
+        {
+            Affinity = new Affinity(id);
+        }
+
+        public void OnGPIO(int number, bool value)
+        {
+            signals[number] = value;
+        }
+
+        public bool IsSignalSet(InterruptSignalType type)
+        {
+            return signals[(int)type];
+        }
+
+        public ExceptionLevel ExceptionLevel => ExceptionLevel.EL1_SystemMode;
+
+        public Affinity Affinity { get; }
+
+        public SecurityState SecurityState => SecurityState.NonSecure;
+
+        public bool FIQMaskOverride => false;
+
+        public bool IRQMaskOverride => false;
+
+        private readonly bool[] signals = new bool[4];
+    }
+}
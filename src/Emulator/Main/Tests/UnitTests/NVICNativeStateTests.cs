@@ -0,0 +1,388 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System.Collections.Generic;
+using System.Linq;
+
+using Antmicro.Renode.Peripherals.IRQControllers;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class NVICNativeStateTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            // The last slot stands for a Secure banked exception
+            exceptionNumbers = Enumerable.Range(0, ExceptionsCount).Append(SecureBankedException).ToArray();
+            priorities = new Dictionary<int, int>();
+            groupPriorities = new Dictionary<int, int>();
+            state = new RecordingNativeState();
+            publisher = new NVICNativeStatePublisher(state, exceptionNumbers,
+                i => priorities.TryGetValue(i, out var priority) ? priority : 0,
+                i => groupPriorities.TryGetValue(i, out var priority) ? priority : 0);
+        }
+
+        [Test]
+        public void ShouldPublishAllPrioritiesInitially()
+        {
+            priorities[2] = -2;
+            groupPriorities[2] = -2;
+            priorities[20] = 0x41;
+            groupPriorities[20] = 0x40;
+            priorities[SecureBankedException] = 0x20;
+            Publish();
+
+            CollectionAssert.AreEquivalent(new Dictionary<int, (int, int)>
+            {
+                { 2, (-2, -2) },
+                { 20, (0x41, 0x40) },
+                { BankedSlot, (0x20, 0) },
+            }, state.Priorities);
+            Assert.AreEqual(1, state.Updates);
+            Assert.IsTrue(state.Valid);
+        }
+
+        [Test]
+        public void ShouldPublishOnlyChangedPriorities()
+        {
+            priorities[20] = 0x40;
+            Publish();
+            state.Priorities.Clear();
+
+            priorities[21] = 0x80;
+            Publish();
+            Assert.IsEmpty(state.Priorities, "Priorities shouldn't be sent until they are marked as changed");
+
+            publisher.MarkPrioritiesChanged();
+            Publish();
+            CollectionAssert.AreEquivalent(new Dictionary<int, (int, int)> { { 21, (0x80, 0) } }, state.Priorities);
+        }
+
+        [Test]
+        public void ShouldPublishPrioritiesAfterGroupingOrSecurityConfigurationChange()
+        {
+            Publish();
+            groupPriorities[20] = 0x40;
+            Publish(binaryPoint: 3);
+            CollectionAssert.AreEquivalent(new Dictionary<int, (int, int)> { { 20, (0, 0x40) } }, state.Priorities);
+
+            state.Priorities.Clear();
+            priorities[20] = 0xA0;
+            Publish(binaryPoint: 3, flags: NVICNativeFlags.TrustZone | NVICNativeFlags.PrioritizeSecure);
+            CollectionAssert.AreEquivalent(new Dictionary<int, (int, int)> { { 20, (0xA0, 0x40) } }, state.Priorities);
+
+            // Lockup doesn't change the priorities
+            state.Priorities.Clear();
+            priorities[20] = 0x10;
+            Publish(binaryPoint: 3, flags: NVICNativeFlags.TrustZone | NVICNativeFlags.PrioritizeSecure | NVICNativeFlags.LockedUp);
+            Assert.IsEmpty(state.Priorities);
+        }
+
+        [Test]
+        public void ShouldPublishBankedExceptionNumbersOnce()
+        {
+            Publish();
+            CollectionAssert.AreEquivalent(new Dictionary<int, int> { { BankedSlot, SecureBankedException } }, state.ExceptionNumbers);
+
+            state.ExceptionNumbers.Clear();
+            Publish();
+            Assert.IsEmpty(state.ExceptionNumbers);
+        }
+
+        [Test]
+        public void ShouldPublishPendingAndEnabledChanges()
+        {
+            // An interrupt becomes a candidate when it's both pending and enabled
+            Publish(candidates: new[] { 16 });
+            Assert.AreEqual(1UL << 16, state.Candidates[0]);
+            state.Candidates.Clear();
+
+            Publish(candidates: new[] { 16, 100 });
+            CollectionAssert.AreEquivalent(new Dictionary<int, ulong> { { 1, 1UL << (100 - 64) } }, state.Candidates);
+
+            // Disabling or clearing the pending state drops the candidate
+            Publish(candidates: new[] { 100 });
+            Assert.AreEqual(0UL, state.Candidates[0]);
+        }
+
+        [Test]
+        public void ShouldPublishActiveStackFromItsBottom()
+        {
+            // From the top of the stack, as NVIC enumerates it
+            publisher.Clear();
+            publisher.AddActive(17, pending: true, running: false);
+            publisher.AddActive(15, pending: false, running: true);
+            publisher.AddActive(BankedSlot, pending: false, running: false);
+            publisher.Publish(0, 0, 0, 0, PriorityMask, NVICNativeFlags.TrustZone, false, false);
+
+            Assert.AreEqual(3, state.ActiveDepth);
+            CollectionAssert.AreEqual(new[] { BankedSlot, 15, 17 }, Enumerable.Range(0, 3).Select(i => state.ActiveStack[i]));
+            Assert.AreEqual((1UL << 15) | (1UL << 17), state.Active[0]);
+            Assert.AreEqual(1UL << (BankedSlot % 64), state.Active[BankedSlot / 64]);
+            Assert.AreEqual(1UL << 17, state.PendingActive[0]);
+            Assert.AreEqual(1UL << 15, state.Running[0]);
+
+            Publish();
+            Assert.AreEqual(0, state.ActiveDepth);
+            Assert.AreEqual(0UL, state.Active[0]);
+            Assert.AreEqual(0UL, state.PendingActive[0]);
+            Assert.AreEqual(0UL, state.Running[0]);
+        }
+
+        [Test]
+        public void ShouldPublishPriorityBoostStateAndOutputs()
+        {
+            Publish(basepri: 0x40, irqLine: true, flags: NVICNativeFlags.LockedUp);
+            Assert.AreEqual(0x40, state.NonSecureBasepri);
+            Assert.AreEqual(NVICNativeFlags.LockedUp, state.Flags);
+            Assert.AreEqual(PriorityMask, state.PriorityMask);
+            Assert.IsTrue(state.IrqLine);
+
+            Publish(basepri: 0x20, binaryPoint: 2);
+            Assert.AreEqual(0x20, state.NonSecureBasepri);
+            Assert.AreEqual(2, state.NonSecureBinaryPoint);
+            Assert.AreEqual(NVICNativeFlags.None, state.Flags);
+            Assert.IsFalse(state.IrqLine);
+            Assert.AreEqual(2, state.Updates);
+        }
+
+        [Test]
+        public void ShouldInvalidateUntilNextPublication()
+        {
+            Publish();
+            publisher.Invalidate();
+            Assert.IsFalse(state.Valid);
+
+            Publish();
+            Assert.IsTrue(state.Valid);
+        }
+
+        [Test]
+        public void ShouldTakeOperationsOnlyAfterPublication()
+        {
+            Assert.IsFalse(publisher.TryTakeOperation(out var _));
+            Assert.AreEqual(0, state.TakeCalls, "Nothing can be done natively before the state is published");
+
+            Publish();
+            state.Operations.Enqueue(Encode(NVICNativeOperationType.Acknowledge, SecureBankedException));
+            state.Operations.Enqueue(Encode(NVICNativeOperationType.WriteSecureBasepri, 0x60));
+            state.Operations.Enqueue(Encode(NVICNativeOperationType.Complete, 16));
+
+            Assert.IsTrue(publisher.TryTakeOperation(out var operation));
+            Assert.IsFalse(state.Valid, "Taking the operations invalidates the native state");
+            Assert.AreEqual(NVICNativeOperationType.Acknowledge, operation.Type);
+            Assert.AreEqual(SecureBankedException, operation.Argument);
+            Assert.IsTrue(publisher.TryTakeOperation(out operation));
+            Assert.AreEqual(NVICNativeOperationType.WriteSecureBasepri, operation.Type);
+            Assert.AreEqual(0x60, operation.Argument);
+            Assert.IsTrue(publisher.TryTakeOperation(out operation));
+            Assert.AreEqual(NVICNativeOperationType.Complete, operation.Type);
+            Assert.AreEqual(16, operation.Argument);
+            Assert.IsFalse(publisher.TryTakeOperation(out operation));
+
+            // No operations can be done until the next publication
+            var takeCalls = state.TakeCalls;
+            Assert.IsFalse(publisher.TryTakeOperation(out operation));
+            Assert.AreEqual(takeCalls, state.TakeCalls);
+        }
+
+        [Test]
+        public void ShouldRepublishStateChangedByOperations()
+        {
+            Publish(candidates: new[] { 16 });
+            state.Candidates.Clear();
+            state.Active.Clear();
+
+            // The native library acknowledged the exception, while NVIC pended it again in the meantime
+            state.Operations.Enqueue(Encode(NVICNativeOperationType.Acknowledge, 16));
+            while(publisher.TryTakeOperation(out var _))
+            {
+            }
+            publisher.Clear();
+            publisher.AddCandidate(16);
+            publisher.Publish(0, 0, 0, 0, PriorityMask, NVICNativeFlags.None, false, false);
+
+            Assert.AreEqual(1UL << 16, state.Candidates[0]);
+            Assert.AreEqual(0UL, state.Active[0]);
+        }
+
+        [Test]
+        public void ShouldDecodeOutputs()
+        {
+            state.Outputs = 0b10;
+            publisher.GetOutputs(out var irqLine, out var maskedInterruptPresent);
+            Assert.IsFalse(irqLine);
+            Assert.IsTrue(maskedInterruptPresent);
+
+            state.Outputs = 0b01;
+            publisher.GetOutputs(out irqLine, out maskedInterruptPresent);
+            Assert.IsTrue(irqLine);
+            Assert.IsFalse(maskedInterruptPresent);
+        }
+
+        private static ulong Encode(NVICNativeOperationType type, int argument)
+        {
+            return ((ulong)type << 32) | (uint)argument;
+        }
+
+        private void Publish(int[] candidates = null, byte basepri = 0, int binaryPoint = 0, NVICNativeFlags flags = NVICNativeFlags.None, bool irqLine = false)
+        {
+            publisher.Clear();
+            foreach(var i in candidates ?? new int[0])
+            {
+                publisher.AddCandidate(i);
+            }
+            publisher.Publish(binaryPoint, 0, basepri, 0, PriorityMask, flags, irqLine, false);
+        }
+
+        private int[] exceptionNumbers;
+        private Dictionary<int, int> priorities;
+        private Dictionary<int, int> groupPriorities;
+        private RecordingNativeState state;
+        private NVICNativeStatePublisher publisher;
+
+        private const int ExceptionsCount = 512 + 16 + 1;
+        private const int BankedSlot = ExceptionsCount;
+        // SysTick_S
+        private const int SecureBankedException = (1 << 30) | 15;
+        private const byte PriorityMask = 0xF0;
+
+        private class RecordingNativeState : INVICNativeState
+        {
+            public void BeginNvicStateUpdate()
+            {
+                Assert.IsFalse(inUpdate);
+                inUpdate = true;
+                Valid = false;
+            }
+
+            public void SetNvicCandidateExceptions(int word, ulong bits)
+            {
+                Assert.IsTrue(inUpdate);
+                Candidates[word] = bits;
+            }
+
+            public void SetNvicActiveExceptions(int word, ulong bits)
+            {
+                Assert.IsTrue(inUpdate);
+                Active[word] = bits;
+            }
+
+            public void SetNvicRunningExceptions(int word, ulong bits)
+            {
+                Assert.IsTrue(inUpdate);
+                Running[word] = bits;
+            }
+
+            public void SetNvicPendingActiveExceptions(int word, ulong bits)
+            {
+                Assert.IsTrue(inUpdate);
+                PendingActive[word] = bits;
+            }
+
+            public void SetNvicActiveStackEntry(int index, int slot)
+            {
+                Assert.IsTrue(inUpdate);
+                ActiveStack[index] = slot;
+            }
+
+            public void SetNvicExceptionNumber(int slot, int number)
+            {
+                Assert.IsTrue(inUpdate);
+                ExceptionNumbers[slot] = number;
+            }
+
+            public void SetNvicPriority(int slot, int priority, int groupPriority)
+            {
+                Assert.IsTrue(inUpdate);
+                Priorities[slot] = (priority, groupPriority);
+            }
+
+            public void SetNvicPriorityBoostState(byte nonSecureBasepri, byte secureBasepri, int nonSecureBinaryPoint, int secureBinaryPoint)
+            {
+                Assert.IsTrue(inUpdate);
+                NonSecureBasepri = nonSecureBasepri;
+                NonSecureBinaryPoint = nonSecureBinaryPoint;
+            }
+
+            public void SetNvicExecutionState(NVICNativeFlags flags, int activeDepth, byte priorityMask)
+            {
+                Assert.IsTrue(inUpdate);
+                Flags = flags;
+                ActiveDepth = activeDepth;
+                PriorityMask = priorityMask;
+            }
+
+            public void EndNvicStateUpdate(bool irqLine, bool maskedInterruptPresent)
+            {
+                Assert.IsTrue(inUpdate);
+                inUpdate = false;
+                IrqLine = irqLine;
+                Valid = true;
+                Updates++;
+            }
+
+            public void InvalidateNvicState()
+            {
+                Valid = false;
+            }
+
+            public ulong TakeNvicOperation()
+            {
+                TakeCalls++;
+                Valid = false;
+                return Operations.Count == 0 ? 0 : Operations.Dequeue();
+            }
+
+            public uint GetNvicOutputs()
+            {
+                return Outputs;
+            }
+
+            public Dictionary<int, ulong> Candidates { get; } = new Dictionary<int, ulong>();
+
+            public Dictionary<int, ulong> Active { get; } = new Dictionary<int, ulong>();
+
+            public Dictionary<int, ulong> Running { get; } = new Dictionary<int, ulong>();
+
+            public Dictionary<int, ulong> PendingActive { get; } = new Dictionary<int, ulong>();
+
+            public Dictionary<int, int> ActiveStack { get; } = new Dictionary<int, int>();
+
+            public Dictionary<int, int> ExceptionNumbers { get; } = new Dictionary<int, int>();
+
+            public Dictionary<int, (int, int)> Priorities { get; } = new Dictionary<int, (int, int)>();
+
+            public Queue<ulong> Operations { get; } = new Queue<ulong>();
+
+            public byte NonSecureBasepri { get; private set; }
+
+            public int NonSecureBinaryPoint { get; private set; }
+
+            public NVICNativeFlags Flags { get; private set; }
+
+            public int ActiveDepth { get; private set; }
+
+            public byte PriorityMask { get; private set; }
+
+            public bool IrqLine { get; private set; }
+
+            public bool Valid { get; private set; }
+
+            public int Updates { get; private set; }
+
+            public int TakeCalls { get; private set; }
+
+            public uint Outputs { get; set; }
+
+            private bool inUpdate;
+        }
+    }
+}
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System.Collections.Generic;
+
+using Antmicro.Renode.Exceptions;
+using Antmicro.Renode.Peripherals.CPU;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class NativeCustomInstructionTableTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            target = new RecordingTarget();
+            table = new NativeCustomInstructionTable(target);
+        }
+
+        [Test]
+        public void ShouldResolveHandlerBeforeInstallingPattern()
+        {
+            var id = table.Install(Pattern, LibraryPath, "handler", "custom");
+
+            Assert.AreEqual(1, id);
+            CollectionAssert.AreEqual(new[]
+            {
+                $"resolve {LibraryPath} handler",
+                $"pattern {Pattern} custom",
+                $"install 1 {LibraryPath} handler",
+            }, target.Calls);
+        }
+
+        [Test]
+        public void ShouldNotInstallPatternIfHandlerCannotBeResolved()
+        {
+            target.ResolveSucceeds = false;
+
+            Assert.Throws<ConstructionException>(() => table.Install(Pattern, LibraryPath, "missing", null));
+            CollectionAssert.AreEqual(new[] { $"resolve {LibraryPath} missing" }, target.Calls);
+
+            // Nothing is restored for a failed installation
+            target.Calls.Clear();
+            table.Restore((libraryPath, handlerName) => Assert.Fail("Nothing should be restored"));
+            Assert.IsEmpty(target.Calls);
+        }
+
+        [Test]
+        public void ShouldNotRestoreHandlerWhoseInstallationFailed()
+        {
+            target.InstallSucceeds = false;
+
+            Assert.Throws<ConstructionException>(() => table.Install(Pattern, LibraryPath, "handler", null));
+            // The pattern stays installed in tlib, but its instructions are handled in C#
+            Assert.AreEqual(1, target.PatternsInstalled);
+
+            target.InstallSucceeds = true;
+            target.Calls.Clear();
+            table.Restore((libraryPath, handlerName) => Assert.Fail("Nothing should be restored"));
+            Assert.IsEmpty(target.Calls);
+        }
+
+        [Test]
+        public void ShouldRestoreOnlyHandlersInInstallationOrder()
+        {
+            table.Install(Pattern, LibraryPath, "first", null);
+            table.Install(Pattern, OtherLibraryPath, "second", null);
+            target.Calls.Clear();
+
+            table.Restore((libraryPath, handlerName) => Assert.Fail("Restoring should succeed"));
+
+            // Patterns are restored with the tlib state
+            CollectionAssert.AreEqual(new[]
+            {
+                $"install 1 {LibraryPath} first",
+                $"install 2 {OtherLibraryPath} second",
+            }, target.Calls);
+        }
+
+        [Test]
+        public void ShouldReportHandlersThatCouldNotBeRestored()
+        {
+            table.Install(Pattern, LibraryPath, "first", null);
+            table.Install(Pattern, OtherLibraryPath, "second", null);
+            target.InstallSucceeds = false;
+
+            var failures = new List<string>();
+            table.Restore((libraryPath, handlerName) => failures.Add($"{libraryPath} {handlerName}"));
+
+            CollectionAssert.AreEqual(new[] { $"{LibraryPath} first", $"{OtherLibraryPath} second" }, failures);
+        }
+
+        private RecordingTarget target;
+        private NativeCustomInstructionTable table;
+
+        private const string Pattern = "0000000----------000-----0001011";
+        private const string LibraryPath = "/plugins/libfirst.so";
+        private const string OtherLibraryPath = "/plugins/libsecond.so";
+
+        private class RecordingTarget : INativeCustomInstructionTarget
+        {
+            public bool ResolveNativeCustomInstruction(string libraryPath, string handlerName)
+            {
+                Calls.Add($"resolve {libraryPath} {handlerName}");
+                return ResolveSucceeds;
+            }
+
+            public ulong InstallCustomInstructionPattern(string pattern, string name)
+            {
+                Calls.Add($"pattern {pattern} {name}");
+                // Ids returned by tlib start from 1
+                return ++PatternsInstalled;
+            }
+
+            public bool InstallNativeCustomInstructionHandler(ulong id, string libraryPath, string handlerName)
+            {
+                Calls.Add($"install {id} {libraryPath} {handlerName}");
+                return InstallSucceeds;
+            }
+
+            public List<string> Calls { get; } = new List<string>();
+
+            public ulong PatternsInstalled { get; private set; }
+
+            public bool ResolveSucceeds { get; set; } = true;
+
+            public bool InstallSucceeds { get; set; } = true;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using Antmicro.Renode.Peripherals.IRQControllers.ARM_GenericInterruptControllerModel;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class PendingInterruptsQueueTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            queue = new PendingInterruptsQueue<string>();
+        }
+
+        [Test]
+        public void ShouldFindPrioritiesWithPendingInterruptsFromTheHighest()
+        {
+            queue.Add("a", 0x80);
+            queue.Add("b", 0x40);
+            queue.Add("c", 0xFF);
+
+            Assert.AreEqual(0x40, queue.FindNextPriority(0));
+            Assert.AreEqual(0x80, queue.FindNextPriority(0x41));
+            Assert.AreEqual(0xFF, queue.FindNextPriority(0x81));
+            Assert.AreEqual(PendingInterruptsQueue<string>.NoPriority, queue.FindNextPriority(0x100));
+        }
+
+        [Test]
+        public void ShouldKeepPendingOrderWithinPriority()
+        {
+            queue.Add("a", 0x10);
+            queue.Add("b", 0x10);
+            queue.Add("c", 0x10);
+            queue.Remove("b");
+            // Adding an interrupt which is already pending doesn't change its position
+            queue.Add("a", 0x10);
+
+            CollectionAssert.AreEqual(new[] { "a", "c" }, queue.GetInterrupts(0x10));
+        }
+
+        [Test]
+        public void ShouldKeepPendingOrderWhenPriorityChanges()
+        {
+            queue.Add("a", 0x10);
+            queue.Add("b", 0x20);
+            queue.Add("c", 0x20);
+            queue.UpdatePriority("a", 0x20);
+
+            Assert.AreEqual(0x20, queue.FindNextPriority(0));
+            CollectionAssert.AreEqual(new[] { "a", "b", "c" }, queue.GetInterrupts(0x20));
+
+            queue.UpdatePriority("b", 0x10);
+            queue.UpdatePriority("b", 0x20);
+            CollectionAssert.AreEqual(new[] { "a", "b", "c" }, queue.GetInterrupts(0x20));
+        }
+
+        [Test]
+        public void ShouldClearPriorityWhenLastInterruptIsRemoved()
+        {
+            queue.Add("a", 0x10);
+            queue.Add("b", 0x90);
+            queue.Remove("a");
+
+            Assert.AreEqual(0x90, queue.FindNextPriority(0));
+            queue.Remove("b");
+            Assert.AreEqual(PendingInterruptsQueue<string>.NoPriority, queue.FindNextPriority(0));
+        }
+
+        [Test]
+        public void ShouldIgnoreInterruptsWhichAreNotPending()
+        {
+            queue.UpdatePriority("a", 0x10);
+            queue.Remove("a");
+
+            Assert.AreEqual(PendingInterruptsQueue<string>.NoPriority, queue.FindNextPriority(0));
+        }
+
+        private PendingInterruptsQueue<string> queue;
+    }
+}
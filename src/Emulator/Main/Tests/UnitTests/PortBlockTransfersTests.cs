@@ -0,0 +1,198 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals;
+using Antmicro.Renode.Peripherals.Bus;
+using Antmicro.Renode.Peripherals.CPU;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class PortBlockTransfersTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            machine = new Machine();
+            EmulationManager.Instance.CurrentEmulation.AddMachine(machine);
+            transfers = new PortBlockTransfers(machine, null, PortsBaseAddress);
+            blockPeripheral = new MockPortBlockPeripheral();
+            machine.SystemBus.Register(blockPeripheral, new BusRangeRegistration(PortsBaseAddress + BlockPeripheralPort, PortsRangeSize));
+            buffer = Marshal.AllocHGlobal(BufferSize);
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            Marshal.FreeHGlobal(buffer);
+            EmulationManager.Instance.Clear();
+        }
+
+        [Test]
+        public void ShouldPassStringInToPortBlockPeripheral()
+        {
+            transfers.Read((ushort)(BlockPeripheralPort + 2), 2, 4, buffer);
+
+            Assert.AreEqual(1, blockPeripheral.ReadCalls);
+            Assert.AreEqual(2, blockPeripheral.LastOffset);
+            Assert.AreEqual(SysbusAccessWidth.Word, blockPeripheral.LastWidth);
+            Assert.AreEqual(4, blockPeripheral.LastCount);
+            // The peripheral fills the block with consecutive bytes
+            for(var i = 0; i < 8; i++)
+            {
+                Assert.AreEqual((byte)i, Marshal.ReadByte(buffer, i));
+            }
+        }
+
+        [Test]
+        public void ShouldPassStringOutToPortBlockPeripheral()
+        {
+            var data = new byte[] { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88 };
+            Marshal.Copy(data, 0, buffer, data.Length);
+
+            transfers.Write(BlockPeripheralPort, 4, 2, buffer);
+
+            Assert.AreEqual(1, blockPeripheral.WriteCalls);
+            Assert.AreEqual(0, blockPeripheral.LastOffset);
+            Assert.AreEqual(SysbusAccessWidth.DoubleWord, blockPeripheral.LastWidth);
+            Assert.AreEqual(2, blockPeripheral.LastCount);
+            CollectionAssert.AreEqual(data, blockPeripheral.LastWritten);
+        }
+
+        [Test]
+        public void ShouldAccessOtherPeripheralsElementByElement()
+        {
+            var bytePeripheral = new MockBytePeripheral();
+            machine.SystemBus.Register(bytePeripheral, new BusRangeRegistration(PortsBaseAddress + BytePeripheralPort, PortsRangeSize));
+            Marshal.Copy(new byte[] { 1, 2, 3 }, 0, buffer, 3);
+
+            transfers.Write((ushort)(BytePeripheralPort + 1), 1, 3, buffer);
+            transfers.Read((ushort)(BytePeripheralPort + 1), 1, 3, buffer);
+
+            CollectionAssert.AreEqual(new byte[] { 1, 2, 3 }, bytePeripheral.Written);
+            Assert.AreEqual(3, bytePeripheral.Reads);
+            Assert.AreEqual(1, bytePeripheral.LastOffset);
+            Assert.AreEqual(0, blockPeripheral.ReadCalls + blockPeripheral.WriteCalls);
+        }
+
+        [Test]
+        public void ShouldRefreshCachedLookupAfterPeripheralIsUnregistered()
+        {
+            transfers.Write(BlockPeripheralPort, 1, 4, buffer);
+            Assert.AreEqual(1, blockPeripheral.WriteCalls);
+
+            machine.UnregisterFromParent(blockPeripheral);
+            // Nothing is registered at the port now, the access is reported as unhandled by the system bus
+            transfers.Write(BlockPeripheralPort, 1, 4, buffer);
+            Assert.AreEqual(1, blockPeripheral.WriteCalls);
+
+            // Registration of another peripheral at the same ports is noticed too
+            var bytePeripheral = new MockBytePeripheral();
+            machine.SystemBus.Register(bytePeripheral, new BusRangeRegistration(PortsBaseAddress + BlockPeripheralPort, PortsRangeSize));
+            transfers.Write(BlockPeripheralPort, 1, 4, buffer);
+            Assert.AreEqual(4, bytePeripheral.Written.Count);
+        }
+
+        private IMachine machine;
+        private PortBlockTransfers transfers;
+        private MockPortBlockPeripheral blockPeripheral;
+        private IntPtr buffer;
+
+        private const ulong PortsBaseAddress = 0xE0000000;
+        private const ulong PortsRangeSize = 8;
+        private const ushort BlockPeripheralPort = 0x1F0;
+        private const ushort BytePeripheralPort = 0x3F8;
+        private const int BufferSize = 64;
+
+        private class MockBytePeripheral : IBytePeripheral
+        {
+            public void Reset()
+            {
+            }
+
+            public byte ReadByte(long offset)
+            {
+                Reads++;
+                LastOffset = offset;
+                return (byte)Reads;
+            }
+
+            public void WriteByte(long offset, byte value)
+            {
+                LastOffset = offset;
+                Written.Add(value);
+            }
+
+            public int Reads { get; private set; }
+
+            public long LastOffset { get; private set; }
+
+            public List<byte> Written { get; } = new List<byte>();
+        }
+
+        private class MockPortBlockPeripheral : IBytePeripheral, IPortBlockPeripheral
+        {
+            public void Reset()
+            {
+            }
+
+            public byte ReadByte(long offset)
+            {
+                Assert.Fail("String I/O should not be split into single accesses");
+                return 0;
+            }
+
+            public void WriteByte(long offset, byte value)
+            {
+                Assert.Fail("String I/O should not be split into single accesses");
+            }
+
+            public void ReadPortBlock(long offset, SysbusAccessWidth width, byte[] data, int count)
+            {
+                ReadCalls++;
+                Remember(offset, width, count);
+                for(var i = 0; i < (int)width * count; i++)
+                {
+                    data[i] = (byte)i;
+                }
+            }
+
+            public void WritePortBlock(long offset, SysbusAccessWidth width, byte[] data, int count)
+            {
+                WriteCalls++;
+                Remember(offset, width, count);
+                LastWritten = new byte[(int)width * count];
+                Array.Copy(data, LastWritten, LastWritten.Length);
+            }
+
+            public int ReadCalls { get; private set; }
+
+            public int WriteCalls { get; private set; }
+
+            public long LastOffset { get; private set; }
+
+            public SysbusAccessWidth LastWidth { get; private set; }
+
+            public int LastCount { get; private set; }
+
+            public byte[] LastWritten { get; private set; }
+
+            private void Remember(long offset, SysbusAccessWidth width, int count)
+            {
+                LastOffset = offset;
+                LastWidth = width;
+                LastCount = count;
+            }
+        }
+    }
+}
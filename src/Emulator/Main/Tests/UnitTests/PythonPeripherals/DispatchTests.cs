@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Diagnostics;
+
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.Python;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests.PythonPeripherals
+{
+    [TestFixture]
+    public class DispatchTests
+    {
+        [Test]
+        public void ShouldDispatchDeclaredOffsets()
+        {
+            var source = @"
+if request.IsInit:
+    control = 0
+    def read_control(request):
+        request.Value = control
+    def write_control(request):
+        global control
+        control = request.Value
+    self.DeclareConstantRead(0x0, 0x12345678)
+    self.DeclareReadHandler(0x4, 'read_control')
+    self.DeclareWriteHandler(0x4, 'write_control')
+if request.IsRead:
+    request.Value = 0xdead
+";
+            var pyDev = new PythonPeripheral(0x10, true, script: source);
+            Assert.AreEqual(0x12345678, pyDev.ReadDoubleWord(0x0));
+            Assert.AreEqual(0x78, pyDev.ReadByte(0x0));
+            pyDev.WriteDoubleWord(0x4, 0x42);
+            Assert.AreEqual(0x42, pyDev.ReadDoubleWord(0x4));
+            Assert.AreEqual(0xdead, pyDev.ReadDoubleWord(0x8));
+
+            pyDev.Reset();
+            Assert.AreEqual(0, pyDev.ReadDoubleWord(0x4));
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void BenchmarkStatusRegisterReads()
+        {
+            const int accessesCount = 1000000;
+            var source = @"
+if request.IsInit:
+    def read_status(request):
+        request.Value = 1
+    self.DeclareConstantRead(0x0, 1)
+    self.DeclareReadHandler(0x4, 'read_status')
+if request.IsRead:
+    if request.Offset == 0x8:
+        request.Value = 1
+";
+            var pyDev = new PythonPeripheral(0x10, true, script: source);
+            foreach(var (offset, description) in new[] { (0x0L, "constant read"), (0x4L, "handler"), (0x8L, "whole script") })
+            {
+                var stopwatch = Stopwatch.StartNew();
+                for(var i = 0; i < accessesCount; i++)
+                {
+                    pyDev.ReadDoubleWord(offset);
+                }
+                stopwatch.Stop();
+                Console.WriteLine("{0}: {1:0} accesses/s", description, accessesCount / stopwatch.Elapsed.TotalSeconds);
+            }
+        }
+
+        [SetUp]
+        public void SetUp()
+        {
+            EmulationManager.Instance.Clear();
+        }
+    }
+}
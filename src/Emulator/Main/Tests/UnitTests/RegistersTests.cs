@@ -360,6 +360,44 @@ public void ShouldHandle32BitWideRegistersProperly()
             Assert.AreEqual(0xDEADBEEF, test);
         }
 
+        [Test]
+        public void ShouldDispatchAccessesInRegisterCollection()
+        {
+            var collection = new DoubleWordRegisterCollection(null);
+            collection.DefineRegister(0x0, 0x10);
+            collection.DefineRegister(0x8, 0x18);
+            collection.AddAfterReadHook(0x8, (offset, value) => value + 1);
+            collection.AddBeforeReadHook(0xC, offset => 0x1C);
+
+            Assert.IsTrue(collection.TryRead(0x0, out var value));
+            Assert.AreEqual(0x10, value);
+            Assert.IsTrue(collection.TryRead(0x8, out value));
+            Assert.AreEqual(0x19, value);
+            Assert.IsTrue(collection.TryRead(0xC, out value));
+            Assert.AreEqual(0x1C, value);
+            Assert.IsFalse(collection.TryRead(0x4, out _));
+            Assert.IsFalse(collection.TryRead(0x6, out _));
+            Assert.IsFalse(collection.TryRead(-0x8, out _));
+            Assert.IsFalse(collection.TryRead(0x10, out _));
+            Assert.IsFalse(collection.TryWrite(0xC, 0x0));
+
+            // Registers and hooks added after the first access have to be visible too
+            collection.DefineRegister(0x6, 0x16);
+            collection.RemoveAfterReadHook(0x8);
+            Assert.IsTrue(collection.TryRead(0x6, out value));
+            Assert.AreEqual(0x16, value);
+            Assert.IsTrue(collection.TryRead(0x8, out value));
+            Assert.AreEqual(0x18, value);
+
+            // Offsets too sparse for an array
+            collection.DefineRegister(0x100000, 0x20);
+            Assert.IsTrue(collection.TryRead(0x100000, out value));
+            Assert.AreEqual(0x20, value);
+            Assert.IsTrue(collection.TryRead(0x0, out value));
+            Assert.AreEqual(0x10, value);
+            Assert.IsFalse(collection.TryRead(0x4, out _));
+        }
+
         [SetUp]
         public void SetUp()
         {
@@ -0,0 +1,70 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+
+using Antmicro.Renode.Core;
+using Antmicro.Renode.Peripherals.CPU;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class SemihostingHandlerTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            handler = new SemihostingHandler(new Machine());
+        }
+
+        [TearDown]
+        public void TearDown()
+        {
+            handler.Dispose();
+        }
+
+        [Test]
+        public void ShouldSetErrnoWhenTransferringWithUnknownHandle()
+        {
+            // The buffer isn't accessed if there is no such handle
+            Assert.AreEqual(16u, handler.DoSemihostingTransfer(false, UnknownHandle, IntPtr.Zero, 16));
+            Assert.AreEqual(EBADF, handler.DoSemihosting(SYS_ERRNO, 0));
+
+            Assert.AreEqual(16u, handler.DoSemihostingTransfer(true, UnknownHandle, IntPtr.Zero, 16));
+            Assert.AreEqual(EBADF, handler.DoSemihosting(SYS_ERRNO, 0));
+        }
+
+        [Test]
+        public void ShouldKeepErrnoAfterNativeConsoleWrites()
+        {
+            handler.DoSemihostingTransfer(true, UnknownHandle, IntPtr.Zero, 16);
+
+            // Successful console writes don't change the errno when handled by C# either
+            handler.CompleteNativeOperation(SYS_WRITEC);
+            handler.CompleteNativeOperation(SYS_WRITE0);
+            Assert.AreEqual(EBADF, handler.DoSemihosting(SYS_ERRNO, 0));
+        }
+
+        [Test]
+        public void ShouldClearErrnoOnReset()
+        {
+            handler.DoSemihostingTransfer(false, UnknownHandle, IntPtr.Zero, 16);
+            handler.Reset();
+
+            Assert.AreEqual(0u, handler.DoSemihosting(SYS_ERRNO, 0));
+        }
+
+        private SemihostingHandler handler;
+
+        private const uint UnknownHandle = 42;
+        private const uint SYS_WRITEC = 0x03;
+        private const uint SYS_WRITE0 = 0x04;
+        private const uint SYS_ERRNO = 0x13;
+        private const uint EBADF = 9;
+    }
+}
@@ -0,0 +1,160 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System.Collections.Generic;
+
+using Antmicro.Renode.Exceptions;
+using Antmicro.Renode.Peripherals.CPU;
+
+using NUnit.Framework;
+
+namespace Antmicro.Renode.UnitTests
+{
+    [TestFixture]
+    public class StorageRegisterTableTests
+    {
+        [SetUp]
+        public void SetUp()
+        {
+            backend = new FakeBackend();
+            table = new StorageRegisterTable(backend);
+        }
+
+        [Test]
+        public void ShouldUndeclareRegisterWhenInstallationFails()
+        {
+            Assert.Throws<ConstructionException>(() =>
+                table.Declare(Space, 0x7c0, ulong.MaxValue, 0, ulong.MaxValue, install: () => throw new ConstructionException("CSR limit exceeded")));
+
+            Assert.IsFalse(backend.IsDeclared(Space, 0x7c0));
+            Assert.IsFalse(table.Contains(Space, 0x7c0, ulong.MaxValue));
+
+            // The register can be declared again afterwards
+            table.Declare(Space, 0x7c0, ulong.MaxValue, 0, ulong.MaxValue);
+            Assert.IsTrue(backend.IsDeclared(Space, 0x7c0));
+        }
+
+        [Test]
+        public void ShouldNotInstallRegisterDeclaredTwice()
+        {
+            var installations = 0;
+            table.Declare(Space, 0x7c0, ulong.MaxValue, 0, ulong.MaxValue, install: () => installations++);
+            Assert.Throws<ConstructionException>(() => table.Declare(Space, 0x7c0, ulong.MaxValue, 0, ulong.MaxValue, install: () => installations++));
+
+            Assert.AreEqual(1, installations);
+            Assert.IsTrue(backend.IsDeclared(Space, 0x7c0));
+        }
+
+        [Test]
+        public void ShouldApplyWritableMaskOnlyToMaskedWrites()
+        {
+            table.Declare(Space, 0x7c0, ulong.MaxValue, resetValue: 0xa0, writableMask: 0x0f);
+
+            table.Set(Space, 0x7c0, ulong.MaxValue, 0x55);
+            Assert.AreEqual(0xa5, table.Get(Space, 0x7c0));
+
+            table.SetUnmasked(Space, 0x7c0, ulong.MaxValue, 0x55);
+            Assert.AreEqual(0x55, table.Get(Space, 0x7c0));
+        }
+
+        [Test]
+        public void ShouldCallWriteHandlerOnlyForMaskedWrites()
+        {
+            var written = new List<ulong>();
+            table.Declare(Space, 0x7c0, ulong.MaxValue, 0, writableMask: 0x0f, writeHandler: written.Add);
+
+            table.Set(Space, 0x7c0, ulong.MaxValue, 0x33);
+            table.SetUnmasked(Space, 0x7c0, ulong.MaxValue, 0x40);
+
+            CollectionAssert.AreEqual(new ulong[] { 0x03 }, written);
+        }
+
+        [Test]
+        public void ShouldThrowOnUnmaskedWriteToUndeclaredRegister()
+        {
+            Assert.Throws<RecoverableException>(() => table.SetUnmasked(Space, 0x7c0, ulong.MaxValue, 0x1));
+        }
+
+        [Test]
+        public void ShouldRestoreBitsWhichAreNotWritable()
+        {
+            table.Declare(Space, 0x7c0, ulong.MaxValue, 0, writableMask: 0x0f);
+            table.SetUnmasked(Space, 0x7c0, ulong.MaxValue, 0xf0);
+            table.Save();
+
+            // A deserialized CPU starts with a fresh native library
+            backend.Clear();
+            table.Restore();
+            Assert.AreEqual(0xf0, table.Get(Space, 0x7c0));
+        }
+
+        private FakeBackend backend;
+        private StorageRegisterTable table;
+
+        private const StorageRegisterSpace Space = StorageRegisterSpace.ControlAndStatusRegister;
+
+        // Behaves like the table in renode_registers.c
+        private class FakeBackend : IStorageRegisterBackend
+        {
+            public bool DeclareStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask, ulong resetValue, ulong writableMask, bool notifyOnWrite)
+            {
+                if(registers.ContainsKey((space, id)))
+                {
+                    return false;
+                }
+                registers[(space, id)] = new Register { Value = resetValue, ResetValue = resetValue, WritableMask = writableMask };
+                return true;
+            }
+
+            public void UndeclareStorageRegister(StorageRegisterSpace space, ulong id)
+            {
+                registers.Remove((space, id));
+            }
+
+            public ulong GetStorageRegister(StorageRegisterSpace space, ulong id)
+            {
+                return registers.TryGetValue((space, id), out var register) ? register.Value : 0;
+            }
+
+            public void SetStorageRegister(StorageRegisterSpace space, ulong id, ulong value, bool masked)
+            {
+                if(!registers.TryGetValue((space, id), out var register))
+                {
+                    return;
+                }
+                var mask = masked ? register.WritableMask : ulong.MaxValue;
+                register.Value = (register.Value & ~mask) | (value & mask);
+            }
+
+            public void ResetStorageRegisters()
+            {
+                foreach(var register in registers.Values)
+                {
+                    register.Value = register.ResetValue;
+                }
+            }
+
+            public bool IsDeclared(StorageRegisterSpace space, ulong id)
+            {
+                return registers.ContainsKey((space, id));
+            }
+
+            public void Clear()
+            {
+                registers.Clear();
+            }
+
+            private readonly Dictionary<(StorageRegisterSpace, ulong), Register> registers = new Dictionary<(StorageRegisterSpace, ulong), Register>();
+
+            private class Register
+            {
+                public ulong Value;
+                public ulong ResetValue;
+                public ulong WritableMask;
+            }
+        }
+    }
+}
@@ -8,6 +8,7 @@
 
 using System;
 using System.Collections.Generic;
+using System.Diagnostics;
 using System.Linq;
 
 using Antmicro.Renode.Core;
@@ -94,6 +95,51 @@ public void ShouldFindAfterManyRegistrations()
             Assert.AreEqual(0x668, sysbus.ReadDoubleWord(3000));
         }
 
+        [Test]
+        public void ShouldFindAlternatingPeripheralsAfterUnregistration()
+        {
+            var peri1 = new Mock<IDoubleWordPeripheral>();
+            var peri2 = new Mock<IDoubleWordPeripheral>();
+            var peri3 = new Mock<IDoubleWordPeripheral>();
+            peri1.Setup(x => x.ReadDoubleWord(0)).Returns(0x666);
+            peri2.Setup(x => x.ReadDoubleWord(0)).Returns(0x667);
+            peri3.Setup(x => x.ReadDoubleWord(0)).Returns(0x668);
+            // The pages of the first two peripherals share an entry of the access cache
+            sysbus.Register(peri1.Object, 0x1000.By(0x100));
+            sysbus.Register(peri2.Object, 0x21800.By(0x100));
+            sysbus.Register(peri3.Object, 0x2000.By(0x100));
+            for(var i = 0; i < 3; i++)
+            {
+                Assert.AreEqual(0x666, sysbus.ReadDoubleWord(0x1000));
+                Assert.AreEqual(0x667, sysbus.ReadDoubleWord(0x21800));
+                Assert.AreEqual(0x668, sysbus.ReadDoubleWord(0x2000));
+            }
+
+            sysbus.UnregisterFromAddress(0x21800);
+            Assert.AreEqual(0, sysbus.ReadDoubleWord(0x21800));
+            Assert.AreEqual(0x666, sysbus.ReadDoubleWord(0x1000));
+            Assert.AreEqual(0x668, sysbus.ReadDoubleWord(0x2000));
+        }
+
+        [Test, Explicit("Benchmark")]
+        public void BenchmarkAlternatingPeripheralAccesses([Values(1, 2, 4, 16)] int peripheralsCount)
+        {
+            const int accessesCount = 10000000;
+            for(var i = 0; i < peripheralsCount; i++)
+            {
+                // Unaligned registrations go to the binary search array, the stride is the usual one of MMIO peripherals
+                sysbus.Register(new ConstantPeripheral((uint)i), (0x10000000 + (ulong)i * 0x1000 + 0x4).By(0x100));
+            }
+
+            var stopwatch = Stopwatch.StartNew();
+            for(var i = 0; i < accessesCount; i++)
+            {
+                sysbus.ReadDoubleWord(0x10000000 + (ulong)(i % peripheralsCount) * 0x1000 + 0x4);
+            }
+            stopwatch.Stop();
+            Console.WriteLine("{0} peripherals: {1:0.0} ns/access", peripheralsCount, stopwatch.Elapsed.TotalMilliseconds * 1000000 / accessesCount);
+        }
+
         [Test, Ignore("Ignored")]
         public void ShouldFindAfterManyRegistrationsAndRemoves()
         {
@@ -516,6 +562,29 @@ private void TestAllTranslatedAccesses(ulong address, ulong testValue, int imple
         private byte[] bytes;
         private const int PauseResumeRetries = 5;
 
+        private class ConstantPeripheral : IDoubleWordPeripheral
+        {
+            public ConstantPeripheral(uint value)
+            {
+                this.value = value;
+            }
+
+            public uint ReadDoubleWord(long _)
+            {
+                return value;
+            }
+
+            public void WriteDoubleWord(long _, uint __)
+            {
+            }
+
+            public void Reset()
+            {
+            }
+
+            private readonly uint value;
+        }
+
         private class MultiRegistrationPeripheral : IBusPeripheral, IDoubleWordPeripheral
         {
             public uint ReadDoubleWord(long _)
@@ -54,11 +54,13 @@ public virtual void AddClockEntry(ClockEntry entry)
                 UpdateLimits();
             }
             NotifyNumberOfEntriesChanged(clockEntries.Count - 1, clockEntries.Count);
+            StateChanged?.Invoke();
         }
 
         public virtual void ExchangeClockEntryWith(Action handler, Func<ClockEntry, ClockEntry> visitor,
             Func<ClockEntry> factoryIfNonExistent)
         {
+            bool changed;
             lock(sync)
             {
                 UpdateLimits();
@@ -72,6 +74,7 @@ public virtual void AddClockEntry(ClockEntry entry)
                         clockEntriesUpdateHandlers.Add(null);
                         unaccountedTimes.Add(TimeInterval.Empty);
                         UpdateUpdateHandler(clockEntries.Count - 1);
+                        changed = true;
                     }
                     else
                     {
@@ -80,11 +83,17 @@ public virtual void AddClockEntry(ClockEntry entry)
                 }
                 else
                 {
-                    clockEntries[indexOfEntry] = visitor(clockEntries[indexOfEntry]);
+                    var oldEntry = clockEntries[indexOfEntry];
+                    clockEntries[indexOfEntry] = visitor(oldEntry);
                     UpdateUpdateHandler(indexOfEntry);
+                    changed = !HasSameProgression(oldEntry, clockEntries[indexOfEntry]);
                 }
                 UpdateLimits();
             }
+            if(changed)
+            {
+                StateChanged?.Invoke();
+            }
         }
 
         public virtual ClockEntry GetClockEntry(Action handler)
@@ -179,6 +188,7 @@ public virtual bool TryRemoveClockEntry(Action handler)
                 UpdateLimits();
             }
             NotifyNumberOfEntriesChanged(oldCount, clockEntries.Count);
+            StateChanged?.Invoke();
             return true;
         }
 
@@ -195,6 +205,7 @@ public virtual IEnumerable<ClockEntry> EjectClockEntries()
                 unaccountedTimes.Clear();
             }
             NotifyNumberOfEntriesChanged(oldCount, 0);
+            StateChanged?.Invoke();
             return result;
         }
 
@@ -217,6 +228,14 @@ public void Advance(TimeInterval time, bool immediately = false)
                     AdvanceInner(time, immediately);
                 }
             }
+            StateChanged?.Invoke();
+        }
+
+        // For owners of clock entries keeping a part of their values outside of the entries,
+        // e.g. a timer whose value was set without changing its entry
+        public void NotifyStateChanged()
+        {
+            StateChanged?.Invoke();
         }
 
         public IEnumerable<ClockEntry> GetAllClockEntries()
@@ -271,6 +290,17 @@ public bool HasEntries
 
         public event Action<int, int> NumberOfEntriesChanged;
 
+        // Raised after the time advances or any clock entry is added, removed or modified in a way that changes how its value progresses,
+        // i.e. whenever values computed from the entries earlier might no longer be valid
+        public event Action StateChanged;
+
+        // Compares everything that determines the value of the entry and its next event at any point in time
+        private static bool HasSameProgression(ClockEntry a, ClockEntry b)
+        {
+            return a.Value == b.Value && a.ValueResiduum == b.ValueResiduum && a.Ratio == b.Ratio && a.Period == b.Period
+                && a.Step == b.Step && a.Enabled == b.Enabled && a.Direction == b.Direction && a.WorkMode == b.WorkMode;
+        }
+
         private static bool HandleDirectionDescendingPositiveRatio(ref ClockEntry entry, TimeInterval time, ref TimeInterval nearestTickIn)
         {
             var emulatorTicks = time.Ticks;
@@ -313,6 +313,33 @@ public static int Bind(int domain, SocketAddressCan addr, int addrSize)
             return bind(domain, ref addr, addrSize);
         }
 
+        public static IntPtr Mmap(IntPtr address, ulong length, int protection, int flags, int fd, long offset)
+        {
+            if(RuntimeInfo.IsWindows())
+            {
+                throw new NotSupportedException("This API is available on Unix only!");
+            }
+            return mmap(address, (UIntPtr)length, protection, flags, fd, offset);
+        }
+
+        public static int Munmap(IntPtr address, ulong length)
+        {
+            if(RuntimeInfo.IsWindows())
+            {
+                throw new NotSupportedException("This API is available on Unix only!");
+            }
+            return munmap(address, (UIntPtr)length);
+        }
+
+        public static int Madvise(IntPtr address, ulong length, int advice)
+        {
+            if(RuntimeInfo.IsWindows())
+            {
+                throw new NotSupportedException("This API is available on Unix only!");
+            }
+            return madvise(address, (UIntPtr)length, advice);
+        }
+
         public static int O_CREAT => RuntimeInfo.IsMacOS() ? 0x200 : 0x40;
 
         public static int O_EXCL => RuntimeInfo.IsMacOS() ? 0x800 : 0x80;
@@ -327,6 +354,16 @@ public static int Bind(int domain, SocketAddressCan addr, int addrSize)
         public const int O_RDWR = 2;
         public const int DEFFILEMODE = 0b110110110;
 
+        // Source: https://sourceware.org/git/?p=glibc.git;a=blob;f=sysdeps/unix/sysv/linux/bits/mman-linux.h
+        public const int PROT_READ = 0x1;
+        public const int PROT_WRITE = 0x2;
+        public const int MAP_PRIVATE = 0x02;
+        public const int MAP_ANONYMOUS = 0x20;
+        public const int MAP_HUGETLB = 0x40000;
+        public const int MAP_HUGE_SHIFT = 26;
+        public const int MADV_HUGEPAGE = 14;
+        public static readonly IntPtr MAP_FAILED = new IntPtr(-1);
+
         // Disable incorrect warning about the `s_` prefix: https://github.com/dotnet/roslyn/issues/57706
 #pragma warning disable IDE1006
         public const int S_IRUSR = 0x100;
@@ -378,6 +415,15 @@ public static int Bind(int domain, SocketAddressCan addr, int addrSize)
         [DllImport("libc", EntryPoint = "memset")]
         private static extern IntPtr memset(IntPtr pointer, byte value, int length);
 
+        [DllImport("libc", EntryPoint = "mmap", SetLastError = true)]
+        private static extern IntPtr mmap(IntPtr address, UIntPtr length, int protection, int flags, int fd, long offset);
+
+        [DllImport("libc", EntryPoint = "munmap", SetLastError = true)]
+        private static extern int munmap(IntPtr address, UIntPtr length);
+
+        [DllImport("libc", EntryPoint = "madvise", SetLastError = true)]
+        private static extern int madvise(IntPtr address, UIntPtr length, int advice);
+
         private const int EINTR = 4;
 
         #endregion
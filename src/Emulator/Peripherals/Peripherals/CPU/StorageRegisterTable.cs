@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+
+using Antmicro.Renode.Exceptions;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Implemented by TranslationCPU over the table of storage registers in its native library
+    public interface IStorageRegisterBackend
+    {
+        // Returns false if the register is already declared or the limit of storage registers is exceeded
+        bool DeclareStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask, ulong resetValue, ulong writableMask, bool notifyOnWrite);
+
+        void UndeclareStorageRegister(StorageRegisterSpace space, ulong id);
+
+        ulong GetStorageRegister(StorageRegisterSpace space, ulong id);
+
+        // Only the writable bits are changed unless `masked` is false
+        void SetStorageRegister(StorageRegisterSpace space, ulong id, ulong value, bool masked);
+
+        void ResetStorageRegisters();
+    }
+
+    // Keeps the declarations of the storage registers, so that their write handlers can be called
+    // and the registers can be declared again with their values after deserialization
+    public class StorageRegisterTable
+    {
+        public StorageRegisterTable(IStorageRegisterBackend backend)
+        {
+            this.backend = backend;
+        }
+
+        // `install` is called after the register is declared, e.g. to install its accessors, and the register
+        // is undeclared if it throws, so that a failed registration doesn't leave the register declared
+        public void Declare(StorageRegisterSpace space, ulong id, ulong idMask, ulong resetValue, ulong writableMask, Action<ulong> writeHandler = null, Action install = null)
+        {
+            var register = new StorageRegister
+            {
+                Space = space,
+                Id = id & idMask,
+                IdMask = idMask,
+                ResetValue = resetValue,
+                WritableMask = writableMask,
+                WriteHandler = writeHandler,
+                Value = resetValue,
+            };
+            if(registers.ContainsKey((space, register.Id)) || !TryDeclare(register))
+            {
+                throw new ConstructionException($"Cannot declare storage register 0x{id:X} in {space}, it's already declared or the limit of storage registers is exceeded");
+            }
+            try
+            {
+                install?.Invoke();
+            }
+            catch
+            {
+                backend.UndeclareStorageRegister(space, register.Id);
+                throw;
+            }
+            registers.Add((space, register.Id), register);
+        }
+
+        public bool Contains(StorageRegisterSpace space, ulong id, ulong idMask)
+        {
+            return registers.ContainsKey((space, id & idMask));
+        }
+
+        public ulong Get(StorageRegisterSpace space, ulong id)
+        {
+            return backend.GetStorageRegister(space, id);
+        }
+
+        // Only the writable bits are changed, as if written by the guest
+        public void Set(StorageRegisterSpace space, ulong id, ulong idMask, ulong value)
+        {
+            backend.SetStorageRegister(space, id, value, masked: true);
+            NotifyWrite(space, id, idMask);
+        }
+
+        // Changes all the bits, e.g. read-only status bits updated by the model, without calling the write handler
+        public void SetUnmasked(StorageRegisterSpace space, ulong id, ulong idMask, ulong value)
+        {
+            if(!Contains(space, id, idMask))
+            {
+                throw new RecoverableException($"There is no storage register 0x{id:X} in {space}");
+            }
+            backend.SetStorageRegister(space, id, value, masked: false);
+        }
+
+        // Calls the write handler of the register with its current value, returns false if there is no such register
+        public bool NotifyWrite(StorageRegisterSpace space, ulong id, ulong idMask)
+        {
+            if(!registers.TryGetValue((space, id & idMask), out var register))
+            {
+                return false;
+            }
+            register.WriteHandler?.Invoke(backend.GetStorageRegister(space, id));
+            return true;
+        }
+
+        public void Reset()
+        {
+            backend.ResetStorageRegisters();
+        }
+
+        public void Save()
+        {
+            foreach(var register in registers.Values)
+            {
+                register.Value = backend.GetStorageRegister(register.Space, register.Id);
+            }
+        }
+
+        public void Restore()
+        {
+            foreach(var register in registers.Values)
+            {
+                TryDeclare(register);
+                backend.SetStorageRegister(register.Space, register.Id, register.Value, masked: false);
+            }
+        }
+
+        private bool TryDeclare(StorageRegister register)
+        {
+            return backend.DeclareStorageRegister(register.Space, register.Id, register.IdMask, register.ResetValue, register.WritableMask, register.WriteHandler != null);
+        }
+
+        private readonly IStorageRegisterBackend backend;
+        private readonly Dictionary<(StorageRegisterSpace, ulong), StorageRegister> registers = new Dictionary<(StorageRegisterSpace, ulong), StorageRegister>();
+
+        private class StorageRegister
+        {
+            public StorageRegisterSpace Space;
+            public ulong Id;
+            public ulong IdMask;
+            public ulong ResetValue;
+            public ulong WritableMask;
+            public Action<ulong> WriteHandler;
+            // Only up to date while serializing
+            public ulong Value;
+        }
+    }
+
+    // Has to match storage_register_space_t in renode_registers.h
+    public enum StorageRegisterSpace : uint
+    {
+        Coprocessor32BitMove = 0,
+        Coprocessor64BitMove = 1,
+        ControlAndStatusRegister = 2,
+        InterruptCPUInterface = 3,
+    }
+}
@@ -26,6 +26,7 @@
 using Antmicro.Renode.Peripherals.CPU.Assembler;
 using Antmicro.Renode.Peripherals.CPU.Disassembler;
 using Antmicro.Renode.Peripherals.Miscellaneous;
+using Antmicro.Renode.Time;
 using Antmicro.Renode.Utilities;
 using Antmicro.Renode.Utilities.Binding;
 
@@ -590,6 +591,7 @@ public override void Reset()
             pendingTranslationCacheClearing = false;
             TlibReset();
             ResetOpcodesCounters();
+            ResetStorageRegisters();
             profiler?.Dispose();
             localAtomicState?.Reset();
         }
@@ -720,6 +722,9 @@ public override ExecutionResult ExecuteInstructions(ulong numberOfInstructionsTo
                     pendingTranslationCacheClearing = false;
                 }
 
+                // The performance of the CPU could have changed since the counters were published
+                RenodeInvalidateTimeCounters();
+
                 pauseGuard.Enter();
                 lastTlibResult = (TlibExecutionResult)TlibExecute(checked((int)numberOfInstructionsToExecute));
                 pauseGuard.Leave();
@@ -1096,11 +1101,16 @@ protected TranslationCPU(uint id, string cpuType, IMachine machine, Endianess en
             decodedIrqs = new Dictionary<Interrupt, HashSet<int>>();
             hooks = new HookDescriptor(this);
             currentMappings = new List<SegmentMapping>();
+            storageRegisters = new StorageRegisterTable(new NativeStorageRegisters(this));
             this.UseMachineAtomicState = useMachineAtomicState;
             InitializeRegisters();
             Init();
             InitDisas();
             Clustered = new TranslationCPU[] { this };
+            if(machine.ClockSource is BaseClockSource clockSource)
+            {
+                clockSource.StateChanged += InvalidateTimeCounters;
+            }
         }
 
         public new IEnumerable<ICluster<TranslationCPU>> Clusters { get; } = new List<ICluster<TranslationCPU>>(0);
@@ -1124,6 +1134,10 @@ protected override void DisposeInner(bool silent = false)
             base.DisposeInner(silent);
             TimeHandle?.Dispose();
             RemoveAllHooks();
+            if(machine.ClockSource is BaseClockSource clockSource)
+            {
+                clockSource.StateChanged -= InvalidateTimeCounters;
+            }
             TlibDispose();
             RenodeFreeHostBlocks();
             binder.Dispose();
@@ -1690,11 +1704,35 @@ private void RebuildMemoryMappings()
         private void TouchHostBlock(ulong offset)
         {
             this.NoisyLog("Trying to find the mapping for offset 0x{0:X}.", offset);
-            var mapping = currentMappings.FirstOrDefault(x => x.Segment.StartingOffset <= offset && offset <= x.Segment.StartingOffset + (x.Segment.Size - 1));
+            var mapping = FindMapping(offset);
             if(mapping == null)
             {
                 throw new InvalidOperationException(string.Format("Could not find mapped segment for offset 0x{0:X}.", offset));
             }
+            TouchMapping(mapping);
+        }
+
+        // Unlike TouchHostBlock, it's used for lookups that may also hit peripherals, so a missing mapping isn't an error.
+        // Returns 1 if a segment was mapped, the lookup has to be retried then.
+        [Export]
+        private uint TouchHostBlockIfMapped(ulong offset)
+        {
+            var mapping = FindMapping(offset);
+            if(mapping == null || mapping.Touched)
+            {
+                return 0;
+            }
+            TouchMapping(mapping);
+            return 1;
+        }
+
+        private SegmentMapping FindMapping(ulong offset)
+        {
+            return currentMappings.FirstOrDefault(x => x.Segment.StartingOffset <= offset && offset <= x.Segment.StartingOffset + (x.Segment.Size - 1));
+        }
+
+        private void TouchMapping(SegmentMapping mapping)
+        {
             mapping.Segment.Touch();
             mapping.Touched = true;
             RebuildMemoryMappings();
@@ -1963,6 +2001,7 @@ private void PrepareState()
         {
             var statePtr = TlibExportState();
             BeforeSave(statePtr);
+            SaveStorageRegisters();
             cpuState = new byte[TlibGetStateSize()];
             Marshal.Copy(statePtr, cpuState, 0, cpuState.Length);
             var externalMmuStatePtr = TlibExportExternalMmuState();
@@ -1984,6 +2023,7 @@ private void FreeState()
         private void RestoreState()
         {
             Init();
+            RestoreStorageRegisters();
             if(StoreTablePointer != IntPtr.Zero)
             {
                 InitStoreTable();
@@ -0,0 +1,156 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Runtime.InteropServices;
+
+using Antmicro.Renode.Utilities.Binding;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Registers which are plain storage, i.e. a value with a reset value and a writable mask, are kept in a table
+    // of the translation library, so that the guest accesses them without calling back, unless it has to be notified of writes.
+    public abstract partial class TranslationCPU
+    {
+        protected void DeclareStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask, ulong resetValue, ulong writableMask, Action<ulong> writeHandler = null, Action install = null)
+        {
+            storageRegisters.Declare(space, id, idMask, resetValue, writableMask, writeHandler, install);
+        }
+
+        protected bool IsStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask)
+        {
+            return storageRegisters.Contains(space, id, idMask);
+        }
+
+        protected ulong GetStorageRegister(StorageRegisterSpace space, ulong id)
+        {
+            return storageRegisters.Get(space, id);
+        }
+
+        // Only the writable bits are changed, as if written by the guest
+        protected void SetStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask, ulong value)
+        {
+            storageRegisters.Set(space, id, idMask, value);
+        }
+
+        // All the bits are changed and the write handler isn't called
+        protected void SetStorageRegisterUnmasked(StorageRegisterSpace space, ulong id, ulong idMask, ulong value)
+        {
+            storageRegisters.SetUnmasked(space, id, idMask, value);
+        }
+
+        // Has to be called by the write callbacks of spaces with storage registers, which are reached after the guest writes one
+        // declared with a write handler. The value is already stored at that point.
+        protected bool NotifyStorageRegisterWrite(StorageRegisterSpace space, ulong id, ulong idMask)
+        {
+            return storageRegisters.NotifyWrite(space, id, idMask);
+        }
+
+        private void SaveStorageRegisters()
+        {
+            storageRegisters.Save();
+        }
+
+        private void RestoreStorageRegisters()
+        {
+            storageRegisters.Restore();
+        }
+
+        private void ResetStorageRegisters()
+        {
+            storageRegisters.Reset();
+        }
+
+        private readonly StorageRegisterTable storageRegisters;
+
+#pragma warning disable 649
+        [Import]
+        private readonly Func<IntPtr, uint> RenodeDeclareStorageRegister;
+
+        [Import]
+        private readonly Action<uint, ulong> RenodeUndeclareStorageRegister;
+
+        [Import]
+        private readonly Func<uint, ulong, ulong> RenodeGetStorageRegister;
+
+        [Import]
+        private readonly Action<uint, ulong, ulong> RenodeSetStorageRegister;
+
+        [Import]
+        private readonly Action<uint, ulong, ulong> RenodeSetStorageRegisterValue;
+
+        [Import]
+        private readonly Action RenodeResetStorageRegisters;
+#pragma warning restore 649
+
+        private class NativeStorageRegisters : IStorageRegisterBackend
+        {
+            public NativeStorageRegisters(TranslationCPU cpu)
+            {
+                this.cpu = cpu;
+            }
+
+            public bool DeclareStorageRegister(StorageRegisterSpace space, ulong id, ulong idMask, ulong resetValue, ulong writableMask, bool notifyOnWrite)
+            {
+                var declaration = new StorageRegisterDeclaration
+                {
+                    Id = id,
+                    IdMask = idMask,
+                    ResetValue = resetValue,
+                    WritableMask = writableMask,
+                    Space = (uint)space,
+                    NotifyOnWrite = notifyOnWrite ? 1u : 0u,
+                };
+                var declarationBuffer = cpu.memoryManager.Allocate(new IntPtr(Marshal.SizeOf(typeof(StorageRegisterDeclaration))));
+                Marshal.StructureToPtr(declaration, declarationBuffer, false);
+                var result = cpu.RenodeDeclareStorageRegister(declarationBuffer);
+                cpu.memoryManager.Free(declarationBuffer);
+                return result != 0;
+            }
+
+            public void UndeclareStorageRegister(StorageRegisterSpace space, ulong id)
+            {
+                cpu.RenodeUndeclareStorageRegister((uint)space, id);
+            }
+
+            public ulong GetStorageRegister(StorageRegisterSpace space, ulong id)
+            {
+                return cpu.RenodeGetStorageRegister((uint)space, id);
+            }
+
+            public void SetStorageRegister(StorageRegisterSpace space, ulong id, ulong value, bool masked)
+            {
+                if(masked)
+                {
+                    cpu.RenodeSetStorageRegister((uint)space, id, value);
+                }
+                else
+                {
+                    cpu.RenodeSetStorageRegisterValue((uint)space, id, value);
+                }
+            }
+
+            public void ResetStorageRegisters()
+            {
+                cpu.RenodeResetStorageRegisters();
+            }
+
+            private readonly TranslationCPU cpu;
+        }
+
+        // Has to match storage_register_t in renode_registers.h
+        [StructLayout(LayoutKind.Sequential)]
+        private struct StorageRegisterDeclaration
+        {
+            public ulong Id;
+            public ulong IdMask;
+            public ulong ResetValue;
+            public ulong WritableMask;
+            public uint Space;
+            public uint NotifyOnWrite;
+        }
+    }
+}
@@ -0,0 +1,119 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Linq;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+using Antmicro.Renode.Peripherals.Timers;
+using Antmicro.Renode.Time;
+using Antmicro.Renode.Utilities;
+using Antmicro.Renode.Utilities.Binding;
+
+namespace Antmicro.Renode.Peripherals.CPU
+{
+    // Counters read by the guest, e.g. timer registers, are published to the translation library after being read
+    // through a callback, so that it can return their values itself until the clock source of the machine changes.
+    public abstract partial class TranslationCPU
+    {
+        // Reads a counter which only changes when the time of the machine advances, i.e. it's read without syncing the time of the CPU.
+        // Until then, the same value is returned by tlib for the counter identified by `key` without calling back.
+        protected ulong ReadTimeCounter(uint key, Func<ulong> readCounter)
+        {
+            var generation = Volatile.Read(ref timeCountersGeneration);
+            var value = readCounter();
+            SetTimeCounter(new TimeCounter
+            {
+                Value = value,
+                Limit = ulong.MaxValue,
+                Denominator = 1,
+                Key = key,
+            }, generation);
+            return value;
+        }
+
+        // Lets tlib compute the value of a timer read right after syncing the time of the CPU from the number of executed instructions,
+        // until the clock source changes or reaches its nearest event. It's only possible if this CPU alone drives the time of the machine
+        // and every instruction takes a whole number of virtual time ticks, otherwise the timer keeps being read through the callback.
+        protected void PublishLinearTimeCounter(uint key, ILinearTimer timer)
+        {
+            var generation = Volatile.Read(ref timeCountersGeneration);
+            if(timer == null || TimeHandle == null || TlibGetMillicyclesPerInstruction() != 1000
+                || TimeInterval.TicksPerMicrosecond % PerformanceInMips != 0
+                || TimeHandle.TotalElapsedTime != TimeHandle.TimeSource.ElapsedVirtualTime
+                || machine.SystemBus.GetCPUs().Count() != 1
+                || !timer.TryGetLinearState(out var state))
+            {
+                return;
+            }
+
+            var ticksPerInstruction = TimeInterval.TicksPerMicrosecond / PerformanceInMips;
+            var ratio = state.Ratio;
+            if(ratio.Denominator % state.Residuum.Denominator != 0 || ratio.Numerator > ulong.MaxValue / ticksPerInstruction)
+            {
+                return;
+            }
+
+            SetTimeCounter(new TimeCounter
+            {
+                Value = state.Value,
+                Instructions = TlibGetTotalExecutedInstructions(),
+                Limit = state.ValidFor.Ticks / ticksPerInstruction,
+                Numerator = ratio.Numerator * ticksPerInstruction,
+                Denominator = ratio.Denominator,
+                Residuum = state.Residuum.Numerator * (ratio.Denominator / state.Residuum.Denominator),
+                Key = key,
+            }, generation);
+        }
+
+        protected void InvalidateTimeCounters()
+        {
+            Interlocked.Increment(ref timeCountersGeneration);
+            RenodeInvalidateTimeCounters();
+        }
+
+        protected const uint DefaultTimeCounterKey = 0;
+
+        private void SetTimeCounter(TimeCounter counter, int generation)
+        {
+            var counterBuffer = memoryManager.Allocate(new IntPtr(Marshal.SizeOf(typeof(TimeCounter))));
+            Marshal.StructureToPtr(counter, counterBuffer, false);
+            RenodeSetTimeCounter(counterBuffer);
+            memoryManager.Free(counterBuffer);
+
+            // The clock source could have changed on another thread after the counter was read
+            if(generation != Volatile.Read(ref timeCountersGeneration))
+            {
+                RenodeInvalidateTimeCounters();
+            }
+        }
+
+        private int timeCountersGeneration;
+
+#pragma warning disable 649
+        [Import]
+        private readonly Action<IntPtr> RenodeSetTimeCounter;
+
+        [Import]
+        private readonly Action RenodeInvalidateTimeCounters;
+#pragma warning restore 649
+
+        // Has to match time_counter_t in renode_time.h
+        [StructLayout(LayoutKind.Sequential)]
+        private struct TimeCounter
+        {
+            public ulong Value;
+            public ulong Instructions;
+            public ulong Limit;
+            public ulong Numerator;
+            public ulong Denominator;
+            public ulong Residuum;
+            public uint Key;
+            public uint Valid;
+        }
+    }
+}
@@ -22,6 +22,7 @@ public Domain(ARM_SMMUv3 parent, SecurityState securityState)
                 this.parent = parent;
                 SecurityState = securityState;
                 StreamTable = new StreamTableEntry[1 << StreamIdBits];
+                contextDescriptors = new ContextDescriptor?[1 << StreamIdBits];
                 GlobalErrorIRQ = new GPIO();
                 EventQueueIRQ = new GPIO();
             }
@@ -30,6 +31,10 @@ public void Reset()
             {
                 Enabled = false;
                 BlockEventQueue = false;
+                lock(contextDescriptors)
+                {
+                    Array.Clear(contextDescriptors, 0, contextDescriptors.Length);
+                }
             }
 
             public void CreateQueues()
@@ -106,6 +111,40 @@ public void InvalidateSte(uint streamId)
                 var ste = parent.ReadStruct<StreamTableEntry>(StreamTableAddress.Value << 6, streamId);
                 parent.NoisyLog("Invalidated STE {0} = {1}", streamId, ste);
                 StreamTable[streamId] = ste;
+                InvalidateContextDescriptors(streamId);
+            }
+
+            // Only the context descriptor of substream 0 is used, so it's dropped when any descriptor of the stream is invalidated
+            public void InvalidateContextDescriptors(uint streamId)
+            {
+                if(streamId >= contextDescriptors.Length)
+                {
+                    return;
+                }
+                lock(contextDescriptors)
+                {
+                    contextDescriptors[streamId] = null;
+                }
+            }
+
+            public ContextDescriptor GetContextDescriptor(int streamId)
+            {
+                lock(contextDescriptors)
+                {
+                    if(contextDescriptors[streamId] is ContextDescriptor cached)
+                    {
+                        ConfigurationCacheHits++;
+                        return cached;
+                    }
+                    ConfigurationCacheMisses++;
+                    var cd = parent.ReadStruct<ContextDescriptor>(StreamTable[streamId].S1ContextPtr);
+                    // Invalid descriptors aren't cached, so that fixing one takes effect without an invalidation
+                    if(cd.V)
+                    {
+                        contextDescriptors[streamId] = cd;
+                    }
+                    return cd;
+                }
             }
 
             public void UpdateInterrupts()
@@ -144,6 +183,10 @@ public bool Enabled
 
             public GPIO GlobalErrorIRQ { get; }
 
+            public ulong ConfigurationCacheHits { get; private set; }
+
+            public ulong ConfigurationCacheMisses { get; private set; }
+
             public GPIO EventQueueIRQ { get; }
 
             public IValueRegisterField CommandQueueShift;
@@ -169,6 +212,7 @@ public bool Enabled
             private WrappingQueue<Command> commandQueue;
             private WrappingQueue<Event> eventQueue;
 
+            private readonly ContextDescriptor?[] contextDescriptors;
             private readonly ARM_SMMUv3 parent;
         }
     }
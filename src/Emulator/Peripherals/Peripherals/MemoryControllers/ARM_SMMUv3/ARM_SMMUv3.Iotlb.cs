@@ -0,0 +1,159 @@
+//
+// Copyright (c) 2010-2026 Antmicro
+//
+// This file is licensed under the MIT License.
+// Full license text is available in 'licenses/MIT.txt'.
+//
+using System;
+using System.Collections.Generic;
+
+using static Antmicro.Renode.Peripherals.Bus.WindowMMUBusController;
+
+namespace Antmicro.Renode.Peripherals.MemoryControllers
+{
+    public partial class ARM_SMMUv3
+    {
+        // Caches the results of page table walks, so that the windows of the stream controllers can be refilled after being invalidated
+        // without reading the tables from memory again. Entries are tagged like in the hardware TLB and evicted in the least recently used order.
+        private class Iotlb
+        {
+            public Iotlb(int capacity)
+            {
+                this.capacity = capacity;
+                entries = new Dictionary<Key, LinkedListNode<Entry>>(capacity);
+                recentlyUsed = new LinkedList<Entry>();
+            }
+
+            public bool TryGet(Key key, out MMUWindow window)
+            {
+                lock(entries)
+                {
+                    if(!entries.TryGetValue(key, out var node))
+                    {
+                        Misses++;
+                        window = null;
+                        return false;
+                    }
+                    recentlyUsed.Remove(node);
+                    recentlyUsed.AddFirst(node);
+                    Hits++;
+                    window = node.Value.Window;
+                    return true;
+                }
+            }
+
+            public void Add(Key key, MMUWindow window)
+            {
+                lock(entries)
+                {
+                    if(entries.TryGetValue(key, out var node))
+                    {
+                        recentlyUsed.Remove(node);
+                    }
+                    else if(entries.Count == capacity)
+                    {
+                        entries.Remove(recentlyUsed.Last.Value.Key);
+                        recentlyUsed.RemoveLast();
+                    }
+                    entries[key] = recentlyUsed.AddFirst(new Entry(key, window));
+                }
+            }
+
+            // Null arguments match all the entries of the given security state
+            public void Invalidate(SecurityState world, ushort? vmid = null, ushort? asid = null, ulong? virtualAddress = null)
+            {
+                lock(entries)
+                {
+                    var node = recentlyUsed.First;
+                    while(node != null)
+                    {
+                        var next = node.Next;
+                        if(node.Value.Matches(world, vmid, asid, virtualAddress))
+                        {
+                            entries.Remove(node.Value.Key);
+                            recentlyUsed.Remove(node);
+                        }
+                        node = next;
+                    }
+                }
+            }
+
+            public void Clear()
+            {
+                lock(entries)
+                {
+                    entries.Clear();
+                    recentlyUsed.Clear();
+                }
+            }
+
+            public ulong Hits { get; private set; }
+
+            public ulong Misses { get; private set; }
+
+            private readonly int capacity;
+            private readonly Dictionary<Key, LinkedListNode<Entry>> entries;
+            private readonly LinkedList<Entry> recentlyUsed;
+
+            private const int MinimumPageSizeShift = 12;
+
+            public struct Key : IEquatable<Key>
+            {
+                public Key(SecurityState world, int streamId, ushort asid, ushort vmid, ulong address)
+                {
+                    World = world;
+                    StreamId = streamId;
+                    Asid = asid;
+                    Vmid = vmid;
+                    // Translations are never finer than the smallest granule, so any address in the page selects the same one
+                    Page = address >> MinimumPageSizeShift;
+                }
+
+                public bool Equals(Key other)
+                {
+                    return World == other.World && StreamId == other.StreamId && Asid == other.Asid && Vmid == other.Vmid && Page == other.Page;
+                }
+
+                public override bool Equals(object obj)
+                {
+                    return obj is Key other && Equals(other);
+                }
+
+                public override int GetHashCode()
+                {
+                    var hash = 17;
+                    hash = hash * 31 + World.GetHashCode();
+                    hash = hash * 31 + StreamId;
+                    hash = hash * 31 + ((Asid << 16) | Vmid);
+                    hash = hash * 31 + Page.GetHashCode();
+                    return hash;
+                }
+
+                public readonly SecurityState World;
+                public readonly int StreamId;
+                public readonly ushort Asid;
+                public readonly ushort Vmid;
+                public readonly ulong Page;
+            }
+
+            private class Entry
+            {
+                public Entry(Key key, MMUWindow window)
+                {
+                    Key = key;
+                    Window = window;
+                }
+
+                public bool Matches(SecurityState world, ushort? vmid, ushort? asid, ulong? virtualAddress)
+                {
+                    return Key.World == world && (!vmid.HasValue || Key.Vmid == vmid) && (!asid.HasValue || Key.Asid == asid)
+                        && (!(virtualAddress is ulong va) || Window.ContainsAddress(va));
+                }
+
+                public Key Key { get; }
+
+                public MMUWindow Window { get; }
+            }
+        }
+    }
+}
@@ -162,12 +162,47 @@ protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securitySta
             public int Range;
         }
 
+        [Command(Opcode.CMD_CFGI_CD)]
+        public class InvalidateCdCommand : Command
+        {
+            protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
+            {
+                // Security is checked in `ValidateAndRun`
+                parent.SelectDomain(securityState).InvalidateContextDescriptors(StreamID);
+                return CommandError.None;
+            }
+
+            [PacketField, Offset(bits: 12), Width(bits: 20)]
+            public int SubstreamID;
+
+            [PacketField, Offset(bits: 32), Width(bits: 32)]
+            public uint StreamID;
+
+            [PacketField, Offset(bits: 64), Width(bits: 1)]
+            public bool Leaf;
+        }
+
+        [Command(Opcode.CMD_CFGI_CD_ALL)]
+        public class InvalidateCdAllCommand : Command
+        {
+            protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
+            {
+                // Security is checked in `ValidateAndRun`
+                parent.SelectDomain(securityState).InvalidateContextDescriptors(StreamID);
+                return CommandError.None;
+            }
+
+            [PacketField, Offset(bits: 32), Width(bits: 32)]
+            public uint StreamID;
+        }
+
+        // VMIDs are ignored by the TLBI_NH_* commands, as stage 2 translation isn't implemented (SMMU_IDR0.S2P is 0)
         [Command(Opcode.CMD_TLBI_NH_ALL)]
         public class InvalidateTlbByVmidCommand : Command
         {
             protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
             {
-                parent.InvalidateTlb(); // TODO: More granular invalidation
+                parent.InvalidateTlb(securityState);
                 return CommandError.None;
             }
 
@@ -180,7 +215,7 @@ public class InvalidateTlbByVmidAsid : InvalidateTlbByVmidCommand
         {
             protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
             {
-                parent.InvalidateTlb(); // TODO: More granular invalidation
+                parent.InvalidateTlb(securityState, asid: ASID);
                 return CommandError.None;
             }
 
@@ -193,7 +228,7 @@ public class InvalidateTlbByVirtualAddress : InvalidateTlbByVmidCommand
         {
             protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
             {
-                parent.InvalidateTlb(Address); // TODO: Use other hints
+                parent.InvalidateTlb(securityState, asid: ASID, virtualAddress: Address); // TODO: Use other hints
                 return CommandError.None;
             }
 
@@ -209,6 +244,9 @@ protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securitySta
 
             // RES0 26-31
 
+            [PacketField, Offset(bits: 48), Width(bits: 16)]
+            public ushort ASID;
+
             [PacketField, Offset(bits: 64), Width(bits: 1)]
             public bool Leaf;
 
@@ -227,16 +265,25 @@ protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securitySta
             private readonly ulong address;
         }
 
+        // Bits of the ASID field are RES0 in this command, translations of all ASIDs are invalidated
         [Command(Opcode.CMD_TLBI_NH_VAA)]
         public class InvalidateTlbByVirtualAddressAsid : InvalidateTlbByVirtualAddress
         {
             protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
             {
-                return base.Run(parent, securityState); // TODO: Use ASID
+                parent.InvalidateTlb(securityState, virtualAddress: Address); // TODO: Use other hints
+                return CommandError.None;
             }
+        }
 
-            [PacketField, Offset(bits: 48), Width(bits: 16)]
-            public ushort ASID;
+        [Command(Opcode.CMD_TLBI_NSNH_ALL)]
+        public class InvalidateTlbNonSecureNonHypervisorCommand : Command
+        {
+            protected override CommandError Run(ARM_SMMUv3 parent, SecurityState securityState)
+            {
+                parent.InvalidateTlb(SecurityState.NonSecure);
+                return CommandError.None;
+            }
         }
 
         [Command(Opcode.CMD_SYNC)]
@@ -30,7 +30,7 @@ namespace Antmicro.Renode.Peripherals.MemoryControllers
     // * Storing TLBs based on VMID/ASID instead of just the bus controller
     // * Stage 2 translation and support for the remaining STE.Config values
     // * -AE registers (Functional Safety features)
-    // * Support for more invalidation commands (e.g. CMD_TLBI_NSNH_ALL, CMD_TLBI_SNH_ALL)
+    // * Support for more invalidation commands (e.g. CMD_TLBI_EL2_ALL, CMD_TLBI_SNH_ALL)
     // * Support for all STE.PRIVCFG values (i.e. UseIncomming)
     // * MMIO access control with the IMP_PERIPHPREGIONR register (access to SMMU registers - they are currently always available)
     // * 2-level stream table
@@ -50,10 +50,15 @@ static ARM_SMMUv3()
             registeredCommands = commands;
         }
 
-        public ARM_SMMUv3(IMachine machine, IPeripheral context = null)
+        public ARM_SMMUv3(IMachine machine, IPeripheral context = null, int iotlbSize = DefaultIotlbSize)
         {
+            if(iotlbSize <= 0)
+            {
+                throw new ConstructionException($"Invalid IOTLB size: {iotlbSize}, it has to be positive");
+            }
             this.Context = context ?? this; // Context used to read descriptors and tables from memory
             this.machine = machine;
+            iotlb = new Iotlb(iotlbSize);
             sysbus = machine.GetSystemBus(this);
             RegistersCollection = new DoubleWordRegisterCollection(this);
             QuadWordRegisters = new QuadWordRegisterCollection(this);
@@ -120,6 +125,7 @@ public void Reset()
         {
             nonSecureDomain.Reset();
             secureDomain.Reset();
+            iotlb.Clear();
         }
 
         public IEnumerable<ARM_SMMUv3RegistrationPoint> GetRegistrationPoints(IPeripheral peripheral)
@@ -219,7 +225,7 @@ public MMUWindow GetWindowFromPageTable(ulong address, IPeripheral initiator, Ac
                 win.AssertIsValid();
                 return win;
             }
-            var cd = ReadStruct<ContextDescriptor>(ste.S1ContextPtr);
+            var cd = domain.GetContextDescriptor(streamId);
             if(!cd.V)
             {
                 this.WarningLog("Context descriptor for stream #{0} ({1}) loaded from 0x{2:X} is invalid", streamId, domain.SecurityState, ste.S1ContextPtr);
@@ -234,6 +240,21 @@ public MMUWindow GetWindowFromPageTable(ulong address, IPeripheral initiator, Ac
             // TODO: treating UseIncoming as Privileged
             var privileged = ste.PRIVCFG != Privilege.Unprivileged;
 
+            var iotlbKey = new Iotlb.Key(domain.SecurityState, streamId, cd.ASID, GetVmid(ste), address);
+            if(iotlb.TryGet(iotlbKey, out var cachedWindow))
+            {
+                return cachedWindow;
+            }
+            var window = WalkPageTables(address, accessType, domain, streamId, cd, privileged);
+            if(window != null)
+            {
+                iotlb.Add(iotlbKey, window);
+            }
+            return window;
+        }
+
+        private MMUWindow WalkPageTables(ulong address, AccessType accessType, Domain domain, int streamId, ContextDescriptor cd, bool privileged)
+        {
             ulong? tableAddr = null; // Start with TTB0/TTB1
             // For VMSAv8-32 LPAE (AA64 == 0) the virtual address size is 32-bits
             // For VMSAv8-64 (AA64 == 1) the virtual address size is based on the value of the SMMU_IDR5.VAX register field
@@ -416,6 +437,14 @@ public IDisposable BlockEventQueues(bool block)
             });
         }
 
+        public ulong IotlbHits => iotlb.Hits;
+
+        public ulong IotlbMisses => iotlb.Misses;
+
+        public ulong ConfigurationCacheHits => nonSecureDomain.ConfigurationCacheHits + secureDomain.ConfigurationCacheHits;
+
+        public ulong ConfigurationCacheMisses => nonSecureDomain.ConfigurationCacheMisses + secureDomain.ConfigurationCacheMisses;
+
         public GPIO NonSecureGlobalErrorIRQ => nonSecureDomain.GlobalErrorIRQ;
 
         public GPIO SecureGlobalErrorIRQ => secureDomain.GlobalErrorIRQ;
@@ -451,6 +480,12 @@ private static Type GetPageTableEntryType(IList<byte> pte)
             }
         }
 
+        // Stage 2 translation isn't supported, so stage 1 translations are tagged with VMID 0
+        private static ushort GetVmid(StreamTableEntry ste)
+        {
+            return ste.Config == StreamConfiguration.TranslateStage1 ? (ushort)0 : ste.S2VMID;
+        }
+
         private static Type GetCommandType(IList<byte> command)
         {
             // Default to the base Command to log the unhandled operation.
@@ -1133,7 +1168,8 @@ private void DefineRegisters()
                                     domain.InvalidateSte((uint)i);
                                 }
                             }
-                            InvalidateTlb();
+                            iotlb.Clear();
+                            InvalidateStreamControllers();
                         }
                     })
                 .WithReservedBits(1, 31)
@@ -1249,7 +1285,15 @@ private void DefineRegisters()
             ;
         }
 
-        private void InvalidateTlb(ulong? virtualAddress = null)
+        // The windows of the stream controllers aren't tagged, so all of them are dropped (or all covering the address) even if
+        // only the translations of one ASID are invalidated. The ones still valid are then refilled from the IOTLB.
+        private void InvalidateTlb(SecurityState world, ushort? vmid = null, ushort? asid = null, ulong? virtualAddress = null)
+        {
+            iotlb.Invalidate(world, vmid, asid, virtualAddress);
+            InvalidateStreamControllers(virtualAddress);
+        }
+
+        private void InvalidateStreamControllers(ulong? virtualAddress = null)
         {
             foreach(var controller in streamControllers.Values)
             {
@@ -1305,6 +1349,7 @@ private bool CanAccessRegister(long register, ulong? value = null)
         private readonly Domain secureDomain;
         private readonly TwoWayDictionary<ARM_SMMUv3RegistrationPoint, IPeripheral> streams = new TwoWayDictionary<ARM_SMMUv3RegistrationPoint, IPeripheral>();
         private readonly Dictionary<ARM_SMMUv3RegistrationPoint, ISMMUv3StreamController> streamControllers = new Dictionary<ARM_SMMUv3RegistrationPoint, ISMMUv3StreamController>(); // TODO: Index by (ASID, VMID, StreamWorld)
+        private readonly Iotlb iotlb;
 
         private readonly IMachine machine;
         private readonly IBusController sysbus;
@@ -1313,6 +1358,7 @@ private bool CanAccessRegister(long register, ulong? value = null)
         private const int MaxCommandQueueShift = 7; // 128 bytes
         private const int MaxEventQueueShift = 7;
         private const int StreamIdBits = 8;
+        private const int DefaultIotlbSize = 1024;
 
         public enum SecurityState
         {
@@ -66,12 +66,16 @@ public void SemihostingWriteByte(byte b)
         public void SemihostingWriteBytes(byte[] buffer, int offset, int count)
         {
             ReadWriteCheck(buffer, offset, count);
+            SemihostingWriteBytes(new ReadOnlySpan<byte>(buffer, offset, count));
+        }
 
+        public void SemihostingWriteBytes(ReadOnlySpan<byte> bytes)
+        {
             lock(UartLock)
             {
-                for(var i = offset; i < count + offset; i++)
+                foreach(var b in bytes)
                 {
-                    OnCharReceived(buffer[i]);
+                    OnCharReceived(b);
                 }
             }
         }